@@ -1,15 +1,13 @@
 #pragma once
 #include <stdint.h>
+#include <stddef.h>
 // ---- Pins ----
 static constexpr int LED1_PIN = 5;
 static constexpr int LED2_PIN = 4;
 
-// ---- LED engine ----
-static constexpr uint16_t LED_TICK_MS = 25;
-
 // ---- Task configs (words: 1024 words ≈ 4 KB) ----
-// UI (LED/status)
-static constexpr uint32_t TASK_STACK_UI     = 4096;  // ~16 KB
+// UI (picks LED patterns on state changes; the LEDs animate from esp_timer)
+static constexpr uint32_t TASK_STACK_UI     = 2048;
 static constexpr uint8_t  TASK_PRIO_UI      = 2;
 static constexpr int8_t   TASK_CORE_UI      = 1;     // 0/1, -1=no affinity
 
@@ -28,6 +26,17 @@ static constexpr uint32_t TASK_STACK_SENSOR = 4096;
 static constexpr uint8_t  TASK_PRIO_SENSOR  = 2;
 static constexpr int8_t   TASK_CORE_SENSOR  = 1;
 
+// HX711 reader (woken by DOUT ISR, clocks out each conversion)
+static constexpr uint32_t TASK_STACK_HX     = 2048;
+static constexpr uint8_t  TASK_PRIO_HX      = 5;     // above everything app-level
+static constexpr int8_t   TASK_CORE_HX      = 1;
+static constexpr size_t   HX_RING_LEN       = 64;    // samples; power of two
+
+// Uploader (drains the measurement queue, does the HTTPS posts)
+static constexpr uint32_t TASK_STACK_UPLOAD = 6144;  // TLS handshake is stack hungry
+static constexpr uint8_t  TASK_PRIO_UPLOAD  = 1;     // below sensor: never stalls sampling
+static constexpr int8_t   TASK_CORE_UPLOAD  = 0;
+
 // Buttons (debounce/events)
 static constexpr uint32_t TASK_STACK_BTNS   = 2048;
 static constexpr uint8_t  TASK_PRIO_BTNS    = 2;
@@ -38,9 +47,76 @@ static constexpr uint32_t TASK_STACK_BTN_HANDLER = 4096;
 static constexpr uint8_t  TASK_PRIO_BTN_HANDLER  = 1;
 static constexpr int8_t   TASK_CORE_BTN_HANDLER  = 1;
 
+// Log drain (util/log.h): writes queued lines to Serial
+static constexpr uint32_t TASK_STACK_LOG    = 2048;
+static constexpr uint8_t  TASK_PRIO_LOG     = 1;     // lowest app priority
+static constexpr int8_t   TASK_CORE_LOG     = -1;
+static constexpr uint32_t LOG_RING_SLOTS    = 32;    // lines; power of two
+static constexpr size_t   LOG_LINE_MAX      = 120;   // chars per line, longer is truncated
+static constexpr bool     LOG_BENCH_AT_BOOT = false; // time LOGI vs Serial.printf once at boot
+
+// Metrics (core/metrics.h): sampler + serial console task, /metrics over HTTP
+static constexpr uint32_t TASK_STACK_METRICS      = 3072;
+static constexpr uint8_t  TASK_PRIO_METRICS       = 1;
+static constexpr int8_t   TASK_CORE_METRICS       = -1;
+static constexpr uint32_t TASK_STACK_METRICS_HTTP = 4096;  // IDF httpd task (net/metrics_http.h)
+static constexpr uint32_t METRICS_SAMPLE_MS       = 10000; // heap/RSSI/task stacks refresh
+static constexpr uint16_t METRICS_HTTP_PORT       = 8080;  // 0 = no HTTP endpoint
+static constexpr uint8_t  METRICS_MAX_TASKS       = 24;    // task list snapshot size
+
+// Measurement latency trace + SLO (features/latency_trace.h)
+static constexpr uint8_t  TRACE_SLOTS          = 32;    // weights traced at once (oldest evicted)
+static constexpr uint32_t TRACE_SLO_MS         = 5000;  // load change → server ack; "slo <ms>" overrides (NVS)
+static constexpr uint8_t  TRACE_SLO_PCT        = 95;    // share of weights that must make it
+static constexpr uint8_t  TRACE_SLO_WINDOW     = 64;    // judged over the last N weights (<= 64)
+static constexpr uint8_t  TRACE_SLO_MIN_TRACES = 10;    // no verdict before this many
+
+// Event bus (core/event_bus.h) + wakeup accounting (core/wake_stats.h)
+static constexpr uint8_t  EVENT_MAX_SUBS      = 8;      // subscriber queues
+static constexpr uint32_t WAKE_LOG_MS         = 60000;  // "[WAKE]" rates line period (0 = off)
+static constexpr uint32_t WIFI_RSSI_CHECK_MS  = 5000;   // wifi task wakeup while connected (roam check)
+
+// Measurement queue (sensor → uploader)
+static constexpr uint8_t  MEAS_Q_LEN          = 32;
+static constexpr bool     MEAS_Q_DROP_OLDEST  = true;   // false = reject the new record
+static constexpr uint8_t  UPLOAD_MAX_ATTEMPTS = 5;      // per record the server rejects (4xx), then dropped
+static constexpr uint32_t UPLOAD_RETRY_MS     = 2000;   // between tries of a rejected record
+// Transport errors / 5xx (util/retry_scheduler.h): jittered exponential
+// backoff, then a circuit breaker with a single half-open probe
+static constexpr uint32_t RETRY_BASE_MS       = 1000;
+static constexpr uint32_t RETRY_MAX_MS        = 60000;
+static constexpr uint16_t BREAKER_OPEN_AFTER  = 5;      // consecutive failures
+static constexpr uint32_t BREAKER_OPEN_MS     = 30000;  // doubles per failed probe...
+static constexpr uint32_t BREAKER_OPEN_MAX_MS = 600000; // ...up to 10 min
+static constexpr uint32_t SEQ_BLOCK           = 256;    // seq numbers reserved per NVS write
+static constexpr uint32_t UPLOAD_IDLE_WAIT_MS = 1000;   // re-check NET_UP while records are spooled
+static constexpr bool     BATCH_ENABLED       = true;   // false = always one POST per record
+static constexpr uint8_t  BATCH_MAX_RECORDS   = 16;     // per request
+static constexpr uint16_t BATCH_MAX_BYTES     = 1536;   // JSON body limit
+static constexpr uint32_t BATCH_REJECT_PAUSE_MS = 10UL * 60 * 1000;  // single posts after a refused batch
+static constexpr bool     WIRE_BIN_ENABLED    = true;   // offer binary batches in welcome (net/weight_codec.h)
+static constexpr bool     HEAP_LOG_POSTS      = false;  // "[HEAP]" line per post (see util/heap_stats.h)
+
 // Timeouts
 static constexpr uint32_t WIFI_CONNECT_TIMEOUT_MS = 15000; // per attempt
-static constexpr uint8_t  WIFI_MAX_ATTEMPTS       = 3;     // then we give up (for now)
+static constexpr uint8_t  WIFI_MAX_NETWORKS       = 5;     // saved SSID/password pairs
+static constexpr uint8_t  WIFI_MAX_CANDIDATES     = 3;     // BSSIDs tried per connect round (best RSSI first)
+static constexpr int8_t   WIFI_MIN_RSSI           = -88;   // ignore APs weaker than this (dBm)
+static constexpr uint32_t WIFI_SCAN_CACHE_MS      = 30000; // reuse scan results this long
+static constexpr uint32_t WIFI_RETRY_MIN_MS       = 1000;  // between failed rounds, doubling...
+static constexpr uint32_t WIFI_RETRY_MAX_MS       = 60000; // ...up to this; measuring never stops
+static constexpr int8_t   WIFI_ROAM_RSSI          = -75;   // look for a better AP below this (dBm)
+static constexpr uint8_t  WIFI_ROAM_DELTA_DB      = 8;     // switch only if that much stronger
+static constexpr uint32_t WIFI_ROAM_INTERVAL_MS   = 60000; // min time between roam scans
+static constexpr bool     WIFI_FAST_CONNECT       = true;  // directed connect from the cached BSSID/channel
+static constexpr uint32_t WIFI_FAST_TIMEOUT_MS    = 4000;  // then full scan
+static constexpr bool     WIFI_FAST_REUSE_LEASE   = false; // skip DHCP on the fast path with the cached lease...
+static constexpr uint32_t WIFI_FAST_LEASE_MAX_S   = 3600;  // ...only while younger than this (s, needs NTP time); keep below the DHCP lease time
+// Optional static IP ("" = DHCP); overrides the cached lease when set
+static constexpr char WIFI_STATIC_IP[]   = "";
+static constexpr char WIFI_STATIC_GW[]   = "";
+static constexpr char WIFI_STATIC_MASK[] = "255.255.255.0";
+static constexpr char WIFI_STATIC_DNS[]  = "";
 
 // ---- Time / NTP ----
 static constexpr char     NTP_SERVER_1[]      = "pool.ntp.org";
@@ -59,16 +135,55 @@ static constexpr int BTN2_PIN = 7;   // change to your wiring
 static constexpr uint16_t BTN_DEBOUNCE_MS  = 30;
 static constexpr uint16_t BTN_SHORT_MIN_MS = 50;
 static constexpr uint16_t BTN_LONG_MS      = 2000;
+static constexpr uint8_t  BTN_EDGE_Q_LEN   = 16;    // ISR → buttons task raw edges
+
+// --- HX711 sampling + decimating filter chain ---
+// RATE pin: LOW = 10 SPS, HIGH = 80 SPS. -1 = strapped on the board (ours:
+// 10 SPS); the sensor task then measures the rate from the conversion
+// timestamps at startup and HX_RATE_SPS is only the fallback.
+static constexpr int      HX_RATE_PIN      = -1;
+static constexpr uint16_t HX_RATE_SPS      = 10;
+// CIC order N; decimation R = input rate / FILT_OUT_SPS (1 at 10 SPS)
+static constexpr uint8_t  FILT_CIC_ORDER   = 2;
+static constexpr uint8_t  FILT_OUT_SPS     = 10;    // filtered readings per second
+static constexpr uint8_t  FILT_POST        = 1;     // 0=none 1=median3 2=median5 3=FIR5 (FilterPost)
+static constexpr uint16_t FILT_NOISE_N     = 100;   // outputs per noise report while idle (0=off)
+
+// Live value: adaptive Kalman on the filter-chain output
+static constexpr int32_t  LIVE_SIGMA_MEAS_MG = 150;  // chain output noise σ
+static constexpr int32_t  LIVE_SIGMA_REST_MG = 5;    // drift per output at rest
+static constexpr uint8_t  LIVE_GATE_SIGMA    = 3;    // innovation gate → "moving"
 
 // --- Weight detection thresholds (tune later) ---
-static constexpr float    DELTA_SEND_G     = 20.0f; // trigger threshold
-static constexpr float    STABILITY_BAND_G = 6.0f;  // how close readings must be (±band)
-static constexpr uint32_t STABILITY_MS     = 800;   // must stay stable for this long
+// Integer milligrams: the whole measurement path is fixed-point (no FPU on C3)
+static constexpr int32_t  DELTA_SEND_MG     = 20000; // trigger threshold (20 g)
+static constexpr int32_t  STABILITY_BAND_MG = 6000;  // how close readings must be (±6 g)
+static constexpr uint32_t STABILITY_MS      = 800;   // must stay stable for this long
+
+// Early settle: post a predicted final weight from the settling curve as soon
+// as an exponential fit is good enough; the confirmed value follows only if
+// it differs by more than STABILITY_BAND_MG.
+static constexpr bool     EARLY_SETTLE_ENABLED       = false;
+static constexpr uint8_t  EARLY_SETTLE_MIN_SAMPLES   = 6;      // filter outputs
+static constexpr int32_t  EARLY_SETTLE_MAX_RMS_MG    = 1500;   // fit residual bound
+static constexpr int32_t  EARLY_SETTLE_MAX_EXTRAP_MG = 50000;  // max distance from last sample
+static constexpr int32_t  EARLY_SETTLE_MAX_DECAY_Q16 = 62259;  // a < 0.95 (Q16)
+static constexpr uint8_t  EARLY_SETTLE_MIN_CONF      = 70;     // % confidence to post
 
 // ---- Server / HTTP ----
 static constexpr char     SERVER_BASE_URL[]   = "https://tehtnice.forcapsolutions.net";
 static constexpr uint32_t HTTP_TIMEOUT_MS     = 7000;
 static constexpr bool     HTTP_TLS_INSECURE   = true;   // dev: accept self-signed
+static constexpr char     SERVER_CA_PEM[]     = "";     // root CA (PEM) checked when !HTTP_TLS_INSECURE
+
+// ---- Upload transport ----
+static constexpr uint8_t  UPLOAD_TRANSPORT      = 0;      // 0 = HTTP posts, 1 = persistent stream
+static constexpr char     STREAM_HOST[]         = "tehtnice.forcapsolutions.net";
+static constexpr uint16_t STREAM_PORT           = 8443;
+static constexpr char     STREAM_TOKEN[]        = "";     // per-deployment shared secret
+static constexpr uint32_t STREAM_HEARTBEAT_MS   = 15000;
+static constexpr uint32_t STREAM_ACK_TIMEOUT_MS = 5000;
+static constexpr uint32_t STREAM_RECONNECT_MS   = 5000;   // min gap between connect attempts
 
 // Device "friendly" name to send with weight posts
 static constexpr char DEVICE_NAME[] = "Sample Scale1";
@@ -80,8 +195,10 @@ static constexpr uint8_t  AP_CHAN = 6;
 static constexpr uint32_t AP_IDLE_REBOOT_MS = 10UL * 60UL * 1000UL; // reboot after 10 min idle
 
 // NVS keys (same "smartscale" namespace you already open via nvs_init)
-static constexpr char WIFI_KEY_SSID[] = "wifi_ssid";
+static constexpr char WIFI_KEY_LIST[] = "wifi_list";    // saved networks (net/wifi_creds.h)
+static constexpr char WIFI_KEY_SSID[] = "wifi_ssid";    // legacy single network, migrated on load
 static constexpr char WIFI_KEY_PASS[] = "wifi_pass";
+static constexpr char WIFI_KEY_FAST[] = "wifi_fast";    // last good BSSID/channel/lease (blob)
 
 // Boot combo to wipe Wi-Fi creds
 static constexpr uint32_t BOOT_WIPE_HOLD_MS = 3000;  // hold both buttons for 3s at boot
\ No newline at end of file
@@ -1,39 +1,77 @@
 #include "app_state.h"
+#include "freertos/semphr.h"
+#include "core/event_bus.h"
 
 static EventGroupHandle_t s_events = nullptr;
+static SemaphoreHandle_t  s_mtx    = nullptr;   // orders change + publish
 static AppMode s_mode = AppMode::BOOT;
 
+// Bit b is mirrored (inverted) at b + 12: set while b is clear
+static constexpr int         MIRROR_SHIFT = 12;
+static constexpr EventBits_t mirror(EventBits_t b) { return (b & AppBits::ALL) << MIRROR_SHIFT; }
+
 void app_state_init() {
   if (!s_events) {
     s_events = xEventGroupCreate();
+    s_mtx    = xSemaphoreCreateMutex();
+    if (s_events) xEventGroupSetBits(s_events, mirror(AppBits::ALL));   // everything starts clear
   }
   s_mode = AppMode::BOOT;
 }
 
+static void publish_changes(EventBits_t before, EventBits_t after) {
+  before &= AppBits::ALL;
+  after  &= AppBits::ALL;
+  if (before == after) return;
+  const EventBits_t down = before & ~after;
+  if (down & AppBits::NET_UP) event_publish(EventType::NET_OFFLINE);
+  event_publish(EventType::STATE, after);
+}
+
 EventGroupHandle_t app_events() {
   return s_events;
 }
 
+// Order keeps waiters honest: the old side goes first, so for a moment
+// neither a bit nor its mirror is set (nobody wakes early), never both.
 void app_set_bits(EventBits_t bits) {
-  if (s_events) xEventGroupSetBits(s_events, bits);
+  if (!s_events) return;
+  xSemaphoreTake(s_mtx, portMAX_DELAY);
+  const EventBits_t before = xEventGroupGetBits(s_events);
+  xEventGroupClearBits(s_events, mirror(bits));
+  xEventGroupSetBits(s_events, bits);
+  xSemaphoreGive(s_mtx);
+  publish_changes(before, before | bits);
 }
 
 void app_clear_bits(EventBits_t bits) {
-  if (s_events) xEventGroupClearBits(s_events, bits);
+  if (!s_events) return;
+  xSemaphoreTake(s_mtx, portMAX_DELAY);
+  const EventBits_t before = xEventGroupGetBits(s_events);
+  xEventGroupClearBits(s_events, bits);
+  xEventGroupSetBits(s_events, mirror(bits));
+  xSemaphoreGive(s_mtx);
+  publish_changes(before, before & ~bits);
+}
+
+bool app_wait_bits(EventBits_t bits, uint32_t timeoutMs) {
+  if (!s_events) return false;
+  const TickType_t t = (timeoutMs == portMAX_DELAY) ? portMAX_DELAY : pdMS_TO_TICKS(timeoutMs);
+  const EventBits_t got = xEventGroupWaitBits(s_events, bits, pdFALSE, pdTRUE, t);
+  return (got & bits) == bits;
+}
+
+bool app_wait_bits_clear(EventBits_t bits, uint32_t timeoutMs) {
+  if (!s_events) return false;
+  const TickType_t t = (timeoutMs == portMAX_DELAY) ? portMAX_DELAY : pdMS_TO_TICKS(timeoutMs);
+  const EventBits_t got = xEventGroupWaitBits(s_events, mirror(bits), pdFALSE, pdTRUE, t);
+  return (got & mirror(bits)) == mirror(bits);
 }
 
 EventBits_t app_get_bits() {
   if (!s_events) return 0;
-  return xEventGroupGetBits(s_events);
+  return xEventGroupGetBits(s_events) & AppBits::ALL;
 }
 
 void app_set_mode(AppMode m) { s_mode = m; }
 AppMode app_get_mode() { return s_mode; }
-
-void app_debug_print() {
-  auto b = app_get_bits();
-  Serial.printf("[APP] bits=0x%02X\r\n", (unsigned)b);
-  Serial.printf("  NET_UP=%d TIME_VALID=%d AP_MODE=%d POSTING=%d OTA=%d CALIB=%d\r\n",
-    !!(b & AppBits::NET_UP), !!(b & AppBits::TIME_VALID), !!(b & AppBits::AP_MODE),
-    !!(b & AppBits::POSTING), !!(b & AppBits::OTA_ACTIVE), !!(b & AppBits::CALIB_ACTIVE));
-}
@@ -20,16 +20,24 @@ namespace AppBits {
   static constexpr EventBits_t POSTING     = 1 << 3;
   static constexpr EventBits_t OTA_ACTIVE  = 1 << 4;
   static constexpr EventBits_t CALIB_ACTIVE= 1 << 5;
+  static constexpr EventBits_t ALL         = (1 << 6) - 1;
 }
 
 void app_state_init();
 EventGroupHandle_t app_events();
 
+// Changing bits also publishes EventType::STATE (and NET_OFFLINE when
+// NET_UP drops), see core/event_bus.h.
 void app_set_bits(EventBits_t bits);
 void app_clear_bits(EventBits_t bits);
 EventBits_t app_get_bits();
 
+// Block until all of 'bits' are set / all are clear, up to 'timeoutMs'
+// (portMAX_DELAY = forever). Return true if the condition holds.
+// Waiting for "clear" uses a mirror copy of each bit in the upper half of
+// the event group, so both directions are a plain xEventGroupWaitBits.
+bool app_wait_bits(EventBits_t bits, uint32_t timeoutMs);
+bool app_wait_bits_clear(EventBits_t bits, uint32_t timeoutMs);
+
 void app_set_mode(AppMode m);
 AppMode app_get_mode();
-
-void app_debug_print();
@@ -0,0 +1,97 @@
+#include "event_bus.h"
+#include "app_config.h"
+#include "hal/clock.h"
+#include "util/log.h"
+#ifdef ARDUINO
+#include <Arduino.h>
+#else
+#include <deque>
+#include <mutex>
+#endif
+
+// Queue primitives: FreeRTOS on the device, a locked deque on the host
+#ifdef ARDUINO
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static void     table_lock()                          { portENTER_CRITICAL(&s_mux); }
+static void     table_unlock()                        { portEXIT_CRITICAL(&s_mux); }
+static EventSub q_create(uint8_t depth)               { return xQueueCreate(depth, sizeof(Event)); }
+static void     q_delete(EventSub q)                  { vQueueDelete(q); }
+static bool     q_send(EventSub q, const Event& ev)   { return xQueueSendToBack(q, &ev, 0) == pdPASS; }
+static bool     q_receive(EventSub q, Event& out, TickType_t wait) {
+  return xQueueReceive(q, &out, wait) == pdPASS;
+}
+#else
+struct EventQueue {
+  std::deque<Event> q;
+  uint8_t           depth;
+};
+
+static std::mutex s_mtx;
+
+static void     table_lock()                          { s_mtx.lock(); }
+static void     table_unlock()                        { s_mtx.unlock(); }
+static EventSub q_create(uint8_t depth)               { return new EventQueue{ {}, depth }; }
+static void     q_delete(EventSub q)                  { delete q; }
+static bool     q_send(EventSub q, const Event& ev) {
+  std::lock_guard<std::mutex> lock(s_mtx);
+  if (q->q.size() >= q->depth) return false;
+  q->q.push_back(ev);
+  return true;
+}
+static bool     q_receive(EventSub q, Event& out, TickType_t) {
+  std::lock_guard<std::mutex> lock(s_mtx);
+  if (q->q.empty()) return false;
+  out = q->q.front();
+  q->q.pop_front();
+  return true;
+}
+#endif
+
+struct Sub {
+  EventSub q;
+  uint32_t mask;
+};
+
+static Sub               s_subs[EVENT_MAX_SUBS];
+static volatile uint8_t  s_subCount = 0;
+static volatile uint32_t s_dropped  = 0;
+
+EventSub event_subscribe(uint32_t typeMask, uint8_t depth) {
+  EventSub q = q_create(depth ? depth : 1);
+  if (!q) return nullptr;
+
+  table_lock();
+  const bool room = s_subCount < EVENT_MAX_SUBS;
+  if (room) {
+    s_subs[s_subCount] = Sub{ q, typeMask };
+    s_subCount = s_subCount + 1;          // publish sees the entry only once it is filled
+  }
+  table_unlock();
+
+  if (!room) {
+    q_delete(q);
+    LOGE("EVT", "ERROR: subscriber table full");
+    return nullptr;
+  }
+  return q;
+}
+
+void event_publish(EventType type, uint32_t arg) {
+  const Event ev{ type, hal_millis(), arg };
+  const uint32_t bit = event_bit(type);
+  const uint8_t n = s_subCount;             // subscribers are only ever added
+  for (uint8_t i = 0; i < n; ++i) {
+    if (!(s_subs[i].mask & bit)) continue;
+    if (!q_send(s_subs[i].q, ev)) s_dropped++;
+  }
+}
+
+bool event_receive(EventSub sub, Event& out, TickType_t waitTicks) {
+  if (!sub) return false;
+  return q_receive(sub, out, waitTicks);
+}
+
+uint32_t event_dropped() {
+  return s_dropped;
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <stdint.h>
+#ifdef ARDUINO
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#endif
+
+// Typed events between tasks. A task subscribes once (at start) to the
+// types it cares about and gets its own small queue; it then blocks on
+// that queue instead of polling shared state. Publishing never blocks:
+// a full subscriber queue drops the event (counted).
+//
+// STATE is published by app_state whenever the event-group bits change
+// (arg = new bits; the UI task redraws the LEDs), NET_OFFLINE on the
+// NET_UP falling edge (the timekeeper drops its resync wait). A type goes
+// in here together with its first subscriber: buttons, uploads and new
+// weights already have a queue of their own.
+
+enum class EventType : uint8_t {
+  STATE,          // arg = app bits after the change
+  NET_OFFLINE,
+  COUNT
+};
+
+inline constexpr uint32_t event_bit(EventType t) { return 1u << (uint8_t)t; }
+
+struct Event {
+  EventType type;
+  uint32_t  ms;     // millis() at publish
+  uint32_t  arg;
+};
+
+#ifdef ARDUINO
+typedef QueueHandle_t EventSub;
+#else
+// Host build (test/test_event_bus): same fan-out over a plain ring per
+// subscriber; there is no scheduler, so event_receive() never waits.
+typedef struct EventQueue* EventSub;
+typedef uint32_t TickType_t;
+#endif
+
+// 'typeMask' = OR of event_bit(...). Returns nullptr when the table
+// (EVENT_MAX_SUBS) is full or the queue cannot be created.
+EventSub event_subscribe(uint32_t typeMask, uint8_t depth);
+
+void event_publish(EventType type, uint32_t arg = 0);
+
+// Wait up to 'waitTicks' for the next event on 'sub'.
+bool event_receive(EventSub sub, Event& out, TickType_t waitTicks);
+
+uint32_t event_dropped();
@@ -1,24 +1,60 @@
 #include "identity.h"
+#include "freertos/FreeRTOS.h"
 #include "storage/nvs_store.h"
 #include "net/api_client.h"
 #include "net/http_client.h"
+#include "util/log.h"
 
 static constexpr const char* KEY_DEVICE_ID = "device_id";
 
+// RAM copy of the NVS id; posts read this instead of NVS every time
+static char         s_id[48] = "none";
+static bool         s_idLoaded = false;
+static uint32_t     s_idGen = 1;
+static portMUX_TYPE s_idMux = portMUX_INITIALIZER_UNLOCKED;
+
+static void id_cache_set(const String& id) {
+  portENTER_CRITICAL(&s_idMux);
+  strlcpy(s_id, id.length() ? id.c_str() : "none", sizeof(s_id));
+  s_idLoaded = true;
+  s_idGen++;
+  portEXIT_CRITICAL(&s_idMux);
+}
+
+static void id_cache_load() {
+  if (s_idLoaded) return;
+  String id;
+  if (!nvs_load_string(KEY_DEVICE_ID, id)) id = "";
+  id_cache_set(id);
+}
+
 bool identity_load_id(String& out) {
   return nvs_load_string(KEY_DEVICE_ID, out);
 }
 
 bool identity_save_id(const String& id) {
-  return nvs_save_string(KEY_DEVICE_ID, id);
+  const bool ok = nvs_save_string(KEY_DEVICE_ID, id);
+  if (ok) id_cache_set(id);
+  return ok;
 }
 
 String identity_get_id() {
-  String id;
-  if(!identity_load_id(id) || id.length() == 0) {
-    return "none";
-  }
-  return id;
+  char id[sizeof(s_id)];
+  identity_copy_id(id, sizeof(id));
+  return String(id);
+}
+
+size_t identity_copy_id(char* out, size_t len) {
+  id_cache_load();
+  portENTER_CRITICAL(&s_idMux);
+  const size_t n = strlcpy(out, s_id, len);
+  portEXIT_CRITICAL(&s_idMux);
+  return n < len ? n : (len ? len - 1 : 0);
+}
+
+uint32_t identity_generation() {
+  id_cache_load();
+  return s_idGen;
 }
 
 void identity_ensure_welcome() {
@@ -28,24 +64,24 @@ void identity_ensure_welcome() {
 
   String mac = http_mac();
 
-  Serial.printf("[SERVER] → welcome POST: mac=%s id=%s\r\n", mac.c_str(), localId.c_str());
+  LOGI("SERVER", "→ welcome POST: mac=%s id=%s", mac.c_str(), localId.c_str());
 
   String serverId = api_welcome(mac, localId);
   if (serverId.length() == 0) {
-    Serial.println("[ID] welcome: server gave no id (or parse failed) → keeping current");
+    LOGW("ID", "welcome: server gave no id (or parse failed) → keeping current");
     return;
   }
   else{
-    Serial.printf("[SERVER] ← server_id=%s\r\n", serverId.c_str());
+    LOGI("SERVER", "← server_id=%s", serverId.c_str());
   }
 
   if (serverId != localId) {
     if (identity_save_id(serverId)) {
-      Serial.printf("[ID] updated device_id → %s\r\n", serverId.c_str());
+      LOGI("ID", "updated device_id → %s", serverId.c_str());
     } else {
-      Serial.println("[ID] ERROR: failed to save device_id");
+      LOGE("ID", "ERROR: failed to save device_id");
     }
   } else {
-    Serial.println("[ID] device_id unchanged");
+    LOGI("ID", "device_id unchanged");
   }
 }
\ No newline at end of file
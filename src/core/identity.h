@@ -9,4 +9,11 @@ bool identity_save_id(const String& id);  // returns true if written
 // if server returns different id, updates NVS and logs change.
 void identity_ensure_welcome();
 
-String identity_get_id(); // returns current ID or empty string if none
\ No newline at end of file
+String identity_get_id(); // returns current ID or empty string if none
+
+// Allocation-free access to the cached ID ("none" if unset). The NVS key is
+// read once; identity_save_id() updates the cache. Returns the length.
+size_t identity_copy_id(char* out, size_t len);
+
+// Bumped on every ID change, so callers can invalidate derived caches.
+uint32_t identity_generation();
\ No newline at end of file
@@ -0,0 +1,50 @@
+#include "metric_text.h"
+#include <stdio.h>
+
+size_t metric_line(char* out, size_t cap, const char* name, const char* label, int64_t value) {
+  const int n = *label
+    ? snprintf(out, cap, "%s{%s} %lld\n", name, label, (long long)value)
+    : snprintf(out, cap, "%s %lld\n", name, (long long)value);
+  return (n > 0 && (size_t)n < cap) ? (size_t)n : 0;
+}
+
+uint32_t metric_percentile(const HistSnapshot& s, uint8_t pct) {
+  if (s.count == 0) return 0;
+  const uint64_t rank = ((uint64_t)s.count * pct + 99) / 100;   // 1-based
+  uint64_t cum = 0;
+  for (uint8_t b = 0; b <= METRIC_BUCKETS; ++b) {
+    if (s.bucket[b] && cum + s.bucket[b] >= rank) {
+      const uint32_t lo = b ? METRIC_BUCKET_LE[b - 1] : 0;
+      const uint32_t hi = b < METRIC_BUCKETS ? METRIC_BUCKET_LE[b] : s.maxMs;
+      const uint32_t v  = lo + (uint32_t)((uint64_t)(hi > lo ? hi - lo : 0) * (rank - cum) / s.bucket[b]);
+      return v < s.maxMs ? v : s.maxMs;
+    }
+    cum += s.bucket[b];
+  }
+  return s.maxMs;
+}
+
+void metric_write_hist(MetricSink sink, void* ctx, const char* base, const HistSnapshot& s) {
+  char name[40];
+  char label[24];
+
+  snprintf(name, sizeof(name), "%s_bucket", base);
+  uint32_t cum = 0;
+  for (uint8_t b = 0; b < METRIC_BUCKETS; ++b) {
+    cum += s.bucket[b];
+    snprintf(label, sizeof(label), "le=\"%lu\"", (unsigned long)METRIC_BUCKET_LE[b]);
+    sink(ctx, name, label, cum);
+  }
+  sink(ctx, name, "le=\"+Inf\"", cum + s.bucket[METRIC_BUCKETS]);
+  snprintf(name, sizeof(name), "%s_sum", base);
+  sink(ctx, name, "", s.sumMs);
+  snprintf(name, sizeof(name), "%s_count", base);
+  sink(ctx, name, "", s.count);
+  snprintf(name, sizeof(name), "%s_max", base);
+  sink(ctx, name, "", s.maxMs);
+  static const uint8_t kPct[] = { 50, 90, 99 };
+  for (uint8_t p : kPct) {
+    snprintf(name, sizeof(name), "%s_p%u", base, (unsigned)p);
+    sink(ctx, name, "", metric_percentile(s, p));
+  }
+}
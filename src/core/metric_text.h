@@ -0,0 +1,19 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "core/metrics.h"
+
+// Prometheus text rendering of core/metrics (no Arduino deps), shared by
+// the serial dump and GET /metrics.
+
+// "name{label} value\n", or "name value\n" when 'label' is "". Returns the
+// length; 0 when the line does not fit in 'cap' (never a cut-off line).
+size_t metric_line(char* out, size_t cap, const char* name, const char* label, int64_t value);
+
+// Estimated pct-th percentile (interpolated inside its bucket, capped at
+// the max seen); 0 when empty
+uint32_t metric_percentile(const HistSnapshot& s, uint8_t pct);
+
+// One histogram: <base>_bucket{le="..."} cumulative with +Inf last (= count),
+// then _sum, _count, _max and the _p50 / _p90 / _p99 estimates
+void metric_write_hist(MetricSink sink, void* ctx, const char* base, const HistSnapshot& s);
@@ -0,0 +1,346 @@
+#include "metrics.h"
+#include <Arduino.h>
+#include <atomic>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "app_config.h"
+#include "core/app_state.h"
+#include "core/event_bus.h"
+#include "core/metric_text.h"
+#include "core/wake_stats.h"
+#include "drivers/hx711_driver.h"
+#include "features/uploader.h"
+#include "features/latency_trace.h"
+#include "net/metrics_http.h"
+#include "net/wifi_manager.h"
+#include "util/heap_stats.h"
+#include "util/log.h"
+
+static constexpr uint8_t NC = (uint8_t)Ctr::COUNT;
+static constexpr uint8_t NG = (uint8_t)Gauge::COUNT;
+static constexpr uint8_t NH = (uint8_t)Hist::COUNT;
+
+static const char* const kCtrNames[NC] = {
+  "meas_emitted_total", "upload_records_ok_total", "upload_records_failed_total"
+};
+static const char* const kGaugeNames[NG] = {
+  "uptime_seconds", "heap_free_bytes", "heap_largest_block_bytes", "heap_min_free_bytes",
+  "heap_frag_pct", "wifi_rssi_dbm", "upload_queue_depth", "spool_backlog_records",
+  "hx_dropped_samples", "log_dropped_lines", "event_dropped"
+};
+static const char* const kHistNames[NH] = {
+  "upload_post_ms", "http_connect_ms",
+  "latency_filter_ms", "latency_stable_ms", "latency_final_ms", "latency_enqueue_ms",
+  "latency_queue_ms", "latency_send_ms", "latency_total_ms"
+};
+
+struct HistCells {
+  std::atomic<uint32_t> bucket[METRIC_BUCKETS + 1];
+  std::atomic<uint32_t> count;
+  std::atomic<uint32_t> sumMs;
+  std::atomic<uint32_t> maxMs;
+};
+
+static std::atomic<uint32_t> s_ctr[NC];
+static std::atomic<int32_t>  s_gauge[NG];
+static HistCells             s_hist[NH];
+
+// Per-task figures from the last sample. Written by the sampler, read by
+// the renderers (serial + HTTP task), one entry at a time under s_mux.
+struct TaskSample {
+  char     name[configMAX_TASK_NAME_LEN];
+  uint32_t stackFree;   // bytes never touched since the task started
+  uint32_t stackSize;   // configured TASK_STACK_*, 0 = not one of ours
+  int8_t   cpuPct;      // share since the previous sample, -1 = no run-time stats
+};
+
+static TaskSample   s_tasks[METRICS_MAX_TASKS];
+static uint8_t      s_taskCount = 0;
+static portMUX_TYPE s_mux       = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t s_task      = nullptr;
+
+static void metricsTask(void*);
+
+// ---- hot path ----
+
+void metric_inc(Ctr c, uint32_t n) {
+  s_ctr[(uint8_t)c].fetch_add(n, std::memory_order_relaxed);
+}
+
+void metric_set(Gauge g, int32_t v) {
+  s_gauge[(uint8_t)g].store(v, std::memory_order_relaxed);
+}
+
+void metric_observe(Hist h, uint32_t ms) {
+  HistCells& c = s_hist[(uint8_t)h];
+  uint8_t b = 0;
+  while (b < METRIC_BUCKETS && ms > METRIC_BUCKET_LE[b]) ++b;
+  c.bucket[b].fetch_add(1, std::memory_order_relaxed);
+  c.count.fetch_add(1, std::memory_order_relaxed);
+  c.sumMs.fetch_add(ms, std::memory_order_relaxed);
+  uint32_t m = c.maxMs.load(std::memory_order_relaxed);
+  while (ms > m && !c.maxMs.compare_exchange_weak(m, ms, std::memory_order_relaxed)) {}
+}
+
+uint32_t metric_get(Ctr c)  { return s_ctr[(uint8_t)c].load(std::memory_order_relaxed); }
+int32_t  metric_get(Gauge g) { return s_gauge[(uint8_t)g].load(std::memory_order_relaxed); }
+
+void metric_hist(Hist h, HistSnapshot& out) {
+  const HistCells& c = s_hist[(uint8_t)h];
+  for (uint8_t b = 0; b <= METRIC_BUCKETS; ++b) out.bucket[b] = c.bucket[b].load(std::memory_order_relaxed);
+  out.count = c.count.load(std::memory_order_relaxed);
+  out.sumMs = c.sumMs.load(std::memory_order_relaxed);
+  out.maxMs = c.maxMs.load(std::memory_order_relaxed);
+}
+
+// ---- sampler ----
+
+struct KnownTask { const char* name; uint32_t stack; };
+static const KnownTask kKnownTasks[] = {
+  { "sensor",      TASK_STACK_SENSOR },
+  { "hx_reader",   TASK_STACK_HX },
+  { "uploader",    TASK_STACK_UPLOAD },
+  { "wifi",        TASK_STACK_WIFI },
+  { "timekeeper",  TASK_STACK_TIME },
+  { "ui",          TASK_STACK_UI },
+  { "buttons",     TASK_STACK_BTNS },
+  { "btn_handler", TASK_STACK_BTN_HANDLER },
+  { "log",         TASK_STACK_LOG },
+  { "metrics",     TASK_STACK_METRICS },
+};
+
+static uint32_t known_stack(const char* name) {
+  for (const KnownTask& k : kKnownTasks) {
+    if (strcmp(k.name, name) == 0) return k.stack;
+  }
+  return 0;
+}
+
+static void store_task(uint8_t i, const char* name, uint32_t stackFree, int8_t cpuPct) {
+  TaskSample t;
+  strncpy(t.name, name, sizeof(t.name) - 1);
+  t.name[sizeof(t.name) - 1] = '\0';
+  t.stackFree = stackFree;      // ESP-IDF counts stack in bytes
+  t.stackSize = known_stack(t.name);
+  t.cpuPct    = cpuPct;
+  portENTER_CRITICAL(&s_mux);
+  s_tasks[i] = t;
+  portEXIT_CRITICAL(&s_mux);
+}
+
+#if configUSE_TRACE_FACILITY
+// All tasks, with CPU share from the run-time counters when the FreeRTOS
+// build has them (configGENERATE_RUN_TIME_STATS)
+static void sample_tasks() {
+  static TaskStatus_t st[METRICS_MAX_TASKS];
+  static struct { UBaseType_t num; uint32_t rt; } prev[METRICS_MAX_TASKS];
+  static uint8_t  prevN     = 0;
+  static uint32_t prevTotal = 0;
+
+  uint32_t total = 0;
+  const UBaseType_t n = uxTaskGetSystemState(st, METRICS_MAX_TASKS, &total);
+  if (n == 0) {                                   // more tasks than slots
+    static bool warned = false;
+    if (!warned) LOGW("METRICS", "more than %u tasks, raise METRICS_MAX_TASKS", (unsigned)METRICS_MAX_TASKS);
+    warned = true;
+    return;
+  }
+
+  const uint32_t dTotal = total - prevTotal;
+  for (UBaseType_t i = 0; i < n; ++i) {
+    int8_t cpu = -1;
+#if configGENERATE_RUN_TIME_STATS
+    if (prevTotal != 0 && dTotal > 0) {
+      for (uint8_t k = 0; k < prevN; ++k) {
+        if (prev[k].num != st[i].xTaskNumber) continue;
+        cpu = (int8_t)((uint64_t)(st[i].ulRunTimeCounter - prev[k].rt) * 100u / dTotal);
+        break;
+      }
+    }
+#endif
+    store_task((uint8_t)i, st[i].pcTaskName, (uint32_t)st[i].usStackHighWaterMark, cpu);
+  }
+  for (UBaseType_t i = 0; i < n; ++i) prev[i] = { st[i].xTaskNumber, st[i].ulRunTimeCounter };
+  prevN     = (uint8_t)n;
+  prevTotal = total;
+
+  portENTER_CRITICAL(&s_mux);
+  s_taskCount = (uint8_t)n;
+  portEXIT_CRITICAL(&s_mux);
+}
+#else
+// No task list in this FreeRTOS build: our own tasks, by name
+static void sample_tasks() {
+  uint8_t n = 0;
+  for (const KnownTask& k : kKnownTasks) {
+    TaskHandle_t h = xTaskGetHandle(k.name);
+    if (!h || n >= METRICS_MAX_TASKS) continue;
+    store_task(n++, k.name, (uint32_t)uxTaskGetStackHighWaterMark(h), -1);
+  }
+  portENTER_CRITICAL(&s_mux);
+  s_taskCount = n;
+  portEXIT_CRITICAL(&s_mux);
+}
+#endif
+
+static void sample() {
+  metric_set(Gauge::UPTIME_S, (int32_t)(millis() / 1000));
+
+  HeapSnapshot hs;
+  heap_snapshot(hs);
+  metric_set(Gauge::HEAP_FREE,     (int32_t)hs.freeBytes);
+  metric_set(Gauge::HEAP_LARGEST,  (int32_t)hs.largestBlock);
+  metric_set(Gauge::HEAP_MIN_FREE, (int32_t)hs.minFree);
+  metric_set(Gauge::HEAP_FRAG_PCT, heap_frag_pct(hs));
+
+  WifiStats ws;
+  wifi_get_stats(ws);
+  metric_set(Gauge::WIFI_RSSI, (app_get_bits() & AppBits::NET_UP) ? ws.rssi : 0);
+
+  UploaderStats us;
+  uploader_get_stats(us);
+  metric_set(Gauge::UPLOAD_DEPTH,  (int32_t)us.depth);
+  metric_set(Gauge::SPOOL_BACKLOG, (int32_t)us.backlog);
+
+  LogStats ls;
+  log_get_stats(ls);
+  metric_set(Gauge::HX_DROPPED,    (int32_t)HX::droppedSamples());
+  metric_set(Gauge::LOG_DROPPED,   (int32_t)ls.dropped);
+  metric_set(Gauge::EVENT_DROPPED, (int32_t)event_dropped());
+
+  sample_tasks();
+}
+
+// ---- rendering ----
+
+void metrics_write(MetricSink sink, void* ctx) {
+  char label[40];
+
+  for (uint8_t i = 0; i < NC; ++i) sink(ctx, kCtrNames[i], "", s_ctr[i].load(std::memory_order_relaxed));
+  for (uint8_t i = 0; i < NG; ++i) sink(ctx, kGaugeNames[i], "", s_gauge[i].load(std::memory_order_relaxed));
+
+  // Mode bits (what app_debug_print used to show)
+  static const struct { EventBits_t bit; const char* name; } kBits[] = {
+    { AppBits::NET_UP, "NET_UP" }, { AppBits::TIME_VALID, "TIME_VALID" },
+    { AppBits::AP_MODE, "AP_MODE" }, { AppBits::POSTING, "POSTING" },
+    { AppBits::OTA_ACTIVE, "OTA" }, { AppBits::CALIB_ACTIVE, "CALIB" },
+  };
+  const EventBits_t bits = app_get_bits();
+  for (const auto& b : kBits) {
+    snprintf(label, sizeof(label), "bit=\"%s\"", b.name);
+    sink(ctx, "app_state", label, (bits & b.bit) ? 1 : 0);
+  }
+
+  for (uint8_t i = 0; i < (uint8_t)WakeSrc::COUNT; ++i) {
+    snprintf(label, sizeof(label), "task=\"%s\"", wake_name((WakeSrc)i));
+    sink(ctx, "wakeups_total", label, wake_count((WakeSrc)i));
+  }
+
+  portENTER_CRITICAL(&s_mux);
+  const uint8_t nTasks = s_taskCount;
+  portEXIT_CRITICAL(&s_mux);
+  for (uint8_t i = 0; i < nTasks; ++i) {
+    portENTER_CRITICAL(&s_mux);
+    const TaskSample t = s_tasks[i];
+    portEXIT_CRITICAL(&s_mux);
+    snprintf(label, sizeof(label), "task=\"%s\"", t.name);
+    sink(ctx, "task_stack_free_bytes", label, t.stackFree);
+    if (t.stackSize) sink(ctx, "task_stack_size_bytes", label, t.stackSize);
+    if (t.cpuPct >= 0) sink(ctx, "task_cpu_pct", label, t.cpuPct);
+  }
+
+  for (uint8_t h = 0; h < NH; ++h) {
+    HistSnapshot s;
+    metric_hist((Hist)h, s);
+    metric_write_hist(sink, ctx, kHistNames[h], s);
+  }
+
+  trace_write(sink, ctx);
+}
+
+static void serial_sink(void* ctx, const char* name, const char* label, int64_t value) {
+  uint16_t& lines = *(uint16_t*)ctx;
+  if (*label) LOGI("METRICS", "%s{%s} %lld", name, label, (long long)value);
+  else        LOGI("METRICS", "%s %lld", name, (long long)value);
+  if (++lines % (LOG_RING_SLOTS / 2) == 0) log_flush(1000);   // a dump is longer than the ring
+}
+
+void metrics_print() {
+  uint16_t lines = 0;
+  metrics_write(serial_sink, &lines);
+}
+
+// ---- task + serial console ----
+
+// Runs in the UART/USB driver's context: just wake the metrics task
+static void on_serial_rx() {
+  if (s_task) xTaskNotifyGive(s_task);
+}
+
+// Reads what arrived; a complete "metrics"/"m" line prints a dump
+static void poll_console() {
+  static char line[16];
+  static uint8_t len = 0;
+  while (Serial.available() > 0) {
+    const int c = Serial.read();
+    if (c < 0) break;
+    if (c != '\r' && c != '\n') {
+      if (len < sizeof(line) - 1) line[len++] = (char)c;
+      continue;
+    }
+    if (len == 0) continue;
+    line[len] = '\0';
+    len = 0;
+    if (strcmp(line, "metrics") == 0 || strcmp(line, "m") == 0) {
+      sample();
+      metrics_print();
+    } else if (strncmp(line, "slo ", 4) == 0 && atol(line + 4) > 0) {
+      trace_slo_set((uint32_t)atol(line + 4));
+    } else {
+      LOGI("METRICS", "unknown command '%s' (try: metrics, slo <ms>)", line);
+    }
+  }
+}
+
+void metrics_start() {
+  if (s_task) return;
+  sample();
+
+  BaseType_t ok = xTaskCreatePinnedToCore(
+    metricsTask,
+    "metrics",
+    TASK_STACK_METRICS,
+    nullptr,
+    TASK_PRIO_METRICS,
+    &s_task,
+    (TASK_CORE_METRICS < 0) ? tskNO_AFFINITY : TASK_CORE_METRICS
+  );
+  if (ok != pdPASS) {
+    s_task = nullptr;
+    LOGE("METRICS", "ERROR: task create failed");
+    return;
+  }
+
+#if ARDUINO_USB_CDC_ON_BOOT && ARDUINO_USB_MODE
+  Serial.onEvent(ARDUINO_HW_CDC_RX_EVENT, [](void*, esp_event_base_t, int32_t, void*) { on_serial_rx(); });
+#else
+  Serial.onReceive(on_serial_rx);
+#endif
+}
+
+static void metricsTask(void*) {
+  uint32_t lastSampleMs = millis();
+  for (;;) {
+    const uint32_t since = millis() - lastSampleMs;
+    const uint32_t wait  = since < METRICS_SAMPLE_MS ? METRICS_SAMPLE_MS - since : 0;
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait));     // sample period or console input
+    wake_note(WakeSrc::METRICS);
+
+    poll_console();
+    if (millis() - lastSampleMs >= METRICS_SAMPLE_MS) {
+      lastSampleMs = millis();
+      sample();
+      if (METRICS_HTTP_PORT && (app_get_bits() & AppBits::NET_UP)) metrics_http_start();   // once
+    }
+  }
+}
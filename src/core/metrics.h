@@ -0,0 +1,81 @@
+#pragma once
+#include <stdint.h>
+
+// Runtime metrics: counters, gauges and fixed-bucket latency histograms.
+//
+// Hot paths update them with a few relaxed atomics (no locks, any task).
+// A low-priority sampler task refreshes the system gauges every
+// METRICS_SAMPLE_MS: heap free/largest/min/fragmentation, Wi-Fi RSSI,
+// queue and drop counts, plus per-task stack high-water marks and CPU
+// share (when FreeRTOS run-time stats are compiled in).
+//
+// Everything is rendered one "name{label} value" line at a time, in
+// Prometheus text format (histograms also get _p50/_p90/_p99 lines; the
+// text itself is core/metric_text.h):
+//   - serial: type "metrics" (or "m") + Enter → "[METRICS] ..." lines;
+//     "slo <ms>" sets the latency SLO (features/latency_trace.h)
+//   - HTTP:   GET http://<device>:METRICS_HTTP_PORT/metrics (net/metrics_http.h)
+
+enum class Ctr : uint8_t {
+  MEAS_EMITTED,     // weights handed to the uploader
+  POST_OK,          // records the server accepted
+  POST_FAIL,        // records a send attempt did not deliver
+  COUNT
+};
+
+enum class Gauge : uint8_t {            // filled by the sampler
+  UPTIME_S,
+  HEAP_FREE,
+  HEAP_LARGEST,
+  HEAP_MIN_FREE,
+  HEAP_FRAG_PCT,
+  WIFI_RSSI,        // dBm at the last Wi-Fi check, 0 = not connected
+  UPLOAD_DEPTH,
+  SPOOL_BACKLOG,
+  HX_DROPPED,
+  LOG_DROPPED,
+  EVENT_DROPPED,
+  COUNT
+};
+
+enum class Hist : uint8_t {
+  POST_MS,          // one transport send (single or batch)
+  HTTP_CONNECT_MS,  // fresh TCP + TLS handshake
+  // Measurement trace stages (features/latency_trace.h)
+  LAT_FILTER_MS,    // ADC sample with the change → filter output crossing the trigger
+  LAT_STABLE_MS,    // load change detected → stable (or early estimate)
+  LAT_FINAL_MS,     // stable → final value computed
+  LAT_ENQUEUE_MS,   // final value → in the upload queue
+  LAT_QUEUE_MS,     // queued → (last) send started, incl. offline/backoff
+  LAT_SEND_MS,      // send started → server ack
+  LAT_TOTAL_MS,     // ADC sample with the change → server ack
+  COUNT
+};
+
+// Upper bounds (ms) of the histogram buckets; one more bucket is +Inf
+static constexpr uint8_t  METRIC_BUCKETS = 15;
+static constexpr uint32_t METRIC_BUCKET_LE[METRIC_BUCKETS] = {
+  1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 30000, 60000
+};
+
+struct HistSnapshot {
+  uint32_t bucket[METRIC_BUCKETS + 1];  // per bucket, not cumulative
+  uint32_t count;
+  uint32_t sumMs;
+  uint32_t maxMs;
+};
+
+void metric_inc(Ctr c, uint32_t n = 1);
+void metric_set(Gauge g, int32_t v);
+void metric_observe(Hist h, uint32_t ms);
+
+uint32_t metric_get(Ctr c);
+int32_t  metric_get(Gauge g);
+void     metric_hist(Hist h, HistSnapshot& out);
+
+// One sample line; 'label' is "" or e.g. task="wifi"
+typedef void (*MetricSink)(void* ctx, const char* name, const char* label, int64_t value);
+void metrics_write(MetricSink sink, void* ctx);
+
+void metrics_start();   // sampler task + serial console
+void metrics_print();   // all metrics as "[METRICS]" log lines
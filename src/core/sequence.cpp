@@ -0,0 +1,58 @@
+#include "sequence.h"
+#include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "app_config.h"
+#include "storage/nvs_store.h"
+#include "util/log.h"
+
+static constexpr const char* KEY_SEQ_HI = "seq_hi";
+static constexpr const char* KEY_BOOTS  = "boot_cnt";
+
+static SemaphoreHandle_t s_mtx = nullptr;
+static uint32_t s_next  = 1;     // next number to hand out
+static uint32_t s_limit = 1;     // first number NOT covered by the reservation
+static uint32_t s_boot  = 0;
+
+// Persist a new reservation; on failure keep going in RAM (a reboot may
+// then repeat numbers, which the server treats as duplicates → logged).
+static void reserve_block() {
+  const uint32_t hi = s_limit + SEQ_BLOCK;
+  if (!nvs_save_u32(KEY_SEQ_HI, hi)) {
+    LOGE("SEQ", "ERROR: failed to persist seq reservation");
+  }
+  s_limit = hi;
+}
+
+void seq_init() {
+  if (!s_mtx) s_mtx = xSemaphoreCreateMutex();
+
+  uint32_t boots = 0;
+  (void)nvs_load_u32(KEY_BOOTS, boots);
+  s_boot = boots + 1;
+  if (!nvs_save_u32(KEY_BOOTS, s_boot)) {
+    LOGE("SEQ", "ERROR: failed to persist boot count");
+  }
+
+  uint32_t hi = 1;
+  (void)nvs_load_u32(KEY_SEQ_HI, hi);
+  s_next  = hi;
+  s_limit = hi;
+  reserve_block();
+
+  LOGI("SEQ", "boot=%lu, seq starts at %lu (reserved to %lu)",
+       (unsigned long)s_boot, (unsigned long)s_next, (unsigned long)s_limit);
+}
+
+uint32_t seq_next() {
+  if (!s_mtx) return 0;                        // seq_init() not called
+  xSemaphoreTake(s_mtx, portMAX_DELAY);
+  if (s_next >= s_limit) reserve_block();
+  const uint32_t v = s_next++;
+  xSemaphoreGive(s_mtx);
+  return v;
+}
+
+uint32_t seq_boot_id() {
+  return s_boot;
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include <stdint.h>
+
+// Per-device record sequence numbers that keep increasing across reboots,
+// plus a boot counter. Together with the MAC they form the dedupe key the
+// server uses for weights and finish events: retries and resends of the
+// same record always carry the same (seq, boot).
+//
+// NVS is not written per record: a block of SEQ_BLOCK numbers is reserved
+// at a time ("seq_hi" = first number not yet handed out by any boot).
+// A reboot skips the unused rest of the block, which is fine for dedupe.
+
+// Load counters, bump the boot count. Call once after nvs_init().
+void seq_init();
+
+// Next sequence number (thread safe; touches NVS once per SEQ_BLOCK calls).
+uint32_t seq_next();
+
+// This boot's number (1, 2, ...), 0 before seq_init().
+uint32_t seq_boot_id();
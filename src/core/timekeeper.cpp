@@ -7,6 +7,9 @@
 
 #include "app_config.h"
 #include "core/app_state.h"
+#include "core/event_bus.h"
+#include "core/wake_stats.h"
+#include "util/log.h"
 
 static void timeTask(void*);
 
@@ -54,46 +57,47 @@ static void print_times(const char* tag) {
   char utc[40];
   strftime(utc, sizeof(utc), "%Y-%m-%d %H:%M:%S UTC", &ut);
 
-  Serial.printf("[Time] %s  Local=%s  UTC=%s\r\n", tag, loc, utc);
+  LOGI("Time", "%s  Local=%s  UTC=%s", tag, loc, utc);
 }
 
 static void timeTask(void*) {
-
-  bool lastNet = false;
-  uint32_t lastSyncMs = 0;  // 0 = never synced in this boot
+  // Only NET_OFFLINE matters while online; NET_UP itself is waited on as a bit
+  EventSub sub = event_subscribe(event_bit(EventType::NET_OFFLINE), 4);
 
   for (;;) {
-    const bool netUp = (app_get_bits() & AppBits::NET_UP) != 0;
-    const uint32_t nowMs = millis();
-
-    if (netUp && !lastNet) {
-      // Just came online → try NTP
-      Serial.println("[Time] NET_UP: syncing NTP...");
-      if (waitForTime(NTP_SYNC_TIMEOUT_MS)) {
-        app_set_bits(AppBits::TIME_VALID);
-        lastSyncMs = nowMs;
-        print_times("Sync OK.");
-      }
+    // Offline: sleep until the network is up (no polling)
+    wake_note(WakeSrc::TIME);
+    app_wait_bits(AppBits::NET_UP, portMAX_DELAY);
+    Event ev;
+    while (event_receive(sub, ev, 0)) {}   // OFFLINE edges from earlier flaps are stale now
+
+    // Just came online → try NTP
+    LOGI("Time", "NET_UP: syncing NTP...");
+    if (waitForTime(NTP_SYNC_TIMEOUT_MS)) {
+      app_set_bits(AppBits::TIME_VALID);
+      print_times("Sync OK.");
     }
 
-    if (!netUp && lastNet) {
-      // Lost network → mark time as potentially invalid
-      app_clear_bits(AppBits::TIME_VALID);
-      Serial.println("[Time] NET_DOWN: time marked invalid.");
-    }
+    // Online: wake for the periodic resync or when the network goes away
+    for (;;) {
+      if (event_receive(sub, ev, pdMS_TO_TICKS(TIME_RESYNC_INTERVAL_MS))) {
+        wake_note(WakeSrc::TIME);
+        if (ev.type != EventType::NET_OFFLINE) continue;
+        // Lost network → mark time as potentially invalid
+        app_clear_bits(AppBits::TIME_VALID);
+        LOGI("Time", "NET_DOWN: time marked invalid.");
+        break;
+      }
 
-    // Periodic resync while online
-    if (netUp && (nowMs - lastSyncMs >= TIME_RESYNC_INTERVAL_MS)) {
-      Serial.println("[Time] Periodic NTP resync...");
+      // Periodic resync while online
+      wake_note(WakeSrc::TIME);
+      if (!(app_get_bits() & AppBits::NET_UP)) continue;   // the OFFLINE event is queued
+      LOGI("Time", "Periodic NTP resync...");
       if (waitForTime(NTP_SYNC_TIMEOUT_MS)) {
         app_set_bits(AppBits::TIME_VALID);
-        lastSyncMs = nowMs;
         print_times("Resync OK.");
       }
     }
-
-    lastNet = netUp;
-    vTaskDelay(pdMS_TO_TICKS(500));
   }
 }
 
@@ -1,10 +1,10 @@
 #pragma once
 
 // Starts a background task that:
-// - waits for NET_UP,
+// - blocks until NET_UP,
 // - runs NTP sync,
-// - sets AppBits::TIME_VALID on success, clears it on loss of Wi-Fi,
-// - re-checks on re-connects.
+// - sets AppBits::TIME_VALID on success, clears it on NET_OFFLINE (event bus),
+// - re-checks on re-connects and every TIME_RESYNC_INTERVAL_MS.
 void timekeeper_start();
 
 // Simple helper to check if time is valid
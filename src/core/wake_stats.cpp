@@ -0,0 +1,55 @@
+#include "wake_stats.h"
+#include <Arduino.h>
+#include <atomic>
+#include "freertos/FreeRTOS.h"
+#include "freertos/timers.h"
+#include "app_config.h"
+#include "util/log.h"
+
+static constexpr uint8_t N = (uint8_t)WakeSrc::COUNT;
+static const char* const kNames[N] = {
+  "sensor", "upload", "wifi", "time", "ui", "buttons", "btn_handler", "metrics"
+};
+
+static std::atomic<uint32_t> s_count[N];
+static uint32_t              s_last[N];       // timer callback only
+static uint32_t              s_lastMs = 0;
+static TimerHandle_t         s_timer  = nullptr;
+
+void wake_note(WakeSrc src) {
+  s_count[(uint8_t)src].fetch_add(1, std::memory_order_relaxed);
+}
+
+uint32_t wake_count(WakeSrc src) {
+  return s_count[(uint8_t)src].load(std::memory_order_relaxed);
+}
+
+const char* wake_name(WakeSrc src) {
+  return (uint8_t)src < N ? kNames[(uint8_t)src] : "?";
+}
+
+static void log_rates(TimerHandle_t) {
+  const uint32_t now = millis();
+  const uint32_t dt  = now - s_lastMs;
+  s_lastMs = now;
+  if (dt == 0) return;
+
+  char line[160];
+  int len = snprintf(line, sizeof(line), "/s:");
+  for (uint8_t i = 0; i < N && len > 0 && len < (int)sizeof(line); ++i) {
+    const uint32_t c = s_count[i].load(std::memory_order_relaxed);
+    const uint32_t per10 = (uint32_t)(((uint64_t)(c - s_last[i]) * 10000u) / dt);   // 0.1/s units
+    s_last[i] = c;
+    len += snprintf(line + len, sizeof(line) - len, " %s=%lu.%lu", kNames[i],
+                    (unsigned long)(per10 / 10), (unsigned long)(per10 % 10));
+  }
+  LOGI("WAKE", "%s", line);
+}
+
+void wake_stats_start() {
+  if (WAKE_LOG_MS == 0 || s_timer) return;
+  s_lastMs = millis();
+  for (uint8_t i = 0; i < N; ++i) s_last[i] = s_count[i].load(std::memory_order_relaxed);
+  s_timer = xTimerCreate("wake", pdMS_TO_TICKS(WAKE_LOG_MS), pdTRUE, nullptr, log_rates);
+  if (s_timer) xTimerStart(s_timer, 0);
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <stdint.h>
+
+// Per-task wakeup counters: each task loop notes one wakeup per pass, so
+// polling shows up as a fixed rate and event-driven tasks as ~0 when idle.
+// wake_stats_start() logs the rates every WAKE_LOG_MS from a FreeRTOS
+// timer (no extra task):
+//   [WAKE] /s: sensor=80.0 upload=0.0 wifi=0.2 time=0.0 ui=40.0 ...
+
+enum class WakeSrc : uint8_t {
+  SENSOR,
+  UPLOAD,
+  WIFI,
+  TIME,
+  UI,
+  BUTTONS,
+  BTN_HANDLER,
+  METRICS,
+  COUNT
+};
+
+void wake_note(WakeSrc src);          // any task; one atomic add
+void wake_stats_start();              // no-op when WAKE_LOG_MS == 0
+
+// Wakeups since boot
+uint32_t wake_count(WakeSrc src);
+const char* wake_name(WakeSrc src);
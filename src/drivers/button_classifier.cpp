@@ -0,0 +1,96 @@
+#include "button_classifier.h"
+
+// a before-or-at b on a wrapping millis() clock
+static inline bool due(uint32_t a, uint32_t b) { return (int32_t)(a - b) <= 0; }
+
+void ButtonClassifier::reset(bool pressed1, bool pressed2, uint32_t nowMs) {
+  const bool p[2] = { pressed1, pressed2 };
+  for (uint8_t i = 0; i < 2; ++i) {
+    b[i].raw = b[i].deb = p[i];
+    b[i].changeMs = nowMs;
+    b[i].downMs   = nowMs;
+  }
+  bothFired = false;
+  swallow   = false;
+}
+
+uint32_t ButtonClassifier::bothAt() const {
+  const uint32_t later = due(b[0].downMs, b[1].downMs) ? b[1].downMs : b[0].downMs;
+  return later + cfg.longPressMs;
+}
+
+// Earliest settle / BOTH_LONG deadline at or before 'nowMs'
+bool ButtonClassifier::nextDue(uint32_t nowMs, uint32_t& at) const {
+  bool found = false;
+  auto consider = [&](uint32_t t) {
+    if (due(t, nowMs) && (!found || !due(at, t))) { at = t; found = true; }
+  };
+  for (uint8_t i = 0; i < 2; ++i) {
+    if (settlePending(b[i])) consider(settleAt(b[i]));
+  }
+  if (bothPending()) consider(bothAt());
+  return found;
+}
+
+void ButtonClassifier::push(Events& out, ButtonEventType t) {
+  if (out.n < MAX_EVENTS) out.type[out.n++] = t;
+}
+
+// One step at 'at', in the order of the polled loop: debounce both
+// buttons, then press/release, then the BOTH_LONG bookkeeping. Buttons
+// settling at the same instant are seen together (a hand-over from one
+// button to the other keeps swallowing singles).
+void ButtonClassifier::step(uint32_t at, Events& out) {
+  bool changed[2] = { false, false };
+  for (uint8_t i = 0; i < 2; ++i) {
+    if (settlePending(b[i]) && settleAt(b[i]) == at) { b[i].deb = b[i].raw; changed[i] = true; }
+  }
+
+  for (uint8_t i = 0; i < 2; ++i) {
+    if (!changed[i]) continue;
+    if (b[i].deb) { b[i].downMs = at; continue; }
+    if (swallow) continue;
+    const uint32_t dur = at - b[i].downMs;
+    if (dur >= cfg.longPressMs)     push(out, i ? ButtonEventType::BTN2_LONG  : ButtonEventType::BTN1_LONG);
+    else if (dur >= cfg.shortMinMs) push(out, i ? ButtonEventType::BTN2_SHORT : ButtonEventType::BTN1_SHORT);
+  }
+
+  if (b[0].deb && b[1].deb) {
+    if (bothPending() && due(bothAt(), at)) {
+      push(out, ButtonEventType::BOTH_LONG);
+      bothFired = true;
+      swallow   = true;
+      b[0].downMs = b[1].downMs = at;   // the presses are consumed
+    }
+  } else {
+    bothFired = false;
+    if (!b[0].deb && !b[1].deb) swallow = false;   // singles count again
+  }
+}
+
+void ButtonClassifier::update(uint32_t nowMs, Events& out) {
+  uint32_t at;
+  while (nextDue(nowMs, at)) step(at, out);
+}
+
+void ButtonClassifier::edge(uint8_t btn, bool pressed, uint32_t ms, Events& out) {
+  if (btn > 1) return;
+  update(ms - 1, out);              // an edge at a settle instant restarts the debounce
+  Btn& x = b[btn];
+  if (pressed == x.raw) return;     // lost/duplicate edge: level unchanged
+  x.raw      = pressed;
+  x.changeMs = ms;
+}
+
+uint32_t ButtonClassifier::nextDueMs(uint32_t nowMs) const {
+  uint32_t best = IDLE;
+  auto consider = [&](uint32_t t) {
+    const uint32_t left = due(t, nowMs) ? 0 : t - nowMs;
+    if (left < best) best = left;
+  };
+  for (uint8_t i = 0; i < 2; ++i) {
+    if (settlePending(b[i])) consider(settleAt(b[i]));
+  }
+  if (bothPending()) consider(bothAt());
+  return best;
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <stdint.h>
+
+// Two-button debounce + short/long/BOTH_LONG classification, driven by
+// timestamped edges instead of periodic sampling (no Arduino/RTOS deps).
+//
+// Semantics match the old 10 ms polling loop:
+//   - a level counts once it has been stable for debounceMs,
+//   - BTNx_SHORT / BTNx_LONG are emitted on release (duration between the
+//     debounced press and release; shorter than shortMinMs = ignored),
+//   - BOTH_LONG fires while both are held longPressMs (counted from the
+//     later press); singles are then swallowed until both are released.
+// Time only matters at the debounce settle points and the BOTH_LONG
+// deadline: nextDueMs() says when update() has work, so the caller can
+// sleep until the next edge or that deadline.
+
+enum class ButtonEventType : uint8_t {
+  NONE = 0,
+  BTN1_SHORT,
+  BTN2_SHORT,
+  BTN1_LONG,
+  BTN2_LONG,
+  BOTH_LONG
+};
+
+class ButtonClassifier {
+public:
+  static constexpr uint32_t IDLE = 0xFFFFFFFFu;   // nextDueMs(): nothing pending
+  static constexpr uint8_t  MAX_EVENTS = 4;       // per edge()/update() call
+
+  struct Config {
+    uint16_t debounceMs;
+    uint16_t shortMinMs;
+    uint16_t longPressMs;
+  };
+
+  struct Events {
+    ButtonEventType type[MAX_EVENTS];
+    uint8_t         n = 0;
+  };
+
+  explicit ButtonClassifier(const Config& cfg) : cfg(cfg) {}
+
+  // Current (raw) levels at start; held buttons count as pressed since nowMs
+  void reset(bool pressed1, bool pressed2, uint32_t nowMs);
+
+  // Raw level of button 0/1 changed at 'ms'. Anything due before 'ms' is
+  // processed first. Timestamps must be non-decreasing (wrap-safe).
+  void edge(uint8_t btn, bool pressed, uint32_t ms, Events& out);
+
+  // Process everything due up to 'nowMs'
+  void update(uint32_t nowMs, Events& out);
+
+  // Milliseconds from 'nowMs' until update() has work (0 = now), or IDLE
+  uint32_t nextDueMs(uint32_t nowMs) const;
+
+  bool pressed(uint8_t btn) const { return b[btn].deb; }
+
+private:
+  struct Btn {
+    bool     raw      = false;   // last edge level
+    bool     deb      = false;   // debounced level
+    uint32_t changeMs = 0;       // time of the last raw edge
+    uint32_t downMs   = 0;       // debounced press time
+  };
+
+  bool settlePending(const Btn& x) const { return x.raw != x.deb; }
+  uint32_t settleAt(const Btn& x) const  { return x.changeMs + cfg.debounceMs; }
+  bool bothPending() const { return b[0].deb && b[1].deb && !bothFired; }
+  uint32_t bothAt() const;
+
+  bool nextDue(uint32_t nowMs, uint32_t& at) const;
+  void step(uint32_t at, Events& out);
+  static void push(Events& out, ButtonEventType t);
+
+  Config cfg;
+  Btn    b[2];
+  bool   bothFired = false;
+  bool   swallow   = false;   // BOTH_LONG fired: no singles until both released
+};
@@ -1,8 +1,18 @@
 #include "button_driver.h"
 #include "app_config.h"
+#include "core/wake_stats.h"
+
+// Raw edge captured in the ISR; all timing logic runs in the task
+struct Edge {
+  uint8_t  btn;
+  uint8_t  level;     // digitalRead() right after the edge
+  uint32_t ms;
+};
 
 static ButtonDriverConfig s_cfg{};
-static QueueHandle_t s_evtq = nullptr;
+static QueueHandle_t s_evtq  = nullptr;
+static QueueHandle_t s_edgeq = nullptr;
+static volatile bool s_edgeLost = false;    // ISR queue overflowed → resample pins
 
 static void buttonsTask(void*);
 
@@ -11,6 +21,16 @@ static inline bool physPressed(int pin, bool activeLow) {
   return activeLow ? (v == LOW) : (v == HIGH);
 }
 
+static inline void IRAM_ATTR push_edge(uint8_t btn, int pin) {
+  const Edge e{ btn, (uint8_t)digitalRead(pin), (uint32_t)millis() };
+  BaseType_t woken = pdFALSE;
+  if (xQueueSendToBackFromISR(s_edgeq, &e, &woken) != pdPASS) s_edgeLost = true;
+  if (woken) portYIELD_FROM_ISR();
+}
+
+static void IRAM_ATTR onEdge1() { push_edge(0, s_cfg.pin1); }
+static void IRAM_ATTR onEdge2() { push_edge(1, s_cfg.pin2); }
+
 bool buttons_start(const ButtonDriverConfig& cfg) {
   s_cfg = cfg;
 
@@ -21,6 +41,10 @@ bool buttons_start(const ButtonDriverConfig& cfg) {
     s_evtq = xQueueCreate(8, sizeof(ButtonEvent));
     if (!s_evtq) return false;
   }
+  if (!s_edgeq) {
+    s_edgeq = xQueueCreate(BTN_EDGE_Q_LEN, sizeof(Edge));
+    if (!s_edgeq) return false;
+  }
 
   BaseType_t ok = xTaskCreatePinnedToCore(
     buttonsTask,
@@ -43,82 +67,52 @@ bool buttons_get_event(ButtonEvent& out, TickType_t waitTicks) {
 
 static void emit(ButtonEventType type) {
   if (!s_evtq || type == ButtonEventType::NONE) return;
-  ButtonEvent ev{ type, millis() };
+  ButtonEvent ev{ type, (uint32_t)millis() };
   xQueueSendToBack(s_evtq, &ev, 0);
 }
 
-static void buttonsTask(void*) {
-  // Debounce state
-  bool lastRaw1 = physPressed(s_cfg.pin1, s_cfg.activeLow);
-  bool lastRaw2 = physPressed(s_cfg.pin2, s_cfg.activeLow);
-  bool deb1 = lastRaw1, deb2 = lastRaw2;
-  uint32_t lastChange1 = millis(), lastChange2 = millis();
+static void emit_all(const ButtonClassifier::Events& evs) {
+  for (uint8_t i = 0; i < evs.n; ++i) emit(evs.type[i]);
+}
 
-  // Press timing
-  bool pressed1 = deb1, pressed2 = deb2;
-  uint32_t downMs1 = pressed1 ? lastChange1 : 0;
-  uint32_t downMs2 = pressed2 ? lastChange2 : 0;
+static bool level_pressed(uint8_t level) {
+  return s_cfg.activeLow ? (level == LOW) : (level == HIGH);
+}
 
-  // BOTH_LONG detection
-  bool bothLongFired = false;
-  bool swallowSingles = false;   // NEW
+static void buttonsTask(void*) {
+  ButtonClassifier cls({ s_cfg.debounceMs, s_cfg.shortMinMs, s_cfg.longPressMs });
+  const int pins[2] = { s_cfg.pin1, s_cfg.pin2 };
 
-  const TickType_t tick = pdMS_TO_TICKS(10);
+  // Interrupts first, then the initial levels: an edge in between is just
+  // a duplicate the classifier ignores
+  attachInterrupt(digitalPinToInterrupt(s_cfg.pin1), onEdge1, CHANGE);
+  attachInterrupt(digitalPinToInterrupt(s_cfg.pin2), onEdge2, CHANGE);
+  cls.reset(physPressed(pins[0], s_cfg.activeLow), physPressed(pins[1], s_cfg.activeLow), millis());
 
   for (;;) {
-    const bool raw1 = physPressed(s_cfg.pin1, s_cfg.activeLow);
-    const bool raw2 = physPressed(s_cfg.pin2, s_cfg.activeLow);
-    const uint32_t now = millis();
-
-    // Debounce BTN1
-    if (raw1 != lastRaw1) { lastRaw1 = raw1; lastChange1 = now; }
-    if ((now - lastChange1) >= s_cfg.debounceMs) deb1 = raw1;
-
-    // Debounce BTN2
-    if (raw2 != lastRaw2) { lastRaw2 = raw2; lastChange2 = now; }
-    if ((now - lastChange2) >= s_cfg.debounceMs) deb2 = raw2;
-
-    // Track press/release + durations
-    if (deb1 && !pressed1) { pressed1 = true;  downMs1 = now; }
-    if (!deb1 && pressed1) {
-      uint32_t dur = now - downMs1;
-      if (!swallowSingles) {   // NEW: ignore if BOTH_LONG fired
-        if (dur >= s_cfg.longPressMs) emit(ButtonEventType::BTN1_LONG);
-        else if (dur >= s_cfg.shortMinMs) emit(ButtonEventType::BTN1_SHORT);
-      }
-      pressed1 = false;
-    }
-
-    if (deb2 && !pressed2) { pressed2 = true;  downMs2 = now; }
-    if (!deb2 && pressed2) {
-      uint32_t dur = now - downMs2;
-      if (!swallowSingles) {   // NEW: ignore if BOTH_LONG fired
-        if (dur >= s_cfg.longPressMs) emit(ButtonEventType::BTN2_LONG);
-        else if (dur >= s_cfg.shortMinMs) emit(ButtonEventType::BTN2_SHORT);
-      }
-      pressed2 = false;
+    // Sleep until an edge, or until a debounce / BOTH_LONG deadline is due
+    const uint32_t dueMs = cls.nextDueMs(millis());
+    const TickType_t wait = (dueMs == ButtonClassifier::IDLE) ? portMAX_DELAY : pdMS_TO_TICKS(dueMs) + 1;
+
+    Edge e;
+    if (xQueueReceive(s_edgeq, &e, wait) == pdPASS) {
+      do {
+        ButtonClassifier::Events evs;
+        cls.edge(e.btn, level_pressed(e.level), e.ms, evs);
+        emit_all(evs);
+      } while (xQueueReceive(s_edgeq, &e, 0) == pdPASS);
     }
-
-    // BOTH_LONG: both held continuously >= longPressMs
-    if (deb1 && deb2) {
-      const uint32_t bothDownSince = (downMs1 > downMs2) ? downMs1 : downMs2;
-      if (!bothLongFired && (now - bothDownSince) >= s_cfg.longPressMs) {
-        emit(ButtonEventType::BOTH_LONG);
-        bothLongFired = true;
-        swallowSingles = true;    // NEW: block single events until release
-        // consume individual events
-        pressed1 = false;
-        pressed2 = false;
-        downMs1 = now;
-        downMs2 = now;
-      }
-    } else {
-      bothLongFired = false;
-      if (!deb1 && !deb2) {
-        swallowSingles = false;  // NEW: re-enable singles once both released
-      }
+    wake_note(WakeSrc::BUTTONS);
+
+    // Dropped edges: the queue is only short while a contact bounces hard;
+    // read the real levels so the debounced state cannot get stuck
+    ButtonClassifier::Events evs;
+    if (s_edgeLost) {
+      s_edgeLost = false;
+      const uint32_t now = millis();
+      for (uint8_t i = 0; i < 2; ++i) cls.edge(i, physPressed(pins[i], s_cfg.activeLow), now, evs);
     }
-
-    vTaskDelay(tick);
+    cls.update(millis(), evs);
+    emit_all(evs);
   }
 }
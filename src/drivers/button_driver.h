@@ -2,15 +2,7 @@
 #include <Arduino.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/queue.h"
-
-enum class ButtonEventType : uint8_t {
-  NONE = 0,
-  BTN1_SHORT,
-  BTN2_SHORT,
-  BTN1_LONG,
-  BTN2_LONG,
-  BOTH_LONG
-};
+#include "drivers/button_classifier.h"   // ButtonEventType
 
 struct ButtonEvent {
   ButtonEventType type;
@@ -26,7 +18,9 @@ struct ButtonDriverConfig {
   uint16_t longPressMs;     // long press threshold, e.g., 2000
 };
 
-// Start the background task (creates internal queue). Returns false on failure.
+// Start the background task (creates internal queues, attaches CHANGE
+// interrupts on both pins). Returns false on failure. The task sleeps until
+// an edge arrives or a debounce / long-press deadline is due.
 bool buttons_start(const ButtonDriverConfig& cfg);
 
 // Pop next event; wait up to waitTicks. Returns true if an event was received.
@@ -1,58 +1,233 @@
 #include "hx711_driver.h"
-#include <HX711.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include "app_config.h"
+#include "hal/clock.h"
+#include "hal/gpio.h"
+#include "hal/hx711_port.h"
+#include "util/spsc_ring.h"
+#include "util/log.h"
 
-static HX711 s_hx;
 static bool  s_inited = false;
+static WeightScale s_scale;          // offset (tare) + mg/count
+static float s_countsPerG = 1.0f;    // legacy float factor for getUnits()
+static int   s_doutPin = -1;
+
+// Serialises every clocking of the chip (blocking helpers vs. async reader)
+static SemaphoreHandle_t s_busMtx = nullptr;
+
+// ---- Async acquisition state ----
+static SpscRing<HX::RawSample, HX_RING_LEN> s_ring;
+static TaskHandle_t      s_reader     = nullptr;
+static SemaphoreHandle_t s_dataSem    = nullptr;   // given after each push
+static volatile bool     s_clocking   = false;     // DOUT toggles while we shift
+static volatile bool     s_asyncStop  = false;
+static volatile uint32_t s_dropped    = 0;
+static volatile uint32_t s_readCount  = 0;
+
+struct BusLock {
+  BusLock()  { if (s_busMtx) xSemaphoreTake(s_busMtx, portMAX_DELAY); }
+  ~BusLock() { if (s_busMtx) xSemaphoreGive(s_busMtx); }
+};
+
+static long clockOut() {
+  s_clocking = true;
+  long v = hal_hx711_read();   // blocks until ready
+  s_clocking = false;
+  return v;
+}
+
+// DOUT falling edge = conversion ready. Just wake the reader; the 25 SCK
+// pulses are clocked out at task level so the ISR stays a few instructions.
+static void IRAM_ATTR onDoutFall() {
+  if (s_clocking || !s_reader) return;
+  BaseType_t woken = pdFALSE;
+  vTaskNotifyGiveFromISR(s_reader, &woken);
+  if (woken) portYIELD_FROM_ISR();
+}
+
+static void readerTask(void*) {
+  // Fallback wake-up in case an edge is lost (e.g. while a blocking helper
+  // owned the bus): ≥ 2 conversion periods even at 10 SPS.
+  const TickType_t idle = pdMS_TO_TICKS(250);
+
+  while (!s_asyncStop) {
+    ulTaskNotifyTake(pdTRUE, idle);
+    if (s_asyncStop) break;
+
+    // Drain: the next conversion may already be waiting once we got the bus
+    while (!hal_gpio_read(s_doutPin)) {
+      HX::RawSample smp;
+      {
+        BusLock lock;
+        if (hal_gpio_read(s_doutPin)) break;  // a blocking helper took it
+        smp.us  = hal_micros();
+        smp.raw = (int32_t)clockOut();
+      }
+      s_readCount++;
+      if (!s_ring.push(smp)) {
+        s_dropped++;
+      } else if (s_dataSem) {
+        xSemaphoreGive(s_dataSem);
+      }
+    }
+  }
+
+  s_reader = nullptr;
+  vTaskDelete(nullptr);
+}
+
+// Caller holds the bus
+static long averageLocked(uint16_t samples) {
+  long sum = 0;
+  for (uint16_t i = 0; i < samples; ++i) { sum += clockOut(); }
+  return sum / (long)samples;
+}
 
 namespace HX {
 
 bool init(int dout_pin, int sck_pin, uint8_t gain) {
-  s_hx.begin(dout_pin, sck_pin, gain);
+  if (!s_busMtx) s_busMtx = xSemaphoreCreateMutex();
+  s_doutPin = dout_pin;
+  hal_hx711_begin(dout_pin, sck_pin, gain);
   // quick readiness probe (up to ~1s)
-  unsigned long t0 = millis();
-  while (!s_hx.is_ready() && (millis() - t0) < 1000) { vTaskDelay(pdMS_TO_TICKS(5));; }
-  s_inited = s_hx.is_ready();
+  const uint32_t t0 = hal_millis();
+  while (!hal_hx711_ready() && (hal_millis() - t0) < 1000) { hal_delay_ms(5); }
+  s_inited = hal_hx711_ready();
   return s_inited;
 }
 
+void setRate(int ratePin, bool fast) {
+  if (ratePin < 0) return;
+  hal_gpio_output(ratePin);
+  hal_gpio_write(ratePin, fast);
+  // the chip restarts conversion on rate change; first sample settles in 4 periods
+}
+
 bool isReady() {
-  return s_inited && s_hx.is_ready();
+  return s_inited && hal_hx711_ready();
 }
 
 bool tare(uint16_t samples) {
-  if (!s_inited) return false;
-  s_hx.tare(samples);  // library captures offset internally
+  if (!s_inited || samples == 0) return false;
+  BusLock lock;
+  s_scale.offset = (int32_t)averageLocked(samples);
   return true;
 }
 
 void setCalibrationFactor(float scale) {
-  // In bogde/HX711: units = (raw_avg - offset) / scale
+  // units = (raw_avg - offset) / scale
   // If your known mass is W grams and delta counts is D, then scale = D / W
-  s_hx.set_scale(scale);
+  s_countsPerG = scale;
+  s_scale.mgPerCountQ16 = weight_scale_from_counts_per_g(scale);
 }
 
 float getCalibrationFactor() {
-  return s_hx.get_scale();
+  return s_countsPerG;
 }
 
 float getUnits(uint16_t samples) {
   if (!s_inited) {
-    Serial.println("[HX] getUnits() called before init!");
+    LOGE("HX", "getUnits() called before init!");
   return 0.0f;
 }
-  return s_hx.get_units(samples);
+  if (samples == 0 || s_countsPerG == 0.0f) return 0.0f;
+  BusLock lock;
+  return (float)(averageLocked(samples) - s_scale.offset) / s_countsPerG;
+}
+
+void setScaleQ16(int32_t mgPerCountQ16) {
+  if (mgPerCountQ16 == 0) return;
+  s_scale.mgPerCountQ16 = mgPerCountQ16;
+  s_countsPerG = weight_scale_to_counts_per_g(mgPerCountQ16);  // keep getUnits() in step
+}
+
+int32_t getScaleQ16() { return s_scale.mgPerCountQ16; }
+
+int32_t getOffset() { return s_scale.offset; }
+
+int32_t rawToMg(int32_t raw) { return weight_raw_to_mg(raw, s_scale); }
+
+int32_t getMilligrams(uint16_t samples) {
+  if (!s_inited || samples == 0) return 0;
+  return weight_raw_to_mg((int32_t)readRawAverage(samples), s_scale);
 }
 
 long readRaw() {
   if (!s_inited) return 0;
-  return s_hx.read(); // blocks until ready
+  BusLock lock;
+  return clockOut();
 }
 
 long readRawAverage(uint16_t samples) {
   if (!s_inited || samples == 0) return 0;
-  long sum = 0;
-  for (uint16_t i = 0; i < samples; ++i) { sum += s_hx.read(); }
-  return sum / (long)samples;
+  BusLock lock;
+  return averageLocked(samples);
+}
+
+// ---- Async acquisition ----
+
+bool startAsync() {
+  if (!s_inited) return false;
+  if (s_reader) return true;
+
+  if (!s_dataSem) s_dataSem = xSemaphoreCreateBinary();
+  if (!s_dataSem) return false;
+
+  s_asyncStop = false;
+  s_ring.clear();
+
+  BaseType_t ok = xTaskCreatePinnedToCore(
+    readerTask,
+    "hx_reader",
+    TASK_STACK_HX,
+    nullptr,
+    TASK_PRIO_HX,                 // above sensor/UI: never miss a conversion
+    &s_reader,
+    (TASK_CORE_HX < 0) ? tskNO_AFFINITY : TASK_CORE_HX
+  );
+  if (ok != pdPASS) { s_reader = nullptr; return false; }
+
+  hal_gpio_on_falling(s_doutPin, onDoutFall);
+  xTaskNotifyGive(s_reader);     // pick up a conversion that is already pending
+  LOGI("HX", "async acquisition started (ring=%u)", (unsigned)HX_RING_LEN);
+  return true;
+}
+
+void stopAsync() {
+  if (!s_reader) return;
+  hal_gpio_detach(s_doutPin);
+  s_asyncStop = true;
+  xTaskNotifyGive(s_reader);
+  // reader clears s_reader on its way out
+  while (s_reader) hal_delay_ms(5);
+}
+
+bool asyncActive() { return s_reader != nullptr; }
+
+bool popSample(RawSample& out) {
+  return s_ring.pop(out);
+}
+
+bool waitSample(RawSample& out, uint32_t timeoutMs) {
+  if (s_ring.pop(out)) return true;
+  if (!s_dataSem) return false;
+  const TickType_t deadline = xTaskGetTickCount() + pdMS_TO_TICKS(timeoutMs);
+  for (;;) {
+    const TickType_t now = xTaskGetTickCount();
+    const TickType_t left = (TickType_t)(deadline - now);
+    if ((int32_t)left <= 0) return s_ring.pop(out);
+    xSemaphoreTake(s_dataSem, left);
+    if (s_ring.pop(out)) return true;
+  }
 }
 
+size_t pendingSamples() { return s_ring.size(); }
+
+uint32_t droppedSamples() { return s_dropped; }
+
+uint32_t asyncSampleCount() { return s_readCount; }
+
 } // namespace HX
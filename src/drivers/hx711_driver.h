@@ -1,14 +1,19 @@
 #pragma once
 #include <Arduino.h>
+#include "util/fixed_weight.h"
 
 namespace HX {
   // Initialize the chip. 'gain' is usually 128.
   bool  init(int dout_pin, int sck_pin, uint8_t gain = 128);
 
+  // Drive the RATE pin (if wired to a GPIO): false = 10 SPS, true = 80 SPS.
+  // No-op for ratePin < 0 (rate strapped on the board).
+  void  setRate(int ratePin, bool fast);
+
   // True if the ADC is up and data is ready
   bool  isReady();
 
-  // Library built-ins, wrapped:
+  // Offset and scale (bits come through hal/hx711_port.h):
   // Capture current offset (tare) by averaging 'samples'
   bool  tare(uint16_t samples = 10);
 
@@ -19,7 +24,40 @@ namespace HX {
   // Read weight in "units" (grams if you calibrated with grams)
   float getUnits(uint16_t samples = 1);
 
+  // ---- Integer path (preferred on the C3: no soft-float per sample) ----
+  // Scale in mg/count Q16.16 (see util/fixed_weight.h); offset is the tare.
+  void    setScaleQ16(int32_t mgPerCountQ16);
+  int32_t getScaleQ16();
+  int32_t getOffset();
+
+  // Averaged weight in milligrams, and conversion for async raw samples
+  int32_t getMilligrams(uint16_t samples = 1);
+  int32_t rawToMg(int32_t raw);
+
   // Optional raw helpers
   long  readRaw();
   long  readRawAverage(uint16_t samples = 5);
+
+  // ---- Async (interrupt-driven) acquisition ----
+  // A DOUT falling-edge ISR wakes a high-priority reader task that clocks out
+  // each conversion and pushes it into a lock-free ring (HX_RING_LEN deep).
+  // The blocking helpers above still work while this runs, but they own the
+  // bus for their whole duration, so the stream pauses meanwhile.
+  struct RawSample {
+    int32_t  raw;   // signed 24-bit counts, no offset/scale applied
+    uint32_t us;    // micros() when the conversion was clocked out
+  };
+
+  bool     startAsync();                 // requires init(); idempotent
+  void     stopAsync();
+  bool     asyncActive();
+
+  // Single consumer only. popSample never blocks; waitSample blocks up to
+  // timeoutMs for the next conversion.
+  bool     popSample(RawSample& out);
+  bool     waitSample(RawSample& out, uint32_t timeoutMs);
+  size_t   pendingSamples();
+
+  uint32_t droppedSamples();             // conversions lost to a full ring
+  uint32_t asyncSampleCount();           // conversions clocked out so far
 }
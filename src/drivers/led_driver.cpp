@@ -1,10 +1,14 @@
 #include "led_driver.h"
 #include <FastLED.h>
+#include "esp_timer.h"
 
 #ifndef MAX_LEDS_LOGICAL
 #define MAX_LEDS_LOGICAL 2
 #endif
 
+// Each LED renders from its own one-shot esp_timer, armed for the next
+// pattern edge only (blink toggles, pulse start/end). OFF/SOLID arm
+// nothing. Callbacks run in the esp_timer task, one at a time.
 struct LedState {
   int       pin         = -1;
   bool      activeLow   = false;
@@ -12,38 +16,43 @@ struct LedState {
   uint32_t  nextMs      = 0;
   bool      logicalOn   = false;  // abstract on/off decided by pattern
   uint8_t   pulsePhase  = 0;
+  esp_timer_handle_t timer = nullptr;
 };
 
 static LedState s_leds[MAX_LEDS_LOGICAL];
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;   // pattern vs. timer callback
 
 // ---- WS2812 mirror (optional) ----
 static bool   s_wsMirrorEnabled = false;
 static CRGB   s_wsPixel[1];
 static uint8_t s_ws_on[3]  = {0, 255, 0}; // default ON = green
 static uint8_t s_ws_off[3] = {0, 0, 0};   // default OFF = black
+static int8_t s_wsShown    = -1;           // last pushed state (-1 = unknown)
 
 static void write_gpio(const LedState* s, bool on) {
   if (!s || s->pin < 0) return;
   digitalWrite(s->pin, (s->activeLow ? (on ? LOW : HIGH) : (on ? HIGH : LOW)));
 }
 
-static void reset_runtime(LedState* S) {
-  if (!S) return;
-  S->nextMs = 0;
-  S->logicalOn = false;
-  S->pulsePhase = 0;
-  write_gpio(S, false);
+// Push the pixel only when LED1's state actually changes
+static void write_mirror(bool on) {
+  if (!s_wsMirrorEnabled || s_wsShown == (int8_t)on) return;
+  const uint8_t* c = on ? s_ws_on : s_ws_off;
+  s_wsPixel[0].setRGB(c[0], c[1], c[2]);
+  FastLED.show();
+  s_wsShown = on;
 }
 
-static void tick_one(LedState* L, uint32_t now) {
-  if (!L || L->pin < 0) return;
-  if ((int32_t)(now - L->nextMs) < 0) return;
+// Advance the pattern if its edge is due. Returns false for static
+// patterns (nothing to re-arm).
+static bool step_one(LedState* L, uint32_t now) {
+  if ((int32_t)(now - L->nextMs) < 0) return true;   // early/stale fire: just re-arm
 
   switch (L->pattern) {
     case LEDPattern::OFF:
-      L->logicalOn = false; L->nextMs = now + 500; break;
+      L->logicalOn = false; return false;
     case LEDPattern::SOLID:
-      L->logicalOn = true;  L->nextMs = now + 500; break;
+      L->logicalOn = true;  return false;
     case LEDPattern::SLOW_BLINK:
       L->logicalOn = !L->logicalOn;
       L->nextMs = now + (L->logicalOn ? 200 : 800);
@@ -60,8 +69,23 @@ static void tick_one(LedState* L, uint32_t now) {
       }
       break;
   }
+  return true;
+}
+
+static void on_led_timer(void* arg) {
+  LedState* L = (LedState*)arg;
+  const uint32_t now = millis();
 
-  write_gpio(L, L->logicalOn);
+  portENTER_CRITICAL(&s_mux);
+  const bool rearm = step_one(L, now);
+  const bool on    = L->logicalOn;
+  const uint32_t waitMs = rearm ? L->nextMs - now : 0;
+  portEXIT_CRITICAL(&s_mux);
+
+  write_gpio(L, on);
+  if (L == &s_leds[0]) write_mirror(on);
+  // Fails harmlessly if led_setPattern() re-armed us meanwhile
+  if (rearm) esp_timer_start_once(L->timer, (uint64_t)waitMs * 1000ULL);
 }
 
 void led_init_gpio(LedId id, int pin, bool activeLow) {
@@ -75,30 +99,34 @@ void led_init_gpio(LedId id, int pin, bool activeLow) {
 
   pinMode(pin, OUTPUT);
   write_gpio(&s_leds[i], false);
+
+  if (!s_leds[i].timer) {
+    const esp_timer_create_args_t args = {
+      .callback = on_led_timer,
+      .arg = &s_leds[i],
+      .dispatch_method = ESP_TIMER_TASK,
+      .name = i ? "led2" : "led1",
+      .skip_unhandled_events = true,
+    };
+    if (esp_timer_create(&args, &s_leds[i].timer) != ESP_OK) s_leds[i].timer = nullptr;
+  }
 }
 
+// Restart the pattern from its first phase; the timer renders it right away
 void led_setPattern(LedId id, LEDPattern p) {
   uint8_t i = (id == LedId::LED1) ? 0 : 1;
-  s_leds[i].pattern = p;
-  reset_runtime(&s_leds[i]);
-}
-
-void led_tick_all() {
-  uint32_t now = millis();
-
-  // Tick LED1 and LED2 (GPIO)
-  tick_one(&s_leds[0], now);
-  tick_one(&s_leds[1], now);
-
-  // Mirror LED1’s logical state onto WS2812 if enabled
-  if (s_wsMirrorEnabled) {
-    if (s_leds[0].logicalOn) {
-      s_wsPixel[0].setRGB(s_ws_on[0], s_ws_on[1], s_ws_on[2]);
-    } else {
-      s_wsPixel[0].setRGB(s_ws_off[0], s_ws_off[1], s_ws_off[2]);
-    }
-    FastLED.show();
-  }
+  LedState* L = &s_leds[i];
+
+  portENTER_CRITICAL(&s_mux);
+  L->pattern = p;
+  L->nextMs = millis();
+  L->logicalOn = false;
+  L->pulsePhase = 0;
+  portEXIT_CRITICAL(&s_mux);
+
+  if (!L->timer) return;
+  esp_timer_stop(L->timer);
+  esp_timer_start_once(L->timer, 0);
 }
 
 const char* led_patternName(LEDPattern p) {
@@ -122,5 +150,6 @@ void led_enable_ws2812_mirror(int dataPin,
   s_ws_on[0] = r_on;  s_ws_on[1] = g_on;  s_ws_on[2] = b_on;
   s_ws_off[0] = r_off; s_ws_off[1] = g_off; s_ws_off[2] = b_off;
 
+  s_wsShown = -1;                 // next LED1 edge pushes the real colour
   s_wsMirrorEnabled = true;
 }
@@ -14,13 +14,13 @@ enum class LEDPattern : uint8_t {
   PULSE_1S
 };
 
-// GPIO LEDs
+// GPIO LEDs. Patterns run by themselves from esp_timer callbacks fired
+// at each pattern edge (no tick task); OFF/SOLID cost nothing once set.
 void led_init_gpio(LedId id, int pin, bool activeLow = false);
 void led_setPattern(LedId id, LEDPattern p);
-void led_tick_all();
 const char* led_patternName(LEDPattern p);
 
-// NEW: mirror LED1 to a single WS2812 pixel (optional)
+// NEW: mirror LED1 to a single WS2812 pixel (optional; pushed only on change)
 void led_enable_ws2812_mirror(
   int dataPin,
   uint8_t r_on,
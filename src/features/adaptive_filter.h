@@ -0,0 +1,73 @@
+#pragma once
+#include <stdint.h>
+
+// 1-D Kalman filter for the live weight value, integer only (no Arduino deps).
+//
+// Constant-value model: x' = x + w (w ~ Q), z = x + v (v ~ R).
+// At rest the gain settles near sqrt(Q/R), i.e. heavy smoothing. When the
+// innovation leaves the gate (|z - x| > gate·sqrt(P + R)) the load is moving:
+// P is inflated to the innovation², so the gain jumps towards 1 and the
+// output follows within a sample or two, then smooths again as P shrinks.
+//
+// Units: mg and mg². Gains are Q16. Cost per update: a few 64-bit mul/div.
+class AdaptiveKalman {
+public:
+  // sigmaMeasMg: sensor noise σ (R = σ²); sigmaRestMg: allowed drift per
+  // sample at rest (Q = σ²); gateSigma: innovation gate in σ units.
+  AdaptiveKalman(int32_t sigmaMeasMg, int32_t sigmaRestMg, uint8_t gateSigma)
+    : r((int64_t)sigmaMeasMg * sigmaMeasMg),
+      q((int64_t)sigmaRestMg * sigmaRestMg),
+      gate2((int64_t)gateSigma * gateSigma) {
+    if (r < 1) r = 1;
+    if (gate2 < 1) gate2 = 1;
+  }
+
+  void reset() { primed = false; }
+
+  int32_t update(int32_t z) {
+    if (!primed) {
+      x = z; p = r; primed = true; moving = false;
+      return x;
+    }
+
+    p += q;                                   // predict
+    const int64_t e = (int64_t)z - x;         // innovation
+    const int64_t e2 = e * e;
+
+    // Gate: e² > gate² · (P + R) → manoeuvre, open up the gain
+    moving = e2 / gate2 > p + r;
+    if (moving && e2 > p) p = e2;
+
+    k = computeGain(p, r);
+    x += (int32_t)((k * e + 32768) >> 16);      // nearest: a floor would hold x up to 1/K low
+    p  = mulQ16(p, 65536 - k);                 // P = (1 - K)·P
+    if (p < 1) p = 1;
+    return x;
+  }
+
+  int32_t value() const     { return x; }
+  bool    isMoving() const  { return moving; }
+  int32_t gainQ16() const   { return (int32_t)k; }
+
+private:
+  static int64_t computeGain(int64_t p, int64_t r) {
+    // K = P / (P + R) in Q16 without overflowing the << 16
+    uint64_t den = (uint64_t)(p + r);
+    uint64_t num = (uint64_t)p;
+    while (den >> 46) { den >>= 1; num >>= 1; }
+    if (den == 0) return 0;
+    return (int64_t)((num << 16) / den);
+  }
+
+  static int64_t mulQ16(int64_t v, int64_t kq16) {
+    // v · k / 65536 split so the product stays inside 64 bits
+    return (v >> 16) * kq16 + (((v & 0xFFFF) * kq16) >> 16);
+  }
+
+  int64_t r, q, gate2;
+  int64_t p = 0;
+  int64_t k = 0;
+  int32_t x = 0;
+  bool    primed = false;
+  bool    moving = false;
+};
@@ -4,7 +4,9 @@
 
 #include "drivers/hx711_driver.h"
 #include "features/calibration.h"
+#include "features/calibration_math.h"
 #include "storage/nvs_store.h"
+#include "util/log.h"
 
 static constexpr const char* KEY_SCALE = "cal_scale";
 
@@ -16,32 +18,32 @@ bool calibration_try_load() {
     return false;
   }
   HX::setCalibrationFactor(s);
-  Serial.printf("[CAL] Loaded scale=%.6f counts/gram\r\n", s);
+  LOGI("CAL", "Loaded scale=%.6f counts/gram", s);
   return true;
 }
 
 bool calibration_run_100g() {
-  Serial.printf("\r\n=== Calibration: 100 g ===\r\n");
-  Serial.printf("1) Remove all weight. Waiting to stabilize...\r\n");
+  LOGI("CAL", "=== Calibration: 100 g ===");
+  LOGI("CAL", "1) Remove all weight. Waiting to stabilize...");
 
-  // Warm-up + tare for clean offset in getUnits()
+  // Warm-up + tare for clean offset in getMilligrams()
   vTaskDelay(pdMS_TO_TICKS(1500));
-  (void)HX::getUnits(20);   // throw away a few reads
+  (void)HX::readRawAverage(20);   // throw away a few reads
   HX::tare(20);
 
   // Capture raw baseline (independent of tare)
   vTaskDelay(pdMS_TO_TICKS(200));
   const long raw_zero = readRawAvg(20);
-  Serial.printf("[CAL] raw_zero=%ld\r\n", raw_zero);
+  LOGI("CAL", "raw_zero=%ld", raw_zero);
 
-  Serial.printf("2) Place the 100 g weight and keep it steady...\r\n");
+  LOGI("CAL", "2) Place the 100 g weight and keep it steady...");
 
   // Wait until “something present”
   long raw_ref = 0;
   const uint32_t t0 = millis();
   while (millis() - t0 < 10000) {
     raw_ref = readRawAvg(10);
-    if (labs(raw_ref - raw_zero) > 200) break;   // heuristic threshold
+    if (calibration_load_present(raw_zero, raw_ref)) break;
     vTaskDelay(pdMS_TO_TICKS(150));
   }
 
@@ -49,35 +51,39 @@ bool calibration_run_100g() {
   raw_ref = readRawAvg(20);
   const long delta = raw_ref - raw_zero;
 
-  if (labs(delta) < 100) {
-    Serial.printf("[CAL] ERROR: too small delta (%ld). Check 100 g or wiring.\r\n", delta);
+  // Integer scale: mg per count (Q16.16); NVS keeps the legacy counts/gram float
+  int32_t scaleQ16 = 0;
+  if (!calibration_scale(raw_zero, raw_ref, CAL_MASS_MG, scaleQ16)) {
+    LOGE("CAL", "ERROR: too small delta (%ld). Check 100 g or wiring.", delta);
     return false;
   }
-
-  // counts per gram for bogde/HX711 set_scale
-  float scale = (float)delta / 100.0f;
-  HX::setCalibrationFactor(scale);
+  HX::setScaleQ16(scaleQ16);
+  float scale = weight_scale_to_counts_per_g(scaleQ16);
 
   // Save; report if it fails
   if (!nvs_save_float(KEY_SCALE, scale)) {
-    Serial.println("[CAL] WARNING: failed to save scale to NVS");
+    LOGW("CAL", "WARNING: failed to save scale to NVS");
   }
 
-  Serial.printf("[CAL] raw_ref=%ld  delta=%ld  scale=%.6f counts/gram\r\n",
-                raw_ref, delta, scale);
+  LOGI("CAL", "raw_ref=%ld  delta=%ld  scale=%.6f counts/gram (q16=%ld)",
+       raw_ref, delta, scale, (long)scaleQ16);
 
   // Verify & auto-fix sign so 100 g reads positive
-  float verify = HX::getUnits(5);
-  if (verify < 0.0f) {
-    scale = -scale;
-    HX::setCalibrationFactor(scale);
+  char vBuf[16];
+  int32_t verify = HX::getMilligrams(5);
+  if (verify < 0) {
+    scaleQ16 = -scaleQ16;
+    HX::setScaleQ16(scaleQ16);
+    scale = weight_scale_to_counts_per_g(scaleQ16);
     (void)nvs_save_float(KEY_SCALE, scale);
-    verify = HX::getUnits(15);
-    Serial.printf("[CAL] Sign corrected. New scale=%.6f; Verify=%.1f g\r\n", scale, verify);
+    verify = HX::getMilligrams(15);
+    weight_format_g(vBuf, sizeof(vBuf), verify, 1);
+    LOGI("CAL", "Sign corrected. New scale=%.6f; Verify=%s g", scale, vBuf);
   } else {
-    Serial.printf("[CAL] Verify: ~%.1f g (with 100 g on)\r\n", verify);
+    weight_format_g(vBuf, sizeof(vBuf), verify, 1);
+    LOGI("CAL", "Verify: ~%s g (with 100 g on)", vBuf);
   }
 
-  Serial.printf("[CAL] Done. Factor saved.\r\n\r\n");
+  LOGI("CAL", "Done. Factor saved.");
   return true;
 }
\ No newline at end of file
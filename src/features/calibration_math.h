@@ -0,0 +1,24 @@
+#pragma once
+#include <stdint.h>
+#include "util/fixed_weight.h"
+
+// Two-point calibration math (header-only, no Arduino deps): raw averages
+// with the scale empty and with a known mass on it. The blocking flow that
+// collects them is features/calibration.
+
+static constexpr int32_t CAL_MASS_MG        = 100000;  // reference weight
+static constexpr int32_t CAL_PRESENT_COUNTS = 200;     // "something is on the scale"
+static constexpr int32_t CAL_MIN_DELTA      = 100;     // less → wrong mass or wiring
+
+inline bool calibration_load_present(int32_t rawZero, int32_t raw) {
+  return weight_abs_mg(raw - rawZero) > CAL_PRESENT_COUNTS;
+}
+
+// mg per count (Q16.16) so that rawRef - rawZero reads as massMg. False
+// (scale untouched) when the delta is too small to trust.
+inline bool calibration_scale(int32_t rawZero, int32_t rawRef, int32_t massMg, int32_t& scaleQ16) {
+  const int32_t delta = rawRef - rawZero;
+  if (weight_abs_mg(delta) < CAL_MIN_DELTA) return false;
+  scaleQ16 = weight_scale_from_delta(delta, massMg);
+  return true;
+}
@@ -0,0 +1,155 @@
+#include "filter_chain.h"
+#include "util/fixed_weight.h"
+#include <stdio.h>
+
+static inline void swap32(int32_t& a, int32_t& b) { int32_t t = a; a = b; b = t; }
+
+static int32_t median3(int32_t a, int32_t b, int32_t c) {
+  if (a > b) swap32(a, b);
+  if (b > c) swap32(b, c);
+  if (a > b) swap32(a, b);
+  return b;
+}
+
+static int32_t median5(const int32_t* v) {
+  int32_t s[5] = { v[0], v[1], v[2], v[3], v[4] };
+  // insertion sort: 5 elements, at most 10 compares
+  for (int i = 1; i < 5; ++i) {
+    int32_t x = s[i];
+    int j = i - 1;
+    while (j >= 0 && s[j] > x) { s[j + 1] = s[j]; --j; }
+    s[j + 1] = x;
+  }
+  return s[2];
+}
+
+FilterChain::FilterChain(const FilterChainConfig& c) : cfg(c) {
+  if (cfg.cicOrder < 1) cfg.cicOrder = 1;
+  if (cfg.cicOrder > MAX_ORDER) cfg.cicOrder = MAX_ORDER;
+  if (cfg.decim < 1) cfg.decim = 1;
+  if (cfg.inRateSps == 0) cfg.inRateSps = 10;
+  norm = 1;
+  for (uint8_t i = 0; i < cfg.cicOrder; ++i) norm *= cfg.decim;
+  reset();
+}
+
+void FilterChain::reset() {
+  for (uint8_t i = 0; i < MAX_ORDER; ++i) { integ[i] = 0; combPrev[i] = 0; }
+  phase = 0;
+  histLen = 0;
+  primed = false;
+}
+
+bool FilterChain::push(int32_t mg, int32_t& out) {
+  // Integrators (modular)
+  uint64_t x = (uint64_t)(int64_t)mg;
+  for (uint8_t i = 0; i < cfg.cicOrder; ++i) { integ[i] += x; x = integ[i]; }
+
+  if (++phase < cfg.decim) return false;
+  phase = 0;
+
+  // Combs at the output rate
+  uint64_t y = x;
+  for (uint8_t i = 0; i < cfg.cicOrder; ++i) {
+    const uint64_t prev = combPrev[i];
+    combPrev[i] = y;
+    y = y - prev;
+  }
+
+  // Orders > 1 need N output periods before the combs hold real history
+  if (!primed) {
+    if (++histLen < cfg.cicOrder) return false;
+    primed = true;
+    histLen = 0;
+  }
+
+  const int32_t cic = (int32_t)((int64_t)y / norm);
+  return postStage(cic, out);
+}
+
+bool FilterChain::postStage(int32_t x, int32_t& out) {
+  uint8_t need = 1;
+  switch (cfg.post) {
+    case FilterPost::NONE:    need = 1; break;
+    case FilterPost::MEDIAN3: need = 3; break;
+    case FilterPost::MEDIAN5:
+    case FilterPost::FIR5:    need = 5; break;
+  }
+  if (need == 1) { out = x; return true; }
+
+  for (uint8_t i = need - 1; i > 0; --i) hist[i] = hist[i - 1];
+  hist[0] = x;
+  if (histLen < need) histLen++;
+  if (histLen < need) return false;
+
+  switch (cfg.post) {
+    case FilterPost::MEDIAN3:
+      out = median3(hist[0], hist[1], hist[2]);
+      break;
+    case FilterPost::MEDIAN5:
+      out = median5(hist);
+      break;
+    case FilterPost::FIR5: {
+      const int64_t acc = (int64_t)hist[0] + 4LL * hist[1] + 6LL * hist[2] + 4LL * hist[3] + hist[4];
+      out = (int32_t)((acc >= 0 ? acc + 8 : acc - 8) / 16);
+      break;
+    }
+    default:
+      out = x;
+      break;
+  }
+  return true;
+}
+
+uint32_t FilterChain::outPeriodMs() const {
+  return (1000u * cfg.decim) / cfg.inRateSps;
+}
+
+uint32_t FilterChain::latencyMs() const {
+  // Group delay in input samples, doubled to stay integer:
+  //   CIC: N(R-1)/2, median3: 1 output, median5/FIR5: 2 outputs
+  uint32_t twice = (uint32_t)cfg.cicOrder * (cfg.decim - 1);
+  switch (cfg.post) {
+    case FilterPost::MEDIAN3: twice += 2u * cfg.decim; break;
+    case FilterPost::MEDIAN5:
+    case FilterPost::FIR5:    twice += 4u * cfg.decim; break;
+    default: break;
+  }
+  return (twice * 1000u) / (2u * cfg.inRateSps);
+}
+
+int FilterChain::describe(char* buf, size_t len) const {
+  const char* post = "";
+  switch (cfg.post) {
+    case FilterPost::NONE:    post = "";      break;
+    case FilterPost::MEDIAN3: post = " MED3"; break;
+    case FilterPost::MEDIAN5: post = " MED5"; break;
+    case FilterPost::FIR5:    post = " FIR5"; break;
+  }
+  return snprintf(buf, len, "%uSPS CIC%u/%u%s", (unsigned)cfg.inRateSps,
+                  (unsigned)cfg.cicOrder, (unsigned)cfg.decim, post);
+}
+
+uint16_t filter_rate_from_stamps(const uint32_t* us, size_t n) {
+  if (n < 3 || n > 16) return 0;
+  uint32_t d[15];
+  const size_t m = n - 1;
+  for (size_t i = 0; i < m; ++i) {
+    const uint32_t x = us[i + 1] - us[i];
+    size_t j = i;
+    while (j > 0 && d[j - 1] > x) { d[j] = d[j - 1]; --j; }
+    d[j] = x;
+  }
+  // 12.5 ms at 80 SPS, 100 ms at 10 SPS; split at their geometric mean
+  const uint32_t period = d[m / 2];
+  if (period < 6000 || period > 200000) return 0;
+  return period < 35355 ? 80 : 10;
+}
+
+int32_t NoiseMeter::stddevMg() const {
+  if (n < 2) return 0;
+  const int64_t m = sum / n;
+  int64_t v = sumSq / n - m * m;
+  if (v < 0) v = 0;
+  return (int32_t)weight_isqrt64((uint64_t)v);
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Decimating filter chain for the raw weight stream (no Arduino deps).
+//
+//   in (mg @ inRateSps) → CIC order N, decimate by R → post stage → out
+//
+// The CIC stage is N integrators at the input rate and N combs at the output
+// rate, normalised by R^N (order 1 is a plain block average). Integrators
+// run in modular uint64 arithmetic, so they may wrap freely; the comb output
+// is exact as long as the true sum fits in 64 bits.
+//
+// Post stages run at the output rate: a 3/5-point median (kills single
+// spikes) or a 5-tap binomial FIR (1 4 6 4 1)/16.
+
+enum class FilterPost : uint8_t {
+  NONE = 0,
+  MEDIAN3,
+  MEDIAN5,
+  FIR5
+};
+
+struct FilterChainConfig {
+  uint16_t   inRateSps;   // HX711 data rate: 10 or 80
+  uint8_t    cicOrder;    // 1..3
+  uint8_t    decim;       // R >= 1
+  FilterPost post;
+};
+
+class FilterChain {
+public:
+  static constexpr uint8_t MAX_ORDER = 3;
+
+  explicit FilterChain(const FilterChainConfig& cfg);
+
+  void reset();
+
+  // Feed one input sample. Returns true (and fills 'out') when the chain
+  // produced an output sample.
+  bool push(int32_t mg, int32_t& out);
+
+  const FilterChainConfig& config() const { return cfg; }
+
+  // Output period, and the chain's group delay (CIC + post stage) in ms.
+  uint32_t outPeriodMs() const;
+  uint32_t latencyMs() const;
+
+  // Short label such as "80SPS CIC2/8 MED3"
+  int describe(char* buf, size_t len) const;
+
+private:
+  bool postStage(int32_t x, int32_t& out);
+
+  FilterChainConfig cfg;
+
+  uint64_t integ[MAX_ORDER];
+  uint64_t combPrev[MAX_ORDER];
+  uint8_t  phase = 0;
+  int64_t  norm = 1;       // R^N
+
+  int32_t  hist[5];        // post-stage history (newest at [0])
+  uint8_t  histLen = 0;
+  bool     primed = false; // first CIC output discarded (combs warm up)
+};
+
+// HX711 data rate (10 or 80 SPS) nearest to the median spacing of 'n'
+// conversion timestamps in µs (wrap-safe, n <= 16). 0 when there are fewer
+// than 3 stamps or the spacing fits neither rate.
+uint16_t filter_rate_from_stamps(const uint32_t* us, size_t n);
+
+// Streaming mean/σ over N samples, used to report per-configuration noise.
+struct NoiseMeter {
+  uint16_t target = 0;
+  uint16_t n      = 0;
+  int32_t  ref    = 0;
+  int64_t  sum    = 0;
+  int64_t  sumSq  = 0;
+
+  explicit NoiseMeter(uint16_t samples) : target(samples) {}
+  void reset() { n = 0; sum = 0; sumSq = 0; }
+
+  // Returns true when 'target' samples are in; then stddevMg()/meanMg() are valid.
+  bool push(int32_t mg) {
+    if (n == 0) ref = mg;
+    const int64_t d = (int64_t)mg - ref;
+    sum += d; sumSq += d * d; n++;
+    return n >= target;
+  }
+  int32_t meanMg() const { return n ? ref + (int32_t)(sum / n) : 0; }
+  int32_t stddevMg() const;
+};
@@ -0,0 +1,165 @@
+#include "latency_trace.h"
+#include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "app_config.h"
+#include "storage/nvs_store.h"
+#include "util/log.h"
+
+static constexpr const char* KEY_SLO = "slo_ms";
+
+static_assert(TRACE_SLO_WINDOW <= 64, "SLO window is a 64-bit mask");
+
+static constexpr uint8_t     NS      = (uint8_t)TraceStage::COUNT;
+
+struct Trace {
+  uint32_t   seq;
+  TraceMarks m;
+  bool       used;
+};
+
+static const char* const kStageNames[NS] = { "filter", "stable", "final", "enqueue", "queue", "send", "total" };
+static const Hist kStageHist[NS] = {
+  Hist::LAT_FILTER_MS, Hist::LAT_STABLE_MS, Hist::LAT_FINAL_MS, Hist::LAT_ENQUEUE_MS,
+  Hist::LAT_QUEUE_MS, Hist::LAT_SEND_MS, Hist::LAT_TOTAL_MS
+};
+
+static Trace        s_tr[TRACE_SLOTS];
+static portMUX_TYPE s_mux     = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t     s_sloMs   = TRACE_SLO_MS;
+static uint64_t     s_window  = 0;       // bit = trace met the SLO, newest in bit 0
+static uint8_t      s_windowN = 0;
+static uint32_t     s_met     = 0;
+static uint32_t     s_total   = 0;
+static uint32_t     s_evicted = 0;
+static uint32_t     s_last[NS];
+static bool         s_below   = false;   // window compliance under target (logged once)
+
+void trace_init() {
+  uint32_t ms;
+  if (nvs_load_u32(KEY_SLO, ms) && ms > 0) s_sloMs = ms;
+  LOGI("TRACE", "SLO: %u%% of weights acked within %lu ms", (unsigned)TRACE_SLO_PCT, (unsigned long)s_sloMs);
+}
+
+void trace_slo_set(uint32_t ms) {
+  portENTER_CRITICAL(&s_mux);
+  s_sloMs   = ms;
+  s_window  = 0;        // old results were judged against the old target
+  s_windowN = 0;
+  s_below   = false;
+  portEXIT_CRITICAL(&s_mux);
+  if (!nvs_save_u32(KEY_SLO, ms)) LOGW("TRACE", "SLO not saved (NVS)");
+  LOGI("TRACE", "SLO set to %lu ms", (unsigned long)ms);
+}
+
+uint32_t trace_slo_ms() { return s_sloMs; }
+
+// Caller holds s_mux
+static Trace* find(uint32_t seq) {
+  for (Trace& t : s_tr) {
+    if (t.used && t.seq == seq) return &t;
+  }
+  return nullptr;
+}
+
+void trace_begin(uint32_t seq, uint32_t sampleMs, uint32_t detectMs, uint32_t stableMs, uint32_t finalMs) {
+  portENTER_CRITICAL(&s_mux);
+  Trace* slot = nullptr;
+  for (Trace& t : s_tr) {
+    if (!t.used) { slot = &t; break; }
+    if (!slot || (int32_t)(t.m.ms[0] - slot->m.ms[0]) < 0) slot = &t;    // oldest SAMPLE
+  }
+  if (slot->used) s_evicted++;
+  slot->used = true;
+  slot->seq  = seq;
+  slot->m.ms[(uint8_t)TraceMark::SAMPLE] = sampleMs;
+  slot->m.ms[(uint8_t)TraceMark::DETECT] = detectMs;
+  slot->m.ms[(uint8_t)TraceMark::STABLE] = stableMs;
+  slot->m.ms[(uint8_t)TraceMark::FINAL]  = finalMs;
+  slot->m.have = (1u << (uint8_t)TraceMark::SAMPLE) | (1u << (uint8_t)TraceMark::DETECT) |
+                 (1u << (uint8_t)TraceMark::STABLE) | (1u << (uint8_t)TraceMark::FINAL);
+  portEXIT_CRITICAL(&s_mux);
+}
+
+void trace_mark(uint32_t seq, TraceMark mark) {
+  const uint32_t now = millis();
+  portENTER_CRITICAL(&s_mux);
+  Trace* t = find(seq);
+  if (t) {
+    t->m.ms[(uint8_t)mark] = now;
+    t->m.have |= 1u << (uint8_t)mark;
+  }
+  portEXIT_CRITICAL(&s_mux);
+}
+
+void trace_ack(uint32_t seq) {
+  const uint32_t now = millis();
+  Trace t;
+  portENTER_CRITICAL(&s_mux);
+  Trace* p = find(seq);
+  if (p) { t = *p; p->used = false; }
+  portEXIT_CRITICAL(&s_mux);
+  if (!p) return;
+
+  uint32_t d[NS];
+  trace_stages(t.m, now, d);
+  for (uint8_t i = 0; i < NS; ++i) metric_observe(kStageHist[i], d[i]);
+  auto st = [&](TraceStage s) { return (unsigned long)d[(uint8_t)s]; };
+
+  portENTER_CRITICAL(&s_mux);
+  const bool met = d[(uint8_t)TraceStage::TOTAL] <= s_sloMs;
+  const uint32_t slo = s_sloMs;
+  memcpy(s_last, d, sizeof(s_last));
+  s_total++;
+  if (met) s_met++;
+  s_window = (s_window << 1) | (met ? 1u : 0u);
+  if (s_windowN < TRACE_SLO_WINDOW) s_windowN++;
+  const uint8_t n   = s_windowN;
+  const uint8_t pct = trace_window_pct(s_window, n);
+  const bool judged = n >= TRACE_SLO_MIN_TRACES;
+  bool wentBelow = false, recovered = false;
+  if (judged && pct < TRACE_SLO_PCT && !s_below) { s_below = true;  wentBelow = true; }
+  if (judged && pct >= TRACE_SLO_PCT && s_below) { s_below = false; recovered = true; }
+  portEXIT_CRITICAL(&s_mux);
+
+  if (met) {
+    LOGD("TRACE", "seq=%lu filter=%lu stable=%lu final=%lu enqueue=%lu queue=%lu send=%lu → total %lu ms",
+         (unsigned long)seq, st(TraceStage::FILTER), st(TraceStage::STABLE), st(TraceStage::FINAL),
+         st(TraceStage::ENQUEUE), st(TraceStage::QUEUE), st(TraceStage::SEND), st(TraceStage::TOTAL));
+  } else {
+    LOGW("TRACE", "seq=%lu filter=%lu stable=%lu final=%lu enqueue=%lu queue=%lu send=%lu → total %lu ms > SLO %lu",
+         (unsigned long)seq, st(TraceStage::FILTER), st(TraceStage::STABLE), st(TraceStage::FINAL),
+         st(TraceStage::ENQUEUE), st(TraceStage::QUEUE), st(TraceStage::SEND), st(TraceStage::TOTAL),
+         (unsigned long)slo);
+  }
+  if (wentBelow) {
+    LOGW("TRACE", "SLO breached: %u%% of the last %u weights within %lu ms (target %u%%)",
+         (unsigned)pct, (unsigned)n, (unsigned long)slo, (unsigned)TRACE_SLO_PCT);
+  }
+  if (recovered) {
+    LOGI("TRACE", "SLO met again: %u%% of the last %u weights within %lu ms",
+         (unsigned)pct, (unsigned)n, (unsigned long)slo);
+  }
+}
+
+void trace_write(MetricSink sink, void* ctx) {
+  portENTER_CRITICAL(&s_mux);
+  const uint32_t slo = s_sloMs, met = s_met, total = s_total, evicted = s_evicted;
+  const uint8_t  n   = s_windowN;
+  const uint64_t w   = s_window;
+  uint32_t last[NS];
+  memcpy(last, s_last, sizeof(last));
+  portEXIT_CRITICAL(&s_mux);
+
+  sink(ctx, "latency_slo_ms", "", slo);
+  sink(ctx, "latency_slo_target_pct", "", TRACE_SLO_PCT);
+  sink(ctx, "latency_slo_met_total", "", met);
+  sink(ctx, "latency_traces_total", "", total);
+  sink(ctx, "latency_traces_evicted_total", "", evicted);
+  if (n) sink(ctx, "latency_slo_window_pct", "", trace_window_pct(w, n));
+
+  char label[24];
+  for (uint8_t i = 0; i < NS; ++i) {
+    snprintf(label, sizeof(label), "stage=\"%s\"", kStageNames[i]);
+    sink(ctx, "latency_last_ms", label, last[i]);
+  }
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <stdint.h>
+#include "core/metrics.h"
+#include "features/trace_stages.h"
+
+// End-to-end latency of each weight, from the load change to the server
+// ack. A record is traced from the moment the sensor task emits it:
+//
+//   SAMPLE   ADC conversion that carried the change (DETECT - filter latency)
+//   DETECT   filtered value moved by DELTA_SEND_MG (first output of the change)
+//   STABLE   stability window full, or early estimate accepted
+//   FINAL    value computed and the record stamped
+//   ENQUEUE  handed to the upload queue
+//   SEND     (last) transport attempt started
+//   ACK      server confirmed it
+//
+// On ACK the stage durations go into the LAT_* histograms (core/metrics.h,
+// exported with p50/p90/p99) and the total is checked against the SLO:
+// "TRACE_SLO_PCT % of weights reach the server within slo ms". The target
+// is per scale (NVS, "slo <ms>" on the serial console); compliance over
+// the last TRACE_SLO_WINDOW traces is exported and a drop below target is
+// logged once.
+//
+// Traces live in a small RAM table keyed by seq (TRACE_SLOTS, oldest
+// evicted); records the table no longer holds (long offline spells,
+// spooled across a reboot) are simply not traced. The stage math itself
+// is features/trace_stages (host-tested).
+//
+// FINISH records are not traced on purpose: they come from a button, not a
+// load change, so they have no SAMPLE..FINAL stages, and the SLO is about
+// weights. Their delivery shows up in upload_post_ms and the post counters.
+
+void trace_init();      // loads the SLO target from NVS (after nvs_init)
+
+// Sensor task: a new record with its first four timestamps (millis())
+void trace_begin(uint32_t seq, uint32_t sampleMs, uint32_t detectMs, uint32_t stableMs, uint32_t finalMs);
+
+// ENQUEUE / SEND at millis(); unknown seq is ignored
+void trace_mark(uint32_t seq, TraceMark mark);
+
+// Record delivered: closes the trace (histograms, SLO) and frees its slot
+void trace_ack(uint32_t seq);
+
+void     trace_slo_set(uint32_t ms);    // persisted
+uint32_t trace_slo_ms();
+
+// SLO and last-trace lines for metrics_write()
+void trace_write(MetricSink sink, void* ctx);
@@ -0,0 +1,40 @@
+#pragma once
+#include <stdint.h>
+
+enum class MeasKind : uint8_t {
+  ADD    = 0,
+  REMOVE = 1,
+  FINISH = 2     // "measurement finished" button; carries 'epoch' instead of 'mg'
+};
+
+// One accepted weight (or finish) event, fixed size so it can be queued by
+// value and stored in the flash spool. (seq, boot) is the dedupe key.
+struct Measurement {
+  union {
+    int32_t  mg;      // ADD: new total, REMOVE: (negative) delta to previous
+    uint32_t epoch;   // FINISH: wall clock (s), 0 if unknown
+  };
+  uint32_t monoMs;    // millis() when the value was accepted (this boot's clock)
+  uint32_t seq;       // per-device, increasing across reboots (core/sequence)
+  MeasKind kind;
+  uint8_t  confPct;   // 100 = confirmed, < 100 = early-settle estimate,
+                      // MEAS_CORRECTS | d = confirmed, replaces the estimate seq - d
+  uint16_t boot;      // seq_boot_id() of the boot that created it
+};
+
+static_assert(sizeof(Measurement) == 16, "Measurement must stay 16 bytes");
+
+// A confirmed value that replaces a mispredicted early estimate of the same
+// load change names it by seq distance (1..127, usually 1) in confPct, so
+// the server can drop the estimate. Farther back it goes out unlinked.
+static constexpr uint8_t MEAS_CORRECTS = 0x80;
+
+inline uint8_t meas_correction_conf(uint32_t seq, uint32_t earlySeq) {
+  const uint32_t d = seq - earlySeq;
+  return (d >= 1 && d <= 0x7F) ? (uint8_t)(MEAS_CORRECTS | d) : 100;
+}
+
+// seq of the early estimate this record replaces, 0 if none
+inline uint32_t meas_corrects_seq(const Measurement& m) {
+  return (m.confPct & MEAS_CORRECTS) ? m.seq - (m.confPct & 0x7F) : 0;
+}
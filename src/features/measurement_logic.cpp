@@ -0,0 +1,69 @@
+#include "measurement_logic.h"
+#include "util/fixed_weight.h"
+
+MeasurementLogic::MeasurementLogic(const Params& p)
+  : prm(p), stab(p.stabilityMs, p.bandMg), settle(p.settle) {}
+
+void MeasurementLogic::reset() {
+  stab.reset();
+  settle.reset();
+  state     = IDLE;
+  earlySent = false;
+}
+
+void MeasurementLogic::push(uint32_t nowMs, int32_t reading, int32_t liveMg, Step& out) {
+  out = Step{};
+
+  if (state == IDLE) {
+    // Trigger on the live (filtered) value: no false starts on noise
+    const int32_t delta = weight_abs_mg(liveMg - lastStable);
+    if (delta >= prm.deltaMg) {
+      stab.reset();
+      stab.push(nowMs, reading);
+      settle.reset();
+      settle.push(reading);
+      earlySent     = false;
+      trigMs        = nowMs;
+      state         = STABILIZING;
+      out.triggered = true;
+      out.deltaMg   = delta;
+    }
+    return;
+  }
+
+  stab.push(nowMs, reading);
+
+  if (prm.earlyEnabled && !earlySent) {
+    settle.push(reading);
+    if (settle.predict(out.est) && out.est.confidencePct >= prm.earlyMinConf) {
+      earlySent = true;
+      earlyVal  = out.est.valueMg;
+      out.early = true;
+      out.earlyW = { out.est.valueMg, lastStable,
+                     (uint8_t)(out.est.confidencePct < 100 ? out.est.confidencePct : 99),
+                     trigMs, nowMs };
+    }
+  }
+
+  if (stab.isStable()) {
+    // Precise value = mean of the newest quarter of the window: "stable"
+    // only bounds the spread, and the older samples still trail a load
+    // that is ringing down (no extra blocking conversions either way)
+    const int32_t finalVal = stab.recentMeanMg(prm.stabilityMs / 4);
+    const int32_t prev     = lastStable;
+    lastStable  = finalVal;
+    out.settled = true;
+    out.finalW  = { finalVal, prev, 100, trigMs, nowMs };
+
+    // Confirmed value only goes out if the early estimate missed
+    if (earlySent && weight_abs_mg(finalVal - earlyVal) <= prm.bandMg) {
+      out.confirmed  = true;
+      out.earlyErrMg = finalVal - earlyVal;
+    } else if (earlySent) {
+      out.corrects   = true;
+    }
+
+    state = IDLE;
+    stab.reset();
+  }
+}
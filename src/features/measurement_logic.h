@@ -0,0 +1,75 @@
+#pragma once
+#include <stdint.h>
+#include "features/stability_detector.h"
+#include "features/settle_predictor.h"
+
+// When does a filtered reading become a weight to send (no Arduino deps)?
+//
+//   IDLE         |live - last stable| >= deltaMg → STABILIZING
+//   STABILIZING  early estimate with enough confidence → send it (once);
+//                window stable → final value = mean of the window's
+//                newest quarter (least ring-down bias), sent unless
+//                the early estimate was already within bandMg of it
+//                (then it corrects the estimate)
+//
+// The sensor task feeds it one filter output at a time and turns the
+// returned Step into log lines and Measurements.
+class MeasurementLogic {
+public:
+  struct Params {
+    int32_t  deltaMg;          // trigger threshold
+    uint32_t stabilityMs;      // window length
+    int32_t  bandMg;           // ± around the window midpoint
+    bool     earlyEnabled;
+    uint8_t  earlyMinConf;     // % confidence to accept an estimate
+    SettlePredictor::Params settle;
+  };
+
+  // A weight to send. confPct < 100 marks an early estimate.
+  struct Weight {
+    int32_t  valueMg;
+    int32_t  prevMg;           // last stable value before this change
+    uint8_t  confPct;
+    uint32_t detectMs;         // load change detected
+    uint32_t stableMs;         // window stable / estimate accepted
+  };
+
+  // What one reading did; several flags can be set at once
+  struct Step {
+    bool     triggered;        // IDLE → STABILIZING (deltaMg = |live - last stable|)
+    int32_t  deltaMg;
+    bool     early;            // 'earlyW' should be sent; 'est' is the fit
+    SettlePredictor::Estimate est;
+    Weight   earlyW;
+    bool     settled;          // window stable, back to IDLE; 'finalW' is the recent mean
+    bool     confirmed;        // early estimate was within bandMg: don't send finalW
+    int32_t  earlyErrMg;       // final - early, when confirmed
+    bool     corrects;         // an early estimate went out and missed: finalW replaces it
+    Weight   finalW;
+  };
+
+  explicit MeasurementLogic(const Params& p);
+
+  // Back to IDLE with the window cleared (last stable value is kept)
+  void reset();
+
+  // One filter output at nowMs: 'reading' feeds the window and the
+  // predictor, 'liveMg' (adaptive-filtered) decides the trigger.
+  void push(uint32_t nowMs, int32_t reading, int32_t liveMg, Step& out);
+
+  bool    idle() const          { return state == IDLE; }
+  int32_t lastStableMg() const  { return lastStable; }
+  size_t  settleSamples() const { return settle.count(); }
+
+private:
+  enum State : uint8_t { IDLE, STABILIZING };
+
+  Params            prm;
+  StabilityDetector stab;
+  SettlePredictor   settle;
+  State    state      = IDLE;
+  int32_t  lastStable = 0;
+  bool     earlySent  = false;
+  int32_t  earlyVal   = 0;
+  uint32_t trigMs     = 0;
+};
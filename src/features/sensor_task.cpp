@@ -6,7 +6,15 @@
 #include "drivers/hx711_driver.h"
 #include "core/app_state.h"
 #include "features/calibration.h"
-#include "net/api_client.h"
+#include "features/uploader.h"
+#include "features/measurement_logic.h"
+#include "features/filter_chain.h"
+#include "features/adaptive_filter.h"
+#include "util/fixed_weight.h"
+#include "core/wake_stats.h"
+#include "core/metrics.h"
+#include "features/latency_trace.h"
+#include "util/log.h"
 
 // --- Pins (set to your wiring) ---
 static constexpr int HX_DOUT = 1;   // change me
@@ -14,12 +22,68 @@ static constexpr int HX_SCK  = 10;  // change me
 
 // --- Calibration factor ---
 // If unknown, set to 1.0 so "units" are raw counts.
-// After calibration set proper factor so HX::getUnits() returns grams.
+// After calibration set proper factor so HX::getMilligrams() returns mg.
 static constexpr float INITIAL_SCALE = 42.40f;
 
 // --- RTOS task entry ---
 static void sensorTask(void*);
 
+// Latest adaptive-filtered weight (mg) for UI/telemetry readers
+static volatile int32_t s_liveMg   = 0;
+static volatile bool    s_liveMove = false;
+
+int32_t sensor_live_mg()  { return s_liveMg; }
+bool sensor_live_moving() { return s_liveMove; }
+
+// Queue one accepted weight for upload. ADD carries the new total, REMOVE
+// the (negative) difference to the previous stable value, as the server
+// expects. confPct < 100 marks an early (predicted) value; a value that
+// replaces a missed one names it by 'correctsSeq'. detectMs and stableMs
+// start the record's latency trace, which begins at the ADC sample one
+// filter delay before detection. Returns the record's seq.
+static uint32_t emit_weight(const MeasurementLogic::Weight& w, uint32_t filterMs,
+                            uint32_t correctsSeq = 0) {
+  const int32_t value = w.valueMg, prev = w.prevMg;
+  const uint8_t confPct = w.confPct;
+  char gBuf[16], gBuf2[16];
+  const bool increased = (value - prev) >= 0;
+  const char* kind     = increased ? "ADD" : "REMOVE";
+  weight_format_g(gBuf, sizeof(gBuf), value, 1);
+  weight_format_g(gBuf2, sizeof(gBuf2), prev, 1);
+  LOGI("MEAS", "%s %s: %s g (prev %s g)", kind,
+       confPct < 100 ? "predicted" : "stable", gBuf, gBuf2);
+
+  Measurement m{};
+  m.mg      = increased ? value : value - prev;
+  m.kind    = increased ? MeasKind::ADD : MeasKind::REMOVE;
+  m.confPct = confPct;
+  uploader_stamp(m);
+  if (correctsSeq) m.confPct = meas_correction_conf(m.seq, correctsSeq);
+  trace_begin(m.seq, w.detectMs - filterMs, w.detectMs, w.stableMs, m.monoMs);
+  trace_mark(m.seq, TraceMark::ENQUEUE);
+  (void)uploader_enqueue(m);   // never blocks; overflow is counted/logged there
+  metric_inc(Ctr::MEAS_EMITTED);
+  return m.seq;
+}
+
+// Conversion rate from the spacing of a few samples, for boards that strap
+// the RATE pin instead of wiring it to us
+static uint16_t measure_rate_sps(bool async) {
+  uint32_t us[9];
+  size_t n = 0;
+  for (; n < 9; ++n) {
+    HX::RawSample smp;
+    if (async) {
+      if (!HX::waitSample(smp, 500)) break;
+    } else {
+      (void)HX::readRaw();
+      smp.us = (uint32_t)micros();
+    }
+    us[n] = smp.us;
+  }
+  return filter_rate_from_stamps(us, n);
+}
+
 void sensor_start() {
   xTaskCreatePinnedToCore(
     sensorTask,
@@ -33,9 +97,9 @@ void sensor_start() {
 }
 
 static void sensorTask(void*) {
-  Serial.printf("[SENSOR] init HX711...\r\n");
+  LOGI("SENSOR", "init HX711...");
   if (!HX::init(HX_DOUT, HX_SCK, 128)) {
-    Serial.printf("[SENSOR] HX711 not ready (check pins/wiring)\r\n");
+    LOGW("SENSOR", "HX711 not ready (check pins/wiring)");
     vTaskDelete(nullptr);
     return;
   }
@@ -46,87 +110,126 @@ static void sensorTask(void*) {
 
   // Tare at boot (scale empty!)
   vTaskDelay(pdMS_TO_TICKS(2000));
-  (void)HX::getUnits(20);   // throw away
+  (void)HX::readRawAverage(20);   // throw away
   HX::tare(50);
-  Serial.printf("[SENSOR] tared\r\n");
+  LOGI("SENSOR", "tared");
+
+  // Stream every conversion through the decimating filter chain. If the
+  // async reader can't start we fall back to blocking single reads.
+  HX::setRate(HX_RATE_PIN, HX_RATE_SPS >= 80);
+  const bool async = HX::startAsync();
+  if (!async) LOGI("SENSOR", "async HX711 unavailable → blocking reads");
+
+  uint16_t sps = HX_RATE_SPS;
+  if (HX_RATE_PIN < 0) {
+    const uint16_t measured = measure_rate_sps(async);
+    if (measured) sps = measured;
+    else LOGW("SENSOR", "HX711 rate not measurable → assuming %u SPS", (unsigned)sps);
+  }
+  FilterChain chain({ sps, FILT_CIC_ORDER, (uint8_t)(sps / FILT_OUT_SPS), (FilterPost)FILT_POST });
+  NoiseMeter  noise(FILT_NOISE_N);
+  {
+    char desc[32];
+    chain.describe(desc, sizeof(desc));
+    LOGI("FILT", "%s → out every %lu ms, latency ~%lu ms",
+         desc, (unsigned long)chain.outPeriodMs(), (unsigned long)chain.latencyMs());
+  }
 
-  const TickType_t period = pdMS_TO_TICKS(100); // 100 ms = 10 Hz
+  // --- Live value: adaptive Kalman (quiet at rest, fast when moving) ---
+  AdaptiveKalman live(LIVE_SIGMA_MEAS_MG, LIVE_SIGMA_REST_MG, LIVE_GATE_SIGMA);
 
-  // --- Filtering for smoothness (single-pole IIR) ---
-  bool  haveFilt = false;
-  float filt     = 0.0f;
+  // --- Trigger / stability / early-settle decisions (features/measurement_logic) ---
+  // Static: the stability window is ~2 KB, keep it off the task stack
+  static MeasurementLogic logic({ DELTA_SEND_MG, STABILITY_MS, STABILITY_BAND_MG,
+                                  EARLY_SETTLE_ENABLED, EARLY_SETTLE_MIN_CONF,
+                                  { EARLY_SETTLE_MIN_SAMPLES, EARLY_SETTLE_MAX_RMS_MG,
+                                    EARLY_SETTLE_MAX_EXTRAP_MG, EARLY_SETTLE_MAX_DECAY_Q16 } });
+  char gBuf[16], gBuf2[16];
 
-  // --- Simple state machine for stable detection ---
-  enum DetectState { IDLE, STABILIZING };
-  DetectState state = IDLE;
+  bool wasPaused = false;
+  uint32_t earlySeq = 0;     // last early estimate sent, for its correction
 
-  float    lastStable   = 0.0f;  // last accepted stable value
-  float    candidate    = 0.0f;  // target we’re trying to stabilize around
-  bool     inBand       = false;
-  uint32_t stableSince  = 0;
-  
   for (;;) {
-  // Pause sensor during calibration
+  // Pause sensor during calibration/tare (they clock the chip themselves)
   if (app_get_bits() & AppBits::CALIB_ACTIVE) {
-    vTaskDelay(pdMS_TO_TICKS(100));
+    HX::RawSample drop;
+    while (HX::popSample(drop)) {}
+    wasPaused = true;
+    wake_note(WakeSrc::SENSOR);
+    app_wait_bits_clear(AppBits::CALIB_ACTIVE, 200);   // re-drain now and then
     continue;
   }
+  if (wasPaused) {
+    // Offset/scale may have changed: restart the chain from clean history
+    wasPaused = false;
+    chain.reset();
+    live.reset();
+    noise.reset();
+    logic.reset();
+  }
 
-  // Read an instantaneous-but-averaged value from HX711
-  float reading = HX::getUnits(10);   // already averaged by the lib
-
-  switch (state) {
-    case IDLE: {
-      float delta = fabsf(reading - lastStable);
-      if (delta >= DELTA_SEND_G) {
-        candidate   = reading;
-        inBand      = false;
-        stableSince = millis();
-        state       = STABILIZING;
-        Serial.printf("[MEAS] Δ=%.1fg detected → stabilizing near %.1f g\r\n", delta, candidate);
-      }
-      break;
-    }
+  // Next conversion (blocks only this task, at most ~one conversion period)
+  HX::RawSample smp;
+  if (async) {
+    const bool got = HX::waitSample(smp, 500);
+    wake_note(WakeSrc::SENSOR);
+    if (!got) continue;
+  } else {
+    smp.raw = (int32_t)HX::readRaw();
+    smp.us  = (uint32_t)micros();
+  }
 
-    case STABILIZING: {
-      if (fabsf(reading - candidate) <= STABILITY_BAND_G) {
-        if (!inBand) { inBand = true; stableSince = millis(); }
-      } else {
-        candidate   = reading;
-        inBand      = false;
-        stableSince = millis();
-      }
-
-      if (inBand && (millis() - stableSince) >= STABILITY_MS) {
-        // Take a precise value NOW (don’t use any IIR)
-        float finalVal = HX::getUnits(20);
-
-        float prev = lastStable;
-        lastStable = finalVal;
-
-        const bool increased = (finalVal - prev) >= 0.0f;
-        const char* kind     = increased ? "ADD" : "REMOVE";
-        Serial.printf("[MEAS] %s stable: %.1f g (prev %.1f g)\r\n", kind, finalVal, prev);
-        
-        if(!increased) {
-          finalVal = finalVal-prev;
-        }
-          
-        if (app_get_bits() & AppBits::NET_UP) { // only try if online
-          bool ok = api_post_weight(finalVal, DEVICE_NAME);
-          Serial.printf("[MEAS] post weight %.2f → %s\r\n", finalVal, ok ? "OK" : "FAIL");
-        } else {
-          Serial.println("[MEAS] offline; skipped post (later: queue for upload)");
-        }
-
-        state  = IDLE;
-        inBand = false;
-      }
-      break;
-    }
+  int32_t reading;
+  if (!chain.push(HX::rawToMg(smp.raw), reading)) continue;
+  // The output belongs to this conversion, not to when we got to it: back
+  // millis() off by the time the sample waited (smp.us wraps after ~71 min)
+  const uint32_t nowMs = millis() - ((uint32_t)micros() - smp.us) / 1000u;
+
+  const int32_t liveMg = live.update(reading);
+  s_liveMg   = liveMg;
+  s_liveMove = live.isMoving();
+
+  // Noise figure of the current chain while nothing is happening
+  if (logic.idle() && FILT_NOISE_N > 0 && noise.push(reading)) {
+    char desc[32];
+    chain.describe(desc, sizeof(desc));
+    weight_format_g(gBuf, sizeof(gBuf), noise.stddevMg(), 3);
+    LOGI("FILT", "%s noise σ=%s g over %u outputs (latency ~%lu ms, dropped=%lu)",
+         desc, gBuf, (unsigned)noise.n, (unsigned long)chain.latencyMs(),
+         (unsigned long)HX::droppedSamples());
+    noise.reset();
+  }
+
+  MeasurementLogic::Step st;
+  logic.push(nowMs, reading, liveMg, st);
+
+  if (st.triggered) {
+    noise.reset();
+    weight_format_g(gBuf, sizeof(gBuf), st.deltaMg, 1);
+    weight_format_g(gBuf2, sizeof(gBuf2), reading, 1);
+    LOGI("MEAS", "Δ=%sg detected → stabilizing near %s g", gBuf, gBuf2);
+  }
+
+  if (st.early) {
+    weight_format_g(gBuf, sizeof(gBuf), st.est.rmsMg, 3);
+    LOGI("MEAS", "early settle after %u samples: conf=%u%% fit rms=%s g",
+         (unsigned)logic.settleSamples(), (unsigned)st.est.confidencePct, gBuf);
+    earlySeq = emit_weight(st.earlyW, chain.latencyMs());
   }
 
-  vTaskDelay(period);  // ~100 ms (10 Hz)
+  if (st.settled) {
+    if (st.confirmed) {
+      weight_format_g(gBuf, sizeof(gBuf), st.finalW.valueMg, 1);
+      weight_format_g(gBuf2, sizeof(gBuf2), st.earlyErrMg, 1);
+      LOGI("MEAS", "confirmed %s g (early estimate off by %s g) → no repost", gBuf, gBuf2);
+    } else if (st.corrects) {
+      weight_format_g(gBuf, sizeof(gBuf), st.finalW.valueMg, 1);
+      LOGI("MEAS", "early estimate seq=%lu missed → corrected to %s g", (unsigned long)earlySeq, gBuf);
+      emit_weight(st.finalW, chain.latencyMs(), earlySeq);
+    } else {
+      emit_weight(st.finalW, chain.latencyMs());
+    }
+  }
 }
 
 }
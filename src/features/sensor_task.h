@@ -1,2 +1,8 @@
 #pragma once
+#include <stdint.h>
+
 void sensor_start();  // starts the background sensor task
+
+// Live weight after the adaptive filter (mg), updated every filter output
+int32_t sensor_live_mg();
+bool    sensor_live_moving();   // true while the filter sees the load moving
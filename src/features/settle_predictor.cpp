@@ -0,0 +1,78 @@
+#include "settle_predictor.h"
+#include "util/fixed_weight.h"
+
+static int64_t abs64(int64_t v) { return v < 0 ? -v : v; }
+
+void SettlePredictor::push(int32_t mg) {
+  buf[head] = mg;
+  head = (head + 1) % CAPACITY;
+  if (n < CAPACITY) n++;
+}
+
+int32_t SettlePredictor::at(size_t i) const {
+  return buf[(head + CAPACITY - n + i) % CAPACITY];
+}
+
+bool SettlePredictor::predict(Estimate& out) const {
+  const size_t minN = prm.minSamples < 4 ? 4 : prm.minSamples;
+  if (n < minN) return false;
+
+  // Pairs (u, v) = (y[i], y[i+1]) relative to the newest sample
+  const int32_t ref = at(n - 1);
+  const size_t  m   = n - 1;
+  int64_t su = 0, sv = 0;
+  for (size_t i = 0; i < m; ++i) {
+    su += (int64_t)at(i) - ref;
+    sv += (int64_t)at(i + 1) - ref;
+  }
+  const int64_t mu = su / (int64_t)m;
+  const int64_t mv = sv / (int64_t)m;
+
+  int64_t suu = 0, suv = 0;
+  for (size_t i = 0; i < m; ++i) {
+    const int64_t du = ((int64_t)at(i) - ref) - mu;
+    const int64_t dv = ((int64_t)at(i + 1) - ref) - mv;
+    suu += du * du;
+    suv += du * dv;
+  }
+
+  int64_t aQ16;
+  if (suu == 0) {
+    aQ16 = 0;                       // flat: already settled
+  } else {
+    // a = suv / suu in Q16; shift both so suv << 16 stays in range
+    int64_t num = suv, den = suu;
+    while (abs64(num) >= ((int64_t)1 << 46) || den >= ((int64_t)1 << 46)) { num /= 2; den /= 2; }
+    if (den == 0) return false;
+    aQ16 = (num * 65536) / den;
+  }
+
+  // Residual RMS of v - mv = a (u - mu)
+  uint64_t sse = 0;
+  for (size_t i = 0; i < m; ++i) {
+    const int64_t du = ((int64_t)at(i) - ref) - mu;
+    const int64_t dv = ((int64_t)at(i + 1) - ref) - mv;
+    const int64_t r  = dv - ((aQ16 * du) >> 16);
+    sse += (uint64_t)(r * r);
+  }
+  const int32_t rms = (int32_t)weight_isqrt64(sse / m);
+
+  if (suu != 0 && (aQ16 <= 0 || aQ16 >= prm.maxDecayQ16)) return false;
+  if (rms > prm.maxRmsMg) return false;
+
+  // A = mv + a (mv - mu) / (1 - a), all relative to ref
+  const int64_t aRel = mv + (aQ16 * (mv - mu)) / (65536 - aQ16);
+  const int64_t extrap = abs64(aRel);          // distance from the newest sample
+  if (extrap > prm.maxExtrapMg) return false;
+
+  int32_t conf = 100;
+  if (prm.maxRmsMg > 0)    conf -= (int32_t)(50 * (int64_t)rms / prm.maxRmsMg);
+  if (prm.maxExtrapMg > 0) conf -= (int32_t)(50 * extrap / prm.maxExtrapMg);
+  if (conf < 0) conf = 0;
+
+  out.valueMg       = ref + (int32_t)aRel;
+  out.rmsMg         = rms;
+  out.decayQ16      = (int32_t)aQ16;
+  out.confidencePct = (uint8_t)conf;
+  return true;
+}
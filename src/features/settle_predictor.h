@@ -0,0 +1,54 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Early "settled value" estimate from a load that is still settling
+// (no Arduino deps, integer only).
+//
+// Mechanical settling after a placement is close to an exponential approach
+// y(t) = A + B·a^t. For evenly spaced samples that means y[n+1] = a·y[n] + c,
+// so a least-squares line through the pairs (y[n], y[n+1]) gives a and c,
+// and the asymptote A = c / (1 - a).
+//
+// A prediction is offered only when
+//   - at least minSamples are in,
+//   - 0 < a < maxDecay (a decaying approach, not noise or a ramp),
+//   - the RMS fit residual is <= maxRmsMg,
+//   - the extrapolation |A - y_last| is <= maxExtrapMg.
+// confidencePct falls linearly with both the residual and the extrapolation
+// distance (100 = perfect fit on an already settled load).
+class SettlePredictor {
+public:
+  static constexpr size_t CAPACITY = 32;
+
+  struct Params {
+    uint8_t  minSamples;     // >= 4
+    int32_t  maxRmsMg;
+    int32_t  maxExtrapMg;
+    int32_t  maxDecayQ16;    // e.g. 0.95 · 65536
+  };
+
+  struct Estimate {
+    int32_t  valueMg;
+    int32_t  rmsMg;          // fit residual
+    int32_t  decayQ16;       // a
+    uint8_t  confidencePct;
+  };
+
+  explicit SettlePredictor(const Params& p) : prm(p) {}
+
+  void reset() { n = 0; head = 0; }
+  void push(int32_t mg);
+  size_t count() const { return n; }
+
+  // Fit over the buffered samples; true + 'out' when the criteria hold.
+  bool predict(Estimate& out) const;
+
+private:
+  int32_t at(size_t i) const;   // i = 0 oldest .. n-1 newest
+
+  Params  prm;
+  int32_t buf[CAPACITY];
+  size_t  n = 0;
+  size_t  head = 0;
+};
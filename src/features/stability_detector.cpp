@@ -0,0 +1,114 @@
+#include "stability_detector.h"
+
+static_assert((StabilityDetector::CAPACITY & (StabilityDetector::CAPACITY - 1)) == 0,
+              "CAPACITY must be a power of two");
+
+StabilityDetector::StabilityDetector(uint32_t windowMs, int32_t bandMg)
+  : winMs(windowMs), band(bandMg) {
+  reset();
+}
+
+void StabilityDetector::configure(uint32_t windowMs, int32_t bandMg) {
+  winMs = windowMs;
+  band  = bandMg;
+  reset();
+}
+
+void StabilityDetector::reset() {
+  head = tail = 0;
+  minHead = minTail = 0;
+  maxHead = maxTail = 0;
+  ref = 0;
+  sum = 0;
+  sumSq = 0;
+}
+
+void StabilityDetector::popOldest() {
+  if (head == tail) return;
+  const uint32_t seq = tail;
+  const int64_t d = (int64_t)at(seq).mg - ref;
+  sum   -= d;
+  sumSq -= d * d;
+  if (minHead != minTail && minQ[minTail & (CAPACITY - 1)] == seq) minTail++;
+  if (maxHead != maxTail && maxQ[maxTail & (CAPACITY - 1)] == seq) maxTail++;
+  tail++;
+}
+
+void StabilityDetector::push(uint32_t ms, int32_t mg) {
+  if (head == tail) {
+    // Empty window: re-anchor the reference so deviations stay small
+    ref = mg;
+    sum = 0;
+    sumSq = 0;
+  }
+  if (count() == CAPACITY) popOldest();
+
+  const uint32_t seq = head;
+  samples[seq & (CAPACITY - 1)] = Sample{ ms, mg };
+  head++;
+
+  const int64_t d = (int64_t)mg - ref;
+  sum   += d;
+  sumSq += d * d;
+
+  // max deque: values strictly decreasing front → back
+  while (maxHead != maxTail && at(maxQ[(maxHead - 1) & (CAPACITY - 1)]).mg <= mg) maxHead--;
+  maxQ[maxHead & (CAPACITY - 1)] = seq;
+  maxHead++;
+
+  // min deque: values strictly increasing front → back
+  while (minHead != minTail && at(minQ[(minHead - 1) & (CAPACITY - 1)]).mg >= mg) minHead--;
+  minQ[minHead & (CAPACITY - 1)] = seq;
+  minHead++;
+
+  // Slide: keep exactly one sample at/behind the window edge so that
+  // spanMs() reaches windowMs once enough history exists.
+  while (count() >= 2 && (uint32_t)(ms - at(tail + 1).ms) >= winMs) popOldest();
+}
+
+uint32_t StabilityDetector::spanMs() const {
+  if (count() < 2) return 0;
+  return at(head - 1).ms - at(tail).ms;
+}
+
+int32_t StabilityDetector::minMg() const {
+  if (minHead == minTail) return 0;
+  return at(minQ[minTail & (CAPACITY - 1)]).mg;
+}
+
+int32_t StabilityDetector::maxMg() const {
+  if (maxHead == maxTail) return 0;
+  return at(maxQ[maxTail & (CAPACITY - 1)]).mg;
+}
+
+int32_t StabilityDetector::meanMg() const {
+  const size_t n = count();
+  if (n == 0) return 0;
+  return ref + (int32_t)(sum / (int64_t)n);
+}
+
+int32_t StabilityDetector::recentMeanMg(uint32_t ms) const {
+  if (head == tail) return 0;
+  const uint32_t newest = at(head - 1).ms;
+  int64_t  acc = 0;
+  uint32_t n   = 0;
+  for (uint32_t seq = head; seq != tail; ) {
+    const Sample& s = at(--seq);
+    if ((uint32_t)(newest - s.ms) > ms) break;
+    acc += (int64_t)s.mg - ref;
+    n++;
+  }
+  return ref + (int32_t)(acc / (int64_t)n);
+}
+
+int64_t StabilityDetector::varianceMg2() const {
+  const size_t n = count();
+  if (n == 0) return 0;
+  const int64_t m = sum / (int64_t)n;
+  const int64_t v = sumSq / (int64_t)n - m * m;
+  return v < 0 ? 0 : v;
+}
+
+bool StabilityDetector::isStable() const {
+  return count() >= 2 && spanMs() >= winMs && spreadMg() <= 2 * band;
+}
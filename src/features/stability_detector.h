@@ -0,0 +1,65 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Time-based sliding-window stability detector (no Arduino/RTOS deps).
+//
+// Keeps the last 'windowMs' of samples and maintains, in O(1) amortised per
+// push:
+//   - running min/max via two monotonic deques,
+//   - running mean/variance via sums of deviations from a reference value.
+// "Stable" = the window spans at least windowMs AND max-min <= 2*bandMg
+// (i.e. every sample within ±bandMg of the window midpoint).
+//
+// Fixed storage: at most CAPACITY samples are held; if the sample rate is
+// high enough to exceed that within windowMs, the oldest are evicted early
+// (the window then simply never reports stable — size CAPACITY for the
+// fastest stream you feed it).
+class StabilityDetector {
+public:
+  static constexpr size_t CAPACITY = 128;   // power of two
+
+  StabilityDetector(uint32_t windowMs, int32_t bandMg);
+
+  void reset();
+  void configure(uint32_t windowMs, int32_t bandMg);   // also resets
+
+  // Timestamps must be non-decreasing (wrap-safe, uint32 millis()).
+  void push(uint32_t ms, int32_t mg);
+
+  bool     isStable() const;
+  size_t   count() const     { return (size_t)(head - tail); }
+  uint32_t spanMs() const;
+
+  int32_t  minMg() const;
+  int32_t  maxMg() const;
+  int32_t  spreadMg() const  { return count() ? (maxMg() - minMg()) : 0; }
+  int32_t  meanMg() const;
+  int32_t  recentMeanMg(uint32_t ms) const;   // samples within 'ms' of the newest, O(n)
+  int64_t  varianceMg2() const;   // population variance, mg²
+
+  uint32_t windowMs() const  { return winMs; }
+  int32_t  bandMg() const    { return band; }
+
+private:
+  struct Sample { uint32_t ms; int32_t mg; };
+
+  void popOldest();
+  const Sample& at(uint32_t seq) const { return samples[seq & (CAPACITY - 1)]; }
+
+  uint32_t winMs;
+  int32_t  band;
+
+  Sample   samples[CAPACITY];
+  uint32_t head = 0, tail = 0;          // sample sequence numbers [tail, head)
+
+  // Monotonic deques of sample sequence numbers
+  uint32_t minQ[CAPACITY], maxQ[CAPACITY];
+  uint32_t minHead = 0, minTail = 0;    // [minTail, minHead)
+  uint32_t maxHead = 0, maxTail = 0;
+
+  // Running sums of (mg - ref); ref keeps the squares small
+  int32_t  ref = 0;
+  int64_t  sum = 0;
+  int64_t  sumSq = 0;
+};
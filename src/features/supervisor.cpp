@@ -7,14 +7,24 @@
 #include "drivers/led_driver.h"
 #include "drivers/hx711_driver.h"
 #include "net/wifi_manager.h"
+#include "net/wifi_creds.h"
 #include "core/timekeeper.h"
 #include "features/sensor_task.h"
+#include "features/uploader.h"
 #include "storage/nvs_store.h"
+#include "storage/spool_queue.h"
+#include "core/sequence.h"
 #include "drivers/button_driver.h"
 #include "features/calibration.h"
 #include "net/http_client.h"
+#include "net/stream_client.h"
 #include "core/identity.h"
 #include "net/api_client.h"
+#include "core/event_bus.h"
+#include "core/wake_stats.h"
+#include "core/metrics.h"
+#include "features/latency_trace.h"
+#include "util/log.h"
 
 
 static void uiTask(void*);
@@ -89,21 +99,26 @@ void supervisor_start() {
   led_setPattern(LedId::LED2, LEDPattern::OFF);
 
   nvs_init("smartscale");
+  seq_init();
+  trace_init();
+  wake_stats_start();
+  if (LOG_BENCH_AT_BOOT) log_benchmark(64);
 
   // Indicate we’re checking for boot combo
   led_setPattern(LedId::LED1, LEDPattern::FAST_BLINK);
-  Serial.println("[BOOT] Hold BOTH buttons ~3s to clear Wi-Fi creds...");
+  LOGI("BOOT", "Hold BOTH buttons ~3s to clear Wi-Fi creds...");
 
   if (boot_combo_held(BOOT_WIPE_HOLD_MS, /*activeLow=*/true)) {
-    Serial.println("[BOOT] Combo detected → clearing Wi-Fi creds");
+    LOGI("BOOT", "Combo detected → clearing Wi-Fi creds");
     led_setPattern(LedId::LED1, LEDPattern::SOLID);
 
     vTaskDelay(pdMS_TO_TICKS(1000));
 
-    nvs_remove_key(WIFI_KEY_SSID);
-    nvs_remove_key(WIFI_KEY_PASS);
+    wifi_creds_clear();
+    nvs_remove_key(WIFI_KEY_FAST);
 
     vTaskDelay(pdMS_TO_TICKS(300));
+    log_flush(500);
     ESP.restart();
   }
 
@@ -115,6 +130,7 @@ void supervisor_start() {
   timekeeper_start();
 
   http_init(SERVER_BASE_URL);
+  stream_init();
 
 
   ButtonDriverConfig bcfg{
@@ -129,7 +145,10 @@ void supervisor_start() {
 
   calibration_try_load();
 
+  spool_init();      // before the uploader: it decides flash vs RAM at start
+  uploader_start();
   sensor_start();
+  metrics_start();
 
   // Start UI task
   xTaskCreatePinnedToCore(
@@ -164,28 +183,38 @@ void supervisor_start() {
   );*/
 }
 
+// Re-evaluate both LED patterns. Only called on state changes; the LED
+// driver animates the chosen pattern on its own timers.
+static void apply_patterns(LEDPattern& curMain, LEDPattern& curAux) {
+  LEDPattern desMain = selectPatternMain();
+  LEDPattern desAux  = selectPatternAux();
+
+  if (desMain != curMain) {
+    curMain = desMain;
+    led_setPattern(LedId::LED1, curMain);
+    LOGI("LED1", "pattern → %s", led_patternName(curMain));
+  }
+  if (desAux != curAux) {
+    curAux = desAux;
+    led_setPattern(LedId::LED2, curAux);
+    LOGI("LED2", "pattern → %s", led_patternName(curAux));
+  }
+}
+
 static void uiTask(void*) {
+  EventSub sub = event_subscribe(event_bit(EventType::STATE), 4);
+
+  // Boot sequence left LED1 on SLOW_BLINK; catch up with bits set before
+  // we subscribed, then sleep until the next state change
   LEDPattern curMain = LEDPattern::SLOW_BLINK;
   LEDPattern curAux  = LEDPattern::OFF;
+  apply_patterns(curMain, curAux);
 
   for (;;) {
-    LEDPattern desMain = selectPatternMain();
-    LEDPattern desAux  = selectPatternAux();
-
-    if (desMain != curMain) {
-      curMain = desMain;
-      led_setPattern(LedId::LED1, curMain);
-      Serial.printf("[LED1] pattern → %s\r\n", led_patternName(curMain));
-    }
-    if (desAux != curAux) {
-      curAux = desAux;
-      led_setPattern(LedId::LED2, curAux);
-      Serial.printf("[LED2] pattern → %s\r\n", led_patternName(curAux));
-    }
-
-    // Tick both LEDs once per loop
-    led_tick_all();
-    vTaskDelay(pdMS_TO_TICKS(LED_TICK_MS));
+    Event ev;
+    if (!event_receive(sub, ev, portMAX_DELAY)) continue;
+    wake_note(WakeSrc::UI);
+    apply_patterns(curMain, curAux);
   }
 }
 
@@ -193,26 +222,31 @@ static void buttonTask(void*) {
   for (;;) {
     ButtonEvent ev;
     if (buttons_get_event(ev, portMAX_DELAY)) {   // block until event
+      wake_note(WakeSrc::BTN_HANDLER);
       if (ev.type == ButtonEventType::BOTH_LONG) {
-        Serial.printf("[BTN] Both long → calibration\r\n");
+        LOGI("BTN", "Both long → calibration");
         app_set_bits(AppBits::CALIB_ACTIVE);
 
         bool ok = calibration_run_100g();
 
         app_clear_bits(AppBits::CALIB_ACTIVE);
-        Serial.printf("[BTN] Calibration %s\r\n", ok ? "OK" : "FAILED");
+        LOGI("BTN", "Calibration %s", ok ? "OK" : "FAILED");
       }
       else if (ev.type == ButtonEventType::BTN1_SHORT) {
         app_set_bits(AppBits::CALIB_ACTIVE);
         HX::tare(30);
         app_clear_bits(AppBits::CALIB_ACTIVE);
-        Serial.println("[BTN] Tare done");
+        LOGI("BTN", "Tare done");
+      }
+      else if (ev.type == ButtonEventType::BTN1_LONG) {
+        LOGI("BTN", "BTN1 long → Wi-Fi setup portal");
+        wifi_request_portal();
       }
       else if (ev.type == ButtonEventType::BTN2_SHORT) {
-        Serial.println("[BTN] Measurement finished");
+        LOGI("BTN", "Measurement finished");
         uint32_t ts = time_epoch();
-        bool ok = api_post_finish(ts);
-        Serial.printf("[BTN] Measurement finished → POST %s\r\n", ok ? "OK" : "FAIL");
+        bool ok = uploader_post_finish(ts);
+        LOGI("BTN", "Measurement finished → %s", ok ? "queued" : "DROPPED");
       }
     }
   }
@@ -0,0 +1,24 @@
+#include "trace_stages.h"
+
+void trace_stages(const TraceMarks& t, uint32_t ackMs, uint32_t out[(uint8_t)TraceStage::COUNT]) {
+  auto at  = [&](TraceMark m) { return t.ms[(uint8_t)m]; };
+  auto has = [&](TraceMark m) { return (t.have & (1u << (uint8_t)m)) != 0; };
+  auto set = [&](TraceStage s, uint32_t v) { out[(uint8_t)s] = v; };
+
+  const bool enq  = has(TraceMark::ENQUEUE);
+  const bool sent = has(TraceMark::SEND);
+  const uint32_t queued = enq ? at(TraceMark::ENQUEUE) : at(TraceMark::FINAL);
+  set(TraceStage::FILTER,  at(TraceMark::DETECT) - at(TraceMark::SAMPLE));
+  set(TraceStage::STABLE,  at(TraceMark::STABLE) - at(TraceMark::DETECT));
+  set(TraceStage::FINAL,   at(TraceMark::FINAL) - at(TraceMark::STABLE));
+  set(TraceStage::ENQUEUE, enq ? at(TraceMark::ENQUEUE) - at(TraceMark::FINAL) : 0);
+  set(TraceStage::QUEUE,   (sent ? at(TraceMark::SEND) : ackMs) - queued);
+  set(TraceStage::SEND,    sent ? ackMs - at(TraceMark::SEND) : 0);
+  set(TraceStage::TOTAL,   ackMs - at(TraceMark::SAMPLE));
+}
+
+uint8_t trace_window_pct(uint64_t window, uint8_t n) {
+  if (n == 0) return 100;
+  const uint64_t mask = (n >= 64) ? ~0ull : (1ull << n) - 1;
+  return (uint8_t)(__builtin_popcountll(window & mask) * 100u / n);
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <stdint.h>
+
+// Stage math of features/latency_trace (no Arduino deps; times are passed in).
+//
+//   SAMPLE → DETECT → STABLE → FINAL → ENQUEUE → SEND → ack
+//   filter   stable   final    enqueue  queue     send
+//
+// SAMPLE is the ADC conversion that carried the load change: the filter
+// output that crossed the trigger lags it by the chain's group delay.
+// Differences are modular, so millis() may wrap inside a trace.
+
+enum class TraceMark : uint8_t { SAMPLE, DETECT, STABLE, FINAL, ENQUEUE, SEND, ACK, COUNT };
+
+// Stage durations, in LAT_* histogram order (core/metrics.h)
+enum class TraceStage : uint8_t { FILTER, STABLE, FINAL, ENQUEUE, QUEUE, SEND, TOTAL, COUNT };
+
+struct TraceMarks {
+  uint32_t ms[(uint8_t)TraceMark::COUNT];   // millis() per mark
+  uint8_t  have;                            // bit per TraceMark
+};
+
+// Durations of a trace acked at ackMs. SAMPLE..FINAL are always set by the
+// sensor task; without ENQUEUE the queue stage runs from FINAL, and without
+// SEND the wait until the ack counts as queue time (send = 0).
+void trace_stages(const TraceMarks& t, uint32_t ackMs, uint32_t out[(uint8_t)TraceStage::COUNT]);
+
+// Share (%) of the newest n bits of 'window' that are set; 100 when n = 0
+uint8_t trace_window_pct(uint64_t window, uint8_t n);
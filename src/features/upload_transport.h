@@ -0,0 +1,31 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "features/measurement.h"
+
+// Why a send stopped short. UNREACHABLE feeds the uploader's retry
+// scheduler / circuit breaker; REJECTED means the server answered but
+// refused recs[done] (counted against that record, UPLOAD_MAX_ATTEMPTS).
+enum class TxError : uint8_t { NONE, UNREACHABLE, REJECTED };
+
+// How the uploader gets records to the server. One instance per transport,
+// picked at start from UPLOAD_TRANSPORT; the uploader only sees this table.
+struct UploadTransport {
+  const char* name;
+
+  // Deliver recs[0..n) in order (n >= 1; weights and FINISH events).
+  // Returns how many leading records the server confirmed; the rest stay
+  // queued/spooled and are resent with the same seq/boot. Sets 'err' when
+  // it stopped short on an error (a batch acknowledged in part is not one).
+  // Makes one attempt; no retries or sleeps inside.
+  size_t (*send)(const Measurement* recs, size_t n, TxError& err);
+
+  // Housekeeping while idle (heartbeats, incoming frames); may be null.
+  void (*poll)();
+  uint32_t pollMs;      // how often poll() wants to run while online (0 = never)
+};
+
+// HTTP request/response (api_client): batches when n > 1, single posts otherwise
+extern const UploadTransport HTTP_TRANSPORT;
+// One persistent framed TLS connection (net/stream_client)
+extern const UploadTransport STREAM_TRANSPORT;
@@ -0,0 +1,375 @@
+#include "uploader.h"
+
+#include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_system.h"      // esp_random()
+
+#include "app_config.h"
+#include "core/app_state.h"
+#include "features/upload_transport.h"
+#include "net/api_client.h"
+#include "core/sequence.h"
+#include "core/wake_stats.h"
+#include "core/metrics.h"
+#include "features/latency_trace.h"
+#include "storage/spool_queue.h"
+#include "util/fixed_weight.h"
+#include "util/retry_scheduler.h"
+#include "util/log.h"
+
+static QueueHandle_t s_q = nullptr;
+
+static volatile uint32_t s_highWater = 0;
+static volatile uint32_t s_enqueued  = 0;
+static volatile uint32_t s_dropped   = 0;
+static volatile uint32_t s_sent      = 0;
+static volatile uint32_t s_failed    = 0;
+static volatile uint32_t s_spooled   = 0;
+static volatile uint32_t s_batches   = 0;
+static uint32_t          s_batchPauseAtMs = 0;        // a batch was refused: single posts for a while
+static const UploadTransport* s_tx   = &HTTP_TRANSPORT;
+
+// Spaces out attempts while the server is unreachable; driven by the
+// uploader task only, s_retryMux just keeps uploader_get_retry_stats() whole.
+static RetryScheduler s_retry({ RETRY_BASE_MS, RETRY_MAX_MS, BREAKER_OPEN_AFTER,
+                                BREAKER_OPEN_MS, BREAKER_OPEN_MAX_MS }, 1);
+static portMUX_TYPE   s_retryMux = portMUX_INITIALIZER_UNLOCKED;
+
+static void uploaderTask(void*);
+
+bool uploader_start() {
+  s_tx = (UPLOAD_TRANSPORT == 1) ? &STREAM_TRANSPORT : &HTTP_TRANSPORT;
+  LOGI("UPLOAD", "transport: %s", s_tx->name);
+  s_retry.seed(esp_random());        // desynchronise backoff across devices
+
+  if (!s_q) {
+    s_q = xQueueCreate(MEAS_Q_LEN, sizeof(Measurement));
+    if (!s_q) return false;
+  }
+
+  BaseType_t ok = xTaskCreatePinnedToCore(
+    uploaderTask,
+    "uploader",
+    TASK_STACK_UPLOAD,      // HTTPS handshake runs on this stack
+    nullptr,
+    TASK_PRIO_UPLOAD,
+    nullptr,
+    (TASK_CORE_UPLOAD < 0) ? tskNO_AFFINITY : TASK_CORE_UPLOAD
+  );
+  return ok == pdPASS;
+}
+
+void uploader_stamp(Measurement& m) {
+  m.seq    = seq_next();
+  m.boot   = (uint16_t)seq_boot_id();
+  m.monoMs = millis();
+}
+
+bool uploader_enqueue(const Measurement& m) {
+  if (!s_q) return false;
+
+  bool accepted = true;
+  if (xQueueSendToBack(s_q, &m, 0) != pdPASS) {
+    if (MEAS_Q_DROP_OLDEST) {
+      Measurement old;
+      if (xQueueReceive(s_q, &old, 0) == pdPASS) {
+        LOGW("UPLOAD", "queue full → dropped oldest seq=%lu", (unsigned long)old.seq);
+      }
+      accepted = xQueueSendToBack(s_q, &m, 0) == pdPASS;
+    } else {
+      accepted = false;
+      LOGW("UPLOAD", "queue full → dropped seq=%lu", (unsigned long)m.seq);
+    }
+    s_dropped++;
+  }
+  if (accepted) s_enqueued++;
+
+  const uint32_t depth = (uint32_t)uxQueueMessagesWaiting(s_q);
+  if (depth > s_highWater) s_highWater = depth;
+  return accepted;
+}
+
+void uploader_get_stats(UploaderStats& out) {
+  out.depth     = s_q ? (uint32_t)uxQueueMessagesWaiting(s_q) : 0;
+  out.highWater = s_highWater;
+  out.enqueued  = s_enqueued;
+  out.dropped   = s_dropped;
+  out.sent      = s_sent;
+  out.failed    = s_failed;
+  out.spooled   = s_spooled;
+  out.batches   = s_batches;
+  out.backlog   = spool_size();
+}
+
+void uploader_get_retry_stats(RetryScheduler::Stats& out) {
+  portENTER_CRITICAL(&s_retryMux);
+  out = s_retry.stats();
+  portEXIT_CRITICAL(&s_retryMux);
+}
+
+// Batch only what the server negotiated in welcome, and not again for
+// BATCH_REJECT_PAUSE_MS after it refused one (the records go singly then)
+static bool batching() {
+  if (!BATCH_ENABLED) return false;
+  if (s_tx != &HTTP_TRANSPORT) return true;            // the stream takes records in runs
+  if (!api_batches_supported()) return false;
+  if (s_batchPauseAtMs && (millis() - s_batchPauseAtMs) < BATCH_REJECT_PAUSE_MS) return false;
+  s_batchPauseAtMs = 0;
+  return true;
+}
+
+static ApiResult post_one(const Measurement& m) {
+  if (m.kind == MeasKind::FINISH) return api_post_finish(m);
+  return api_post_weight(m, DEVICE_NAME);
+}
+
+static const char* kind_name(MeasKind k) {
+  switch (k) {
+    case MeasKind::ADD:    return "ADD";
+    case MeasKind::REMOVE: return "REMOVE";
+    case MeasKind::FINISH: return "FINISH";
+  }
+  return "?";
+}
+
+static bool net_up() {
+  return (app_get_bits() & AppBits::NET_UP) != 0;
+}
+
+static ApiResult post_logged(const Measurement& m, const char* via) {
+  const uint32_t t0 = millis();
+  const ApiResult r = post_one(m);
+  const bool ok = r == ApiResult::OK;
+  char gBuf[16];
+  weight_format_g(gBuf, sizeof(gBuf), m.mg, 2);
+  LOGI("UPLOAD", "seq=%lu %s %s g → %s (%s, %lu ms, queued %lu ms, depth=%u)",
+       (unsigned long)m.seq, kind_name(m.kind), m.kind == MeasKind::FINISH ? "-" : gBuf,
+       ok ? "OK" : (r == ApiResult::REJECTED ? "REJECTED" : "FAIL"), via, (unsigned long)(millis() - t0),
+       (unsigned long)(t0 - m.monoMs), (unsigned)uxQueueMessagesWaiting(s_q));
+  if (ok) s_sent++;
+  return r;
+}
+
+static void spool_or_drop(const Measurement& m) {
+  if (spool_push(m)) {
+    s_spooled++;
+  } else {
+    s_failed++;
+    LOGW("UPLOAD", "seq=%lu spool write failed → dropped", (unsigned long)m.seq);
+  }
+}
+
+// HTTP transport: deliver recs[0..n) in order; returns how many the server
+// accepted (a prefix). Uses one batch request when there is more than one
+// record.
+static size_t http_tx_send(const Measurement* recs, size_t n, TxError& err) {
+  const char* via = "http";
+  if (n > 1 && batching()) {
+    size_t sent = 0;
+    const uint32_t t0 = millis();
+    const ApiResult r = api_post_weights(recs, n, DEVICE_NAME, sent);
+    LOGI("UPLOAD", "batch seq=%lu..%lu (%u/%u) → %s (%s, %lu ms)",
+         (unsigned long)recs[0].seq, (unsigned long)recs[n - 1].seq,
+         (unsigned)sent, (unsigned)n,
+         r == ApiResult::OK ? "OK" : r == ApiResult::FAILED ? "FAIL" :
+         r == ApiResult::NO_BATCH ? "NO_BATCH" : "REJECTED",
+         via, (unsigned long)(millis() - t0));
+    if (r == ApiResult::OK) { s_sent += sent; s_batches++; return sent; }
+    if (r == ApiResult::FAILED) { err = TxError::UNREACHABLE; return 0; }
+    if (r == ApiResult::NO_BATCH) {
+      LOGI("UPLOAD", "server does not take batches → single posts until the next welcome");
+    } else {
+      s_batchPauseAtMs = millis() | 1;      // 0 = not paused
+      LOGI("UPLOAD", "server rejected batch → single posts for %lu s",
+           (unsigned long)(BATCH_REJECT_PAUSE_MS / 1000));
+    }
+  }
+
+  size_t done = 0;
+  while (done < n) {
+    const ApiResult r = post_logged(recs[done], via);
+    if (r != ApiResult::OK) {
+      err = (r == ApiResult::REJECTED) ? TxError::REJECTED : TxError::UNREACHABLE;
+      break;
+    }
+    done++;
+  }
+  return done;
+}
+
+const UploadTransport HTTP_TRANSPORT = {
+  "http",
+  http_tx_send,
+  nullptr,
+  0
+};
+
+// 0 = an attempt may start now, else ms until the scheduler allows one
+static uint32_t retry_wait_ms() {
+  portENTER_CRITICAL(&s_retryMux);
+  const uint32_t w = s_retry.waitMs(millis());
+  portEXIT_CRITICAL(&s_retryMux);
+  return w;
+}
+
+// One transport attempt, with its outcome reported to the scheduler. A
+// rejection (or any progress) means the server is up; only UNREACHABLE
+// backs off / trips the breaker. Counts what non-HTTP transports delivered
+// (HTTP counts inside post_logged/batch).
+static size_t tx_send(const Measurement* recs, size_t n, TxError& err) {
+  err = TxError::NONE;
+  portENTER_CRITICAL(&s_retryMux);
+  const bool go = s_retry.begin(millis());
+  const RetryScheduler::State before = s_retry.state();
+  portEXIT_CRITICAL(&s_retryMux);
+  if (!go) { err = TxError::UNREACHABLE; return 0; }
+  if (before == RetryScheduler::State::HALF_OPEN) {
+    LOGI("UPLOAD", "breaker HALF_OPEN → probing server");
+  }
+
+  for (size_t i = 0; i < n; ++i) trace_mark(recs[i].seq, TraceMark::SEND);
+  const uint32_t t0 = millis();
+  const size_t done = s_tx->send(recs, n, err);
+  metric_observe(Hist::POST_MS, millis() - t0);
+  for (size_t i = 0; i < done; ++i) trace_ack(recs[i].seq);
+  metric_inc(Ctr::POST_OK, (uint32_t)done);
+  if (done < n) metric_inc(Ctr::POST_FAIL, (uint32_t)(n - done));
+  if (s_tx != &HTTP_TRANSPORT) s_sent += done;
+  const bool serverUp = done > 0 || err != TxError::UNREACHABLE;
+
+  portENTER_CRITICAL(&s_retryMux);
+  if (serverUp) s_retry.onSuccess(millis());
+  else          s_retry.onFailure(millis());
+  const RetryScheduler::Stats st = s_retry.stats();
+  portEXIT_CRITICAL(&s_retryMux);
+
+  if (st.state != before) {
+    if (st.state == RetryScheduler::State::OPEN) {
+      LOGW("UPLOAD", "breaker %s → %s for %lu ms (%lu failures)", RetryScheduler::stateName(before),
+           RetryScheduler::stateName(st.state), (unsigned long)st.lastDelayMs,
+           (unsigned long)st.consecutiveFails);
+    } else {
+      LOGI("UPLOAD", "breaker %s → %s", RetryScheduler::stateName(before),
+           RetryScheduler::stateName(st.state));
+    }
+  } else if (!serverUp) {
+    LOGW("UPLOAD", "server unreachable (%lu in a row) → retry in %lu ms",
+         (unsigned long)st.consecutiveFails, (unsigned long)st.lastDelayMs);
+  }
+  return done;
+}
+
+bool uploader_post_finish(uint32_t epoch) {
+  Measurement m{};
+  m.kind    = MeasKind::FINISH;
+  m.epoch   = epoch;
+  m.confPct = 100;
+  uploader_stamp(m);
+  return uploader_enqueue(m);
+}
+
+// No spool partition: hold the record in RAM until it is sent or the
+// server has rejected it UPLOAD_MAX_ATTEMPTS times.
+static void send_from_ram(const Measurement& m) {
+  uint8_t rejects = 0;
+  for (;;) {
+    // Park until the network is up (no polling)
+    app_wait_bits(AppBits::NET_UP, portMAX_DELAY);
+
+    const uint32_t w = retry_wait_ms();
+    if (w) { vTaskDelay(pdMS_TO_TICKS(w) + 1); continue; }
+
+    TxError err;
+    if (tx_send(&m, 1, err) == 1) return;
+    if (err != TxError::REJECTED) continue;        // scheduler paces the retry
+
+    if (++rejects >= UPLOAD_MAX_ATTEMPTS) {
+      s_failed++;
+      LOGW("UPLOAD", "seq=%lu rejected %u times → dropped",
+           (unsigned long)m.seq, (unsigned)rejects);
+      return;
+    }
+    vTaskDelay(pdMS_TO_TICKS(UPLOAD_RETRY_MS));
+  }
+}
+
+// Replay the oldest spooled records. They are committed (removed from
+// flash) only after the server accepted them, so a reboot mid-post resends.
+// An unreachable server never costs a record; only repeated rejections do.
+static void drain_some(uint8_t& rejects) {
+  static Measurement recs[BATCH_MAX_RECORDS];   // uploader task only
+  const size_t n = spool_peek(recs, batching() ? BATCH_MAX_RECORDS : 1);
+  if (n == 0) return;
+
+  TxError err;
+  const size_t done = tx_send(recs, n, err);
+  if (done > 0) {
+    spool_commit(done);
+    rejects = 0;
+    return;
+  }
+  if (err != TxError::REJECTED) return;          // scheduler paces the retry
+
+  if (++rejects >= UPLOAD_MAX_ATTEMPTS) {
+    spool_commit(1);
+    s_failed++;
+    rejects = 0;
+    LOGW("UPLOAD", "seq=%lu rejected %u times → dropped (spool)",
+         (unsigned long)recs[0].seq, (unsigned)UPLOAD_MAX_ATTEMPTS);
+    return;
+  }
+  vTaskDelay(pdMS_TO_TICKS(UPLOAD_RETRY_MS));
+}
+
+static void uploaderTask(void*) {
+  uint8_t drainRejects = 0;
+
+  for (;;) {
+    const bool spool   = spool_ready();
+    const bool online  = net_up();
+    const bool backlog = spool && spool_size() > 0;
+    const uint32_t retryWait = online ? retry_wait_ms() : 0;
+    const bool ready   = online && retryWait == 0;    // backoff / breaker allow a try
+
+    // Busy draining → only peek at the queue; otherwise block on it. With
+    // records on flash we wake up periodically to notice NET_UP, or when
+    // the retry scheduler allows the next attempt.
+    TickType_t wait = portMAX_DELAY;
+    if (backlog) {
+      wait = ready ? 0 : pdMS_TO_TICKS(UPLOAD_IDLE_WAIT_MS);
+      if (online && !ready && retryWait < UPLOAD_IDLE_WAIT_MS) wait = pdMS_TO_TICKS(retryWait) + 1;
+    }
+    // Transports with a live connection need regular heartbeats
+    const bool wantPoll = ready && s_tx->poll && s_tx->pollMs;
+    if (wantPoll && wait > pdMS_TO_TICKS(s_tx->pollMs)) wait = pdMS_TO_TICKS(s_tx->pollMs);
+
+    // Take ownership of the head record; the producer may drop queued
+    // records on overflow, but never the one we are working on.
+    Measurement m;
+    const bool got = xQueueReceive(s_q, &m, wait) == pdPASS;
+    wake_note(WakeSrc::UPLOAD);
+    if (got) {
+      if (!spool) { send_from_ram(m); continue; }
+
+      // Keep FIFO order: anything behind a backlog goes to the back of it.
+      // While backing off, new records wait on flash as well.
+      if (!ready || backlog) { spool_or_drop(m); continue; }
+
+      // Anything else already queued rides along in the same request
+      static Measurement recs[BATCH_MAX_RECORDS];   // uploader task only
+      size_t n = 0;
+      recs[n++] = m;
+      while (n < BATCH_MAX_RECORDS && batching() && xQueueReceive(s_q, &recs[n], 0) == pdPASS) n++;
+
+      TxError err;
+      const size_t done = tx_send(recs, n, err);
+      for (size_t i = done; i < n; ++i) spool_or_drop(recs[i]);   // retried from flash
+      continue;
+    }
+
+    if (backlog && ready) drain_some(drainRejects);
+    else if (wantPoll) s_tx->poll();
+  }
+}
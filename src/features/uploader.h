@@ -0,0 +1,50 @@
+#pragma once
+#include <stdint.h>
+#include "features/measurement.h"
+#include "util/retry_scheduler.h"
+
+// Measurement upload pipeline: the sensor task enqueues fixed-size records
+// into a bounded queue (never blocks), a dedicated task drains it and posts.
+// While offline (or after a failed post) records go to the flash spool and
+// are replayed oldest-first once NET_UP is back. Without a spool partition
+// the task falls back to holding records in RAM until the network returns.
+// When more than one record is pending they go out as one batch request
+// (api_post_weights). A refused batch is posted singly; only 404/405/415
+// (no batch endpoint) switches to single posts for the rest of the boot.
+// The wire side is an UploadTransport (HTTP or persistent stream), chosen
+// by UPLOAD_TRANSPORT. When the server is unreachable, a RetryScheduler
+// spaces attempts out (jittered exponential backoff) and, after
+// BREAKER_OPEN_AFTER failures in a row, stops them altogether until a
+// single half-open probe gets through; records wait on flash meanwhile.
+
+struct UploaderStats {
+  uint32_t depth;       // records waiting (excludes the one in flight)
+  uint32_t highWater;   // max depth seen
+  uint32_t enqueued;
+  uint32_t dropped;     // lost to overflow
+  uint32_t sent;
+  uint32_t failed;      // dropped after UPLOAD_MAX_ATTEMPTS rejections
+  uint32_t spooled;     // written to flash for later replay
+  uint32_t batches;     // multi-record requests accepted
+  uint32_t backlog;     // records currently in the spool
+};
+
+bool uploader_start();
+
+// Fill seq/boot/monoMs of a new record (core/sequence). A record keeps
+// them through queue, spool and every retry, so resends are idempotent.
+void uploader_stamp(Measurement& m);
+
+// Non-blocking. When full: MEAS_Q_DROP_OLDEST discards the oldest queued
+// record to make room, otherwise the new record is rejected.
+// Returns false if the new record itself was dropped.
+bool uploader_enqueue(const Measurement& m);
+
+void uploader_get_stats(UploaderStats& out);
+
+// Backoff / circuit breaker state and counters.
+void uploader_get_retry_stats(RetryScheduler::Stats& out);
+
+// Queue a FINISH event (non-blocking); it is delivered, spooled and
+// retried like a weight record, with its own seq.
+bool uploader_post_finish(uint32_t epoch);
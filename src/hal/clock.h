@@ -0,0 +1,9 @@
+#pragma once
+#include <stdint.h>
+
+// Time source for code that must also run on a PC. On the device these are
+// millis()/micros()/vTaskDelay; the host fake (hal/fake.h) is a virtual
+// clock that only moves when told to (or when a fake peripheral blocks).
+uint32_t hal_millis();
+uint32_t hal_micros();
+void     hal_delay_ms(uint32_t ms);
@@ -0,0 +1,195 @@
+// Host side of the HAL and nvs_store: see hal/fake.h.
+#include "hal/fake.h"
+#include <math.h>
+#include <string.h>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "hal/clock.h"
+#include "hal/gpio.h"
+#include "hal/hx711_port.h"
+#include "hal/http_port.h"
+#include "hal/serial.h"
+#include "storage/nvs_store.h"
+#include "util/xorshift.h"
+
+// ---- Clock ----
+
+static uint64_t s_us = 0;
+
+void     fake_clock_set_us(uint64_t us)     { s_us = us; }
+void     fake_clock_advance_us(uint64_t us) { s_us += us; }
+uint64_t fake_clock_us()                    { return s_us; }
+
+uint32_t hal_millis()              { return (uint32_t)(s_us / 1000); }
+uint32_t hal_micros()              { return (uint32_t)s_us; }
+void     hal_delay_ms(uint32_t ms) { s_us += (uint64_t)ms * 1000; }
+
+// ---- Serial ----
+
+static std::string s_serial;
+static std::mutex  s_serialMu;   // writers may be threads, as on the device UART driver
+
+void hal_serial_write(const uint8_t* data, size_t len) {
+  std::lock_guard<std::mutex> lock(s_serialMu);
+  s_serial.append((const char*)data, len);
+}
+void hal_serial_flush() {}
+
+const std::string& fake_serial_output() { return s_serial; }
+void fake_serial_clear()                { s_serial.clear(); }
+
+// ---- GPIO ----
+
+static constexpr int MAX_PINS = 48;
+
+struct FakePin {
+  bool level = true;       // pulled up
+  bool output = false;
+  void (*onFall)() = nullptr;
+};
+static FakePin s_pins[MAX_PINS];
+
+static FakePin* pin_at(int pin) { return (pin >= 0 && pin < MAX_PINS) ? &s_pins[pin] : nullptr; }
+
+void hal_gpio_output(int pin) { if (FakePin* p = pin_at(pin)) p->output = true; }
+void hal_gpio_input(int pin)  { if (FakePin* p = pin_at(pin)) p->output = false; }
+void hal_gpio_write(int pin, bool high) { if (FakePin* p = pin_at(pin)) p->level = high; }
+bool hal_gpio_read(int pin) { const FakePin* p = pin_at(pin); return p ? p->level : true; }
+void hal_gpio_on_falling(int pin, void (*isr)()) { if (FakePin* p = pin_at(pin)) p->onFall = isr; }
+void hal_gpio_detach(int pin) { if (FakePin* p = pin_at(pin)) p->onFall = nullptr; }
+
+void fake_gpio_set(int pin, bool high) {
+  FakePin* p = pin_at(pin);
+  if (!p) return;
+  const bool fell = p->level && !high;
+  p->level = high;
+  if (fell && p->onFall) p->onFall();
+}
+
+bool fake_gpio_get(int pin)       { return hal_gpio_read(pin); }
+bool fake_gpio_is_output(int pin) { const FakePin* p = pin_at(pin); return p && p->output; }
+
+// ---- HX711 ----
+
+static FakeHx711Config s_hxCfg = { 80, 0, 420.0f, 0, 1 };
+static XorShift32 s_rng;
+static uint64_t s_nextConvUs = 0;
+static uint32_t s_reads      = 0;
+static int32_t  s_fromMg     = 0;    // mass when the current load was placed
+static int32_t  s_toMg       = 0;
+static uint64_t s_loadUs     = 0;
+static uint32_t s_settleMs   = 0;
+
+static uint64_t conv_period_us() { return 1000000u / (s_hxCfg.sps ? s_hxCfg.sps : 10); }
+
+void fake_hx711_config(const FakeHx711Config& c) {
+  s_hxCfg      = c;
+  s_rng        = XorShift32(c.seed);
+  s_nextConvUs = s_us + conv_period_us();
+  s_reads      = 0;
+}
+
+int32_t fake_hx711_mass_mg() {
+  if (s_settleMs == 0) return s_toMg;
+  const double t = (double)(s_us - s_loadUs) / 1000.0;
+  return s_toMg + (int32_t)lround((s_fromMg - s_toMg) * exp(-t / s_settleMs));
+}
+
+void fake_hx711_load(int32_t mg, uint32_t settleMs) {
+  s_fromMg   = fake_hx711_mass_mg();
+  s_toMg     = mg;
+  s_loadUs   = s_us;
+  s_settleMs = settleMs;
+}
+
+uint32_t fake_hx711_reads() { return s_reads; }
+
+bool hal_hx711_begin(int, int, uint8_t) {
+  s_nextConvUs = s_us + conv_period_us();
+  return true;
+}
+
+bool hal_hx711_ready() { return s_us >= s_nextConvUs; }
+
+int32_t hal_hx711_read() {
+  if (s_us < s_nextConvUs) s_us = s_nextConvUs;      // "blocks" until DOUT falls
+  s_nextConvUs = s_us + conv_period_us();
+  s_reads++;
+
+  int32_t noise = 0;
+  if (s_hxCfg.noiseCounts > 0) {
+    noise = (int32_t)(s_rng.next() % (2u * s_hxCfg.noiseCounts + 1)) - s_hxCfg.noiseCounts;
+  }
+  int64_t raw = s_hxCfg.offset + llround(fake_hx711_mass_mg() * (double)s_hxCfg.countsPerG / 1000.0) + noise;
+  if (raw >  0x7FFFFF) raw =  0x7FFFFF;                // 24-bit ADC clips
+  if (raw < -0x800000) raw = -0x800000;
+  return (int32_t)raw;
+}
+
+// ---- NVS ----
+
+static std::map<std::string, std::vector<uint8_t>> s_nvs;
+static bool s_nvsOpen = false;
+static bool s_nvsFail = false;
+
+void   fake_nvs_clear()             { s_nvs.clear(); }
+void   fake_nvs_fail_writes(bool f) { s_nvsFail = f; }
+size_t fake_nvs_keys()              { return s_nvs.size(); }
+
+static bool nvs_put(const char* key, const void* data, size_t len) {
+  if (!s_nvsOpen || s_nvsFail || !key) return false;
+  const uint8_t* p = (const uint8_t*)data;
+  s_nvs[key].assign(p, p + len);
+  return true;
+}
+
+static bool nvs_get(const char* key, void* out, size_t len) {
+  if (!s_nvsOpen || !key) return false;
+  auto it = s_nvs.find(key);
+  if (it == s_nvs.end() || it->second.size() != len) return false;
+  memcpy(out, it->second.data(), len);
+  return true;
+}
+
+bool nvs_init(const char*) { s_nvsOpen = true; return true; }
+
+bool nvs_save_float(const char* key, float value)  { return nvs_put(key, &value, sizeof(value)); }
+bool nvs_load_float(const char* key, float& out)   { return nvs_get(key, &out, sizeof(out)); }
+bool nvs_save_u32(const char* key, uint32_t value) { return nvs_put(key, &value, sizeof(value)); }
+bool nvs_load_u32(const char* key, uint32_t& out)  { return nvs_get(key, &out, sizeof(out)); }
+
+bool nvs_save_blob(const char* key, const void* data, size_t len) { return nvs_put(key, data, len); }
+bool nvs_load_blob(const char* key, void* out, size_t len)        { return nvs_get(key, out, len); }
+
+bool nvs_remove_key(const char* key) {
+  return s_nvsOpen && key && s_nvs.erase(key) > 0;
+}
+
+// ---- HTTP ----
+
+static int             s_httpStatus  = 200;
+static FakeHttpHandler s_httpHandler = nullptr;
+static FakeHttpStats   s_http{};
+
+void fake_http_set_status(int status)          { s_httpStatus = status; }
+void fake_http_set_handler(FakeHttpHandler h)  { s_httpHandler = h; }
+const FakeHttpStats& fake_http_stats()         { return s_http; }
+void fake_http_reset()                         { s_http = FakeHttpStats{}; }
+
+int hal_http_post(const char* path, const char* contentType,
+                  const uint8_t* body, size_t len, char* resp, size_t respCap) {
+  s_http.posts++;
+  s_http.bytes += (uint32_t)len;
+  strncpy(s_http.lastPath, path ? path : "", sizeof(s_http.lastPath) - 1);
+  strncpy(s_http.lastType, contentType ? contentType : "", sizeof(s_http.lastType) - 1);
+  s_http.lastLen = len;
+  if (body) memcpy(s_http.lastBody, body, len < sizeof(s_http.lastBody) ? len : sizeof(s_http.lastBody));
+
+  if (resp && respCap) resp[0] = '\0';
+  const int code = s_httpHandler ? s_httpHandler(path, contentType, body, len, resp, respCap) : s_httpStatus;
+  if ((code < 200 || code >= 300) && resp && respCap) resp[0] = '\0';   // body only on 2xx, as on the device
+  return code;
+}
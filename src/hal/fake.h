@@ -0,0 +1,69 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+// Host fakes behind hal/*.h and storage/nvs_store.h (native build only,
+// see [env:native] in platformio.ini). Everything but the serial capture
+// is single-threaded and deterministic: time only moves through
+// fake_clock_*, hal_delay_ms() or a blocking hal_hx711_read(), and the ADC
+// noise comes from a seeded PRNG.
+
+// ---- Clock ----
+void     fake_clock_set_us(uint64_t us);
+void     fake_clock_advance_us(uint64_t us);
+uint64_t fake_clock_us();
+
+// ---- Serial ----
+// Everything hal_serial_write() was given since the last clear, in order
+// (text lines and binary log frames alike). Writes are atomic per call and
+// may come from several threads; read and clear with the writers stopped.
+const std::string& fake_serial_output();
+void fake_serial_clear();
+
+// ---- GPIO ----
+// Drive a pin from "outside"; a high → low change runs its falling-edge
+// handler. fake_gpio_get() also returns what the code under test wrote.
+void fake_gpio_set(int pin, bool high);
+bool fake_gpio_get(int pin);
+bool fake_gpio_is_output(int pin);
+
+// ---- HX711 ----
+// A load cell behind an HX711: raw = offset + mass · countsPerG / 1000 +
+// noise. A new load approaches its mass exponentially (time constant
+// settleMs, 0 = instant), like a platform that rings down after a placement.
+struct FakeHx711Config {
+  uint16_t sps;           // 10 or 80; hal_hx711_read() advances the clock to the next conversion
+  int32_t  offset;        // raw counts with nothing on the scale
+  float    countsPerG;
+  int32_t  noiseCounts;   // uniform ± noise per conversion
+  uint32_t seed;
+};
+void     fake_hx711_config(const FakeHx711Config& c);
+void     fake_hx711_load(int32_t mg, uint32_t settleMs);
+int32_t  fake_hx711_mass_mg();    // true mass right now (before noise)
+uint32_t fake_hx711_reads();
+
+// ---- NVS (storage/nvs_store.h) ----
+void   fake_nvs_clear();
+void   fake_nvs_fail_writes(bool fail);   // saves return false, nothing stored
+size_t fake_nvs_keys();
+
+// ---- HTTP ----
+// Every post is counted and its body kept (last one); the reply comes
+// from the handler, or 'status' with an empty body when there is none.
+typedef int (*FakeHttpHandler)(const char* path, const char* contentType,
+                               const uint8_t* body, size_t len, char* resp, size_t respCap);
+void fake_http_set_status(int status);
+void fake_http_set_handler(FakeHttpHandler h);
+
+struct FakeHttpStats {
+  uint32_t posts;
+  uint32_t bytes;
+  char     lastPath[64];
+  char     lastType[64];
+  uint8_t  lastBody[1024];
+  size_t   lastLen;        // may exceed sizeof(lastBody); the copy is truncated
+};
+const FakeHttpStats& fake_http_stats();
+void fake_http_reset();
@@ -0,0 +1,13 @@
+#pragma once
+#include <stdint.h>
+
+// Plain digital pins. Pin numbers are the board's GPIO numbers.
+void hal_gpio_output(int pin);
+void hal_gpio_input(int pin);
+void hal_gpio_write(int pin, bool high);
+bool hal_gpio_read(int pin);
+
+// Falling-edge interrupt. 'isr' runs in interrupt context on the device
+// (IRAM_ATTR, FromISR calls only); one handler per pin.
+void hal_gpio_on_falling(int pin, void (*isr)());
+void hal_gpio_detach(int pin);
@@ -0,0 +1,59 @@
+// Device side of the HAL (hal/*.h): Arduino core, FreeRTOS, bogde/HX711
+// and net/http_client. Excluded from the native build.
+#include <Arduino.h>
+#include <HX711.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "hal/clock.h"
+#include "hal/gpio.h"
+#include "hal/hx711_port.h"
+#include "hal/http_port.h"
+#include "hal/serial.h"
+#include "net/http_client.h"
+
+// ---- Clock ----
+
+uint32_t hal_millis() { return millis(); }
+uint32_t hal_micros() { return (uint32_t)micros(); }
+void     hal_delay_ms(uint32_t ms) { vTaskDelay(pdMS_TO_TICKS(ms)); }
+
+// ---- Serial ----
+
+void hal_serial_write(const uint8_t* data, size_t len) { Serial.write(data, len); }
+void hal_serial_flush() { Serial.flush(); }
+
+// ---- GPIO ----
+
+void hal_gpio_output(int pin)          { pinMode(pin, OUTPUT); }
+void hal_gpio_input(int pin)           { pinMode(pin, INPUT); }
+void hal_gpio_write(int pin, bool high) { digitalWrite(pin, high ? HIGH : LOW); }
+bool hal_gpio_read(int pin)            { return digitalRead(pin) == HIGH; }
+
+void hal_gpio_on_falling(int pin, void (*isr)()) {
+  attachInterrupt(digitalPinToInterrupt(pin), isr, FALLING);
+}
+
+void hal_gpio_detach(int pin) { detachInterrupt(digitalPinToInterrupt(pin)); }
+
+// ---- HX711 ----
+
+static HX711 s_hx;
+
+bool hal_hx711_begin(int doutPin, int sckPin, uint8_t gain) {
+  s_hx.begin(doutPin, sckPin, gain);
+  return true;
+}
+
+bool    hal_hx711_ready() { return s_hx.is_ready(); }
+int32_t hal_hx711_read()  { return (int32_t)s_hx.read(); }
+
+// ---- HTTP ----
+
+int hal_http_post(const char* path, const char* contentType,
+                  const uint8_t* body, size_t len, char* resp, size_t respCap) {
+  String r;
+  const int code = http_post(path, contentType, body, len, r);
+  if (resp && respCap) strlcpy(resp, (code >= 200 && code < 300) ? r.c_str() : "", respCap);
+  return code;
+}
@@ -0,0 +1,11 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// One POST to the server, path relative to the base URL (net/http_client
+// on the device: kept-alive TLS, one reconnect on a dead socket).
+// Returns the HTTP status, or < 0 when no response arrived. On 2xx the
+// response body is copied to 'resp' (NUL-terminated, truncated to respCap);
+// otherwise 'resp' is left empty.
+int hal_http_post(const char* path, const char* contentType,
+                  const uint8_t* body, size_t len, char* resp, size_t respCap);
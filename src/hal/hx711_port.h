@@ -0,0 +1,11 @@
+#pragma once
+#include <stdint.h>
+
+// Bit-level access to the HX711: pin setup and one conversion at a time.
+// Offset, scale, averaging and the async reader live in drivers/hx711_driver.
+//
+// gain 128/64 select channel A, 32 channel B; it applies from the next
+// conversion on.
+bool    hal_hx711_begin(int doutPin, int sckPin, uint8_t gain);
+bool    hal_hx711_ready();          // DOUT low: a conversion is waiting
+int32_t hal_hx711_read();           // blocks until ready; signed 24-bit counts
@@ -0,0 +1,9 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Console output for util/log: Serial on the device, a capture buffer on
+// the host (fake_serial_* in hal/fake.h). Writes whole frames; flush waits
+// until the bytes have left the UART.
+void hal_serial_write(const uint8_t* data, size_t len);
+void hal_serial_flush();
@@ -1,13 +1,14 @@
 #include <Arduino.h>
 #include "core/app_state.h"
 #include "features/supervisor.h"
+#include "util/log.h"
 
 void setup() {
   Serial.begin(115200);
   delay(2000);
   Serial.println();
   Serial.println("SmartScale boot");
-  
+  log_start();          // everything after this logs through the drain task
 
   app_state_init();
   supervisor_start();
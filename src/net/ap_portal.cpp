@@ -7,6 +7,8 @@
 #include "app_config.h"
 #include "core/app_state.h"
 #include "storage/nvs_store.h"
+#include "net/wifi_creds.h"
+#include "util/log.h"
 
 static WebServer server(80);
 static DNSServer dns;
@@ -25,6 +27,7 @@ button{padding:10px 16px}
 </style>
 </head><body>
 <h2>SmartScale Wi-Fi Setup</h2>
+<p>Adds a network to the saved list (the strongest one in range is used).</p>
 <form action="/save" method="post">
   <label>SSID</label><br><input name="ssid" maxlength="32" required><br>
   <label>Password</label><br><input name="pass" type="password" maxlength="64"><br>
@@ -61,14 +64,12 @@ static void handle_save() {
     return;
   }
 
-  bool ok1 = nvs_save_string(WIFI_KEY_SSID, ssid);
-  bool ok2 = nvs_save_string(WIFI_KEY_PASS, pass);
+  const bool ok = wifi_creds_add(ssid.c_str(), pass.c_str());
 
-  Serial.printf("[AP] save creds: ssid=\"%s\" (%s), pass_len=%u (%s)\r\n",
-                ssid.c_str(), ok1 ? "OK" : "ERR",
-                (unsigned)pass.length(), ok2 ? "OK" : "ERR");
+  LOGI("AP", "save creds: ssid=\"%s\", pass_len=%u (%s)",
+       ssid.c_str(), (unsigned)pass.length(), ok ? "OK" : "ERR");
 
-  if (ok1 && ok2) {
+  if (ok) {
     saved = true;
     server.send(200, "text/plain", "Saved. Device will reboot...");
   } else {
@@ -80,7 +81,7 @@ static void handle_save() {
 void ap_portal_run() {
   // Make sure NVS is open so saving works
   if (!nvs_init("smartscale")) {
-    Serial.println("[AP] ERROR: nvs_init failed");
+    LOGE("AP", "ERROR: nvs_init failed");
   }
 
   // Start AP
@@ -91,7 +92,7 @@ void ap_portal_run() {
     WiFi.softAP(AP_SSID, nullptr, AP_CHAN); // open AP if short/empty pass
 
   IPAddress ip = WiFi.softAPIP();
-  Serial.printf("[AP] \"%s\" started. IP=%s\r\n", AP_SSID, ip.toString().c_str());
+  LOGI("AP", "\"%s\" started. IP=%s", AP_SSID, ip.toString().c_str());
 
   app_set_bits(AppBits::AP_MODE);  // your LED should switch to FAST_BLINK
 
@@ -145,11 +146,12 @@ void ap_portal_run() {
 
     // Idle reboot (optional)
     if (AP_IDLE_REBOOT_MS > 0 && (millis() - lastActivityMs) >= AP_IDLE_REBOOT_MS) {
-      Serial.println("[AP] Idle timeout → reboot");
+      LOGI("AP", "Idle timeout → reboot");
       server.stop();
       WiFi.softAPdisconnect(true);
       app_clear_bits(AppBits::AP_MODE);
       vTaskDelay(pdMS_TO_TICKS(200));
+      log_flush(500);
       ESP.restart();
     }
 
@@ -161,8 +163,9 @@ void ap_portal_run() {
       server.stop();
       WiFi.softAPdisconnect(true);
       app_clear_bits(AppBits::AP_MODE);
-      Serial.println("[AP] Saved creds → rebooting...");
+      LOGI("AP", "Saved creds → rebooting...");
       vTaskDelay(pdMS_TO_TICKS(200));
+      log_flush(500);
       ESP.restart();
     }
   }
@@ -1,81 +1,318 @@
 #include "api_client.h"
 #include <ArduinoJson.h>
 #include "net/http_client.h"
+#include "hal/http_port.h"
 #include "core/identity.h"
 #include "core/timekeeper.h"
+#include "core/sequence.h"
+#include "util/fixed_weight.h"
+#include "util/body_writer.h"
+#include "util/heap_stats.h"
+#include "net/weight_codec.h"
+#include "app_config.h"
+#include "freertos/FreeRTOS.h"
+#include "util/log.h"
 
 // Adjust paths if your server uses subpaths; empty "" means base URL
 static constexpr const char* PATH_WELCOME = "";
 static constexpr const char* PATH_WEIGHT  = "";
 static constexpr const char* PATH_FINISH  = "";
+static constexpr const char* PATH_BATCH   = "";
+
+static constexpr const char* CT_FORM = "application/x-www-form-urlencoded";
+static constexpr const char* CT_JSON = "application/json";
+static constexpr int         API_ERR_BODY_OVERFLOW = -100;   // below HTTPClient's error codes
+
+// Cached "mac=..&id=.." (already URL-encoded) plus the raw mac/id for
+// JSON. Rebuilt only when the identity generation changes; the name is
+// appended per body, so weights (named) and finish (unnamed) share it.
+static char         s_prefix[160];
+static size_t       s_prefixLen  = 0;
+static uint32_t     s_prefixGen  = 0;
+static char         s_mac[18]    = "";
+static char         s_id[48]     = "none";
+static portMUX_TYPE s_prefixMux  = portMUX_INITIALIZER_UNLOCKED;
+
+static void refresh_prefix() {
+  const uint32_t gen = identity_generation();
+  if (gen == s_prefixGen && s_mac[0]) return;
+
+  // Build outside the critical section (http_mac() allocates once here)
+  char mac[sizeof(s_mac)];
+  char id[sizeof(s_id)];
+  strlcpy(mac, http_mac().c_str(), sizeof(mac));
+  identity_copy_id(id, sizeof(id));
+
+  char buf[sizeof(s_prefix)];
+  BodyWriter w(buf, sizeof(buf));
+  w.form("mac", mac).form("id", id);
+  if (w.overflow()) LOGW("API", "prefix too long, truncated");
+
+  portENTER_CRITICAL(&s_prefixMux);
+  memcpy(s_prefix, buf, w.length() + 1);
+  s_prefixLen  = w.length();
+  memcpy(s_mac, mac, sizeof(mac));
+  memcpy(s_id, id, sizeof(id));
+  s_prefixGen  = gen;
+  portEXIT_CRITICAL(&s_prefixMux);
+}
+
+// Start a form body with the cached prefix and, if given, the name
+static void begin_form(BodyWriter& w, const char* name) {
+  refresh_prefix();
+  portENTER_CRITICAL(&s_prefixMux);
+  w.raw(s_prefix, s_prefixLen);
+  portEXIT_CRITICAL(&s_prefixMux);
+  if (name) w.form("name", name);
+}
+
+// Every post goes through the HAL seam (hal/http_port.h): the device
+// build lands in net/http_client, the host build in the fake server.
+static int post_body(const char* path, const char* ct, const BodyWriter& w, char* resp, size_t respCap) {
+  if (respCap) resp[0] = '\0';
+  if (w.overflow()) {
+    LOGW("API", "body over %u B, not sent", (unsigned)w.length());
+    return API_ERR_BODY_OVERFLOW;
+  }
+  return hal_http_post(path, ct, (const uint8_t*)w.c_str(), w.length(), resp, respCap);
+}
+
+static bool is_2xx(int code) { return code >= 200 && code < 300; }
+
+// 408/429 are "try again later", not "no"; a body we cannot build will
+// not get better by retrying either.
+static ApiResult classify(int code) {
+  if (is_2xx(code)) return ApiResult::OK;
+  if (code == API_ERR_BODY_OVERFLOW) return ApiResult::REJECTED;
+  if (code >= 400 && code < 500 && code != 408 && code != 429) return ApiResult::REJECTED;
+  return ApiResult::FAILED;
+}
+
+// Batch encodings the server advertised in its welcome reply. Nothing is
+// batched before that (or when it advertised neither); a refused binary
+// body drops back to JSON, a missing endpoint ends batching until the next
+// welcome.
+static volatile bool s_binBatches  = false;
+static volatile bool s_jsonBatches = false;
+
+bool api_batches_supported() { return s_binBatches || s_jsonBatches; }
+
+// 2xx: how many leading records the reply acknowledges ({"ok":N}), or
+// REJECTED when it confirms none (nothing may leave the spool)
+static ApiResult batch_acked(const char* resp, size_t packed, size_t& outSent) {
+  uint32_t ack = 0;
+  if (!wire_parse_ack(resp, ack) || ack == 0) {
+    LOGW("API", "batch 2xx without an ack count → not committed");
+    return ApiResult::REJECTED;
+  }
+  if (ack > packed) {
+    LOGW("API", "batch ack %lu > %u sent", (unsigned long)ack, (unsigned)packed);
+    ack = (uint32_t)packed;
+  }
+  outSent = ack;
+  return ApiResult::OK;
+}
 
 String api_welcome(const String& mac, const String& currentId) {
-  String body = "mac=" + mac + "&id=" + (currentId.length() ? currentId : "none");
-  String resp;
+  char buf[128];
+  BodyWriter w(buf, sizeof(buf));
+  w.form("mac", mac.c_str()).form("id", currentId.length() ? currentId.c_str() : "none");
+  if (BATCH_ENABLED) {
+    w.form("batch", "json");                             // offer JSON batches...
+    if (WIRE_BIN_ENABLED) w.form("enc", WIRE_ENC_NAME);  // ...and the compact format
+  }
 
-  Serial.printf("[SERVER] → POST body: %s\r\n", body.c_str());
+  char resp[256];
+  LOGD("SERVER", "→ POST body: %s", w.c_str());
 
-  if (!http_post_form(PATH_WELCOME, body, resp)) {
-    Serial.println("[API] welcome: post failed");
+  if (!is_2xx(post_body(PATH_WELCOME, CT_FORM, w, resp, sizeof(resp)))) {
+    LOGW("API", "welcome: post failed");
     return String(); // empty
   }
 
-  Serial.printf("[SERVER] ← response: %s\r\n", resp.c_str());
+  LOGD("SERVER", "← response: %s", resp);
 
   // Try parse JSON for {"device_id":"..."}
   StaticJsonDocument<256> doc;
   DeserializationError err = deserializeJson(doc, resp);
   if (err) {
-    Serial.println("[API] welcome: non-JSON (ok if your server replies plain text)");
+    LOGI("API", "welcome: non-JSON (ok if your server replies plain text) → single posts");
+    s_binBatches = s_jsonBatches = false;
     return String(); // empty = no change
   }
+
+  // {"enc":"bin2"} = binary batches, {"batch":"json"} = JSON batches;
+  // neither = the server only takes single posts
+  const char* enc   = doc["enc"] | "";
+  const char* batch = doc["batch"] | "";
+  s_binBatches  = BATCH_ENABLED && WIRE_BIN_ENABLED && strcmp(enc, WIRE_ENC_NAME) == 0;
+  s_jsonBatches = BATCH_ENABLED && strcmp(batch, "json") == 0;
+  LOGI("API", "batch encoding: %s", s_binBatches ? WIRE_ENC_NAME : s_jsonBatches ? "json" : "none (single posts)");
+
   if (doc.containsKey("device_id")) {
     String newId = doc["device_id"].as<String>();
-    Serial.printf("[SERVER] parsed device_id: %s\r\n", newId.c_str());
+    LOGI("SERVER", "parsed device_id: %s", newId.c_str());
     return newId; // may be same or different from current
   }
   return String();
 }
 
-// stubs for later:
-bool api_post_weight(float w, const String& name) { 
-  const String mac = http_mac();
-  const String id = identity_get_id();
-
-  char wBuf[24];
-  // 2 decimals; adjust if you need 1/3 decimals
-  snprintf(wBuf, sizeof(wBuf), "%.2f", w);
-
-  // Build form body exactly as your server expects:
-  // mac, id, name, w
-  String body;
-  body.reserve(128);
-  body += "mac=";  body += mac;
-  body += "&id=";  body += id;
-  body += "&name="; body += name;
-  body += "&w=";   body += wBuf;
-
-  String resp;
-  Serial.printf("[SERVER] → WEIGHT: %s\r\n", body.c_str());
-  const bool ok = http_post_form(PATH_WEIGHT, body, resp);
-  Serial.printf("[SERVER] ← WEIGHT resp: %s (ok=%d)\r\n", resp.c_str(), ok);
-  return ok;
+ApiResult api_post_weight(const Measurement& m, const char* name) {
+  HeapSnapshot heap0;
+  if (HEAP_LOG_POSTS) heap_snapshot(heap0);
+
+  char wBuf[16];
+  // grams, 2 decimals; integer formatting (no soft-float printf)
+  weight_format_g(wBuf, sizeof(wBuf), m.mg, 2);
+
+  // Form body exactly as the server expects: mac, id, name, w (+ dedupe key)
+  char buf[192];
+  BodyWriter w(buf, sizeof(buf));
+  begin_form(w, name);
+  w.form("w", wBuf).form("seq", m.seq).form("boot", (uint32_t)m.boot);
+  if (m.confPct < 100) {              // early (predicted) settle value
+    w.form("est", 1u).form("conf", (uint32_t)m.confPct);
+  } else if (const uint32_t early = meas_corrects_seq(m)) {
+    w.form("fix", early);             // replaces that early value
+  }
+
+  char resp[64];
+  LOGD("SERVER", "→ WEIGHT: %s", w.c_str());
+  const int code = post_body(PATH_WEIGHT, CT_FORM, w, resp, sizeof(resp));
+  LOGD("SERVER", "← WEIGHT code=%d resp: %s", code, resp);
+
+  if (HEAP_LOG_POSTS) heap_log_delta("post WEIGHT", heap0);
+  return classify(code);
+}
+
+ApiResult api_post_finish(const Measurement& m) {
+  HeapSnapshot heap0;
+  if (HEAP_LOG_POSTS) heap_snapshot(heap0);
+
+  char buf[160];
+  BodyWriter w(buf, sizeof(buf));
+  begin_form(w, nullptr);
+  w.form("event", "finish")
+   .form("ts", m.epoch)                         // ok if 0
+   .form("seq", m.seq)
+   .form("boot", (uint32_t)m.boot);
+
+  char resp[64];
+  LOGD("SERVER", "→ FINISH: %s", w.c_str());
+  const int code = post_body(PATH_FINISH, CT_FORM, w, resp, sizeof(resp));
+  LOGD("SERVER", "← FINISH code=%d resp: %s", code, resp);
+
+  if (HEAP_LOG_POSTS) heap_log_delta("post FINISH", heap0);
+  return classify(code);
 }
 
-bool api_post_finish(uint32_t epoch) {
-  const String mac = http_mac();
-  const String id  = identity_get_id();
-
-  String body;
-  body.reserve(96);
-  body += "mac=";    body += mac;
-  body += "&id=";    body += id;
-  body += "&event=finish";
-  body += "&ts=";    body += String(epoch);   // ok if 0
-
-  String resp;
-  Serial.printf("[SERVER] → FINISH: %s\r\n", body.c_str());
-  const bool ok = http_post_form(PATH_FINISH, body, resp);
-  Serial.printf("[SERVER] ← FINISH resp: %s (ok=%d)\r\n", resp.c_str(), ok);
-  return ok;
-}
\ No newline at end of file
+// {"mac":..,"id":..,"name":..,"boot":B,"now":<millis>,"epoch":<s or 0>,
+//  "items":[{"seq":N,"b":B,"t":<millis>,"k":"add"|"rm","w":"12.34"[,"conf":NN|,"fix":<seq>]},
+//           {"seq":N,"b":B,"t":<millis>,"k":"finish","ts":<epoch>}, ...]}
+// (seq, b) is the dedupe key. "t" and "now" share the device clock when
+// b == boot, so the server can place the record in time as
+// epoch - (now - t)/1000; older boots' records only have their order.
+ApiResult api_post_weights(const Measurement* recs, size_t n,
+                             const char* name, size_t& outSent) {
+  outSent = 0;
+  if (n == 0) return ApiResult::OK;
+  if (!api_batches_supported()) return ApiResult::NO_BATCH;
+
+  HeapSnapshot heap0;
+  if (HEAP_LOG_POSTS) heap_snapshot(heap0);
+
+  static char body[BATCH_MAX_BYTES];   // uploader task only
+
+  refresh_prefix();
+  char mac[sizeof(s_mac)], id[sizeof(s_id)];
+  portENTER_CRITICAL(&s_prefixMux);
+  memcpy(mac, s_mac, sizeof(mac));
+  memcpy(id, s_id, sizeof(id));
+  portEXIT_CRITICAL(&s_prefixMux);
+
+  if (s_binBatches) {
+    WireHeader h;
+    if (!wire_parse_mac(mac, h.mac)) memset(h.mac, 0, sizeof(h.mac));
+    h.id    = id;
+    h.name  = name ? name : "";
+    h.boot  = seq_boot_id();
+    h.nowMs = millis();
+    h.epoch = (uint32_t)time_epoch();
+
+    size_t packed = 0;
+    const size_t limit = n < BATCH_MAX_RECORDS ? n : BATCH_MAX_RECORDS;
+    const size_t len = wire_encode_batch((uint8_t*)body, sizeof(body), h, recs, limit, packed);
+    if (len == 0) return ApiResult::REJECTED;     // retrying builds the same body
+
+    char resp[128];
+    LOGD("SERVER", "→ BATCH %s: %u records, %u B", WIRE_ENC_NAME, (unsigned)packed, (unsigned)len);
+    const int code = hal_http_post(PATH_BATCH, WIRE_CONTENT_TYPE, (const uint8_t*)body, len, resp, sizeof(resp));
+    LOGD("SERVER", "← BATCH code=%d resp: %s", code, resp);
+    if (HEAP_LOG_POSTS) heap_log_delta("post BATCH bin", heap0);
+
+    if (is_2xx(code)) return batch_acked(resp, packed, outSent);
+    if (classify(code) != ApiResult::REJECTED) return ApiResult::FAILED;
+    // Binary refused: retry this batch as JSON if the server takes that
+    s_binBatches = false;
+    if (!s_jsonBatches) {
+      LOGW("API", "server refused binary batch → single posts");
+      return ApiResult::NO_BATCH;
+    }
+    LOGW("API", "server refused binary batch → JSON batches");
+  }
+
+  BodyWriter w(body, sizeof(body));
+
+  w.raw("{\"mac\":").jsonStr(mac)
+   .raw(",\"id\":").jsonStr(id)
+   .raw(",\"name\":").jsonStr(name ? name : "")
+   .raw(",\"boot\":").u32(seq_boot_id())
+   .raw(",\"now\":").u32(millis())
+   .raw(",\"epoch\":").u32((uint32_t)time_epoch())
+   .raw(",\"items\":[");
+  if (w.overflow()) return ApiResult::REJECTED;
+
+  static constexpr size_t TAIL = 2;    // closing "]}"
+  size_t packed = 0;
+  const size_t limit = n < BATCH_MAX_RECORDS ? n : BATCH_MAX_RECORDS;
+  for (; packed < limit; ++packed) {
+    const Measurement& m = recs[packed];
+    const size_t mark = w.length();
+    if (packed) w.ch(',');
+    w.raw("{\"seq\":").u32(m.seq)
+     .raw(",\"b\":").u32(m.boot)
+     .raw(",\"t\":").u32(m.monoMs);
+    if (m.kind == MeasKind::FINISH) {
+      w.raw(",\"k\":\"finish\",\"ts\":").u32(m.epoch);
+    } else {
+      char wBuf[16];
+      weight_format_g(wBuf, sizeof(wBuf), m.mg, 2);
+      w.raw(",\"k\":").jsonStr(m.kind == MeasKind::ADD ? "add" : "rm")
+       .raw(",\"w\":").jsonStr(wBuf);
+      if (m.confPct < 100) w.raw(",\"conf\":").u32(m.confPct);
+      else if (const uint32_t early = meas_corrects_seq(m)) w.raw(",\"fix\":").u32(early);
+    }
+    w.ch('}');
+
+    if (w.overflow() || w.length() + TAIL >= sizeof(body)) {
+      w.rewind(mark);      // doesn't fit: drop the partial item, send the rest
+      break;
+    }
+  }
+  if (packed == 0) return ApiResult::REJECTED;   // first record alone does not fit
+  w.raw("]}");
+
+  char resp[128];
+  LOGD("SERVER", "→ BATCH: %u records, %u B", (unsigned)packed, (unsigned)w.length());
+  const int code = post_body(PATH_BATCH, CT_JSON, w, resp, sizeof(resp));
+  LOGD("SERVER", "← BATCH code=%d resp: %s", code, resp);
+
+  if (HEAP_LOG_POSTS) heap_log_delta("post BATCH", heap0);
+
+  if (is_2xx(code)) return batch_acked(resp, packed, outSent);
+  if (code == 404 || code == 405 || code == 415) {
+    s_jsonBatches = false;                       // until the next welcome says otherwise
+    return ApiResult::NO_BATCH;
+  }
+  return classify(code);
+}
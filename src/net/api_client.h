@@ -1,10 +1,35 @@
 #pragma once
 #include <Arduino.h>
+#include "features/measurement.h"
 
 // Returns server-reported device_id (may equal your current ID).
 // If server doesn’t send an id (or parse fails), returns empty string.
 String api_welcome(const String& mac, const String& currentId);
 
-// These we’ll implement after welcome works:
-bool api_post_weight(float w, const String& name);
-bool api_post_finish(uint32_t epoch);
\ No newline at end of file
+// Bodies are built in fixed buffers (util/body_writer.h) on a cached,
+// URL-encoded "mac=..&id=..&name=.." prefix; no String concatenation.
+// Weight is integer milligrams; sent as grams with 2 decimals ("w=123.45").
+// confPct < 100 marks a predicted early-settle value ("&est=1&conf=NN").
+// Every post carries seq/boot so the server can drop retried duplicates.
+enum class ApiResult : uint8_t {
+  OK,         // accepted (batch: the first 'outSent' records, as acknowledged)
+  REJECTED,   // server answered no (4xx), a 2xx batch reply acknowledged nothing,
+              // or the body cannot be built; batch: post these singly
+  FAILED,     // transport error / timeout / 5xx / 408 / 429 → server unhealthy, retry later
+  NO_BATCH    // batch only: not negotiated in welcome, or 404/405/415 → no batches
+};
+
+ApiResult api_post_weight(const Measurement& m, const char* name);
+ApiResult api_post_finish(const Measurement& m);      // m.kind == FINISH, m.epoch = wall clock (s)
+
+// Several records in one POST, oldest first, in the encoding the server
+// advertised in its welcome reply: compact binary ({"enc":"bin2"},
+// weight_codec) or JSON ({"batch":"json"}). Packs as many as fit in
+// BATCH_MAX_RECORDS / BATCH_MAX_BYTES. outSent is how many the reply
+// acknowledged ({"ok":N}); only those may leave the spool.
+ApiResult api_post_weights(const Measurement* recs, size_t n,
+                             const char* name, size_t& outSent);
+
+// True once a welcome reply advertised a batch encoding (and no 404/405/415
+// has withdrawn it since)
+bool api_batches_supported();
@@ -1,17 +1,56 @@
 #include "http_client.h"
 #include <HTTPClient.h>
+#include <WiFiClientSecure.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "app_config.h"
 #include "core/app_state.h"
+#include "core/metrics.h"
+#include "util/log.h"
 
 static String s_base;
-static constexpr uint32_t HTTP_TIMEOUT_MS = 8000;
-static constexpr uint8_t  HTTP_RETRIES    = 2;
+static constexpr uint32_t HTTP_IDLE_CLOSE_MS = 60000;   // drop a keep-alive nobody used
 
-static String build_url(const String& path) {
-  if (s_base.length() == 0) return path;
+// One persistent connection to SERVER_BASE_URL, shared by all callers
+// (welcome from the Wi-Fi task, posts from the uploader, finish from the
+// button handler) and serialized by s_mtx.
+static WiFiClientSecure  s_tls;
+static HTTPClient        s_http;
+static SemaphoreHandle_t s_mtx = nullptr;
+static String            s_host;
+static uint16_t          s_port = 443;
+static uint32_t          s_lastUseMs = 0;
+static volatile bool     s_stale = false;
+static HttpStats         s_stats{};
+
+struct HttpLock {
+  HttpLock()  { xSemaphoreTake(s_mtx, portMAX_DELAY); }
+  ~HttpLock() { xSemaphoreGive(s_mtx); }
+};
+
+static String build_url(const char* path) {
+  if (s_base.length() == 0) return String(path);
+  if (!path || !*path)       return s_base;         // all API calls today
   if (s_base.endsWith("/"))  return s_base + path;
   return s_base + "/" + path;
 }
 
+// "https://host[:port][/...]" → host, port
+static void parse_host(const String& url) {
+  int start = url.indexOf("://");
+  start = (start < 0) ? 0 : start + 3;
+  int end = url.indexOf('/', start);
+  if (end < 0) end = url.length();
+  String hp = url.substring(start, end);
+  const int colon = hp.indexOf(':');
+  s_port = url.startsWith("http://") ? 80 : 443;
+  if (colon >= 0) {
+    s_port = (uint16_t)hp.substring(colon + 1).toInt();
+    hp = hp.substring(0, colon);
+  }
+  s_host = hp;
+}
+
 struct PostingScope {
   PostingScope()  { app_set_bits(AppBits::POSTING); }
   ~PostingScope() { app_clear_bits(AppBits::POSTING); }
@@ -19,37 +58,129 @@ struct PostingScope {
 
 void http_init(const char* base_url) {
   s_base = base_url ? String(base_url) : String();
+  parse_host(s_base);
+
+  if (!s_mtx) s_mtx = xSemaphoreCreateMutex();
+  if (HTTP_TLS_INSECURE) {
+    s_tls.setInsecure();                            // dev: server certificate not checked
+  } else {
+    if (!SERVER_CA_PEM[0]) LOGE("HTTP", "HTTP_TLS_INSECURE off but SERVER_CA_PEM empty: connects will fail");
+    s_tls.setCACert(SERVER_CA_PEM);
+  }
+  s_tls.setHandshakeTimeout(HTTP_TIMEOUT_MS / 1000);
+  s_http.setReuse(true);                            // keep-alive across requests
+  s_http.setConnectTimeout(HTTP_TIMEOUT_MS);
+  s_http.setTimeout(HTTP_TIMEOUT_MS);
+}
+
+void http_close() {
+  s_stale = true;      // non-blocking: the next request reconnects
+}
+
+bool http_try_hold() {
+  return !s_mtx || xSemaphoreTake(s_mtx, 0) == pdTRUE;
+}
+
+void http_release() {
+  if (s_mtx) xSemaphoreGive(s_mtx);
+}
+
+void http_get_stats(HttpStats& out) {
+  if (!s_mtx) { out = HttpStats{}; return; }
+  HttpLock lock;
+  out = s_stats;
 }
 
 String http_mac() {
   return WiFi.macAddress();
 }
 
-bool http_post_form(const String& path, const String& body, String& outResponse) {
-  if (WiFi.status() != WL_CONNECTED) return false;
+// Open (TCP + TLS handshake) unless the kept-alive socket is still usable.
+// Returns false on failure; 'reused' tells whether a handshake was saved.
+static bool ensure_connected(bool& reused, uint32_t& connectMs) {
+  reused = false;
+  connectMs = 0;
+
+  if (!s_stale && s_tls.connected() && (millis() - s_lastUseMs) < HTTP_IDLE_CLOSE_MS) {
+    reused = true;
+    return true;
+  }
+  s_tls.stop();                                     // stale or closed by the server
+  s_stale = false;
+
+  const uint32_t t0 = millis();
+  const bool ok = s_tls.connect(s_host.c_str(), s_port, (int32_t)HTTP_TIMEOUT_MS) == 1;
+  connectMs = millis() - t0;
+  s_stats.connects++;
+  s_stats.lastConnectMs = connectMs;
+  if (ok) metric_observe(Hist::HTTP_CONNECT_MS, connectMs);
+  if (!ok) {
+    char err[64] = {0};
+    s_tls.lastError(err, sizeof(err));
+    LOGW("HTTP", "connect %s:%u failed after %lu ms: %s",
+         s_host.c_str(), (unsigned)s_port, (unsigned long)connectMs, err);
+  }
+  return ok;
+}
+
+int http_post(const char* path, const char* contentType,
+              const uint8_t* body, size_t len, String& outResponse) {
+  if (WiFi.status() != WL_CONNECTED) return HTTPC_ERROR_NOT_CONNECTED;
+  if (!s_mtx) return HTTPC_ERROR_CONNECTION_REFUSED;   // http_init not called
 
+  HttpLock lock;
   PostingScope inFlight;
   const String url = build_url(path);
 
-  for (uint8_t attempt = 0; attempt < (uint8_t)(1 + HTTP_RETRIES); ++attempt) {
-    HTTPClient http;
-    http.setConnectTimeout(HTTP_TIMEOUT_MS);
-    http.begin(url);
-    http.addHeader("Content-Type", "application/x-www-form-urlencoded");
-    http.addHeader("User-Agent", "SmartScale/1.0");
-
-    int code = http.POST(body);
-    Serial.printf("[HTTP] → code=%d\r\n", code);
-
-    if (code > 0 && code >= 200 && code < 300) {
-      outResponse = http.getString();
-      Serial.printf("[HTTP] ← response: %s\r\n", outResponse.c_str());
-      http.end();
-      return true;
+  // One attempt. The only repeat is a kept-alive socket the server had
+  // already closed: that says nothing about the server, so it gets one
+  // fresh connection right away. Everything else is the caller's call
+  // (the uploader's RetryScheduler spaces retries out).
+  int code = HTTPC_ERROR_CONNECTION_REFUSED;
+  for (uint8_t pass = 0; pass < 2; ++pass) {
+    bool reused;
+    uint32_t connectMs;
+    if (!ensure_connected(reused, connectMs)) return HTTPC_ERROR_CONNECTION_REFUSED;
+
+    // HTTPClient sees a connected client with reuse on and skips connect()
+    s_http.begin(s_tls, url);
+    s_http.addHeader("Content-Type", contentType);
+    s_http.addHeader("User-Agent", "SmartScale/1.0");
+
+    const uint32_t t1 = millis();
+    code = s_http.POST(const_cast<uint8_t*>(body), len);   // send + wait for headers
+    const uint32_t reqMs = millis() - t1;
+
+    uint32_t readMs = 0;
+    if (code >= 200 && code < 300) {
+      const uint32_t t2 = millis();
+      outResponse = s_http.getString();
+      readMs = millis() - t2;
+    }
+    s_http.end();                                   // keeps the socket when the server allows it
+    s_lastUseMs = millis();
+
+    s_stats.requests++;
+    if (reused) s_stats.reused++;
+    s_stats.lastRequestMs = reqMs;
+    s_stats.lastReadMs    = readMs;
+
+    LOGD("HTTP", "→ code=%d (%u B) conn=%s%lu ms req=%lu ms read=%lu ms",
+         code, (unsigned)len, reused ? "reused/" : "",
+         (unsigned long)connectMs, (unsigned long)reqMs, (unsigned long)readMs);
+
+    if (code >= 200 && code < 300) {
+      LOGD("HTTP", "← response: %s", outResponse.c_str());
+      return code;
+    }
+    if (code > 0) {
+      LOGI("HTTP", "POST status %d", code);
+      return code;
     }
-    Serial.printf("[HTTP] POST failed: %s\r\n", http.errorToString(code).c_str());
-    http.end();
-    vTaskDelay(pdMS_TO_TICKS(250));
+    LOGW("HTTP", "POST failed: %s", s_http.errorToString(code).c_str());
+    s_tls.stop();
+    s_stats.errors++;
+    if (!reused) break;                            // a fresh connection failed: report it
   }
-  return false;
+  return code;
 }
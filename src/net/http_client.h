@@ -1,10 +1,38 @@
 #pragma once
 #include <Arduino.h>
 
+// Requests share one keep-alive TLS connection to the base URL's host; it
+// is (re)opened on demand, so the first post after boot or a drop pays the
+// handshake and later ones do not.
 void http_init(const char* base_url);
 
-// Low-level POST helper (form encoded). Returns true on 2xx and fills response.
-bool http_post_form(const String& path, const String& body, String& outResponse);
+// Mark the kept-alive connection stale (e.g. on Wi-Fi loss); the next
+// request reconnects. Does not block, safe from the Wi-Fi event handler.
+void http_close();
+
+// Take the request lock without waiting: while held no POST is in flight
+// and none can start (e.g. around a roam's disconnect). False when a
+// request holds it; release with http_release() only after a true.
+bool http_try_hold();
+void http_release();
+
+struct HttpStats {
+  uint32_t requests;
+  uint32_t reused;          // requests that skipped TCP + TLS setup
+  uint32_t connects;        // fresh TCP + TLS handshakes
+  uint32_t errors;          // transport failures (socket dropped)
+  uint32_t lastConnectMs;   // TCP connect + TLS handshake
+  uint32_t lastRequestMs;   // send + wait for response headers
+  uint32_t lastReadMs;      // body download
+};
+void http_get_stats(HttpStats& out);
+
+// POST with an explicit content type. Returns the HTTP status code, or a
+// negative HTTPClient error when no response was received. Makes a single
+// attempt (plus one reconnect if a kept-alive socket turned out dead);
+// retry timing belongs to the caller. outResponse is filled on 2xx only.
+int http_post(const char* path, const char* contentType,
+              const uint8_t* body, size_t len, String& outResponse);
 
 // Optional helpers
 String http_mac();     // Wi-Fi MAC ("AA:BB:...")
\ No newline at end of file
@@ -0,0 +1,64 @@
+#include "metrics_http.h"
+#include <Arduino.h>
+#include <WiFi.h>
+#include <esp_http_server.h>
+#include "app_config.h"
+#include "core/metric_text.h"
+#include "util/log.h"
+
+static httpd_handle_t s_server = nullptr;
+
+// Lines are batched into chunks so a dump is a handful of socket writes
+struct Chunk {
+  httpd_req_t* req;
+  char         buf[512];
+  size_t       len;
+  bool         failed;
+};
+
+static void flush(Chunk& c) {
+  if (c.len && !c.failed && httpd_resp_send_chunk(c.req, c.buf, c.len) != ESP_OK) c.failed = true;
+  c.len = 0;
+}
+
+static void http_sink(void* ctx, const char* name, const char* label, int64_t value) {
+  Chunk& c = *(Chunk*)ctx;
+  char line[128];
+  const size_t n = metric_line(line, sizeof(line), name, label, value);
+  if (n == 0) return;
+  if (c.len + n > sizeof(c.buf)) flush(c);
+  memcpy(c.buf + c.len, line, n);
+  c.len += n;
+}
+
+static esp_err_t handle_metrics(httpd_req_t* req) {
+  httpd_resp_set_type(req, "text/plain; version=0.0.4");
+  Chunk c{ req, {0}, 0, false };
+  metrics_write(http_sink, &c);
+  flush(c);
+  return httpd_resp_send_chunk(req, nullptr, 0);
+}
+
+void metrics_http_start() {
+  if (s_server || METRICS_HTTP_PORT == 0) return;
+
+  httpd_config_t cfg = HTTPD_DEFAULT_CONFIG();
+  cfg.server_port      = METRICS_HTTP_PORT;
+  cfg.ctrl_port        = METRICS_HTTP_PORT + 1;
+  cfg.stack_size       = TASK_STACK_METRICS_HTTP;
+  cfg.task_priority    = TASK_PRIO_METRICS;
+  cfg.max_open_sockets = 2;
+  cfg.lru_purge_enable = true;
+
+  if (httpd_start(&s_server, &cfg) != ESP_OK) {
+    s_server = nullptr;
+    LOGE("METRICS", "ERROR: http server on :%u failed", (unsigned)METRICS_HTTP_PORT);
+    return;
+  }
+  httpd_uri_t uri = {};
+  uri.uri     = "/metrics";
+  uri.method  = HTTP_GET;
+  uri.handler = handle_metrics;
+  httpd_register_uri_handler(s_server, &uri);
+  LOGI("METRICS", "serving http://%s:%u/metrics", WiFi.localIP().toString().c_str(), (unsigned)METRICS_HTTP_PORT);
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+// GET /metrics on METRICS_HTTP_PORT (core/metrics.h, Prometheus text).
+// Uses the IDF HTTP server, which sleeps in select() on its own task, so
+// nothing polls. Started by the metrics task once the network is up; later
+// calls are no-ops. Port 80 stays free for the setup portal.
+void metrics_http_start();
@@ -0,0 +1,317 @@
+#include "stream_client.h"
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <WiFiClientSecure.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include "app_config.h"
+#include "core/app_state.h"
+#include "core/identity.h"
+#include "core/sequence.h"
+#include "features/upload_transport.h"
+#include "net/weight_codec.h"
+#include "util/log.h"
+
+namespace {
+
+enum FrameType : uint8_t {
+  F_HELLO   = 0x01,
+  F_WELCOME = 0x02,
+  F_DENY    = 0x03,
+  F_MEAS    = 0x10,
+  F_PING    = 0x20,
+  F_PONG    = 0x21,
+  F_ACK     = 0x30,
+  F_PUSH    = 0x40,
+};
+
+constexpr uint8_t  PROTO_VERSION   = 1;
+constexpr size_t   MAX_PAYLOAD     = 192;
+constexpr uint32_t CONNECT_TIMEOUT = 8000;
+
+struct Frame {
+  uint8_t  type;
+  uint16_t len;
+  uint8_t  data[MAX_PAYLOAD];
+};
+
+// Payload builder (bounded, like BodyWriter but binary)
+struct Payload {
+  uint8_t b[MAX_PAYLOAD];
+  size_t  n = 0;
+  bool    ovf = false;
+
+  void u8(uint8_t v) { if (n < sizeof(b)) b[n++] = v; else ovf = true; }
+  void bytes(const void* p, size_t len) {
+    if (n + len > sizeof(b)) { ovf = true; return; }
+    memcpy(b + n, p, len);
+    n += len;
+  }
+  void varint(uint32_t v) {
+    const size_t w = wire_put_varint(b + n, sizeof(b) - n, v);
+    if (!w) ovf = true;
+    n += w;
+  }
+  void str(const char* s) {
+    const size_t len = s ? strlen(s) : 0;
+    varint((uint32_t)len);
+    bytes(s, len);
+  }
+};
+
+} // namespace
+
+static WiFiClientSecure  s_c;
+static SemaphoreHandle_t s_mtx = nullptr;
+static bool              s_session   = false;   // HELLO/WELCOME done on this socket
+static uint32_t          s_lastAcked = 0;       // last measurement seq the server confirmed
+static uint32_t          s_hbMs      = STREAM_HEARTBEAT_MS;
+static uint32_t          s_lastTryMs = 0;
+static uint32_t          s_lastRxMs  = 0;
+static uint32_t          s_lastTxMs  = 0;
+static StreamStats       s_stats{};
+
+// Batch in flight (owned by the caller of stream_send, lock held)
+static const Measurement* s_inflight    = nullptr;
+static size_t             s_inflightN   = 0;
+static size_t             s_inflightAck = 0;
+
+struct StreamLock {
+  StreamLock()  { xSemaphoreTake(s_mtx, portMAX_DELAY); }
+  ~StreamLock() { xSemaphoreGive(s_mtx); }
+};
+
+void stream_init() {
+  if (!s_mtx) s_mtx = xSemaphoreCreateMutex();
+}
+
+// Frame payloads are not NUL-terminated; the binary log copies %s args
+// up to LOG_BIN_STR_MAX, so text is copied out (and cut) before logging
+static const char* frame_text(const Frame& f, char* out, size_t cap) {
+  const size_t n = f.len < cap - 1 ? f.len : cap - 1;
+  memcpy(out, f.data, n);
+  out[n] = '\0';
+  return out;
+}
+
+static void drop_connection(const char* why) {
+  if (s_c.connected() || s_session) {
+    LOGI("STREAM", "closed: %s", why);
+  }
+  s_c.stop();
+  s_session = false;
+}
+
+static bool write_frame(uint8_t type, const uint8_t* payload, size_t len) {
+  const uint8_t hdr[3] = { type, (uint8_t)(len & 0xFF), (uint8_t)(len >> 8) };
+  if (s_c.write(hdr, 3) != 3) return false;
+  if (len && s_c.write(payload, len) != len) return false;
+  s_lastTxMs = millis();
+  s_stats.framesOut++;
+  return true;
+}
+
+static bool read_exact(uint8_t* dst, size_t n, uint32_t deadline) {
+  size_t got = 0;
+  while (got < n) {
+    if (!s_c.connected()) return false;
+    const int avail = s_c.available();
+    if (avail > 0) {
+      const int r = s_c.read(dst + got, n - got);
+      if (r > 0) { got += (size_t)r; continue; }
+    }
+    if ((int32_t)(millis() - deadline) >= 0) return false;
+    vTaskDelay(pdMS_TO_TICKS(5));
+  }
+  return true;
+}
+
+// Reads one frame. With timeoutMs == 0 it returns false at once if no
+// header has arrived yet (non-blocking poll).
+static bool read_frame(Frame& f, uint32_t timeoutMs) {
+  if (timeoutMs == 0 && s_c.available() < 3) return false;
+  const uint32_t deadline = millis() + (timeoutMs ? timeoutMs : STREAM_ACK_TIMEOUT_MS);
+
+  uint8_t hdr[3];
+  if (!read_exact(hdr, 3, deadline)) return false;
+  f.type = hdr[0];
+  f.len  = (uint16_t)(hdr[1] | (hdr[2] << 8));
+  if (f.len > MAX_PAYLOAD) { drop_connection("oversized frame"); return false; }
+  if (!read_exact(f.data, f.len, deadline)) { drop_connection("short frame"); return false; }
+
+  s_lastRxMs = millis();
+  s_stats.framesIn++;
+  return true;
+}
+
+static void handle_frame(const Frame& f) {
+  char text[LOG_BIN_STR_MAX + 1];
+  switch (f.type) {
+    case F_ACK: {
+      if (f.len < 2) break;
+      uint32_t seq = 0;
+      if (f.data[0] != F_MEAS || !wire_get_varint(f.data + 1, f.len - 1, seq)) break;
+      // This record and everything before it in the batch
+      for (size_t j = s_inflightN; j > s_inflightAck; --j) {
+        if (s_inflight[j - 1].seq == seq) { s_inflightAck = j; break; }
+      }
+      s_lastAcked = seq;
+      break;
+    }
+    case F_PUSH:
+      s_stats.pushes++;
+      LOGI("STREAM", "push: %s", frame_text(f, text, sizeof(text)));
+      break;
+    case F_PONG:
+      break;
+    case F_DENY:
+      s_stats.denied++;
+      LOGI("STREAM", "denied: %s", frame_text(f, text, sizeof(text)));
+      drop_connection("denied");
+      break;
+    default:
+      LOGI("STREAM", "unknown frame 0x%02x (%u B)", f.type, (unsigned)f.len);
+      break;
+  }
+}
+
+// Connect + HELLO/WELCOME if needed; rate-limited by STREAM_RECONNECT_MS.
+static bool ensure_session() {
+  if (s_session && s_c.connected()) return true;
+  if (s_session) drop_connection("socket lost");
+  if (!(app_get_bits() & AppBits::NET_UP)) return false;
+  if (s_lastTryMs && (millis() - s_lastTryMs) < STREAM_RECONNECT_MS) return false;
+  s_lastTryMs = millis();
+
+  const uint32_t t0 = millis();
+  if (HTTP_TLS_INSECURE) s_c.setInsecure();         // same trust model as http_client
+  else                   s_c.setCACert(SERVER_CA_PEM);
+  if (s_c.connect(STREAM_HOST, STREAM_PORT, (int32_t)CONNECT_TIMEOUT) != 1) {
+    LOGW("STREAM", "connect %s:%u failed", STREAM_HOST, (unsigned)STREAM_PORT);
+    s_c.stop();
+    return false;
+  }
+  s_c.setNoDelay(true);                             // small frames, send now
+
+  uint8_t mac[6];
+  if (!wire_parse_mac(WiFi.macAddress().c_str(), mac)) memset(mac, 0, sizeof(mac));
+  char id[48];
+  identity_copy_id(id, sizeof(id));
+
+  Payload p;
+  p.u8(PROTO_VERSION);
+  p.bytes(mac, sizeof(mac));
+  p.str(STREAM_TOKEN);
+  p.str(id);
+  p.str(DEVICE_NAME);
+  const uint32_t bootId = seq_boot_id();
+  const uint8_t boot[4] = { (uint8_t)bootId, (uint8_t)(bootId >> 8),
+                            (uint8_t)(bootId >> 16), (uint8_t)(bootId >> 24) };
+  p.bytes(boot, sizeof(boot));
+  p.varint(s_lastAcked);
+  if (p.ovf || !write_frame(F_HELLO, p.b, p.n)) { drop_connection("hello"); return false; }
+
+  Frame f;
+  if (!read_frame(f, CONNECT_TIMEOUT)) { drop_connection("no welcome"); return false; }
+  if (f.type != F_WELCOME) { handle_frame(f); drop_connection("unexpected reply"); return false; }
+
+  uint32_t hb = 0;
+  if (wire_get_varint(f.data, f.len, hb) && hb >= 1000) s_hbMs = hb;
+  s_session = true;
+  s_stats.connects++;
+  LOGI("STREAM", "session up in %lu ms (heartbeat %lu ms, resume after seq=%lu)",
+       (unsigned long)(millis() - t0), (unsigned long)s_hbMs, (unsigned long)s_lastAcked);
+  return true;
+}
+
+// Handle frames until 'done' or timeout; false if the wait expired.
+template <typename Done>
+static bool wait_for(Done done) {
+  const uint32_t deadline = millis() + STREAM_ACK_TIMEOUT_MS;
+  while (!done()) {
+    if (!s_session) return false;
+    Frame f;
+    const uint32_t left = deadline - millis();
+    if ((int32_t)left <= 0 || !read_frame(f, left)) {
+      s_stats.timeouts++;
+      drop_connection("ack timeout");
+      return false;
+    }
+    handle_frame(f);
+  }
+  return true;
+}
+
+size_t stream_send(const Measurement* recs, size_t n) {
+  if (!s_mtx) return 0;                             // stream_init not called
+  StreamLock lock;
+  if (!ensure_session()) return 0;
+
+  s_inflight    = recs;
+  s_inflightN   = n;
+  s_inflightAck = 0;
+
+  // Pipeline the whole batch, then wait for the ACKs
+  const uint32_t t0 = millis();
+  for (size_t i = 0; i < n; ++i) {
+    uint8_t rec[24];
+    const size_t len = wire_encode_record(rec, sizeof(rec), recs[i]);
+    if (!len || !write_frame(F_MEAS, rec, len)) { drop_connection("write"); break; }
+  }
+  wait_for([n] { return s_inflightAck >= n; });
+
+  const size_t acked = s_inflightAck;
+  s_inflight  = nullptr;
+  s_inflightN = s_inflightAck = 0;
+  s_stats.acked += acked;
+  s_stats.lastAckMs = millis() - t0;
+  return acked;
+}
+
+void stream_poll() {
+  if (!s_mtx) return;
+  StreamLock lock;
+  if (!ensure_session()) return;
+
+  Frame f;
+  while (s_session && read_frame(f, 0)) handle_frame(f);
+  if (!s_session) return;
+
+  const uint32_t now = millis();
+  if (now - s_lastRxMs > 3 * s_hbMs) { drop_connection("heartbeat lost"); return; }
+  if (now - s_lastTxMs >= s_hbMs && !write_frame(F_PING, nullptr, 0)) drop_connection("write");
+}
+
+void stream_close() {
+  if (!s_mtx) return;
+  StreamLock lock;
+  drop_connection("closed by device");
+}
+
+bool stream_connected() {
+  return s_session;
+}
+
+void stream_get_stats(StreamStats& out) {
+  out = s_stats;
+}
+
+// ---- Uploader transport ----
+
+static size_t stream_tx_send(const Measurement* recs, size_t n, TxError& err) {
+  const size_t acked = stream_send(recs, n);
+  if (acked < n) err = TxError::UNREACHABLE;      // no session, write error or ack timeout
+  LOGI("UPLOAD", "stream seq=%lu..%lu → %u/%u acked (%lu ms)",
+       (unsigned long)recs[0].seq, (unsigned long)recs[n - 1].seq,
+       (unsigned)acked, (unsigned)n, (unsigned long)s_stats.lastAckMs);
+  return acked;
+}
+
+const UploadTransport STREAM_TRANSPORT = {
+  "stream",
+  stream_tx_send,
+  stream_poll,
+  STREAM_HEARTBEAT_MS
+};
@@ -0,0 +1,47 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "features/measurement.h"
+
+// Persistent telemetry connection: one TLS socket to STREAM_HOST:STREAM_PORT,
+// length-prefixed frames both ways.
+//
+//   frame = type(u8) len(u16 LE) payload[len]
+//
+//   → HELLO   ver(u8) mac[6] token(str) id(str) name(str) boot(u32 LE) lastAcked(varint)
+//   ← WELCOME heartbeatMs(varint)
+//   ← DENY    reason(str)                      then the server closes
+//   → MEAS    record (weight_codec, absolute)  weights and FINISH events,
+//                                              pipelined, no wait per frame
+//   → PING                 ← PONG
+//   ← ACK     kind(u8) seq(varint)             that record and all before it
+//                                              on this connection
+//   ← PUSH    text                             server → device message (logged)
+//
+// str = varint length + bytes. Records that were sent but not acked when a
+// connection drops are resent after reconnect with the same seq (unique per
+// device, core/sequence), so the server drops the duplicates; HELLO tells
+// it where the device thinks it left off.
+
+struct StreamStats {
+  uint32_t connects;
+  uint32_t denied;
+  uint32_t framesOut;
+  uint32_t framesIn;
+  uint32_t acked;         // measurement records confirmed
+  uint32_t timeouts;      // ACK waits that expired (connection dropped)
+  uint32_t pushes;        // server → device messages
+  uint32_t lastAckMs;     // send → ACK round trip of the last batch
+};
+
+// Creates the connection lock; call once at boot, before the uploader
+// starts (the other calls do nothing until then).
+void   stream_init();
+
+// Returns how many leading records were acknowledged (blocks up to
+// STREAM_ACK_TIMEOUT_MS for the ACK).
+size_t stream_send(const Measurement* recs, size_t n);
+void   stream_poll();          // connect / heartbeat / drain incoming frames
+void   stream_close();
+bool   stream_connected();
+void   stream_get_stats(StreamStats& out);
@@ -0,0 +1,224 @@
+#include "weight_codec.h"
+#include <string.h>
+
+namespace {
+
+struct Out {
+  uint8_t* p;
+  size_t   cap;
+  size_t   n = 0;
+  bool     ovf = false;
+
+  void byte(uint8_t b) {
+    if (n >= cap) { ovf = true; return; }
+    p[n++] = b;
+  }
+  void bytes(const void* src, size_t len) {
+    if (n + len > cap) { ovf = true; return; }
+    memcpy(p + n, src, len);
+    n += len;
+  }
+  void varint(uint32_t v) {
+    while (v >= 0x80) { byte((uint8_t)(v | 0x80)); v >>= 7; }
+    byte((uint8_t)v);
+  }
+  void zigzag(int32_t v) { varint(((uint32_t)v << 1) ^ (uint32_t)(v >> 31)); }
+  void str(const char* s) {
+    const size_t len = s ? strlen(s) : 0;
+    varint((uint32_t)len);
+    bytes(s, len);
+  }
+};
+
+struct In {
+  const uint8_t* p;
+  size_t         len;
+  size_t         i = 0;
+  bool           bad = false;
+
+  uint8_t byte() {
+    if (i >= len) { bad = true; return 0; }
+    return p[i++];
+  }
+  uint32_t varint() {
+    uint32_t v = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+      const uint8_t b = byte();
+      v |= (uint32_t)(b & 0x7F) << shift;
+      if (!(b & 0x80)) return v;
+    }
+    bad = true;
+    return 0;
+  }
+  int32_t zigzag() {
+    const uint32_t u = varint();
+    return (int32_t)((u >> 1) ^ (~(u & 1) + 1));
+  }
+  void str(char* dst, size_t cap) {
+    const uint32_t n = varint();
+    if (bad || n > len - i) { bad = true; return; }
+    const size_t keep = (n < cap) ? n : (cap ? cap - 1 : 0);
+    if (cap) { memcpy(dst, p + i, keep); dst[keep] = '\0'; }
+    i += n;
+  }
+};
+
+// The record's value field: mg, or a FINISH's epoch as the same 32 bits
+uint32_t value_bits(const Measurement& m) {
+  return m.kind == MeasKind::FINISH ? m.epoch : (uint32_t)m.mg;
+}
+
+void put_record(Out& o, const Measurement& m, const Measurement* prev) {
+  if (prev) {
+    o.varint(m.seq - prev->seq);
+    o.zigzag((int32_t)m.boot - (int32_t)prev->boot);
+    o.zigzag((int32_t)(m.monoMs - prev->monoMs));
+    o.zigzag((int32_t)(value_bits(m) - value_bits(*prev)));
+  } else {
+    o.varint(m.seq);
+    o.zigzag((int32_t)m.boot);
+    o.zigzag((int32_t)m.monoMs);
+    o.zigzag((int32_t)value_bits(m));
+  }
+  const bool hasConf = m.confPct != 100;
+  o.byte((uint8_t)((m.kind == MeasKind::REMOVE ? 1 : 0) | (hasConf ? 2 : 0) |
+                   (m.kind == MeasKind::FINISH ? 4 : 0)));
+  if (hasConf) o.byte(m.confPct);
+}
+
+void get_record(In& r, Measurement& m, const Measurement* prev) {
+  const uint32_t seq  = r.varint();
+  const int32_t  boot = r.zigzag();
+  const int32_t  t    = r.zigzag();
+  const int32_t  val  = r.zigzag();
+  const uint8_t  fl   = r.byte();
+  uint32_t v = (uint32_t)val;
+  if (prev) {
+    m.seq    = prev->seq + seq;
+    m.boot   = (uint16_t)(prev->boot + boot);
+    m.monoMs = prev->monoMs + (uint32_t)t;
+    v       += value_bits(*prev);
+  } else {
+    m.seq = seq; m.boot = (uint16_t)boot; m.monoMs = (uint32_t)t;
+  }
+  m.kind    = (fl & 4) ? MeasKind::FINISH : (fl & 1) ? MeasKind::REMOVE : MeasKind::ADD;
+  if (m.kind == MeasKind::FINISH) m.epoch = v;
+  else                            m.mg    = (int32_t)v;
+  m.confPct = (fl & 2) ? r.byte() : 100;
+}
+
+} // namespace
+
+size_t wire_encode_batch(uint8_t* out, size_t cap, const WireHeader& h,
+                         const Measurement* recs, size_t n, size_t& outPacked) {
+  outPacked = 0;
+  Out o{ out, cap };
+  o.byte('S'); o.byte('W'); o.byte(WIRE_VERSION);
+  o.bytes(h.mac, 6);
+  o.str(h.id);
+  o.str(h.name);
+  o.varint(h.boot);
+  o.varint(h.nowMs);
+  o.varint(h.epoch);
+  const size_t countAt = o.n;
+  o.byte(0);                                     // patched below
+  if (o.ovf) return 0;
+
+  const size_t limit = n < 255 ? n : 255;
+  size_t packed = 0;
+  for (; packed < limit; ++packed) {
+    const size_t mark = o.n;
+    put_record(o, recs[packed], packed ? &recs[packed - 1] : nullptr);
+    if (o.ovf) { o.n = mark; break; }
+  }
+  if (packed == 0) return 0;
+
+  out[countAt] = (uint8_t)packed;
+  outPacked = packed;
+  return o.n;
+}
+
+bool wire_decode_batch(const uint8_t* in, size_t len, WireDecoded& hdr,
+                       Measurement* out, size_t maxRecs, size_t& outCount) {
+  outCount = 0;
+  In r{ in, len };
+  if (r.byte() != 'S' || r.byte() != 'W' || r.byte() != WIRE_VERSION) return false;
+  for (int k = 0; k < 6; ++k) hdr.mac[k] = r.byte();
+  r.str(hdr.id, sizeof(hdr.id));
+  r.str(hdr.name, sizeof(hdr.name));
+  hdr.boot  = r.varint();
+  hdr.nowMs = r.varint();
+  hdr.epoch = r.varint();
+  hdr.count = r.byte();
+  if (r.bad) return false;
+
+  Measurement prev{};
+  for (uint8_t k = 0; k < hdr.count; ++k) {
+    Measurement m{};
+    get_record(r, m, k ? &prev : nullptr);
+    if (r.bad) return false;
+    if (outCount < maxRecs) out[outCount++] = m;
+    prev = m;
+  }
+  return r.i == len;
+}
+
+size_t wire_encode_record(uint8_t* out, size_t cap, const Measurement& m) {
+  Out o{ out, cap };
+  put_record(o, m, nullptr);
+  return o.ovf ? 0 : o.n;
+}
+
+size_t wire_decode_record(const uint8_t* in, size_t len, Measurement& m) {
+  In r{ in, len };
+  m = Measurement{};
+  get_record(r, m, nullptr);
+  return r.bad ? 0 : r.i;
+}
+
+size_t wire_put_varint(uint8_t* out, size_t cap, uint32_t v) {
+  Out o{ out, cap };
+  o.varint(v);
+  return o.ovf ? 0 : o.n;
+}
+
+size_t wire_get_varint(const uint8_t* in, size_t len, uint32_t& v) {
+  In r{ in, len };
+  v = r.varint();
+  return r.bad ? 0 : r.i;
+}
+
+bool wire_parse_mac(const char* s, uint8_t mac[6]) {
+  auto hex = [](char c) -> int {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+  };
+  if (!s) return false;
+  for (int k = 0; k < 6; ++k) {
+    const int hi = hex(s[0]), lo = (hi < 0) ? -1 : hex(s[1]);
+    if (hi < 0 || lo < 0) return false;
+    mac[k] = (uint8_t)(hi << 4 | lo);
+    s += 2;
+    if (k < 5) { if (*s != ':' && *s != '-') return false; ++s; }
+  }
+  return *s == '\0';
+}
+
+bool wire_parse_ack(const char* resp, uint32_t& outCount) {
+  const char* p = resp ? strstr(resp, "\"ok\"") : nullptr;
+  if (!p) return false;
+  p += 4;
+  while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') ++p;
+  if (*p++ != ':') return false;
+  while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') ++p;
+  if (*p < '0' || *p > '9') return false;
+  uint64_t v = 0;
+  for (; *p >= '0' && *p <= '9'; ++p) {
+    v = v * 10 + (uint64_t)(*p - '0');
+    if (v > 0xFFFFFFFFu) return false;
+  }
+  outCount = (uint32_t)v;
+  return true;
+}
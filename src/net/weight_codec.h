@@ -0,0 +1,83 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "features/measurement.h"
+
+// Compact binary batch format for weight telemetry (no Arduino deps).
+//
+//   'S' 'W' ver=2
+//   mac[6]
+//   id     : varint len + bytes
+//   name   : varint len + bytes
+//   boot   : varint   current boot (clock domain of 'now')
+//   now    : varint   device millis() at send time
+//   epoch  : varint   seconds, 0 if unknown
+//   count  : u8
+//   items  : first record absolute, the rest as deltas to the previous one
+//     seq  : varint  (absolute, then seq - prevSeq)
+//     boot : zigzag  (absolute, then boot - prevBoot)
+//     t    : zigzag  (absolute, then t - prevT)
+//     value: zigzag  (absolute, then value - prevValue, mod 2^32)
+//                    ADD/REMOVE: Measurement::mg; FINISH: Measurement::epoch
+//                    (u32 seconds, 0 = unknown) read as int32
+//     flags: u8      bit0 = REMOVE, bit1 = conf byte follows, bit2 = FINISH
+//     [conf: u8]     Measurement::confPct when not 100: < 100 early estimate,
+//                    MEAS_CORRECTS | d replaces the estimate seq - d
+//
+// A typical record costs 6-9 bytes instead of ~70 in JSON.
+//
+// The server acknowledges a batch (bin2 or JSON) with a 2xx and {"ok":N}:
+// the first N records are stored. A 2xx without it confirms nothing.
+// v1 (no boot, no FINISH) was never negotiated by a release build.
+
+static constexpr uint8_t     WIRE_VERSION      = 2;
+static constexpr const char* WIRE_ENC_NAME     = "bin2";
+static constexpr const char* WIRE_CONTENT_TYPE = "application/x-smartscale-bin2";
+
+struct WireHeader {
+  uint8_t     mac[6];
+  const char* id;
+  const char* name;
+  uint32_t    boot;
+  uint32_t    nowMs;
+  uint32_t    epoch;
+};
+
+// Packs as many of recs[0..n) as fit in 'cap' bytes (at most 255).
+// Returns the encoded length, 0 if not even the header and one record fit.
+size_t wire_encode_batch(uint8_t* out, size_t cap, const WireHeader& h,
+                         const Measurement* recs, size_t n, size_t& outPacked);
+
+// Decoded header; strings are copied and truncated to the buffers.
+struct WireDecoded {
+  uint8_t  mac[6];
+  char     id[48];
+  char     name[48];
+  uint32_t boot;
+  uint32_t nowMs;
+  uint32_t epoch;
+  uint8_t  count;
+};
+
+// Inverse of wire_encode_batch (for the server side and round-trip checks).
+// Fills up to maxRecs records; returns false on malformed input.
+bool wire_decode_batch(const uint8_t* in, size_t len, WireDecoded& hdr,
+                       Measurement* out, size_t maxRecs, size_t& outCount);
+
+// One record, absolute fields (seq, boot, t, mg, flags[, conf]) as in a batch's
+// first item. Used by the streaming transport. Returns bytes, 0 if no room.
+size_t wire_encode_record(uint8_t* out, size_t cap, const Measurement& m);
+// Returns bytes consumed, 0 on malformed input.
+size_t wire_decode_record(const uint8_t* in, size_t len, Measurement& m);
+
+// LEB128 varint helpers shared with the stream framing. Return the bytes
+// written/consumed, 0 if there is no room / the input is malformed.
+size_t wire_put_varint(uint8_t* out, size_t cap, uint32_t v);
+size_t wire_get_varint(const uint8_t* in, size_t len, uint32_t& v);
+
+// {"ok":N} batch acknowledgement → N. Returns false when the reply has no
+// "ok" count (a legacy endpoint answering 2xx to a body it cannot parse).
+bool wire_parse_ack(const char* resp, uint32_t& outCount);
+
+// "AA:BB:CC:DD:EE:FF" → 6 bytes. Returns false on malformed input.
+bool wire_parse_mac(const char* s, uint8_t mac[6]);
@@ -0,0 +1,81 @@
+#include "wifi_creds.h"
+#include <Arduino.h>
+#include "storage/nvs_store.h"
+#include "util/log.h"
+
+static constexpr uint32_t LIST_MAGIC = 0x314C5357;   // "WSL1"
+
+struct Stored {
+  uint32_t     magic;
+  WifiCredList list;
+};
+
+static bool save_list(const WifiCredList& list) {
+  Stored s{};
+  s.magic = LIST_MAGIC;
+  s.list  = list;
+  return nvs_save_blob(WIFI_KEY_LIST, &s, sizeof(s));
+}
+
+static void set_cred(WifiCred& c, const char* ssid, const char* pass) {
+  memset(&c, 0, sizeof(c));
+  strlcpy(c.ssid, ssid, sizeof(c.ssid));
+  strlcpy(c.pass, pass ? pass : "", sizeof(c.pass));
+}
+
+int wifi_creds_find(const WifiCredList& list, const char* ssid) {
+  for (uint8_t i = 0; i < list.count; ++i) {
+    if (strcmp(list.items[i].ssid, ssid) == 0) return i;
+  }
+  return -1;
+}
+
+// Insert at the front; drops an existing entry for the same SSID, or the
+// last (oldest) one when full.
+static void put_front(WifiCredList& list, const char* ssid, const char* pass) {
+  int at = wifi_creds_find(list, ssid);
+  if (at < 0) at = (list.count < WIFI_MAX_NETWORKS) ? list.count++ : list.count - 1;
+  for (int i = at; i > 0; --i) list.items[i] = list.items[i - 1];
+  set_cred(list.items[0], ssid, pass);
+}
+
+size_t wifi_creds_load(WifiCredList& out) {
+  memset(&out, 0, sizeof(out));
+
+  Stored s;
+  if (nvs_load_blob(WIFI_KEY_LIST, &s, sizeof(s)) && s.magic == LIST_MAGIC &&
+      s.list.count <= WIFI_MAX_NETWORKS) {
+    out = s.list;
+    for (uint8_t i = 0; i < out.count; ++i) {       // never trust stored terminators
+      out.items[i].ssid[sizeof(out.items[i].ssid) - 1] = '\0';
+      out.items[i].pass[sizeof(out.items[i].pass) - 1] = '\0';
+    }
+  }
+
+  // Legacy single network (older firmware / older portal)
+  String ssid, pass;
+  if (nvs_load_string(WIFI_KEY_SSID, ssid)) {
+    (void)nvs_load_string(WIFI_KEY_PASS, pass);
+    put_front(out, ssid.c_str(), pass.c_str());
+    if (save_list(out)) {
+      nvs_remove_key(WIFI_KEY_SSID);
+      nvs_remove_key(WIFI_KEY_PASS);
+      LOGI("WiFi", "migrated saved network \"%s\" to the list", ssid.c_str());
+    }
+  }
+  return out.count;
+}
+
+bool wifi_creds_add(const char* ssid, const char* pass) {
+  if (!ssid || !*ssid) return false;
+  WifiCredList list;
+  wifi_creds_load(list);
+  put_front(list, ssid, pass);
+  return save_list(list);
+}
+
+void wifi_creds_clear() {
+  nvs_remove_key(WIFI_KEY_LIST);
+  nvs_remove_key(WIFI_KEY_SSID);
+  nvs_remove_key(WIFI_KEY_PASS);
+}
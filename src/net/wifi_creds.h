@@ -0,0 +1,29 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "app_config.h"
+
+// Saved Wi-Fi networks, one NVS blob (WIFI_KEY_LIST), most recently added
+// first. Adding an SSID that is already there updates its password and
+// moves it to the front; when the list is full the oldest entry goes.
+//
+// The first load migrates the legacy single pair (WIFI_KEY_SSID /
+// WIFI_KEY_PASS) into the list and removes those keys.
+
+struct WifiCred {
+  char ssid[33];
+  char pass[65];
+};
+
+struct WifiCredList {
+  uint8_t  count;
+  WifiCred items[WIFI_MAX_NETWORKS];
+};
+
+// Needs nvs_init(). Returns the number of networks (0 = none saved).
+size_t wifi_creds_load(WifiCredList& out);
+bool   wifi_creds_add(const char* ssid, const char* pass);
+void   wifi_creds_clear();                               // list + legacy keys
+
+// Index of 'ssid' in the list, -1 if absent.
+int    wifi_creds_find(const WifiCredList& list, const char* ssid);
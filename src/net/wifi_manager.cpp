@@ -10,10 +10,59 @@
 #include "net/ap_portal.h"
 #include "storage/nvs_store.h"
 #include "core/identity.h"
+#include "core/timekeeper.h"
+#include "net/http_client.h"
+#include "net/wifi_creds.h"
+#include "util/crc.h"
+#include "core/wake_stats.h"
+#include "util/log.h"
 
 static void wifiTask(void*);
 static void onWiFiEvent(WiFiEvent_t event);
 
+// Last good association, persisted as one blob. Only valid for the
+// credentials it was made with (ssidCrc) and when the CRC matches.
+struct FastCache {
+  uint32_t magic;
+  uint32_t ssidCrc;
+  uint8_t  bssid[6];
+  uint8_t  channel;
+  uint8_t  hasLease;       // ip..dns2 came from DHCP
+  uint32_t ip, gw, mask, dns1, dns2;
+  uint32_t leaseEpoch;     // when DHCP granted it (s), 0 = unknown: never reused
+  uint32_t crc;            // over everything above
+};
+static constexpr uint32_t FAST_MAGIC = 0x32465357;   // "WSF2"
+
+// A known AP from the last scan
+struct ScanHit {
+  uint8_t cred;            // index into the saved list
+  int8_t  rssi;
+  uint8_t channel;
+  uint8_t bssid[6];
+};
+
+// Connect-phase timestamps, written by the event handler
+static volatile uint32_t s_tBegin = 0;
+static volatile uint32_t s_tAssoc = 0;
+static volatile uint32_t s_tIp    = 0;
+static WifiStats         s_stats{};
+static volatile bool     s_portalReq = false;
+static TaskHandle_t      s_task      = nullptr;   // notified on disconnect / portal request
+
+// Scan cache (Wi-Fi task only), strongest first
+static ScanHit  s_hits[WIFI_MAX_CANDIDATES];
+static uint8_t  s_hitCount = 0;
+static uint32_t s_scanAtMs = 0;
+
+// Roaming (Wi-Fi task only)
+static bool     s_roamScan      = false;   // background scan running
+static uint32_t s_roamScanAtMs  = 0;
+static bool     s_roamPending   = false;   // switch to s_roamHit when idle
+static bool     s_roaming       = false;   // disconnect issued: latched until the reconnect
+static uint32_t s_roamAtMs      = 0;
+static ScanHit  s_roamHit{};
+
 void wifi_start() {
   // Optional: set hostname so your router shows a friendly name
   WiFi.setHostname("SmartScale");
@@ -28,75 +77,361 @@ void wifi_start() {
     TASK_STACK_WIFI,
     nullptr,
     TASK_PRIO_WIFI,
-    nullptr,            // prio 3 is fine; networking is important
+    &s_task,            // prio 3 is fine; networking is important
     (TASK_CORE_WIFI < 0) ? tskNO_AFFINITY : TASK_CORE_WIFI                     // pin to core 0 (ESP32 WiFi stack prefers core 0)
   );
 }
 
+void wifi_get_stats(WifiStats& out) {
+  out = s_stats;
+}
+
+void wifi_request_portal() {
+  s_portalReq = true;
+  if (s_task) xTaskNotifyGive(s_task);
+}
+
+static uint32_t fast_crc(const FastCache& c) {
+  return crc32(&c, offsetof(FastCache, crc));
+}
+
+static uint32_t ssid_crc(const char* ssid) {
+  return crc32(ssid, strlen(ssid));
+}
+
+// Returns the saved network the cache belongs to, -1 if none/invalid
+static int load_fast(const WifiCredList& list, FastCache& c) {
+  if (!nvs_load_blob(WIFI_KEY_FAST, &c, sizeof(c))) return -1;
+  if (c.magic != FAST_MAGIC || c.crc != fast_crc(c) || c.channel < 1 || c.channel > 14) return -1;
+  for (uint8_t i = 0; i < list.count; ++i) {
+    if (ssid_crc(list.items[i].ssid) == c.ssidCrc) return i;
+  }
+  return -1;
+}
+
+// A cached lease may stand in for DHCP only while it is provably younger
+// than WIFI_FAST_LEASE_MAX_S; without a valid clock its age is unknown.
+static bool lease_fresh(const FastCache& c) {
+  if (!c.hasLease || c.leaseEpoch == 0) return false;
+  const uint32_t now = (uint32_t)time_epoch();
+  return now != 0 && now - c.leaseEpoch < WIFI_FAST_LEASE_MAX_S;
+}
+
+// Snapshot the live association; keeps the stored lease (and its grant
+// time) when this connection ran on static config, until it expires.
+static void save_fast(const char* ssid, FastCache& c, bool haveOld, bool leaseFromDhcp) {
+  FastCache n{};
+  n.magic   = FAST_MAGIC;
+  n.ssidCrc = ssid_crc(ssid);
+  const uint8_t* b = WiFi.BSSID();
+  if (!b) return;
+  memcpy(n.bssid, b, sizeof(n.bssid));
+  n.channel = (uint8_t)WiFi.channel();
+  if (leaseFromDhcp) {
+    n.hasLease = 1;
+    n.ip   = (uint32_t)WiFi.localIP();
+    n.gw   = (uint32_t)WiFi.gatewayIP();
+    n.mask = (uint32_t)WiFi.subnetMask();
+    n.dns1 = (uint32_t)WiFi.dnsIP(0);
+    n.dns2 = (uint32_t)WiFi.dnsIP(1);
+    n.leaseEpoch = (uint32_t)time_epoch();
+  } else if (haveOld && n.ssidCrc == c.ssidCrc && memcmp(n.bssid, c.bssid, sizeof(n.bssid)) == 0 &&
+             lease_fresh(c)) {
+    n.hasLease = c.hasLease;
+    n.ip = c.ip; n.gw = c.gw; n.mask = c.mask; n.dns1 = c.dns1; n.dns2 = c.dns2;
+    n.leaseEpoch = c.leaseEpoch;
+  }
+  n.crc = fast_crc(n);
+
+  if (haveOld && memcmp(&n, &c, sizeof(n)) == 0) return;   // unchanged: no flash write
+  if (nvs_save_blob(WIFI_KEY_FAST, &n, sizeof(n))) {
+    c = n;
+    LOGI("WiFi", "fast-connect cache saved (ch %u%s)",
+         (unsigned)n.channel, n.hasLease ? ", lease" : "");
+  }
+}
+
+// Static config from app_config, else the cached lease (fast path only,
+// while fresh), else DHCP. Returns true when DHCP is in use.
+static bool apply_ip_config(const FastCache* lease) {
+  if (WIFI_STATIC_IP[0]) {
+    IPAddress ip, gw, mask, dns;
+    ip.fromString(WIFI_STATIC_IP);
+    gw.fromString(WIFI_STATIC_GW[0] ? WIFI_STATIC_GW : WIFI_STATIC_IP);
+    mask.fromString(WIFI_STATIC_MASK);
+    dns.fromString(WIFI_STATIC_DNS[0] ? WIFI_STATIC_DNS : (WIFI_STATIC_GW[0] ? WIFI_STATIC_GW : WIFI_STATIC_IP));
+    WiFi.config(ip, gw, mask, dns);
+    return false;
+  }
+  if (lease && lease_fresh(*lease)) {
+    WiFi.config(IPAddress(lease->ip), IPAddress(lease->gw), IPAddress(lease->mask),
+                IPAddress(lease->dns1), IPAddress(lease->dns2));
+    return false;
+  }
+  WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);   // back to DHCP
+  return true;
+}
+
+// Block until GOT_IP (NET_UP) or timeout; no status polling.
+static bool wait_connected(uint32_t timeoutMs) {
+  return app_wait_bits(AppBits::NET_UP, timeoutMs) && WiFi.status() == WL_CONNECTED;
+}
+
+static void begin_timing() {
+  s_tAssoc = 0;
+  s_tIp    = 0;
+  s_tBegin = millis();
+}
+
+static bool connect_fast(const WifiCred& cred, const FastCache& c, bool& dhcp) {
+  s_stats.fastTries++;
+  dhcp = apply_ip_config(WIFI_FAST_REUSE_LEASE ? &c : nullptr);
+  LOGI("WiFi", "Fast connect to %s (ch %u, %02X:%02X:%02X:%02X:%02X:%02X%s) ...",
+       cred.ssid, (unsigned)c.channel, c.bssid[0], c.bssid[1], c.bssid[2],
+       c.bssid[3], c.bssid[4], c.bssid[5], dhcp ? "" : ", cached IP");
+  begin_timing();
+  WiFi.begin(cred.ssid, cred.pass, c.channel, c.bssid, true);
+  if (wait_connected(WIFI_FAST_TIMEOUT_MS)) { s_stats.fastOk++; return true; }
+
+  s_stats.lastFastLostMs = millis() - s_tBegin;
+  LOGW("WiFi", "Fast connect failed after %lu ms → scan",
+       (unsigned long)s_stats.lastFastLostMs);
+  WiFi.disconnect();
+  return false;
+}
+
+// Keep the strongest known APs from a finished scan ('n' results)
+static void collect_hits(const WifiCredList& list, int16_t n) {
+  s_hitCount = 0;
+  for (int16_t i = 0; i < n; ++i) {
+    const int32_t rssi = WiFi.RSSI(i);
+    if (rssi < WIFI_MIN_RSSI) continue;
+    const int cred = wifi_creds_find(list, WiFi.SSID(i).c_str());
+    if (cred < 0) continue;
+
+    // insertion into the sorted top-N
+    uint8_t at = s_hitCount;
+    while (at > 0 && s_hits[at - 1].rssi < rssi) at--;
+    if (at >= WIFI_MAX_CANDIDATES) continue;
+    const uint8_t last = (s_hitCount < WIFI_MAX_CANDIDATES) ? s_hitCount++ : s_hitCount - 1;
+    for (uint8_t k = last; k > at; --k) s_hits[k] = s_hits[k - 1];
+
+    ScanHit& h = s_hits[at];
+    h.cred    = (uint8_t)cred;
+    h.rssi    = (int8_t)rssi;
+    h.channel = (uint8_t)WiFi.channel(i);
+    memcpy(h.bssid, WiFi.BSSID(i), sizeof(h.bssid));
+  }
+  WiFi.scanDelete();
+  s_scanAtMs = millis();
+  s_stats.scans++;
+}
+
+static void scan_known(const WifiCredList& list) {
+  const uint32_t t0 = millis();
+  const int16_t n = WiFi.scanNetworks(false, false, false, 120);
+  if (n < 0) { s_hitCount = 0; s_scanAtMs = 0; return; }
+  collect_hits(list, n);
+  LOGI("WiFi", "Scan: %d APs, %u known in range (%lu ms)",
+       (int)n, (unsigned)s_hitCount, (unsigned long)(millis() - t0));
+  for (uint8_t i = 0; i < s_hitCount; ++i) {
+    LOGI("WiFi", "  %s ch %u %d dBm", list.items[s_hits[i].cred].ssid,
+         (unsigned)s_hits[i].channel, (int)s_hits[i].rssi);
+  }
+}
+
+static bool connect_hit(const WifiCred& cred, const ScanHit& h, bool& dhcp) {
+  s_stats.scanTries++;
+  dhcp = apply_ip_config(nullptr);
+  LOGI("WiFi", "Connecting to %s (ch %u, %d dBm) ...",
+       cred.ssid, (unsigned)h.channel, (int)h.rssi);
+  begin_timing();
+  WiFi.begin(cred.ssid, cred.pass, h.channel, h.bssid, true);
+  if (wait_connected(WIFI_CONNECT_TIMEOUT_MS)) { s_stats.scanOk++; return true; }
+  WiFi.disconnect();
+  return false;
+}
+
+// No known AP seen (hidden SSID?): let the driver probe for the newest one
+static bool connect_blind(const WifiCred& cred, bool& dhcp) {
+  s_stats.scanTries++;
+  dhcp = apply_ip_config(nullptr);
+  LOGI("WiFi", "Connecting to %s (not in scan) ...", cred.ssid);
+  begin_timing();
+  WiFi.begin(cred.ssid, cred.pass);
+  if (wait_connected(WIFI_CONNECT_TIMEOUT_MS)) { s_stats.scanOk++; return true; }
+  WiFi.disconnect();
+  return false;
+}
+
+// While connected: start a background scan when the signal is weak and,
+// once it is done, queue a switch to a clearly stronger known AP.
+static void roam_tick(const WifiCredList& list) {
+  if (s_roamScan) {
+    const int16_t n = WiFi.scanComplete();
+    if (n == -1) return;                           // still scanning
+    s_roamScan = false;
+    if (n < 0) return;
+    collect_hits(list, n);
+
+    const uint8_t* cur = WiFi.BSSID();
+    const int8_t rssi = (int8_t)WiFi.RSSI();
+    for (uint8_t i = 0; i < s_hitCount; ++i) {
+      if (cur && memcmp(s_hits[i].bssid, cur, 6) == 0) continue;
+      if (s_hits[i].rssi >= rssi + (int)WIFI_ROAM_DELTA_DB) {
+        s_roamHit = s_hits[i];
+        s_roamPending = true;
+        LOGI("WiFi", "Roam: %s ch %u %d dBm vs current %d dBm",
+             list.items[s_roamHit.cred].ssid, (unsigned)s_roamHit.channel,
+             (int)s_roamHit.rssi, (int)rssi);
+      }
+      break;                                       // hits are sorted: only the best counts
+    }
+    return;
+  }
+
+  if (s_roamPending) {
+    if (s_roaming) {                               // disconnect issued, link not down yet
+      if ((millis() - s_roamAtMs) < WIFI_CONNECT_TIMEOUT_MS) return;
+      LOGW("WiFi", "Roam: still connected %lu ms after disconnect, staying",
+           (unsigned long)(millis() - s_roamAtMs));
+      s_roaming = s_roamPending = false;
+      return;
+    }
+    // Under the request lock the uploader posts with: no POST can start
+    // between the POSTING check and the disconnect
+    if (!http_try_hold()) return;                  // a request is in flight
+    if (!(app_get_bits() & AppBits::POSTING)) {
+      s_roaming  = true;
+      s_roamAtMs = millis();
+      s_stats.roams++;
+      WiFi.disconnect();                           // the task loop connects to s_roamHit
+    }
+    http_release();
+    return;
+  }
+
+  const int8_t rssi = (int8_t)WiFi.RSSI();
+  s_stats.rssi = rssi;
+  if (rssi == 0 || rssi > WIFI_ROAM_RSSI) return;
+  if (s_roamScanAtMs && (millis() - s_roamScanAtMs) < WIFI_ROAM_INTERVAL_MS) return;
+  s_roamScanAtMs = millis();
+  if (WiFi.scanNetworks(true) == -1) s_roamScan = true;   // WIFI_SCAN_RUNNING
+}
+
+static void log_connected(WifiPath path, uint32_t tStart, const char* ssid) {
+  const uint32_t tIp    = s_tIp ? s_tIp : millis();
+  const uint32_t tAssoc = s_tAssoc ? s_tAssoc : tIp;
+  s_stats.lastPath    = path;
+  s_stats.lastAssocMs = tAssoc - s_tBegin;
+  s_stats.lastIpMs    = tIp - tAssoc;
+  s_stats.lastTotalMs = tIp - tStart;
+  LOGI("WiFi", "Connected to %s (%s) in %lu ms: assoc %lu ms, ip %lu ms. IP: %s RSSI: %d ch %ld",
+       ssid, path == WifiPath::FAST ? "fast" : "scan",
+       (unsigned long)s_stats.lastTotalMs, (unsigned long)s_stats.lastAssocMs,
+       (unsigned long)s_stats.lastIpMs, WiFi.localIP().toString().c_str(),
+       WiFi.RSSI(), (long)WiFi.channel());
+}
+
 static void wifiTask(void*) {
-  // Station mode
+  // Station mode; this task does all (re)connecting
   WiFi.mode(WIFI_STA);
   WiFi.persistent(false);
+  WiFi.setAutoReconnect(false);
 
-
-  // Try to load saved creds from NVS
-  String ssid, pass;
-  bool haveCreds = nvs_load_string(WIFI_KEY_SSID, ssid);
-  if (haveCreds) (void)nvs_load_string(WIFI_KEY_PASS, pass);
-
-  if (!haveCreds) {
-    Serial.println("[WiFi] No saved creds → AP portal");
+  // Saved networks from NVS (migrates the old single SSID/pass)
+  static WifiCredList creds;          // ~500 B, keep it off the stack
+  if (wifi_creds_load(creds) == 0) {
+    LOGI("WiFi", "No saved networks → AP portal");
     ap_portal_run();   // will reboot after saving
     vTaskDelete(nullptr);
     return;
   }
+  for (uint8_t i = 0; i < creds.count; ++i) {
+    LOGI("WiFi", "Saved network %u: \"%s\" (pass_len=%u)", (unsigned)i,
+         creds.items[i].ssid, (unsigned)strlen(creds.items[i].pass));
+  }
 
-  Serial.printf("[WiFi] Saved SSID: \"%s\" (pass_len=%u)\r\n", ssid.c_str(), (unsigned)pass.length());
-
-  uint8_t attempt = 0;
+  FastCache cache{};
+  int  fastCred  = WIFI_FAST_CONNECT ? load_fast(creds, cache) : -1;
+  bool haveCache = fastCred >= 0;
+  bool tryFast   = haveCache;        // once per outage; the scan path refreshes the cache
+  uint32_t retryMs = WIFI_RETRY_MIN_MS;
 
   for (;;) {
+    if (s_portalReq) {
+      LOGI("WiFi", "Portal requested → AP portal");
+      app_clear_bits(AppBits::NET_UP);
+      ap_portal_run();   // never returns, reboots
+    }
 
     if (WiFi.status() == WL_CONNECTED) {
-      // Already connected; sleep a bit and re-check
-      vTaskDelay(pdMS_TO_TICKS(1000));
+      // Already connected; watch the signal. A disconnect or portal request
+      // wakes us early; a running roam scan / pending switch polls faster.
+      roam_tick(creds);
+      const bool busy = s_roamScan || s_roamPending;
+      ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(busy ? 500 : WIFI_RSSI_CHECK_MS));
+      wake_note(WakeSrc::WIFI);
       continue;
     }
 
-    // Try to connect
-    Serial.printf("[WiFi] Connecting to %s ...\r\n", ssid.c_str());
-    WiFi.begin(ssid.c_str(), pass.c_str());
-
-    const uint32_t t0 = millis();
-    bool connected = false;
-    while (millis() - t0 < WIFI_CONNECT_TIMEOUT_MS) {
-        if (WiFi.status() == WL_CONNECTED) {
-            connected = true;
-            break;
-        }
-        vTaskDelay(pdMS_TO_TICKS(200));
+    const uint32_t tStart = millis();
+    bool dhcp = true;
+    int  cred = -1;
+    WifiPath path = WifiPath::NONE;
+
+    if (s_roamPending) {
+      if (connect_hit(creds.items[s_roamHit.cred], s_roamHit, dhcp)) { cred = s_roamHit.cred; path = WifiPath::SCAN; }
+      s_roamPending = false;                       // switched, or the usual paths below take over
+      s_roaming     = false;
+    }
+    if (path == WifiPath::NONE && tryFast && connect_fast(creds.items[fastCred], cache, dhcp)) {
+      cred = fastCred;
+      path = WifiPath::FAST;
     }
+    tryFast = false;
 
-    if (connected) {
-      attempt = 0; // reset attempts on success
-      Serial.printf("[WiFi] Connected. IP: %s RSSI: %d\r\n",
-                    WiFi.localIP().toString().c_str(), WiFi.RSSI());
+    if (path == WifiPath::NONE) {
+      if (s_hitCount == 0 || (millis() - s_scanAtMs) >= WIFI_SCAN_CACHE_MS) scan_known(creds);
+      for (uint8_t i = 0; i < s_hitCount && path == WifiPath::NONE; ++i) {
+        if (connect_hit(creds.items[s_hits[i].cred], s_hits[i], dhcp)) { cred = s_hits[i].cred; path = WifiPath::SCAN; }
+      }
+      if (path == WifiPath::NONE && s_hitCount == 0 && connect_blind(creds.items[0], dhcp)) {
+        cred = 0;
+        path = WifiPath::SCAN;
+      }
+    }
+
+    if (path != WifiPath::NONE) {
+      retryMs = WIFI_RETRY_MIN_MS;
+      log_connected(path, tStart, creds.items[cred].ssid);
       app_set_bits(AppBits::NET_UP);
-      
+      if (WIFI_FAST_CONNECT) {
+        save_fast(creds.items[cred].ssid, cache, haveCache, dhcp);
+        haveCache = true;
+        fastCred  = cred;
+        tryFast   = true;                // next outage starts with the fast path
+      }
+
       //Do welcome POST here (once per connection)
       identity_ensure_welcome();
 
     } else {
-      attempt++;
-      Serial.println("[WiFi] Connect timeout.");
+      LOGI("WiFi", "No network reachable → retry in %lu ms", (unsigned long)retryMs);
       app_clear_bits(AppBits::NET_UP);       // ensure flag is clear
+      s_scanAtMs = 0;                        // rescan next round
+      s_hitCount = 0;
 
-      if (attempt >= WIFI_MAX_ATTEMPTS) {
-        Serial.println("[WiFi] Max attempts reached → AP portal");
-        ap_portal_run();   // never returns, reboots
-      } else {
-        vTaskDelay(pdMS_TO_TICKS(1000));
+      // Keep measuring (records spool); back off so we are not scanning nonstop
+      // (only a portal request cuts the wait short)
+      ulTaskNotifyTake(pdTRUE, 0);           // drop disconnect notifies from this round
+      const uint32_t t0 = millis();
+      for (uint32_t el = 0; el < retryMs && !s_portalReq; el = millis() - t0) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(retryMs - el));
+        wake_note(WakeSrc::WIFI);
       }
+      retryMs = (retryMs * 2 < WIFI_RETRY_MAX_MS) ? retryMs * 2 : WIFI_RETRY_MAX_MS;
+      if (haveCache) tryFast = true;         // the old AP may simply have rebooted
     }
 
     // Small idle delay to avoid tight loops
@@ -107,21 +442,25 @@ static void wifiTask(void*) {
 static void onWiFiEvent(WiFiEvent_t event) {
   switch (event) {
     case SYSTEM_EVENT_STA_CONNECTED:
-      Serial.println("[WiFi] STA_CONNECTED");
+      s_tAssoc = millis();
+      LOGI("WiFi", "STA_CONNECTED");
       break;
 
     case SYSTEM_EVENT_STA_GOT_IP:
-      Serial.printf("[WiFi] GOT_IP: %s\r\n", WiFi.localIP().toString().c_str());
+      s_tIp = millis();
+      LOGI("WiFi", "GOT_IP: %s", WiFi.localIP().toString().c_str());
       app_set_bits(AppBits::NET_UP);
       break;
 
     case SYSTEM_EVENT_STA_DISCONNECTED:
-      Serial.println("[WiFi] DISCONNECTED");
+      LOGI("WiFi", "DISCONNECTED");
       app_clear_bits(AppBits::NET_UP);   // LED back to SLOW_BLINK
+      http_close();                      // the kept-alive TLS socket is dead now
       // WiFi.begin(...) will be re-called by the task loop if needed
+      if (s_task) xTaskNotifyGive(s_task);
       break;
 
     default:
       break;
   }
-}
\ No newline at end of file
+}
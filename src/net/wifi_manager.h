@@ -1,5 +1,43 @@
 #pragma once
+#include <stdint.h>
 
 // Start a background task that tries to connect STA and keeps NET_UP updated.
-// For now it uses WIFI_SSID/WIFI_PASS from app_config.h.
-void wifi_start();
\ No newline at end of file
+// Networks come from the saved list (net/wifi_creds.h); an empty list
+// starts the AP portal, otherwise the device keeps retrying (with backoff,
+// still measuring and spooling) until a network is back.
+//
+// Every (re)connect tries a fast path first: a directed connect to the last
+// good BSSID + channel (no scan) and, with WIFI_FAST_REUSE_LEASE, the last
+// DHCP lease applied as static config (no DHCP round trip) while it is
+// younger than WIFI_FAST_LEASE_MAX_S by NTP time, else DHCP. If that does
+// not come up within WIFI_FAST_TIMEOUT_MS, a scan picks the strongest
+// known APs (results cached for WIFI_SCAN_CACHE_MS) and they are tried
+// best first, up to WIFI_MAX_CANDIDATES. The fast cache (WIFI_KEY_FAST) is
+// rewritten only when it changes.
+//
+// Roaming: while connected below WIFI_ROAM_RSSI, a background scan runs at
+// most every WIFI_ROAM_INTERVAL_MS; a known AP at least WIFI_ROAM_DELTA_DB
+// stronger is switched to between requests (never during a POST).
+void wifi_start();
+
+// Ask the Wi-Fi task to open the setup portal (e.g. on a long press).
+// The portal adds a network to the list and reboots.
+void wifi_request_portal();
+
+enum class WifiPath : uint8_t { NONE, FAST, SCAN };
+
+struct WifiStats {
+  WifiPath lastPath;        // how the current/last connection was made
+  uint32_t fastTries;
+  uint32_t fastOk;
+  uint32_t scanTries;
+  uint32_t scanOk;
+  uint32_t lastAssocMs;     // begin() → associated (STA_CONNECTED)
+  uint32_t lastIpMs;        // associated → GOT_IP (DHCP, or static config)
+  uint32_t lastTotalMs;     // begin() → GOT_IP, including a failed fast try
+  uint32_t lastFastLostMs;  // time spent on a fast try that failed
+  uint32_t scans;           // blocking + background
+  uint32_t roams;           // switches to a stronger AP
+  int8_t   rssi;            // at the last check while connected
+};
+void wifi_get_stats(WifiStats& out);
@@ -0,0 +1,257 @@
+// Host simulation of the weighing pipeline ([env:native], hal/fake.h).
+//
+//   fake HX711 → calibration math → filter chain → adaptive Kalman →
+//   measurement logic → spool (RAM flash) → binary batch → fake HTTP
+//
+// A scripted sequence of loads is placed on the fake cell; every weight the
+// logic emits is spooled, uploaded and decoded again on the "server" side.
+// Prints what was sent, the detect → stable latency of each weight and the
+// host cost of the pipeline per conversion. Exit code 1 when a load change
+// has no weight within STABILITY_BAND_MG, or a record is lost or altered
+// on the way to the server.
+//
+//   pio run -e native -t exec            (or: .pio/build/native/program)
+//   (left out of `pio test -e native` builds, which link their own main)
+//   options: --early  enable the early-settle estimate
+//            --seed N ADC noise seed
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "app_config.h"
+#include "hal/clock.h"
+#include "hal/fake.h"
+#include "hal/hx711_port.h"
+#include "hal/http_port.h"
+#include "features/adaptive_filter.h"
+#include "features/calibration_math.h"
+#include "features/filter_chain.h"
+#include "features/measurement_logic.h"
+#include "net/weight_codec.h"
+#include "storage/nvs_store.h"
+#include "storage/spool_log.h"
+#include "util/fixed_weight.h"
+
+#ifndef PIO_UNIT_TESTING     // the test runners bring their own main()
+
+struct LoadStep {
+  int32_t  mg;          // total on the scale
+  uint32_t settleMs;    // ring-down time constant
+  uint32_t dwellMs;     // time until the next step
+};
+
+static const LoadStep kScript[] = {
+  {      0,   0, 3000 },
+  { 250000, 300, 4000 },
+  { 750000, 500, 4000 },
+  { 700000, 200, 4000 },
+  { 700000,   0, 2000 },   // no change: must not send
+  {      0, 300, 4000 },
+};
+static constexpr size_t SCRIPT_LEN = sizeof(kScript) / sizeof(kScript[0]);
+
+static constexpr uint32_t SERVER_DOWN_UNTIL_MS = 9000;   // first uploads fail, spool holds them
+static constexpr size_t   MAX_WEIGHTS = 16;
+
+// ---- Fake server: decodes what the uploader posts ----
+
+static Measurement s_rx[MAX_WEIGHTS];
+static size_t      s_rxN = 0;
+static uint32_t    s_rxBad = 0;
+
+static int server(const char*, const char* contentType, const uint8_t* body, size_t len,
+                  char* resp, size_t respCap) {
+  if (hal_millis() < SERVER_DOWN_UNTIL_MS) return 503;
+  if (strcmp(contentType, WIRE_CONTENT_TYPE) != 0) return 415;
+
+  WireDecoded hdr;
+  Measurement recs[BATCH_MAX_RECORDS];
+  size_t n = 0;
+  if (!wire_decode_batch(body, len, hdr, recs, BATCH_MAX_RECORDS, n)) { s_rxBad++; return 400; }
+  for (size_t i = 0; i < n && s_rxN < MAX_WEIGHTS; ++i) s_rx[s_rxN++] = recs[i];
+  snprintf(resp, respCap, "{\"ok\":%u}", (unsigned)n);
+  return 200;
+}
+
+// ---- Uploader stand-in: drain the spool in batches ----
+
+static void upload(SpoolLog& spool) {
+  Measurement recs[BATCH_MAX_RECORDS];
+  const size_t n = spool.peek(recs, sizeof(Measurement), BATCH_MAX_RECORDS);
+  if (n == 0) return;
+
+  WireHeader h{};
+  h.id    = "sim";
+  h.name  = "";
+  h.boot  = 1;
+  h.nowMs = hal_millis();
+
+  uint8_t body[256];
+  size_t packed = 0;
+  const size_t len = wire_encode_batch(body, sizeof(body), h, recs, n, packed);
+  if (len == 0) return;
+
+  char resp[64];
+  const int code = hal_http_post("/batch", WIRE_CONTENT_TYPE, body, len, resp, sizeof(resp));
+  uint32_t ack = 0;                                 // commit only what the server confirmed
+  if (code >= 200 && code < 300 && wire_parse_ack(resp, ack)) spool.commit(ack < packed ? ack : packed);
+}
+
+static int32_t average_raw(uint16_t n) {
+  int64_t sum = 0;
+  for (uint16_t i = 0; i < n; ++i) sum += hal_hx711_read();
+  return (int32_t)(sum / n);
+}
+
+int main(int argc, char** argv) {
+  bool     early = false;
+  uint32_t seed  = 1;
+  for (int i = 1; i < argc; ++i) {
+    if (!strcmp(argv[i], "--early")) early = true;
+    else if (!strcmp(argv[i], "--seed") && i + 1 < argc) seed = (uint32_t)strtoul(argv[++i], nullptr, 0);
+  }
+
+  nvs_init();
+  fake_http_set_handler(server);
+  fake_hx711_config({ HX_RATE_SPS, 150000, 420.0f, 150, seed });
+  hal_hx711_begin(1, 10, 128);
+
+  // ---- Calibration: tare, 100 g, scale ----
+  WeightScale scale;
+  scale.offset = average_raw(50);
+  fake_hx711_load(CAL_MASS_MG, 200);
+  hal_delay_ms(2000);
+  const int32_t rawRef = average_raw(20);
+  if (!calibration_load_present(scale.offset, rawRef) ||
+      !calibration_scale(scale.offset, rawRef, CAL_MASS_MG, scale.mgPerCountQ16)) {
+    printf("calibration failed (zero=%ld ref=%ld)\n", (long)scale.offset, (long)rawRef);
+    return 1;
+  }
+  nvs_save_float("cal_scale", weight_scale_to_counts_per_g(scale.mgPerCountQ16));
+  printf("calibration: offset=%ld scale=%.3f counts/g (true 420.000)\n",
+         (long)scale.offset, weight_scale_to_counts_per_g(scale.mgPerCountQ16));
+  fake_hx711_load(0, 0);
+
+  // ---- Weighing ----
+  // Rate from conversion spacing, as the sensor task does on a strapped board
+  uint32_t stamps[9];
+  for (uint32_t& us : stamps) { (void)hal_hx711_read(); us = hal_micros(); }
+  uint16_t sps = filter_rate_from_stamps(stamps, 9);
+  if (!sps) sps = HX_RATE_SPS;
+  FilterChain chain({ sps, FILT_CIC_ORDER, (uint8_t)(sps / FILT_OUT_SPS), (FilterPost)FILT_POST });
+  printf("HX711 rate %u SPS → filter latency ~%lu ms\n", (unsigned)sps, (unsigned long)chain.latencyMs());
+  AdaptiveKalman live(LIVE_SIGMA_MEAS_MG, LIVE_SIGMA_REST_MG, LIVE_GATE_SIGMA);
+  static MeasurementLogic logic({ DELTA_SEND_MG, STABILITY_MS, STABILITY_BAND_MG,
+                                  early, EARLY_SETTLE_MIN_CONF,
+                                  { EARLY_SETTLE_MIN_SAMPLES, EARLY_SETTLE_MAX_RMS_MG,
+                                    EARLY_SETTLE_MAX_EXTRAP_MG, EARLY_SETTLE_MAX_DECAY_Q16 } });
+
+  static uint8_t flashMem[16 * 4096];
+  RamFlash flash(flashMem, sizeof(flashMem));
+  SpoolLog spool(flash);
+  if (!spool.mount()) { printf("spool mount failed\n"); return 1; }
+
+  Measurement sent[MAX_WEIGHTS];
+  int32_t  sentTotal[MAX_WEIGHTS];     // scale reading behind each record
+  size_t   sentN = 0;
+  uint32_t seq = 1;
+  int32_t  expected[SCRIPT_LEN];
+  size_t   expectedN = 0;
+  int32_t  prevLoad = 0;
+
+  uint32_t earlySeq = 0;
+  auto emit = [&](const MeasurementLogic::Weight& w, uint32_t correctsSeq) {
+    Measurement m{};
+    const bool increased = (w.valueMg - w.prevMg) >= 0;
+    m.mg      = increased ? w.valueMg : w.valueMg - w.prevMg;
+    m.kind    = increased ? MeasKind::ADD : MeasKind::REMOVE;
+    m.confPct = w.confPct;
+    m.monoMs  = hal_millis();
+    m.seq     = seq++;
+    m.boot    = 1;
+    if (correctsSeq) m.confPct = meas_correction_conf(m.seq, correctsSeq);
+    if (sentN < MAX_WEIGHTS) { sentTotal[sentN] = w.valueMg; sent[sentN++] = m; }
+    spool.append(&m, sizeof(m));
+
+    char gBuf[16];
+    weight_format_g(gBuf, sizeof(gBuf), w.valueMg, 2);
+    printf("%7lu ms  %-6s %10s g  conf=%3u%%  detect→stable %4lu ms",
+           (unsigned long)m.monoMs, increased ? "ADD" : "REMOVE", gBuf, (unsigned)w.confPct,
+           (unsigned long)(w.stableMs - w.detectMs));
+    if (correctsSeq) printf("  corrects seq %lu", (unsigned long)meas_corrects_seq(m));
+    printf("\n");
+    return m.seq;
+  };
+
+  uint64_t conversions = 0;
+  std::chrono::nanoseconds busy{0};
+  uint32_t lastUploadMs = 0;
+
+  for (size_t s = 0; s < SCRIPT_LEN; ++s) {
+    const LoadStep& step = kScript[s];
+    fake_hx711_load(step.mg, step.settleMs);
+    if (weight_abs_mg(step.mg - prevLoad) >= DELTA_SEND_MG) expected[expectedN++] = step.mg;
+    prevLoad = step.mg;
+
+    const uint32_t until = hal_millis() + step.dwellMs;
+    while ((int32_t)(hal_millis() - until) < 0) {
+      const int32_t raw = hal_hx711_read();        // advances the fake clock
+      const auto t0 = std::chrono::steady_clock::now();
+      conversions++;
+
+      int32_t reading;
+      if (chain.push(weight_raw_to_mg(raw, scale), reading)) {
+        const int32_t liveMg = live.update(reading);
+        MeasurementLogic::Step st;
+        logic.push(hal_millis(), reading, liveMg, st);
+        if (st.early) earlySeq = emit(st.earlyW, 0);
+        if (st.settled && !st.confirmed) emit(st.finalW, st.corrects ? earlySeq : 0);
+      }
+      busy += std::chrono::steady_clock::now() - t0;
+
+      if (hal_millis() - lastUploadMs >= 1000) { upload(spool); lastUploadMs = hal_millis(); }
+    }
+  }
+  hal_delay_ms(1000);
+  upload(spool);
+
+  // ---- Report ----
+  int rc = 0;
+  size_t  matched = 0, cursor = 0;
+  int32_t worstMg = 0;
+  for (size_t e = 0; e < expectedN; ++e) {
+    for (size_t i = cursor; i < sentN; ++i) {
+      const int32_t err = weight_abs_mg(sentTotal[i] - expected[e]);
+      if (err <= STABILITY_BAND_MG) {
+        matched++;
+        cursor = i + 1;
+        if (err > worstMg) worstMg = err;
+        break;
+      }
+    }
+  }
+  if (matched != expectedN) rc = 1;
+
+  bool same = s_rxN == sentN;
+  for (size_t i = 0; same && i < sentN; ++i) {
+    same = s_rx[i].seq == sent[i].seq && s_rx[i].mg == sent[i].mg && s_rx[i].kind == sent[i].kind;
+  }
+  if (!same || s_rxBad) rc = 1;
+
+  const FakeHttpStats& http = fake_http_stats();
+  const SpoolLog::Stats& sp = spool.stats();
+  char wBuf[16];
+  weight_format_g(wBuf, sizeof(wBuf), worstMg, 2);
+  printf("weights: %u sent, %u/%u load changes matched (worst %s g), server got %u%s\n",
+         (unsigned)sentN, (unsigned)matched, (unsigned)expectedN, wBuf, (unsigned)s_rxN,
+         same ? " (identical)" : " (MISMATCH)");
+  printf("upload: %lu posts, %lu B, spool appended=%lu committed=%lu pending=%lu\n",
+         (unsigned long)http.posts, (unsigned long)http.bytes, (unsigned long)sp.appended,
+         (unsigned long)sp.committed, (unsigned long)sp.pending);
+  printf("pipeline: %llu conversions, %.0f ns each on this host\n",
+         (unsigned long long)conversions, conversions ? (double)busy.count() / conversions : 0.0);
+  printf("%s\n", rc ? "FAIL" : "OK");
+  return rc;
+}
+#endif
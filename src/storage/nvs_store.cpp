@@ -36,6 +36,30 @@ bool nvs_load_string(const char* key, String& out) {
   return out.length() > 0;
 }
 
+bool nvs_save_u32(const char* key, uint32_t value) {
+  if (!s_opened) return false;
+  size_t written = prefs.putUInt(key, value);
+  return written == sizeof(uint32_t);
+}
+
+bool nvs_load_u32(const char* key, uint32_t& out) {
+  if (!s_opened) return false;
+  if (!prefs.isKey(key)) return false;
+  out = prefs.getUInt(key, 0);
+  return true;
+}
+
+bool nvs_save_blob(const char* key, const void* data, size_t len) {
+  if (!s_opened) return false;
+  return prefs.putBytes(key, data, len) == len;
+}
+
+bool nvs_load_blob(const char* key, void* out, size_t len) {
+  if (!s_opened) return false;
+  if (!prefs.isKey(key) || prefs.getBytesLength(key) != len) return false;
+  return prefs.getBytes(key, out, len) == len;
+}
+
 bool nvs_remove_key(const char* key) {
   if (!s_opened) return false;
   if (!prefs.isKey(key)) return false;
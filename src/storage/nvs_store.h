@@ -1,5 +1,12 @@
 #pragma once
+#include <stdint.h>
+#include <stddef.h>
+#ifdef ARDUINO
 #include <Arduino.h>
+#endif
+
+// Key/value settings. On the device this is NVS through Preferences; the
+// native build links an in-memory fake (hal/fake.h) with the same API.
 
 // Call once at boot
 bool nvs_init(const char* ns = "smartscale");
@@ -8,11 +15,19 @@ bool nvs_init(const char* ns = "smartscale");
 bool nvs_save_float(const char* key, float value);
 bool nvs_load_float(const char* key, float& out);
 
+#ifdef ARDUINO
 // Basic string helpers
 bool nvs_save_string(const char* key, const String& value);
 bool nvs_load_string(const char* key, String& out);
+#endif
+
+// Basic u32 helpers
+bool nvs_save_u32(const char* key, uint32_t value);
+bool nvs_load_u32(const char* key, uint32_t& out);
+
+// Fixed-size blobs (structs). Load fails unless the stored size == len.
+bool nvs_save_blob(const char* key, const void* data, size_t len);
+bool nvs_load_blob(const char* key, void* out, size_t len);
 
 // Remove any key (float, string, whatever)
 bool nvs_remove_key(const char* key);
-
-// (Room to grow later: u32, blobs, structs, etc.)
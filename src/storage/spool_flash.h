@@ -0,0 +1,74 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// Flash backend for the spool log. NOR semantics: erase sets a whole sector
+// to 0xFF, write can only clear bits. Offsets are relative to the region.
+class SpoolFlash {
+public:
+  virtual ~SpoolFlash() {}
+  virtual uint32_t size() const = 0;
+  virtual uint32_t sectorSize() const = 0;
+  virtual bool read(uint32_t off, void* dst, size_t len) = 0;
+  virtual bool write(uint32_t off, const void* src, size_t len) = 0;
+  virtual bool eraseSector(uint32_t off) = 0;
+};
+
+// Simulated NOR flash over a caller-provided buffer, for running the spool
+// on a PC. Counts erases per sector (wear) and can cut power after a given
+// number of programmed bytes to exercise recovery.
+class RamFlash : public SpoolFlash {
+public:
+  static constexpr uint32_t MAX_SECTORS = 64;
+
+  RamFlash(uint8_t* mem, uint32_t size, uint32_t sectorSize = 4096)
+    : mem(mem), bytes(size), sector(sectorSize) {
+    memset(mem, 0xFF, size);
+    memset(erases, 0, sizeof(erases));
+  }
+
+  uint32_t size() const override       { return bytes; }
+  uint32_t sectorSize() const override { return sector; }
+
+  bool read(uint32_t off, void* dst, size_t len) override {
+    if (off + len > bytes) return false;
+    memcpy(dst, mem + off, len);
+    return true;
+  }
+
+  bool write(uint32_t off, const void* src, size_t len) override {
+    if (off + len > bytes) return false;
+    const uint8_t* s = (const uint8_t*)src;
+    for (size_t i = 0; i < len; ++i) {
+      if (powerCut) return false;
+      if (budget >= 0 && budget-- == 0) { powerCut = true; return false; }
+      mem[off + i] &= s[i];            // NOR: bits only go 1 → 0
+    }
+    return true;
+  }
+
+  bool eraseSector(uint32_t off) override {
+    if (powerCut || off % sector || off >= bytes) return false;
+    memset(mem + off, 0xFF, sector);
+    const uint32_t idx = off / sector;
+    if (idx < MAX_SECTORS) erases[idx]++;
+    return true;
+  }
+
+  // Fault injection: lose power after 'n' more programmed bytes (-1 = never).
+  void cutPowerAfter(int32_t n) { budget = n; powerCut = false; }
+  void restorePower()           { budget = -1; powerCut = false; }
+
+  uint32_t eraseCount(uint32_t sectorIdx) const {
+    return sectorIdx < MAX_SECTORS ? erases[sectorIdx] : 0;
+  }
+
+private:
+  uint8_t* mem;
+  uint32_t bytes;
+  uint32_t sector;
+  uint32_t erases[MAX_SECTORS];
+  int32_t  budget = -1;
+  bool     powerCut = false;
+};
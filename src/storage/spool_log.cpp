@@ -0,0 +1,321 @@
+#include "spool_log.h"
+#include <stddef.h>
+#include <string.h>
+#include "util/crc.h"
+
+static constexpr uint32_t WEAR_MAGIC   = 0x32575053;   // "SPW2"
+static constexpr uint32_t OPEN_MAGIC   = 0x324F5053;   // "SPO2"
+static constexpr uint32_t LEGACY_MAGIC = 0x314C5053;   // "SPL1": one header written on open
+
+static constexpr uint8_t STATE_BLANK    = 0xFF;
+static constexpr uint8_t STATE_VALID    = 0xFE;
+static constexpr uint8_t STATE_CONSUMED = 0xFC;
+
+static uint32_t slot_crc(uint8_t len, const uint8_t* payload) {
+  return crc32_update(crc32(&len, 1), payload, len);
+}
+
+static bool all_ff(const uint8_t* p, size_t n) {
+  for (size_t i = 0; i < n; ++i) if (p[i] != 0xFF) return false;
+  return true;
+}
+
+struct LegacyHdr { uint32_t magic, seq, wear, crc; };
+
+// 'wear' is valid for every state but BLANK, 'seq' only for OPEN
+SpoolLog::HdrState SpoolLog::readSectorHdr(uint32_t s, uint32_t& wear, uint32_t& seq) {
+  wear = seq = 0;
+  uint8_t raw[HDR_SIZE];
+  if (!fl.read(sectorBase(s), raw, sizeof(raw))) return HdrState::TORN;
+  if (all_ff(raw, sizeof(raw))) return HdrState::BLANK;
+
+  LegacyHdr l;
+  memcpy(&l, raw, sizeof(l));
+  if (l.magic == LEGACY_MAGIC && l.crc == crc32(&l, offsetof(LegacyHdr, crc))) {
+    wear = l.wear;
+    seq  = l.seq;
+    return HdrState::OPEN;
+  }
+
+  WearHdr w;
+  memcpy(&w, raw, sizeof(w));
+  if (w.magic != WEAR_MAGIC || w.crc != crc32(&w, offsetof(WearHdr, crc))) return HdrState::TORN;
+  wear = w.wear;
+
+  const uint8_t* open = raw + sizeof(WearHdr);
+  if (all_ff(open, sizeof(OpenHdr))) return HdrState::FREE;
+  OpenHdr o;
+  memcpy(&o, open, sizeof(o));
+  if (o.magic != OPEN_MAGIC || o.crc != crc32(&o, offsetof(OpenHdr, crc))) return HdrState::TORN;
+  seq = o.seq;
+  return HdrState::OPEN;
+}
+
+bool SpoolLog::writeWearHdr(uint32_t s) {
+  WearHdr w;
+  w.magic = WEAR_MAGIC;
+  w.wear  = wearOf[s];
+  w.rsv   = 0xFFFFFFFF;
+  w.crc   = crc32(&w, offsetof(WearHdr, crc));
+  return fl.write(sectorBase(s), &w, sizeof(w));
+}
+
+// The erase count goes back into the header straight away. A power cut in
+// between leaves a blank sector that restarts at 0; rotation keeps its
+// neighbours within one erase, so maxSectorWear still holds.
+bool SpoolLog::eraseForReuse(uint32_t s) {
+  if (!fl.eraseSector(sectorBase(s))) return false;
+  wearOf[s]++;
+  if (wearOf[s] > st.maxSectorWear) st.maxSectorWear = wearOf[s];
+  seqOf[s] = 0;
+  st.erases++;
+  return writeWearHdr(s);
+}
+
+bool SpoolLog::openSector(uint32_t s) {
+  // Free sectors were erased when they were released (or at mount) and
+  // only need the open half; a used or torn header must go.
+  uint32_t wear, seq;
+  const HdrState hs = readSectorHdr(s, wear, seq);
+  if (hs == HdrState::BLANK && seqOf[s] == 0) {
+    if (!writeWearHdr(s)) return false;
+  } else if (hs != HdrState::FREE || seqOf[s] != 0) {
+    if (!eraseForReuse(s)) return false;
+  }
+
+  OpenHdr o;
+  o.magic = OPEN_MAGIC;
+  o.seq   = nextSeq++;
+  o.rsv   = 0xFFFFFFFF;
+  o.crc   = crc32(&o, offsetof(OpenHdr, crc));
+  if (!fl.write(sectorBase(s) + sizeof(WearHdr), &o, sizeof(o))) return false;
+
+  seqOf[s] = o.seq;
+  wr = Cursor{ s, 0 };
+  return true;
+}
+
+bool SpoolLog::format() {
+  secSize        = fl.sectorSize();
+  nSectors       = fl.size() / secSize;
+  if (nSectors > MAX_SECTORS) nSectors = MAX_SECTORS;
+  slotsPerSector = (secSize - HDR_SIZE) / SLOT_SIZE;
+  if (nSectors < 2 || slotsPerSector == 0) return false;
+
+  // Keep what the headers know about wear; the erase adds one more
+  for (uint32_t s = 0; s < nSectors; ++s) {
+    uint32_t wear, seq;
+    (void)readSectorHdr(s, wear, seq);
+    wearOf[s] = wear;
+    if (!eraseForReuse(s)) return false;
+  }
+  nextSeq = 1;
+  if (!openSector(0)) return false;
+  rd = wr;
+  st.pending  = 0;
+  st.capacity = nSectors * slotsPerSector;
+  isMounted   = true;
+  return true;
+}
+
+bool SpoolLog::slotValid(const Cursor& c, SlotHdr& h, uint8_t* payload) {
+  if (!fl.read(slotOff(c), &h, sizeof(h))) return false;
+  if (h.state != STATE_VALID || h.len > MAX_PAYLOAD) return false;
+  if (!fl.read(slotOff(c) + sizeof(h), payload, h.len)) return false;
+  return slot_crc(h.len, payload) == h.crc;
+}
+
+// Step to the next slot; crosses into the next sector unless this is the
+// writer's sector. Returns false once the cursor reaches the write position.
+bool SpoolLog::advance(Cursor& c) const {
+  c.slot++;
+  if (c.slot >= slotsPerSector && c.sector != wr.sector) {
+    c.sector = (c.sector + 1) % nSectors;
+    c.slot = 0;
+  }
+  return !(c.sector == wr.sector && c.slot >= wr.slot);
+}
+
+bool SpoolLog::mount() {
+  isMounted = false;
+  st = Stats{};
+
+  secSize        = fl.sectorSize();
+  nSectors       = fl.size() / secSize;
+  if (nSectors > MAX_SECTORS) nSectors = MAX_SECTORS;
+  slotsPerSector = (secSize - HDR_SIZE) / SLOT_SIZE;
+  if (nSectors < 2 || slotsPerSector == 0) return false;
+  st.capacity = nSectors * slotsPerSector;
+
+  // 1) Sector headers
+  uint32_t newest = UINT32_MAX, maxSeq = 0;
+  for (uint32_t s = 0; s < nSectors; ++s) {
+    uint32_t wear, seq;
+    st.mountReads++;
+    const HdrState hs = readSectorHdr(s, wear, seq);
+    seqOf[s]  = 0;
+    wearOf[s] = wear;
+    if (wear > st.maxSectorWear) st.maxSectorWear = wear;
+    if (hs == HdrState::OPEN) {
+      seqOf[s] = seq;
+      if (seq > maxSeq) { maxSeq = seq; newest = s; }
+    } else if (hs == HdrState::TORN) {
+      // torn/foreign header: reclaim now
+      if (!eraseForReuse(s)) return false;
+    }
+  }
+
+  if (newest == UINT32_MAX) {
+    // Nothing of ours here → start fresh (erases only what is dirty)
+    nextSeq = 1;
+    if (!openSector(0)) return false;
+    rd = wr;
+    isMounted = true;
+    return true;
+  }
+  nextSeq = maxSeq + 1;
+
+  // 2) The used run ends at 'newest'; walk back while sequence numbers
+  //    keep decreasing. Anything used outside that run is stale.
+  uint32_t oldest = newest;
+  for (uint32_t i = 1; i < nSectors; ++i) {
+    const uint32_t prev = (oldest + nSectors - 1) % nSectors;
+    if (seqOf[prev] == 0 || seqOf[prev] >= seqOf[oldest]) break;
+    oldest = prev;
+  }
+  for (uint32_t s = 0; s < nSectors; ++s) {
+    bool inRun = false;
+    for (uint32_t t = oldest; ; t = (t + 1) % nSectors) {
+      if (t == s) { inRun = true; break; }
+      if (t == newest) break;
+    }
+    if (!inRun && seqOf[s] != 0 && !eraseForReuse(s)) return false;
+  }
+
+  // 3) Write position: first slot after the last non-blank one
+  wr = Cursor{ newest, 0 };
+  uint8_t raw[SLOT_SIZE];
+  for (uint32_t i = 0; i < slotsPerSector; ++i) {
+    st.mountReads++;
+    if (!fl.read(sectorBase(newest) + HDR_SIZE + i * SLOT_SIZE, raw, SLOT_SIZE)) return false;
+    if (!all_ff(raw, SLOT_SIZE)) wr.slot = i + 1;
+  }
+
+  // 4) Read position + pending count
+  Cursor c{ oldest, 0 };
+  bool haveRd = false;
+  rd = wr;
+  if (!(c.sector == wr.sector && c.slot >= wr.slot)) {
+    do {
+      SlotHdr h{};
+      uint8_t payload[MAX_PAYLOAD];
+      st.mountReads++;
+      if (slotValid(c, h, payload)) {
+        if (!haveRd) { rd = c; haveRd = true; }
+        st.pending++;
+      } else if (h.state != STATE_CONSUMED) {
+        st.torn++;                               // blank-state with body, or bad CRC
+      }
+    } while (advance(c));
+  }
+
+  // Sectors fully behind the reader were consumed but not yet erased
+  for (uint32_t s = oldest; s != rd.sector; s = (s + 1) % nSectors) {
+    if (!eraseForReuse(s)) return false;
+  }
+
+  isMounted = true;
+  return true;
+}
+
+void SpoolLog::dropOldestSector() {
+  const uint32_t s = rd.sector;
+  Cursor c = rd;
+  SlotHdr h;
+  uint8_t payload[MAX_PAYLOAD];
+  while (c.sector == s && c.slot < slotsPerSector) {
+    if (slotValid(c, h, payload)) { st.pending--; st.dropped++; }
+    c.slot++;
+  }
+  (void)eraseForReuse(s);
+  rd = Cursor{ (s + 1) % nSectors, 0 };
+}
+
+bool SpoolLog::append(const void* rec, uint8_t len) {
+  if (!isMounted || len > MAX_PAYLOAD) return false;
+
+  if (wr.slot >= slotsPerSector) {
+    const uint32_t cur  = wr.sector;
+    const uint32_t next = (cur + 1) % nSectors;
+    const bool wasEmpty = (rd.sector == wr.sector && rd.slot >= wr.slot);
+    if (seqOf[next] != 0) dropOldestSector();     // ring full
+    if (!openSector(next)) return false;
+    if (wasEmpty) {
+      // reader had caught up: the old sector is fully consumed
+      rd = wr;
+      (void)eraseForReuse(cur);
+    }
+  }
+
+  uint8_t buf[SLOT_SIZE];
+  memset(buf, 0xFF, sizeof(buf));
+  SlotHdr h;
+  h.state  = STATE_BLANK;
+  h.len    = len;
+  h.rsv[0] = h.rsv[1] = 0xFF;
+  h.crc    = slot_crc(len, (const uint8_t*)rec);
+  memcpy(buf, &h, sizeof(h));
+  memcpy(buf + sizeof(h), rec, len);
+
+  const uint32_t off = slotOff(wr);
+  wr.slot++;   // the slot is spent even if the program below fails
+
+  // Body first, then the state byte that makes it visible
+  if (!fl.write(off + 1, buf + 1, sizeof(h) - 1 + len)) return false;
+  const uint8_t valid = STATE_VALID;
+  if (!fl.write(off, &valid, 1)) return false;
+
+  st.pending++;
+  st.appended++;
+  return true;
+}
+
+size_t SpoolLog::peek(void* out, uint8_t recLen, size_t maxRecs) {
+  if (!isMounted || maxRecs == 0) return 0;
+  uint8_t* dst = (uint8_t*)out;
+  size_t n = 0;
+  Cursor c = rd;
+  if (c.sector == wr.sector && c.slot >= wr.slot) return 0;
+  do {
+    SlotHdr h;
+    uint8_t payload[MAX_PAYLOAD];
+    if (slotValid(c, h, payload)) {
+      // Tolerate record size changes across firmware versions
+      memset(dst + n * recLen, 0, recLen);
+      memcpy(dst + n * recLen, payload, h.len < recLen ? h.len : recLen);
+      if (++n >= maxRecs) break;
+    }
+  } while (advance(c));
+  return n;
+}
+
+bool SpoolLog::commit(size_t n) {
+  if (!isMounted) return false;
+  Cursor c = rd;
+  while (n > 0 && !(c.sector == wr.sector && c.slot >= wr.slot)) {
+    SlotHdr h;
+    uint8_t payload[MAX_PAYLOAD];
+    if (slotValid(c, h, payload)) {
+      const uint8_t consumed = STATE_CONSUMED;
+      if (!fl.write(slotOff(c), &consumed, 1)) return false;
+      st.pending--;
+      st.committed++;
+      n--;
+    }
+    const uint32_t before = c.sector;
+    advance(c);
+    if (c.sector != before) (void)eraseForReuse(before);   // sector fully consumed
+  }
+  rd = c;
+  return n == 0;
+}
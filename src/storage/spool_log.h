@@ -0,0 +1,93 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "storage/spool_flash.h"
+
+// Persistent FIFO of small records on raw flash (no Arduino deps).
+//
+// Layout: the region is a ring of sectors used strictly in physical order,
+// so every sector gets erased equally often (wear levelling by rotation).
+//
+//   sector = [ header 32 B | slot 0 | slot 1 | ... ]      slots are 32 B
+//   header = wear half (magic, erase count, CRC)  written right after the erase
+//          + open half (magic, sector sequence number, CRC)  written on first use
+//   slot   = state(1) len(1) rsv(2) crc32(4) payload(<= 24)
+//
+// Slot state goes 0xFF (blank) → 0xFE (valid) → 0xFC (consumed); each step
+// only clears bits, so it is a single-byte program. The header works the
+// same way: a free sector carries its erase count in the wear half while the
+// open half is still blank, so the count survives erases and reboots, and
+// opening the sector programs the open half without a second erase. The body is written
+// before the state byte: a power cut mid-append leaves either a blank-state
+// slot with a dirty body or a CRC mismatch, both skipped as "torn".
+//
+// mount() rebuilds the read/write cursors with one pass over the sector
+// headers plus the slot headers: O(region / 32) reads, bounded.
+// Fully consumed sectors are erased on commit (the uploader pays for the
+// erase, not the append path). When the ring is full, append drops the
+// oldest sector.
+class SpoolLog {
+public:
+  static constexpr uint32_t SLOT_SIZE   = 32;
+  static constexpr uint32_t HDR_SIZE    = 32;
+  static constexpr uint32_t MAX_PAYLOAD = SLOT_SIZE - 8;
+  static constexpr uint32_t MAX_SECTORS = 64;
+
+  struct Stats {
+    uint32_t pending;        // valid, not yet committed records
+    uint32_t capacity;       // slots in the ring
+    uint32_t appended;
+    uint32_t committed;
+    uint32_t dropped;        // lost to a full ring
+    uint32_t torn;           // slots skipped at mount/peek (power loss)
+    uint32_t erases;         // sector erases since mount
+    uint32_t maxSectorWear;  // highest erase count of any sector
+    uint32_t mountReads;     // flash reads done by the last mount()
+  };
+
+  explicit SpoolLog(SpoolFlash& flash) : fl(flash) {}
+
+  bool mount();    // scan + recover; formats a blank/foreign region
+  bool format();   // erase everything
+
+  bool   append(const void* rec, uint8_t len);
+  size_t peek(void* out, uint8_t recLen, size_t maxRecs);   // oldest first
+  bool   commit(size_t n);                                  // consume n oldest
+
+  uint32_t pending() const { return st.pending; }
+  const Stats& stats() const { return st; }
+  bool mounted() const { return isMounted; }
+
+private:
+  struct WearHdr   { uint32_t magic, wear, rsv, crc; };
+  struct OpenHdr   { uint32_t magic, seq, rsv, crc; };
+  enum class HdrState : uint8_t { BLANK, FREE, OPEN, TORN };
+  struct SlotHdr   { uint8_t state, len; uint8_t rsv[2]; uint32_t crc; };
+
+  struct Cursor { uint32_t sector, slot; };
+
+  uint32_t sectorBase(uint32_t s) const { return s * secSize; }
+  uint32_t slotOff(const Cursor& c) const { return sectorBase(c.sector) + HDR_SIZE + c.slot * SLOT_SIZE; }
+
+  HdrState readSectorHdr(uint32_t s, uint32_t& wear, uint32_t& seq);
+  bool writeWearHdr(uint32_t s);
+  bool openSector(uint32_t s);                 // write the open half (erase first if used)
+  bool eraseForReuse(uint32_t s);              // erase + wear half
+  bool advance(Cursor& c) const;               // false when it reaches the writer
+  bool slotValid(const Cursor& c, SlotHdr& h, uint8_t* payload);
+  void dropOldestSector();
+
+  SpoolFlash& fl;
+  uint32_t secSize = 0;
+  uint32_t nSectors = 0;
+  uint32_t slotsPerSector = 0;
+
+  uint32_t seqOf[MAX_SECTORS];     // 0 = free/erased
+  uint32_t wearOf[MAX_SECTORS];
+  uint32_t nextSeq = 1;
+
+  Cursor rd{0, 0};
+  Cursor wr{0, 0};
+  bool   isMounted = false;
+  Stats  st{};
+};
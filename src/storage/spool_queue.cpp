@@ -0,0 +1,110 @@
+#include "spool_queue.h"
+
+#include <Arduino.h>
+#include "esp_partition.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "util/log.h"
+
+static constexpr esp_partition_subtype_t SPOOL_SUBTYPE = (esp_partition_subtype_t)0x40;
+static constexpr const char*             SPOOL_LABEL   = "spool";
+
+static_assert(sizeof(Measurement) <= SpoolLog::MAX_PAYLOAD, "record does not fit a spool slot");
+
+// SpoolFlash over an esp_partition (offsets are partition-relative)
+class PartitionFlash : public SpoolFlash {
+public:
+  explicit PartitionFlash(const esp_partition_t* p) : part(p) {}
+
+  uint32_t size() const override       { return part->size; }
+  uint32_t sectorSize() const override { return SPI_FLASH_SEC_SIZE; }
+
+  bool read(uint32_t off, void* dst, size_t len) override {
+    return esp_partition_read(part, off, dst, len) == ESP_OK;
+  }
+  bool write(uint32_t off, const void* src, size_t len) override {
+    return esp_partition_write(part, off, src, len) == ESP_OK;
+  }
+  bool eraseSector(uint32_t off) override {
+    return esp_partition_erase_range(part, off, SPI_FLASH_SEC_SIZE) == ESP_OK;
+  }
+
+private:
+  const esp_partition_t* part;
+};
+
+static SpoolLog*         s_log   = nullptr;
+static SemaphoreHandle_t s_mtx   = nullptr;
+static bool              s_ready = false;
+
+struct SpoolLock {
+  SpoolLock()  { xSemaphoreTake(s_mtx, portMAX_DELAY); }
+  ~SpoolLock() { xSemaphoreGive(s_mtx); }
+};
+
+bool spool_init() {
+  if (s_ready) return true;
+
+  const esp_partition_t* p =
+    esp_partition_find_first(ESP_PARTITION_TYPE_DATA, SPOOL_SUBTYPE, SPOOL_LABEL);
+  if (!p) {
+    LOGI("SPOOL", "no 'spool' partition → offline records kept in RAM only");
+    return false;
+  }
+
+  if (!s_mtx) s_mtx = xSemaphoreCreateMutex();
+  if (!s_mtx) return false;
+
+  // Allocated once for the lifetime of the firmware
+  static PartitionFlash flash(p);
+  static SpoolLog log(flash);
+  s_log   = &log;
+
+  const uint32_t t0 = millis();
+  s_ready = s_log->mount();
+  const SpoolLog::Stats& st = s_log->stats();
+  LOGI("SPOOL", "%s: %lu KB, pending=%lu/%lu torn=%lu wear=%lu (%lu reads, %lu ms)",
+       s_ready ? "mounted" : "mount FAILED", (unsigned long)(p->size / 1024),
+       (unsigned long)st.pending, (unsigned long)st.capacity,
+       (unsigned long)st.torn, (unsigned long)st.maxSectorWear,
+       (unsigned long)st.mountReads, (unsigned long)(millis() - t0));
+  return s_ready;
+}
+
+bool spool_ready() { return s_ready; }
+
+bool spool_push(const Measurement& m) {
+  if (!s_ready) return false;
+  SpoolLock lock;
+  return s_log->append(&m, sizeof(m));
+}
+
+size_t spool_peek(Measurement* out, size_t maxRecs) {
+  if (!s_ready) return 0;
+  SpoolLock lock;
+  return s_log->peek(out, sizeof(Measurement), maxRecs);
+}
+
+bool spool_commit(size_t n) {
+  if (!s_ready) return false;
+  SpoolLock lock;
+  return s_log->commit(n);
+}
+
+uint32_t spool_size() {
+  if (!s_ready) return 0;
+  SpoolLock lock;
+  return s_log->pending();
+}
+
+bool spool_clear() {
+  if (!s_ready) return false;
+  SpoolLock lock;
+  return s_log->format();
+}
+
+void spool_get_stats(SpoolLog::Stats& out) {
+  if (!s_ready) { out = SpoolLog::Stats{}; return; }
+  SpoolLock lock;
+  out = s_log->stats();
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "features/measurement.h"
+#include "storage/spool_log.h"
+
+// Offline measurement FIFO on the "spool" data partition (partitions.csv).
+// Thin, mutex-guarded wrapper over SpoolLog; survives reboots and power loss.
+
+bool spool_init();      // mount (formats a blank/foreign partition)
+bool spool_ready();     // false if the partition is missing or mount failed
+
+bool     spool_push(const Measurement& m);
+size_t   spool_peek(Measurement* out, size_t maxRecs);   // oldest first, not removed
+bool     spool_commit(size_t n);                         // remove the n oldest
+uint32_t spool_size();
+bool     spool_clear();
+
+void spool_get_stats(SpoolLog::Stats& out);
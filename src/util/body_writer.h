@@ -0,0 +1,99 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// Request body builder over a caller-owned buffer (usually on the stack):
+// no heap, no String. Appends silently stop at capacity and set overflow(),
+// so a caller checks once at the end instead of after every field.
+//
+//   char buf[192];
+//   BodyWriter w(buf, sizeof(buf));
+//   w.form("name", DEVICE_NAME).form("w", "12.34");     // name=Sample+Scale1&w=12.34
+//   if (w.overflow()) ...
+class BodyWriter {
+public:
+  BodyWriter(char* buf, size_t cap) : b(buf), cap(cap) { if (cap) b[0] = '\0'; }
+
+  const char* c_str() const  { return b; }
+  size_t      length() const { return n; }
+  bool        overflow() const { return ovf; }
+
+  // Truncate back to an earlier length() (e.g. drop a half-written item
+  // that overflowed); clears overflow().
+  void rewind(size_t len) { if (len <= n) { n = len; b[n] = '\0'; ovf = false; } }
+
+  BodyWriter& raw(const char* s)            { return raw(s, strlen(s)); }
+  BodyWriter& raw(const char* s, size_t len) {
+    if (ovf || n + len >= cap) { ovf = true; return *this; }
+    memcpy(b + n, s, len);
+    n += len;
+    b[n] = '\0';
+    return *this;
+  }
+  BodyWriter& ch(char c) { return raw(&c, 1); }
+
+  BodyWriter& u32(uint32_t v) {
+    char t[10];
+    size_t i = sizeof(t);
+    do { t[--i] = (char)('0' + v % 10); v /= 10; } while (v);
+    return raw(t + i, sizeof(t) - i);
+  }
+  BodyWriter& i32(int32_t v) {
+    if (v < 0) { ch('-'); return u32((uint32_t)(-(int64_t)v)); }
+    return u32((uint32_t)v);
+  }
+
+  // application/x-www-form-urlencoded: unreserved bytes as-is, space → '+',
+  // everything else %XX.
+  BodyWriter& urlEncoded(const char* s) {
+    static const char kHex[] = "0123456789ABCDEF";
+    for (; *s; ++s) {
+      const uint8_t c = (uint8_t)*s;
+      if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+          c == '-' || c == '.' || c == '_' || c == '~') {
+        ch((char)c);
+      } else if (c == ' ') {
+        ch('+');
+      } else {
+        const char e[3] = { '%', kHex[c >> 4], kHex[c & 0xF] };
+        raw(e, 3);
+      }
+    }
+    return *this;
+  }
+
+  // "&key=value" (no '&' for the first field); key and value are encoded
+  BodyWriter& form(const char* key, const char* val) {
+    if (n) ch('&');
+    urlEncoded(key).ch('=');
+    return urlEncoded(val);
+  }
+  BodyWriter& form(const char* key, uint32_t val) {
+    if (n) ch('&');
+    urlEncoded(key).ch('=');
+    return u32(val);
+  }
+
+  // JSON string literal with quotes; escapes " \ and control bytes
+  BodyWriter& jsonStr(const char* s) {
+    static const char kHex[] = "0123456789abcdef";
+    ch('"');
+    for (; *s; ++s) {
+      const uint8_t c = (uint8_t)*s;
+      if (c == '"' || c == '\\') { ch('\\'); ch((char)c); }
+      else if (c < 0x20) {
+        const char e[6] = { '\\', 'u', '0', '0', kHex[c >> 4], kHex[c & 0xF] };
+        raw(e, 6);
+      }
+      else ch((char)c);
+    }
+    return ch('"');
+  }
+
+private:
+  char*  b;
+  size_t cap;
+  size_t n = 0;
+  bool   ovf = false;
+};
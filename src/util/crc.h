@@ -0,0 +1,8 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// CRC-32 (IEEE 802.3, reflected, poly 0xEDB88320), nibble table: 64 bytes
+// of ROM, ~2 lookups per byte. crc32(buf, n) == crc32_update(0, buf, n).
+uint32_t crc32_update(uint32_t crc, const void* data, size_t len);
+inline uint32_t crc32(const void* data, size_t len) { return crc32_update(0, data, len); }
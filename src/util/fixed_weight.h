@@ -0,0 +1,80 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+// Integer weight math for the measurement path (the C3 has no FPU).
+//
+//   mg = ((raw - offset) * mgPerCountQ16) >> 16
+//
+// raw/offset are signed 24-bit HX711 counts, the scale is milligrams per
+// count in Q16.16. The product is done in 64 bits (a handful of integer
+// ops on RV32), everything else stays 32-bit.
+
+static constexpr int     WEIGHT_Q_SHIFT = 16;
+static constexpr int32_t WEIGHT_Q_ONE   = (int32_t)1 << WEIGHT_Q_SHIFT;
+
+struct WeightScale {
+  int32_t offset        = 0;             // raw counts at zero load (tare)
+  int32_t mgPerCountQ16 = WEIGHT_Q_ONE;  // 1 mg/count until calibrated
+};
+
+inline int32_t weight_raw_to_mg(int32_t raw, const WeightScale& s) {
+  const int64_t d = (int64_t)raw - (int64_t)s.offset;
+  const int64_t q = d * (int64_t)s.mgPerCountQ16;
+  // round to nearest, symmetric around zero
+  return (int32_t)((q >= 0) ? ((q + (WEIGHT_Q_ONE / 2)) >> WEIGHT_Q_SHIFT)
+                            : -((-q + (WEIGHT_Q_ONE / 2)) >> WEIGHT_Q_SHIFT));
+}
+
+// Scale from a calibration run: 'deltaCounts' measured for 'massMg'.
+// Returns 0 if delta is 0 (caller should treat that as "not calibrated").
+inline int32_t weight_scale_from_delta(int32_t deltaCounts, int32_t massMg) {
+  if (deltaCounts == 0) return 0;
+  return (int32_t)(((int64_t)massMg << WEIGHT_Q_SHIFT) / deltaCounts);
+}
+
+// Conversions to/from the legacy float "counts per gram" factor that is
+// stored in NVS (bogde/HX711 set_scale semantics). Only used at load/save.
+inline int32_t weight_scale_from_counts_per_g(float countsPerGram) {
+  if (countsPerGram == 0.0f) return 0;
+  return (int32_t)((1000.0f * (float)WEIGHT_Q_ONE) / countsPerGram + (countsPerGram > 0 ? 0.5f : -0.5f));
+}
+
+inline float weight_scale_to_counts_per_g(int32_t mgPerCountQ16) {
+  if (mgPerCountQ16 == 0) return 0.0f;
+  return (1000.0f * (float)WEIGHT_Q_ONE) / (float)mgPerCountQ16;
+}
+
+inline int32_t weight_abs_mg(int32_t mg) { return mg < 0 ? -mg : mg; }
+
+// Integer square root (floor), for σ from mg² variances.
+inline uint32_t weight_isqrt64(uint64_t v) {
+  uint64_t r = 0, bit = (uint64_t)1 << 62;
+  while (bit > v) bit >>= 2;
+  while (bit) {
+    if (v >= r + bit) { v -= r + bit; r = (r >> 1) + bit; }
+    else              { r >>= 1; }
+    bit >>= 2;
+  }
+  return (uint32_t)r;
+}
+
+// "123.45" style grams from milligrams, no float formatting involved.
+// 'decimals' is 0..3. Returns the snprintf length.
+inline int weight_format_g(char* buf, size_t len, int32_t mg, uint8_t decimals = 2) {
+  static const int32_t kDiv[4] = { 1000, 100, 10, 1 };
+  if (decimals > 3) decimals = 3;
+  const bool neg = mg < 0;
+  uint32_t a = neg ? (uint32_t)(-(int64_t)mg) : (uint32_t)mg;
+  const uint32_t step = (uint32_t)kDiv[decimals];
+  a = (a + step / 2) / step;                       // round at the last digit
+  const uint32_t unit = 1000u / step;              // 10^decimals
+  const uint32_t whole = a / unit;
+  const uint32_t frac  = a % unit;
+  if (decimals == 0) {
+    return snprintf(buf, len, "%s%lu", (neg && whole) ? "-" : "", (unsigned long)whole);
+  }
+  return snprintf(buf, len, "%s%lu.%0*lu", (neg && a) ? "-" : "",
+                  (unsigned long)whole, (int)decimals, (unsigned long)frac);
+}
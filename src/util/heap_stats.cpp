@@ -0,0 +1,64 @@
+#include "heap_stats.h"
+#include <Arduino.h>
+#include <atomic>
+#include "esp_heap_caps.h"
+#include "util/log.h"
+
+static std::atomic<uint32_t> s_allocs{0};
+static std::atomic<uint32_t> s_frees{0};
+
+#ifdef HEAP_COUNT_ALLOCS
+// Linked with -Wl,--wrap=malloc,--wrap=free,--wrap=calloc,--wrap=realloc:
+// every call (including operator new and String) lands here first.
+extern "C" {
+void* __real_malloc(size_t);
+void  __real_free(void*);
+void* __real_calloc(size_t, size_t);
+void* __real_realloc(void*, size_t);
+
+void* __wrap_malloc(size_t n) {
+  s_allocs.fetch_add(1, std::memory_order_relaxed);
+  return __real_malloc(n);
+}
+void __wrap_free(void* p) {
+  if (p) s_frees.fetch_add(1, std::memory_order_relaxed);
+  __real_free(p);
+}
+void* __wrap_calloc(size_t n, size_t sz) {
+  s_allocs.fetch_add(1, std::memory_order_relaxed);
+  return __real_calloc(n, sz);
+}
+void* __wrap_realloc(void* p, size_t n) {
+  s_allocs.fetch_add(1, std::memory_order_relaxed);
+  if (p) s_frees.fetch_add(1, std::memory_order_relaxed);
+  return __real_realloc(p, n);
+}
+}
+#endif
+
+void heap_snapshot(HeapSnapshot& out) {
+  out.freeBytes    = (uint32_t)heap_caps_get_free_size(MALLOC_CAP_8BIT);
+  out.largestBlock = (uint32_t)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+  out.minFree      = (uint32_t)heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+  out.allocs       = s_allocs.load(std::memory_order_relaxed);
+  out.frees        = s_frees.load(std::memory_order_relaxed);
+}
+
+uint8_t heap_frag_pct(const HeapSnapshot& s) {
+  if (s.freeBytes == 0) return 100;
+  return (uint8_t)(100u - (uint32_t)((uint64_t)s.largestBlock * 100u / s.freeBytes));
+}
+
+void heap_log_delta(const char* tag, const HeapSnapshot& before) {
+  HeapSnapshot now;
+  heap_snapshot(now);
+  LOGI("HEAP", "%s: allocs=+%lu frees=+%lu free=%lu (%+ld) largest=%lu frag=%u%% min=%lu",
+       tag,
+       (unsigned long)(now.allocs - before.allocs),
+       (unsigned long)(now.frees - before.frees),
+       (unsigned long)now.freeBytes,
+       (long)((int32_t)now.freeBytes - (int32_t)before.freeBytes),
+       (unsigned long)now.largestBlock,
+       (unsigned)heap_frag_pct(now),
+       (unsigned long)now.minFree);
+}
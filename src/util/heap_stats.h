@@ -0,0 +1,23 @@
+#pragma once
+#include <stdint.h>
+
+// Heap health snapshots for comparing code paths (e.g. before/after a post).
+//
+// free/largest/minFree come from the ESP-IDF heap and are always valid.
+// allocs/frees count malloc/free calls and are only live when built with
+// HEAP_COUNT_ALLOCS and the linker wraps (see platformio.ini); otherwise 0.
+struct HeapSnapshot {
+  uint32_t freeBytes;
+  uint32_t largestBlock;   // biggest single allocation that would succeed
+  uint32_t minFree;        // low-water mark since boot
+  uint32_t allocs;
+  uint32_t frees;
+};
+
+void heap_snapshot(HeapSnapshot& out);
+
+// 0 = all free memory is one block, 100 = fully fragmented
+uint8_t heap_frag_pct(const HeapSnapshot& s);
+
+// "[HEAP] <tag>: allocs=+N frees=+M free=... (Δ...) largest=... frag=..%"
+void heap_log_delta(const char* tag, const HeapSnapshot& before);
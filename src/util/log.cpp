@@ -0,0 +1,328 @@
+#include "log.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#ifdef ARDUINO
+#include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#endif
+#include "app_config.h"
+#include "hal/clock.h"
+#include "hal/serial.h"
+
+static_assert((LOG_RING_SLOTS & (LOG_RING_SLOTS - 1)) == 0, "LOG_RING_SLOTS must be a power of two");
+
+// Bounded MPMC ring (Vyukov) used with a single consumer: a producer
+// claims a slot by CAS on s_head, formats into it and publishes it by
+// bumping the slot's seq. No locks; a full ring is detected, not waited on.
+// In binary mode 'text' holds the message ID and the raw arguments.
+struct Slot {
+  std::atomic<uint32_t> seq;
+  uint32_t    ms;
+  const char* tag;
+  uint8_t     level;
+  uint8_t     len;
+  bool        bin;
+  char        text[LOG_LINE_MAX];
+};
+
+static_assert(LOG_LINE_MAX <= 250, "Slot::len and the binary frame length are 8 bit");
+static constexpr uint8_t  BIN_SYNC    = 0xA5;
+static constexpr uint32_t BIN_ID_DROP = 0;     // reserved: u32 dropped count
+static constexpr uint32_t MASK = LOG_RING_SLOTS - 1;
+
+static Slot                  s_ring[LOG_RING_SLOTS];
+static std::atomic<uint32_t> s_head{0};       // next slot to claim
+static std::atomic<uint32_t> s_tail{0};       // next slot to drain (drain task only writes)
+static std::atomic<uint32_t> s_written{0};
+static std::atomic<uint32_t> s_dropped{0};
+static std::atomic<uint32_t> s_truncated{0};
+static std::atomic<uint32_t> s_highWater{0};
+static std::atomic<bool>     s_drainIdle{true};   // drain is (about to be) asleep: notify it
+static bool                  s_async = false;  // log_start() done: producers queue, the drain writes
+#ifdef ARDUINO
+static TaskHandle_t          s_task  = nullptr;
+#endif
+static volatile uint8_t      s_level = LOG_COMPILE_LEVEL;
+
+#ifdef ARDUINO
+static void logTask(void*);
+#endif
+
+// "[TAG] text\r\n" in one write, so lines from the sync path don't interleave
+static void emit(const char* tag, const char* text, size_t len) {
+  char line[LOG_LINE_MAX + 24];
+  int n = snprintf(line, sizeof(line), "[%s] ", tag ? tag : "?");
+  if (n < 0) return;
+  if (len > sizeof(line) - n - 2) len = sizeof(line) - n - 2;
+  memcpy(line + n, text, len);
+  n += len;
+  line[n++] = '\r';
+  line[n++] = '\n';
+  hal_serial_write((const uint8_t*)line, n);
+}
+
+// 0xA5 | len | level | ms | payload | xor over len..payload
+static void emit_bin(uint8_t level, uint32_t ms, const uint8_t* payload, size_t len) {
+  uint8_t frame[LOG_LINE_MAX + 8];
+  if (len > LOG_LINE_MAX) len = LOG_LINE_MAX;
+  frame[0] = BIN_SYNC;
+  frame[1] = (uint8_t)(1 + 4 + len);
+  frame[2] = level;
+  memcpy(frame + 3, &ms, 4);
+  memcpy(frame + 7, payload, len);
+  uint8_t x = 0;
+  for (size_t i = 1; i < 7 + len; ++i) x ^= frame[i];
+  frame[7 + len] = x;
+  hal_serial_write(frame, 8 + len);
+}
+
+// On the host there is no drain task: lines stay queued until log_flush()
+// drains them on the caller's thread (test/test_log).
+void log_start() {
+  if (s_async) return;
+  for (uint32_t i = 0; i < LOG_RING_SLOTS; ++i) s_ring[i].seq.store(i, std::memory_order_relaxed);
+  s_head.store(0, std::memory_order_relaxed);
+  s_tail.store(0, std::memory_order_relaxed);
+
+#ifdef ARDUINO
+  BaseType_t ok = xTaskCreatePinnedToCore(
+    logTask,
+    "log",
+    TASK_STACK_LOG,
+    nullptr,
+    TASK_PRIO_LOG,
+    &s_task,
+    (TASK_CORE_LOG < 0) ? tskNO_AFFINITY : TASK_CORE_LOG
+  );
+  if (ok != pdPASS) {
+    s_task = nullptr;
+    static const char kMsg[] = "drain task failed → synchronous logging";
+    emit("LOG", kMsg, sizeof(kMsg) - 1);
+    return;
+  }
+#endif
+  s_async = true;
+}
+
+void log_set_level(uint8_t level) {
+  s_level = level > LOG_COMPILE_LEVEL ? LOG_COMPILE_LEVEL : level;
+}
+
+uint8_t log_get_level() { return s_level; }
+
+// Claims the next free slot, or counts a drop when the drain is behind
+static Slot* claim(uint32_t& pos) {
+  pos = s_head.load(std::memory_order_relaxed);
+  for (;;) {
+    Slot* s = &s_ring[pos & MASK];
+    const int32_t dif = (int32_t)(s->seq.load(std::memory_order_acquire) - pos);
+    if (dif == 0) {
+      if (s_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) return s;
+    } else if (dif < 0) {
+      s_dropped.fetch_add(1, std::memory_order_relaxed);
+      return nullptr;
+    } else {
+      pos = s_head.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+// Publishes a filled slot and wakes the drain only if it went to sleep
+static void publish(Slot* s, uint32_t pos) {
+  s->ms = hal_millis();
+  s->seq.store(pos + 1, std::memory_order_release);
+
+  s_written.fetch_add(1, std::memory_order_relaxed);
+  const uint32_t tail = s_tail.load(std::memory_order_acquire);     // tail first: head - tail >= 0
+  uint32_t used = s_head.load(std::memory_order_relaxed) - tail;
+  if (used > LOG_RING_SLOTS) used = LOG_RING_SLOTS;                  // drain moved on meanwhile
+  if (used > s_highWater.load(std::memory_order_relaxed)) s_highWater.store(used, std::memory_order_relaxed);
+
+  std::atomic_thread_fence(std::memory_order_seq_cst);              // pairs with the drain's idle check
+  if (s_drainIdle.load(std::memory_order_relaxed) && s_drainIdle.exchange(false)) {
+#ifdef ARDUINO
+    xTaskNotifyGive(s_task);
+#endif
+  }
+}
+
+void log_write(uint8_t level, const char* tag, const char* fmt, ...) {
+  if (level == LOG_LVL_NONE || level > s_level) return;
+
+  va_list ap;
+  va_start(ap, fmt);
+
+  if (!s_async) {
+    char text[LOG_LINE_MAX];
+    int n = vsnprintf(text, sizeof(text), fmt, ap);
+    va_end(ap);
+    if (n < 0) return;
+    emit(tag, text, (size_t)n < sizeof(text) ? (size_t)n : sizeof(text) - 1);
+    return;
+  }
+
+  uint32_t pos;
+  Slot* s = claim(pos);
+  if (!s) { va_end(ap); return; }
+
+  int n = vsnprintf(s->text, sizeof(s->text), fmt, ap);
+  va_end(ap);
+  if (n < 0) n = 0;
+  if ((size_t)n >= sizeof(s->text)) {
+    n = sizeof(s->text) - 1;
+    s_truncated.fetch_add(1, std::memory_order_relaxed);
+  }
+  s->len   = (uint8_t)n;
+  s->tag   = tag;
+  s->level = level;
+  s->bin   = false;
+  publish(s, pos);
+}
+
+bool log_bin_begin(LogBinSlot& b) {
+  b.overflow = false;
+  if (!s_async) {
+    b.pos = 0xFFFFFFFFu;
+    b.buf = b.sync;
+  } else {
+    Slot* s = claim(b.pos);
+    if (!s) return false;
+    b.buf = (uint8_t*)s->text;
+  }
+  b.end = b.buf + LOG_LINE_MAX;
+  return true;
+}
+
+void log_bin_end(LogBinSlot& b, uint8_t level, uint8_t* p) {
+  size_t len = p - b.buf;
+  if (b.overflow) {                   // keep the ID, the decoder marks the line
+    len = 4;
+    s_truncated.fetch_add(1, std::memory_order_relaxed);
+  }
+  if (b.pos == 0xFFFFFFFFu) {
+    emit_bin(level, hal_millis(), b.buf, len);
+    return;
+  }
+  Slot* s  = &s_ring[b.pos & MASK];
+  s->len   = (uint8_t)len;
+  s->tag   = nullptr;
+  s->level = level;
+  s->bin   = true;
+  publish(s, b.pos);
+}
+
+static bool published(uint32_t tail) {
+  return s_ring[tail & MASK].seq.load(std::memory_order_acquire) == tail + 1;
+}
+
+// Drain task (host: log_flush) only. Stops at the first slot that is claimed but not yet
+// published; its producer notifies us when done.
+static void drain() {
+  static uint32_t reportedDrops = 0;
+  uint32_t tail = s_tail.load(std::memory_order_relaxed);
+  for (;;) {
+    while (published(tail)) {
+      Slot& s = s_ring[tail & MASK];
+      if (s.bin) emit_bin(s.level, s.ms, (const uint8_t*)s.text, s.len);
+      else       emit(s.tag, s.text, s.len);
+      s.seq.store(tail + LOG_RING_SLOTS, std::memory_order_release);   // free for lap +1
+      s_tail.store(++tail, std::memory_order_release);
+    }
+
+    // Producers only notify while we are idle: announce it, then look once
+    // more for a line published before they could see the flag
+    s_drainIdle.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!published(tail)) break;
+    s_drainIdle.store(false, std::memory_order_relaxed);
+  }
+
+  const uint32_t drops = s_dropped.load(std::memory_order_relaxed);
+  if (drops != reportedDrops) {
+    const uint32_t n = drops - reportedDrops;
+#if LOG_BINARY
+    uint8_t payload[8];
+    memcpy(payload, &BIN_ID_DROP, 4);
+    memcpy(payload + 4, &n, 4);
+    emit_bin(LOG_LVL_WARN, hal_millis(), payload, sizeof(payload));
+#else
+    char text[48];
+    const int len = snprintf(text, sizeof(text), "dropped %lu lines (ring full)", (unsigned long)n);
+    emit("LOG", text, (size_t)len);
+#endif
+    reportedDrops = drops;
+  }
+}
+
+#ifdef ARDUINO
+static void logTask(void*) {
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    s_drainIdle.store(false, std::memory_order_relaxed);
+    drain();
+  }
+}
+#endif
+
+bool log_flush(uint32_t timeoutMs) {
+  if (!s_async) { hal_serial_flush(); return true; }
+#ifdef ARDUINO
+  const uint32_t t0 = hal_millis();
+  while (s_tail.load(std::memory_order_acquire) != s_head.load(std::memory_order_relaxed)) {
+    if (hal_millis() - t0 >= timeoutMs) return false;
+    xTaskNotifyGive(s_task);
+    vTaskDelay(pdMS_TO_TICKS(5));
+  }
+#else
+  (void)timeoutMs;
+  s_drainIdle.store(false, std::memory_order_relaxed);
+  drain();
+  if (s_tail.load(std::memory_order_acquire) != s_head.load(std::memory_order_relaxed)) return false;
+#endif
+  hal_serial_flush();
+  return true;
+}
+
+void log_get_stats(LogStats& out) {
+  out.written   = s_written.load(std::memory_order_relaxed);
+  out.dropped   = s_dropped.load(std::memory_order_relaxed);
+  out.truncated = s_truncated.load(std::memory_order_relaxed);
+  out.highWater = s_highWater.load(std::memory_order_relaxed);
+}
+
+#ifdef ARDUINO
+// Device only: cycle counter and Serial.printf (host: test/test_log)
+void log_benchmark(uint16_t n) {
+  if (n == 0) return;
+  const uint16_t burst = LOG_RING_SLOTS / 2;   // stay clear of drops
+  uint32_t usLog = 0, usSerial = 0, cycLog = 0;
+
+  log_flush(2000);
+  for (uint16_t i = 0; i < n; ++i) {
+    if (i % burst == 0) log_flush(2000);
+    const uint32_t t0 = micros();
+    const uint32_t c0 = ESP.getCycleCount();
+    LOGI("BENCH", "seq=%u ADD %ld.%02u g → OK (http, %lu ms, depth=%u)",
+         (unsigned)i, (long)(i * 7), (unsigned)(i % 100), (unsigned long)(i + 120), (unsigned)(i % 8));
+    cycLog += ESP.getCycleCount() - c0;
+    usLog  += micros() - t0;
+  }
+  log_flush(2000);
+
+  for (uint16_t i = 0; i < n; ++i) {
+    const uint32_t t0 = micros();
+    Serial.printf("[BENCH] seq=%u ADD %ld.%02u g → OK (http, %lu ms, depth=%u)\r\n",
+                  (unsigned)i, (long)(i * 7), (unsigned)(i % 100), (unsigned long)(i + 120), (unsigned)(i % 8));
+    usSerial += micros() - t0;
+  }
+  Serial.flush();
+
+  LOGI("LOG", "benchmark %u lines (%s): LOGI %lu.%02lu µs/call (%lu cycles), Serial.printf %lu.%02lu µs/call",
+       (unsigned)n, LOG_BINARY ? "binary" : "text",
+       (unsigned long)(usLog / n), (unsigned long)((usLog % n) * 100 / n), (unsigned long)(cycLog / n),
+       (unsigned long)(usSerial / n), (unsigned long)((usSerial % n) * 100 / n));
+}
+#endif
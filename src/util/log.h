@@ -0,0 +1,167 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+#include "app_config.h"
+
+// Leveled, asynchronous logging.
+//
+// LOGE/LOGW/LOGI/LOGD("TAG", fmt, ...) format the message into a slot of a
+// lock-free multi-producer ring (LOG_RING_SLOTS x LOG_LINE_MAX) and return;
+// a low-priority drain task adds the "[TAG] " prefix and writes to Serial
+// (hal/serial.h).
+// A caller never waits for the UART. When the ring is full the line is
+// dropped and counted; the drain reports "[LOG] dropped N lines" once it
+// catches up. Over-long messages are truncated (counted too).
+//
+// Levels above LOG_COMPILE_LEVEL are removed at compile time, arguments
+// included (set it with -DLOG_COMPILE_LEVEL=... in platformio.ini).
+// log_set_level() filters further at run time.
+//
+// Binary trace mode (-DLOG_BINARY=1): nothing is formatted on the device.
+// The macros hash "TAG\x1f" fmt (FNV-1a, at compile time) into a 32-bit
+// message ID and only the raw arguments are queued; the drain writes
+//   0xA5 | len | level | ms(u32) | id(u32) | args | xor(len..args)
+// frames and tools/log_decode.py rebuilds the text from the same sources.
+// Arguments are captured by C++ type: integers up to 32 bit → 4 bytes,
+// 64 bit → 8, float/double → float32, char* → u8 length + bytes (at most
+// LOG_BIN_STR_MAX; a %.*s buffer should be NUL-terminated within that),
+// other pointers → 4. Tag and format must be string literals.
+//
+// Task context only (no ISRs). Before log_start() or if the drain task
+// cannot be created, lines are written synchronously. The host build has
+// no drain task: log_flush() drains on the caller's thread.
+
+#define LOG_LVL_NONE  0
+#define LOG_LVL_ERROR 1
+#define LOG_LVL_WARN  2
+#define LOG_LVL_INFO  3
+#define LOG_LVL_DEBUG 4
+
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL LOG_LVL_INFO
+#endif
+
+#ifndef LOG_BINARY
+#define LOG_BINARY 0
+#endif
+
+#define LOG_BIN_STR_MAX 48
+
+#if LOG_BINARY
+#define LOG_AT(lvl, tag, fmt, ...) \
+  do { if ((lvl) <= LOG_COMPILE_LEVEL) \
+    log_bin((lvl), LogId<log_fnv1a(tag "\x1f" fmt)>::value, ##__VA_ARGS__); } while (0)
+#else
+#define LOG_AT(lvl, tag, fmt, ...) \
+  do { if ((lvl) <= LOG_COMPILE_LEVEL) log_write((lvl), (tag), fmt, ##__VA_ARGS__); } while (0)
+#endif
+
+#define LOGE(tag, ...) LOG_AT(LOG_LVL_ERROR, tag, __VA_ARGS__)
+#define LOGW(tag, ...) LOG_AT(LOG_LVL_WARN,  tag, __VA_ARGS__)
+#define LOGI(tag, ...) LOG_AT(LOG_LVL_INFO,  tag, __VA_ARGS__)
+#define LOGD(tag, ...) LOG_AT(LOG_LVL_DEBUG, tag, __VA_ARGS__)
+
+struct LogStats {
+  uint32_t written;     // lines queued
+  uint32_t dropped;     // ring full
+  uint32_t truncated;   // longer than LOG_LINE_MAX
+  uint32_t highWater;   // max slots in use
+};
+
+void log_start();                       // creates the drain task
+void log_set_level(uint8_t level);      // LOG_LVL_*, capped by LOG_COMPILE_LEVEL
+uint8_t log_get_level();
+
+// 'tag' must outlive the drain (string literals); the message is copied
+void log_write(uint8_t level, const char* tag, const char* fmt, ...)
+  __attribute__((format(printf, 3, 4)));
+
+// Wait until everything queued so far is on the wire (e.g. before a
+// restart). Returns false on timeout (host: a line still being written).
+bool log_flush(uint32_t timeoutMs);
+
+void log_get_stats(LogStats& out);
+
+// Times 'n' LOGI calls against the same lines through Serial.printf and
+// prints the per-call cost in µs and CPU cycles (see LOG_BENCH_AT_BOOT).
+// Device only.
+void log_benchmark(uint16_t n);
+
+// ---- Binary trace mode ----
+
+// FNV-1a, usable in constant expressions (C++11 recursion)
+constexpr uint32_t log_fnv1a(const char* s, uint32_t h = 2166136261u) {
+  return *s ? log_fnv1a(s + 1, (h ^ (uint8_t)*s) * 16777619u) : h;
+}
+
+// Forces the hash to be a compile-time constant
+template <uint32_t ID> struct LogId { static constexpr uint32_t value = ID; };
+
+// Slot reserved by log_bin_begin(); filled by log_bin(), queued by log_bin_end().
+// Before log_start() 'buf' points at 'sync' (the caller's stack), so
+// concurrent callers on the synchronous path never share a buffer.
+struct LogBinSlot {
+  uint8_t* buf;
+  uint8_t* end;
+  uint32_t pos;
+  bool     overflow;
+  uint8_t  sync[LOG_LINE_MAX];
+};
+
+bool log_bin_begin(LogBinSlot& s);                 // false = ring full (counted)
+void log_bin_end(LogBinSlot& s, uint8_t level, uint8_t* p);
+
+namespace logbin {
+
+inline void put(LogBinSlot& s, uint8_t*& p, const void* v, size_t n) {
+  if ((size_t)(s.end - p) < n) { s.overflow = true; p = s.end; return; }
+  memcpy(p, v, n);
+  p += n;
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type
+arg(LogBinSlot& s, uint8_t*& p, T v) {
+  if (sizeof(T) > 4) { const int64_t x = (int64_t)v; put(s, p, &x, 8); }
+  else               { const int32_t x = (int32_t)v; put(s, p, &x, 4); }
+}
+
+inline void arg(LogBinSlot& s, uint8_t*& p, double v) {
+  const float f = (float)v;
+  put(s, p, &f, 4);
+}
+
+inline void arg(LogBinSlot& s, uint8_t*& p, const char* str) {
+  if (!str) str = "(null)";
+  uint8_t n = 0;
+  while (n < LOG_BIN_STR_MAX && str[n]) ++n;
+  put(s, p, &n, 1);
+  put(s, p, str, n);
+}
+
+inline void arg(LogBinSlot& s, uint8_t*& p, const void* ptr) {
+  const uint32_t x = (uint32_t)(uintptr_t)ptr;
+  put(s, p, &x, 4);
+}
+
+inline void args(LogBinSlot&, uint8_t*&) {}
+
+template <typename T, typename... R>
+inline void args(LogBinSlot& s, uint8_t*& p, T v, R... rest) {
+  arg(s, p, v);
+  args(s, p, rest...);
+}
+
+}  // namespace logbin
+
+template <typename... A>
+void log_bin(uint8_t level, uint32_t id, A... a) {
+  if (level > log_get_level()) return;
+  LogBinSlot s;
+  if (!log_bin_begin(s)) return;
+  uint8_t* p = s.buf;
+  logbin::put(s, p, &id, 4);
+  logbin::args(s, p, a...);
+  log_bin_end(s, level, p);
+}
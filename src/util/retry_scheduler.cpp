@@ -0,0 +1,95 @@
+#include "retry_scheduler.h"
+
+RetryScheduler::RetryScheduler(const Config& c, uint32_t seed)
+  : cfg(c), rng(seed ? seed : 0x9E3779B9u) {
+  if (cfg.baseMs == 0)    cfg.baseMs = 1;
+  if (cfg.maxMs < cfg.baseMs) cfg.maxMs = cfg.baseMs;
+  if (cfg.openAfter == 0) cfg.openAfter = 1;
+  if (cfg.openMaxMs < cfg.openMs) cfg.openMaxMs = cfg.openMs;
+  st.state = State::CLOSED;
+}
+
+const char* RetryScheduler::stateName(State s) {
+  switch (s) {
+    case State::CLOSED:    return "CLOSED";
+    case State::OPEN:      return "OPEN";
+    case State::HALF_OPEN: return "HALF_OPEN";
+  }
+  return "?";
+}
+
+// cap/2 + uniform(0..cap/2)
+uint32_t RetryScheduler::jitter(uint32_t capMs) {
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  const uint32_t half = capMs / 2;
+  return (capMs - half) + (half ? rng % (half + 1) : 0);
+}
+
+uint32_t RetryScheduler::waitMs(uint32_t nowMs) const {
+  if (inFlight) return cfg.baseMs;                  // probe/attempt still out
+  if (!waiting) return 0;
+  const int32_t left = (int32_t)(nextAtMs - nowMs);
+  return left > 0 ? (uint32_t)left : 0;
+}
+
+bool RetryScheduler::begin(uint32_t nowMs) {
+  if (waitMs(nowMs) != 0) { st.blocked++; return false; }
+  waiting = false;
+  if (st.state == State::OPEN) {
+    st.state = State::HALF_OPEN;
+    st.probes++;
+  }
+  if (st.state == State::HALF_OPEN) inFlight = true;   // one probe at a time
+  st.attempts++;
+  return true;
+}
+
+void RetryScheduler::onSuccess(uint32_t) {
+  inFlight  = false;
+  waiting   = false;
+  openCount = 0;
+  st.successes++;
+  st.consecutiveFails = 0;
+  st.state = State::CLOSED;
+}
+
+void RetryScheduler::open(uint32_t nowMs) {
+  uint32_t cap = cfg.openMs;
+  for (uint32_t i = 0; i < openCount && cap < cfg.openMaxMs; ++i) cap <<= 1;
+  if (cap > cfg.openMaxMs) cap = cfg.openMaxMs;
+  openCount++;
+
+  st.state = State::OPEN;
+  st.opens++;
+  st.lastDelayMs = jitter(cap);
+  nextAtMs = nowMs + st.lastDelayMs;
+  waiting  = true;
+}
+
+void RetryScheduler::onFailure(uint32_t nowMs) {
+  inFlight = false;
+  st.failures++;
+  st.consecutiveFails++;
+
+  if (st.state == State::HALF_OPEN || st.consecutiveFails >= cfg.openAfter) {
+    open(nowMs);
+    return;
+  }
+
+  uint32_t cap = cfg.baseMs;
+  for (uint32_t i = 1; i < st.consecutiveFails && cap < cfg.maxMs; ++i) cap <<= 1;
+  if (cap > cfg.maxMs) cap = cfg.maxMs;
+  st.lastDelayMs = jitter(cap);
+  nextAtMs = nowMs + st.lastDelayMs;
+  waiting  = true;
+}
+
+void RetryScheduler::reset() {
+  inFlight  = false;
+  waiting   = false;
+  openCount = 0;
+  st.consecutiveFails = 0;
+  st.state = State::CLOSED;
+}
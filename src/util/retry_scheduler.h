@@ -0,0 +1,75 @@
+#pragma once
+#include <stdint.h>
+
+// When to try the server again (no Arduino/RTOS deps; time is passed in).
+//
+// Backoff: after the k-th consecutive failure the next attempt waits
+//   cap = min(maxMs, baseMs << (k-1)),   delay = cap/2 + rand(0 .. cap/2)
+// The random half spreads a fleet that lost the server at the same moment,
+// so devices do not come back in lock-step.
+//
+// Circuit breaker: 'openAfter' consecutive failures open it. While OPEN no
+// attempt is allowed for openMs (doubling per failed probe, up to
+// openMaxMs, jittered the same way). After that it is HALF_OPEN and lets
+// exactly one probe through: success closes it, failure re-opens it.
+//
+// Usage per attempt:
+//   if (r.waitMs(now) == 0 && r.begin(now)) { ok = send(); ok ? r.onSuccess(now) : r.onFailure(now); }
+// Only report failures that say "server unreachable/unhealthy" (transport
+// errors, timeouts, 5xx); a 4xx is an answer and counts as success here.
+class RetryScheduler {
+public:
+  enum class State : uint8_t { CLOSED, OPEN, HALF_OPEN };
+
+  struct Config {
+    uint32_t baseMs;       // first retry delay (before jitter)
+    uint32_t maxMs;        // backoff cap
+    uint16_t openAfter;    // consecutive failures that open the breaker
+    uint32_t openMs;       // first OPEN period
+    uint32_t openMaxMs;    // cap for repeated OPEN periods
+  };
+
+  struct Stats {
+    State    state;
+    uint32_t consecutiveFails;
+    uint32_t attempts;       // begin() calls that were allowed
+    uint32_t successes;
+    uint32_t failures;
+    uint32_t opens;          // CLOSED/HALF_OPEN → OPEN transitions
+    uint32_t probes;         // half-open attempts
+    uint32_t blocked;        // begin() calls refused (backoff or OPEN)
+    uint32_t lastDelayMs;    // last scheduled wait
+  };
+
+  RetryScheduler(const Config& cfg, uint32_t seed);
+
+  // 0 = an attempt may start now, else ms until it may. No side effects.
+  uint32_t waitMs(uint32_t nowMs) const;
+
+  // Claim the next attempt. False while backing off / OPEN, or while the
+  // half-open probe is still out.
+  bool begin(uint32_t nowMs);
+
+  void onSuccess(uint32_t nowMs);
+  void onFailure(uint32_t nowMs);
+
+  void reset();                      // back to CLOSED, counters kept
+  void seed(uint32_t s) { rng = s ? s : 0x9E3779B9u; }
+
+  State state() const { return st.state; }
+  const Stats& stats() const { return st; }
+
+  static const char* stateName(State s);
+
+private:
+  uint32_t jitter(uint32_t capMs);
+  void     open(uint32_t nowMs);
+
+  Config   cfg;
+  uint32_t rng;                      // xorshift32 state, never 0
+  uint32_t nextAtMs = 0;             // earliest next attempt (wrap-safe compare)
+  bool     waiting  = false;         // nextAtMs is in force
+  bool     inFlight = false;         // begin() without onSuccess/onFailure yet
+  uint32_t openCount = 0;            // consecutive OPEN periods (for doubling)
+  Stats    st{};
+};
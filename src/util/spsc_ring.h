@@ -0,0 +1,50 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+// Lock-free single-producer / single-consumer ring.
+// One task (or ISR) pushes, one task pops; no locks, no heap.
+// N must be a power of two. Usable capacity is N (indices run free).
+template <typename T, size_t N>
+class SpscRing {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscRing size must be a power of two");
+
+public:
+  // Producer side. Returns false (and leaves the ring untouched) when full.
+  bool push(const T& v) {
+    const uint32_t head = headIdx.load(std::memory_order_relaxed);
+    const uint32_t tail = tailIdx.load(std::memory_order_acquire);
+    if ((uint32_t)(head - tail) >= N) return false;
+    buf[head & (N - 1)] = v;
+    headIdx.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side. Returns false when empty.
+  bool pop(T& out) {
+    const uint32_t tail = tailIdx.load(std::memory_order_relaxed);
+    const uint32_t head = headIdx.load(std::memory_order_acquire);
+    if (head == tail) return false;
+    out = buf[tail & (N - 1)];
+    tailIdx.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Snapshot; may already be stale when it returns.
+  size_t size() const {
+    return (size_t)(uint32_t)(headIdx.load(std::memory_order_acquire) -
+                              tailIdx.load(std::memory_order_acquire));
+  }
+
+  bool empty() const { return size() == 0; }
+  static constexpr size_t capacity() { return N; }
+
+  // Consumer side only: drop everything currently queued.
+  void clear() { tailIdx.store(headIdx.load(std::memory_order_acquire), std::memory_order_release); }
+
+private:
+  T buf[N];
+  std::atomic<uint32_t> headIdx{0};
+  std::atomic<uint32_t> tailIdx{0};
+};
@@ -0,0 +1,17 @@
+#pragma once
+#include <stdint.h>
+
+// xorshift32 (13/17/5): cheap, repeatable noise for the host fakes and the
+// native suites. Never returns 0 once seeded non-zero.
+struct XorShift32 {
+  uint32_t s;
+
+  explicit XorShift32(uint32_t seed = 1) : s(seed ? seed : 1) {}
+
+  uint32_t next() {
+    s ^= s << 13;
+    s ^= s >> 17;
+    s ^= s << 5;
+    return s;
+  }
+};
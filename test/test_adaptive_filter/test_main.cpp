@@ -0,0 +1,109 @@
+// features/adaptive_filter.h: the integer AdaptiveKalman against the same
+// filter in double precision, smoothing at rest, step tracking and extreme
+// inputs
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include "app_config.h"
+#include "features/adaptive_filter.h"
+#include "../test_support.h"
+
+// Roughly gaussian: sum of four uniforms, σ ≈ sigma
+static int32_t noise(int32_t sigma) {
+  int64_t s = 0;
+  for (int i = 0; i < 4; ++i) s += (int64_t)(rnd() % 2001) - 1000;
+  return (int32_t)(s * sigma * 1.732 / 2000);
+}
+
+// Reference: the same gated filter in doubles
+struct FloatKalman {
+  double r, q, gate2, x = 0, p = 0;
+  bool primed = false, moving = false;
+  FloatKalman(double sm, double sr, double g) : r(sm * sm), q(sr * sr), gate2(g * g) {}
+  double update(double z) {
+    if (!primed) { x = z; p = r; primed = true; return x; }
+    p += q;
+    const double e = z - x;
+    moving = e * e / gate2 > p + r;
+    if (moving && e * e > p) p = e * e;
+    const double k = p / (p + r);
+    x += k * e;
+    p *= 1 - k;
+    return x;
+  }
+};
+
+void setUp() { rnd_reset(); }
+void tearDown() {}
+
+static AdaptiveKalman live() { return AdaptiveKalman(LIVE_SIGMA_MEAS_MG, LIVE_SIGMA_REST_MG, LIVE_GATE_SIGMA); }
+
+// Same data through both: the integer filter must be as close to the truth
+// as the double one, with no bias from the Q16 step (gate decisions may
+// differ sample by sample, so compare the statistics, not each output)
+static void test_tracks_float_reference() {
+  AdaptiveKalman k = live();
+  FloatKalman f(LIVE_SIGMA_MEAS_MG, LIVE_SIGMA_REST_MG, LIVE_GATE_SIGMA);
+  int32_t truth = 0;
+  double biasI = 0, biasF = 0, sqI = 0, sqF = 0;
+  int n = 0;
+  for (int i = 0; i < 50000; ++i) {
+    if (i % 500 == 0) truth = (int32_t)(rnd() % 2000000);
+    const int32_t z = truth + noise(LIVE_SIGMA_MEAS_MG);
+    const double eI = k.update(z) - (double)truth;
+    const double eF = f.update(z) - (double)truth;
+    if (i % 500 < 100) continue;                   // judge the rest phase only
+    biasI += eI; biasF += eF; sqI += eI * eI; sqF += eF * eF;
+    n++;
+  }
+  printf("\n  at rest vs truth: integer bias %+.1f mg rms %.1f mg, double bias %+.1f mg rms %.1f mg\n",
+         biasI / n, sqrt(sqI / n), biasF / n, sqrt(sqF / n));
+  TEST_ASSERT_TRUE(fabs(biasI / n) < 5.0);
+  TEST_ASSERT_TRUE(sqrt(sqI / n) < sqrt(sqF / n) + 5.0);
+}
+
+static void test_smooths_at_rest() {
+  AdaptiveKalman k = live();
+  double inSq = 0, outSq = 0;
+  int n = 0;
+  for (int i = 0; i < 3000; ++i) {
+    const int32_t z = 500000 + noise(LIVE_SIGMA_MEAS_MG);
+    const int32_t y = k.update(z);
+    if (i < 100) continue;
+    inSq  += (double)(z - 500000) * (z - 500000);
+    outSq += (double)(y - 500000) * (y - 500000);
+    n++;
+    TEST_ASSERT_FALSE(k.isMoving() && i > 200 && fabs(z - 500000.0) < 2 * LIVE_SIGMA_MEAS_MG);
+  }
+  printf("\n  at rest: input σ %.0f mg, output σ %.0f mg, gain %.3f\n",
+         sqrt(inSq / n), sqrt(outSq / n), k.gainQ16() / 65536.0);
+  TEST_ASSERT_TRUE(sqrt(outSq / n) < sqrt(inSq / n) / 3);
+}
+
+static void test_follows_step_within_two_samples() {
+  AdaptiveKalman k = live();
+  for (int i = 0; i < 500; ++i) k.update(500000 + noise(LIVE_SIGMA_MEAS_MG));
+  int32_t y = k.update(600000 + noise(LIVE_SIGMA_MEAS_MG));
+  TEST_ASSERT_TRUE(k.isMoving());
+  y = k.update(600000 + noise(LIVE_SIGMA_MEAS_MG));
+  TEST_ASSERT_INT32_WITHIN(4 * LIVE_SIGMA_MEAS_MG, 600000, y);
+}
+
+static void test_extreme_inputs_do_not_overflow() {
+  AdaptiveKalman k(LIVE_SIGMA_MEAS_MG, LIVE_SIGMA_REST_MG, LIVE_GATE_SIGMA);
+  const int32_t kVals[] = { INT32_MAX / 2, -(INT32_MAX / 2), INT32_MAX / 2, 0, 1, -1 };
+  for (int32_t v : kVals) {
+    int32_t y = 0;
+    for (int i = 0; i < 5; ++i) y = k.update(v);
+    TEST_ASSERT_INT32_WITHIN(2, v, y);
+  }
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_tracks_float_reference);
+  RUN_TEST(test_smooths_at_rest);
+  RUN_TEST(test_follows_step_within_two_samples);
+  RUN_TEST(test_extreme_inputs_do_not_overflow);
+  return UNITY_END();
+}
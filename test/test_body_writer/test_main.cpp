@@ -0,0 +1,62 @@
+// util/body_writer.h: fixed-buffer form / JSON building, overflow and rewind
+#include <unity.h>
+#include "util/body_writer.h"
+
+void setUp() {}
+void tearDown() {}
+
+static void test_form_encoding() {
+  char buf[128];
+  BodyWriter w(buf, sizeof(buf));
+  w.form("mac", "AA:BB:CC:DD:EE:FF").form("name", "Kitchen scale 2").form("n", 42u);
+  TEST_ASSERT_FALSE(w.overflow());
+  TEST_ASSERT_EQUAL_STRING("mac=AA%3ABB%3ACC%3ADD%3AEE%3AFF&name=Kitchen+scale+2&n=42", w.c_str());
+  TEST_ASSERT_EQUAL_size_t(strlen(buf), w.length());
+}
+
+static void test_json_escapes() {
+  char buf[64];
+  BodyWriter w(buf, sizeof(buf));
+  w.jsonStr("a\"b\\c\n\x01");
+  TEST_ASSERT_EQUAL_STRING("\"a\\\"b\\\\c\\u000a\\u0001\"", w.c_str());
+}
+
+static void test_integers() {
+  char buf[64];
+  BodyWriter w(buf, sizeof(buf));
+  w.u32(0).ch(',').u32(4294967295u).ch(',').i32(-2147483647 - 1).ch(',').i32(-5);
+  TEST_ASSERT_EQUAL_STRING("0,4294967295,-2147483648,-5", w.c_str());
+}
+
+static void test_overflow_is_sticky_and_terminated() {
+  char buf[8];
+  BodyWriter w(buf, sizeof(buf));
+  w.raw("1234567");                 // fills cap - 1: fits
+  TEST_ASSERT_FALSE(w.overflow());
+  w.ch('8').raw("9");               // no room for either
+  TEST_ASSERT_TRUE(w.overflow());
+  TEST_ASSERT_EQUAL_STRING("1234567", buf);
+}
+
+static void test_rewind_drops_partial_item() {
+  char buf[24];
+  BodyWriter w(buf, sizeof(buf));
+  w.raw("[").u32(1);
+  const size_t mark = w.length();
+  w.ch(',').raw("{\"long\":\"item that will not fit\"}");
+  TEST_ASSERT_TRUE(w.overflow());
+  w.rewind(mark);
+  TEST_ASSERT_FALSE(w.overflow());
+  w.raw("]");
+  TEST_ASSERT_EQUAL_STRING("[1]", w.c_str());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_form_encoding);
+  RUN_TEST(test_json_escapes);
+  RUN_TEST(test_integers);
+  RUN_TEST(test_overflow_is_sticky_and_terminated);
+  RUN_TEST(test_rewind_drops_partial_item);
+  return UNITY_END();
+}
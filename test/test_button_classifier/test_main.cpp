@@ -0,0 +1,215 @@
+// drivers/button_classifier: the edge-driven classifier must report the
+// same events at the same times as the old 10 ms-style polling loop (here
+// polled every 1 ms), including bounce, edges exactly at a settle instant,
+// the BOTH_LONG swallow and millis() wrap
+#include <unity.h>
+#include <algorithm>
+#include <vector>
+#include "drivers/button_classifier.h"
+#include "../test_support.h"
+
+using Ev = ButtonEventType;
+static constexpr ButtonClassifier::Config CFG = { 30, 50, 2000 };
+
+struct Event {
+  Ev       type;
+  uint32_t ms;
+  bool operator==(const Event& o) const { return type == o.type && ms == o.ms; }
+};
+
+// The polling loop the classifier replaced, one call per tick
+struct PolledModel {
+  bool     lastRaw[2], deb[2], pr[2];
+  uint32_t lc[2], dm[2];
+  bool     bothFired = false, swallow = false;
+  std::vector<Event> ev;
+
+  void init(bool a, bool b, uint32_t now) {
+    const bool r[2] = { a, b };
+    for (int i = 0; i < 2; ++i) { lastRaw[i] = deb[i] = pr[i] = r[i]; lc[i] = now; dm[i] = now; }
+  }
+
+  void tick(bool r1, bool r2, uint32_t now) {
+    const bool r[2] = { r1, r2 };
+    for (int i = 0; i < 2; ++i) {
+      if (r[i] != lastRaw[i]) { lastRaw[i] = r[i]; lc[i] = now; }
+      if (now - lc[i] >= CFG.debounceMs) deb[i] = r[i];
+    }
+    for (int i = 0; i < 2; ++i) {
+      if (deb[i] && !pr[i]) { pr[i] = true; dm[i] = now; }
+      if (!deb[i] && pr[i]) {
+        const uint32_t d = now - dm[i];
+        if (!swallow) {
+          if (d >= CFG.longPressMs)     ev.push_back({ i ? Ev::BTN2_LONG : Ev::BTN1_LONG, now });
+          else if (d >= CFG.shortMinMs) ev.push_back({ i ? Ev::BTN2_SHORT : Ev::BTN1_SHORT, now });
+        }
+        pr[i] = false;
+      }
+    }
+    if (deb[0] && deb[1]) {
+      const uint32_t later = (int32_t)(dm[0] - dm[1]) > 0 ? dm[0] : dm[1];
+      if (!bothFired && now - later >= CFG.longPressMs) {
+        ev.push_back({ Ev::BOTH_LONG, now });
+        bothFired = swallow = true;
+        dm[0] = dm[1] = now;
+      }
+    } else {
+      bothFired = false;
+      if (!deb[0] && !deb[1]) swallow = false;
+    }
+  }
+};
+
+struct Edge { uint32_t at; uint8_t btn; bool level; };
+
+// Runs both over the same raw edges (times relative to t0); the classifier
+// is only woken at edges and when nextDueMs() says so
+static void run_both(const std::vector<Edge>& edges, uint32_t t0, uint32_t lenMs,
+                     std::vector<Event>& polled, std::vector<Event>& driven) {
+  PolledModel m;
+  m.init(false, false, t0);
+  ButtonClassifier c(CFG);
+  c.reset(false, false, t0);
+
+  bool   cur[2] = { false, false };
+  size_t k = 0;
+  auto take = [&](const ButtonClassifier::Events& e, uint32_t now) {
+    for (uint8_t j = 0; j < e.n; ++j) driven.push_back({ e.type[j], now });
+  };
+  for (uint32_t ms = 0; ms < lenMs; ++ms) {
+    const uint32_t now = t0 + ms;
+    for (; k < edges.size() && edges[k].at == ms; ++k) {
+      cur[edges[k].btn] = edges[k].level;
+      ButtonClassifier::Events e;
+      c.edge(edges[k].btn, edges[k].level, now, e);
+      take(e, now);
+    }
+    m.tick(cur[0], cur[1], now);
+    if (c.nextDueMs(now) == 0) {
+      ButtonClassifier::Events e;
+      c.update(now, e);
+      take(e, now);
+    }
+  }
+  polled = m.ev;
+}
+
+static std::vector<Event> classify(const std::vector<Edge>& edges, uint32_t t0 = 1000) {
+  std::vector<Event> polled, driven;
+  const uint32_t len = (edges.empty() ? 0 : edges.back().at) + 3000;
+  run_both(edges, t0, len, polled, driven);
+  TEST_ASSERT_EQUAL_size_t(polled.size(), driven.size());
+  for (size_t i = 0; i < polled.size(); ++i) {
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)polled[i].type, (uint8_t)driven[i].type);
+    TEST_ASSERT_EQUAL_UINT32(polled[i].ms, driven[i].ms);
+  }
+  return driven;
+}
+
+void setUp() { rnd_reset(); }
+void tearDown() {}
+
+static void test_short_and_long() {
+  std::vector<Event> ev = classify({ { 0, 0, true }, { 200, 0, false } });
+  TEST_ASSERT_EQUAL_size_t(1, ev.size());
+  TEST_ASSERT_EQUAL_UINT8((uint8_t)Ev::BTN1_SHORT, (uint8_t)ev[0].type);
+  TEST_ASSERT_EQUAL_UINT32(1000 + 230, ev[0].ms);                  // on the debounced release
+
+  ev = classify({ { 0, 1, true }, { 2500, 1, false } });
+  TEST_ASSERT_EQUAL_size_t(1, ev.size());
+  TEST_ASSERT_EQUAL_UINT8((uint8_t)Ev::BTN2_LONG, (uint8_t)ev[0].type);
+
+  ev = classify({ { 0, 0, true }, { 40, 0, false } });            // under shortMinMs
+  TEST_ASSERT_EQUAL_size_t(0, ev.size());
+}
+
+static void test_bounce_is_filtered() {
+  // Chatter shorter than the debounce on press and release: one SHORT
+  std::vector<Event> ev = classify({
+    { 0, 0, true }, { 5, 0, false }, { 9, 0, true }, { 20, 0, false }, { 22, 0, true },
+    { 300, 0, false }, { 310, 0, true }, { 318, 0, false },
+  });
+  TEST_ASSERT_EQUAL_size_t(1, ev.size());
+  TEST_ASSERT_EQUAL_UINT8((uint8_t)Ev::BTN1_SHORT, (uint8_t)ev[0].type);
+  TEST_ASSERT_EQUAL_UINT32(1000 + 348, ev[0].ms);
+
+  // Pure chatter never settles
+  ev = classify({ { 0, 1, true }, { 20, 1, false }, { 40, 1, true }, { 60, 1, false } });
+  TEST_ASSERT_EQUAL_size_t(0, ev.size());
+}
+
+static void test_edge_at_settle_instant_restarts_debounce() {
+  // The release lands exactly when the press would have settled: the
+  // press never counts (the polled loop samples the raw level first)
+  ButtonClassifier c(CFG);
+  c.reset(false, false, 0);
+  ButtonClassifier::Events e;
+  c.edge(0, true, 0, e);
+  TEST_ASSERT_EQUAL_UINT32(30, c.nextDueMs(0));
+  c.edge(0, false, 30, e);
+  TEST_ASSERT_FALSE(c.pressed(0));
+  TEST_ASSERT_EQUAL_UINT32(ButtonClassifier::IDLE, c.nextDueMs(30));
+
+  // One tick later it has settled
+  c.edge(0, true, 100, e);
+  c.edge(0, false, 131, e);
+  TEST_ASSERT_TRUE(c.pressed(0));
+
+  classify({ { 0, 0, true }, { 30, 0, false }, { 60, 0, true }, { 400, 0, false } });
+  classify({ { 0, 0, true }, { 0, 1, true }, { 30, 1, false }, { 2100, 0, false } });
+}
+
+static void test_both_long_swallows_singles() {
+  // Both held: BOTH_LONG 2 s after the later press, releases stay silent
+  std::vector<Event> ev = classify({ { 0, 0, true }, { 100, 1, true }, { 2500, 0, false }, { 2600, 1, false } });
+  TEST_ASSERT_EQUAL_size_t(1, ev.size());
+  TEST_ASSERT_EQUAL_UINT8((uint8_t)Ev::BOTH_LONG, (uint8_t)ev[0].type);
+  TEST_ASSERT_EQUAL_UINT32(1000 + 130 + 2000, ev[0].ms);
+
+  // Hand-over: button 1 re-pressed at the instant button 2 settles
+  // released; the swallow carries on until both are up
+  ev = classify({
+    { 0, 0, true }, { 0, 1, true }, { 2200, 0, false },
+    { 2500, 1, false }, { 2500, 0, true }, { 2800, 0, false },
+  });
+  TEST_ASSERT_EQUAL_size_t(1, ev.size());
+
+  // Both up again: singles count
+  ev = classify({
+    { 0, 0, true }, { 0, 1, true }, { 2200, 0, false }, { 2300, 1, false },
+    { 2600, 1, true }, { 2800, 1, false },
+  });
+  TEST_ASSERT_EQUAL_size_t(2, ev.size());
+  TEST_ASSERT_EQUAL_UINT8((uint8_t)Ev::BTN2_SHORT, (uint8_t)ev[1].type);
+}
+
+static void test_random_edges_match_polled_loop() {
+  for (int trial = 0; trial < 1500; ++trial) {
+    const uint32_t t0 = (trial % 3 == 0) ? 0xFFFF0000u : 1000;     // across the millis() wrap
+    std::vector<Edge> edges;
+    for (uint8_t i = 0; i < 2; ++i) {
+      bool lvl = false;
+      for (uint32_t t = rnd() % 500; t < 8000; ) {
+        const uint32_t kind = rnd() % 10;
+        const uint32_t hold = kind < 4 ? 30 + rnd() % 400
+                            : kind < 8 ? 1500 + rnd() % 1500
+                            : 1 + rnd() % 40;                       // bounce
+        lvl = !lvl;
+        edges.push_back({ t, i, lvl });
+        t += hold;
+      }
+    }
+    std::stable_sort(edges.begin(), edges.end(), [](const Edge& a, const Edge& b) { return a.at < b.at; });
+    classify(edges, t0);
+  }
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_short_and_long);
+  RUN_TEST(test_bounce_is_filtered);
+  RUN_TEST(test_edge_at_settle_instant_restarts_debounce);
+  RUN_TEST(test_both_long_swallows_singles);
+  RUN_TEST(test_random_edges_match_polled_loop);
+  return UNITY_END();
+}
@@ -0,0 +1,55 @@
+// features/calibration_math.h on the fake load cell: tare, 100 g, scale
+#include <unity.h>
+#include "features/calibration_math.h"
+#include "hal/clock.h"
+#include "hal/fake.h"
+#include "hal/hx711_port.h"
+
+void setUp() { fake_clock_set_us(0); }
+void tearDown() {}
+
+static int32_t average_raw(uint16_t n) {
+  int64_t sum = 0;
+  for (uint16_t i = 0; i < n; ++i) sum += hal_hx711_read();
+  return (int32_t)(sum / n);
+}
+
+static void calibrate(float countsPerG, int32_t noise, uint32_t seed) {
+  fake_hx711_config({ 80, -52000, countsPerG, noise, seed });
+  fake_hx711_load(0, 0);
+  const int32_t zero = average_raw(50);
+  fake_hx711_load(CAL_MASS_MG, 200);
+  hal_delay_ms(2000);
+  const int32_t ref = average_raw(20);
+  TEST_ASSERT_TRUE(calibration_load_present(zero, ref));
+
+  int32_t q16 = 0;
+  TEST_ASSERT_TRUE(calibration_scale(zero, ref, CAL_MASS_MG, q16));
+  // 250 g must read back within 0.1 %
+  WeightScale s;
+  s.offset = zero;
+  s.mgPerCountQ16 = q16;
+  fake_hx711_load(250000, 0);
+  TEST_ASSERT_INT32_WITHIN(250, 250000, weight_raw_to_mg(average_raw(40), s));
+}
+
+static void test_positive_and_negative_cells() {
+  calibrate(420.0f, 150, 1);
+  calibrate(-420.0f, 150, 2);         // reversed wiring: negative scale, still reads +
+  calibrate(42.4f, 20, 3);
+}
+
+static void test_rejects_small_delta() {
+  int32_t q16 = 1234;
+  TEST_ASSERT_FALSE(calibration_scale(1000, 1000 + CAL_MIN_DELTA - 1, CAL_MASS_MG, q16));
+  TEST_ASSERT_EQUAL_INT32(1234, q16);                 // untouched
+  TEST_ASSERT_FALSE(calibration_load_present(1000, 1000 + CAL_PRESENT_COUNTS));
+  TEST_ASSERT_TRUE(calibration_load_present(1000, 1000 - CAL_PRESENT_COUNTS - 1));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_positive_and_negative_cells);
+  RUN_TEST(test_rejects_small_delta);
+  return UNITY_END();
+}
@@ -0,0 +1,112 @@
+// core/event_bus fan-out on the host: routing by type mask, publish order
+// and timestamp, full subscriber queues drop (counted) without blocking the
+// others, subscriber table limit
+#include <unity.h>
+#include "app_config.h"
+#include "core/event_bus.h"
+#include "hal/fake.h"
+
+// The bus keeps its subscribers for the life of the program; every test
+// starts with all of them drained
+static EventSub s_all[EVENT_MAX_SUBS];
+static uint8_t  s_n = 0;
+
+static EventSub sub(uint32_t mask, uint8_t depth) {
+  EventSub s = event_subscribe(mask, depth);
+  if (s) s_all[s_n++] = s;
+  return s;
+}
+
+static uint8_t drain(EventSub s) {
+  Event ev;
+  uint8_t n = 0;
+  while (event_receive(s, ev, 0)) n++;
+  return n;
+}
+
+void setUp() {
+  fake_clock_set_us(0);
+  for (uint8_t i = 0; i < s_n; ++i) drain(s_all[i]);
+}
+void tearDown() {}
+
+static void test_routes_by_mask_in_order() {
+  EventSub ui   = sub(event_bit(EventType::STATE), 4);
+  EventSub both = sub(event_bit(EventType::STATE) | event_bit(EventType::NET_OFFLINE), 4);
+  TEST_ASSERT_NOT_NULL(ui);
+  TEST_ASSERT_NOT_NULL(both);
+
+  fake_clock_set_us(1234000);
+  event_publish(EventType::NET_OFFLINE);
+  fake_clock_advance_us(5000);
+  event_publish(EventType::STATE, 0x21);
+
+  Event ev;
+  TEST_ASSERT_TRUE(event_receive(ui, ev, 0));
+  TEST_ASSERT_EQUAL_UINT8((uint8_t)EventType::STATE, (uint8_t)ev.type);
+  TEST_ASSERT_EQUAL_UINT32(0x21, ev.arg);
+  TEST_ASSERT_EQUAL_UINT32(1239, ev.ms);
+  TEST_ASSERT_FALSE(event_receive(ui, ev, 0));
+
+  TEST_ASSERT_TRUE(event_receive(both, ev, 0));
+  TEST_ASSERT_EQUAL_UINT8((uint8_t)EventType::NET_OFFLINE, (uint8_t)ev.type);
+  TEST_ASSERT_EQUAL_UINT32(1234, ev.ms);
+  TEST_ASSERT_TRUE(event_receive(both, ev, 0));
+  TEST_ASSERT_EQUAL_UINT8((uint8_t)EventType::STATE, (uint8_t)ev.type);
+  TEST_ASSERT_FALSE(event_receive(both, ev, 0));
+}
+
+// A slow subscriber loses the newest events; the others still get them
+static void test_full_queue_drops_and_counts() {
+  EventSub slow = sub(event_bit(EventType::STATE), 2);
+  EventSub fast = sub(event_bit(EventType::STATE), 8);
+  const uint32_t dropped0 = event_dropped();
+
+  for (uint32_t i = 1; i <= 4; ++i) event_publish(EventType::STATE, i);   // fits the depth-4 queues above
+
+  TEST_ASSERT_EQUAL_UINT32(2, event_dropped() - dropped0);
+  Event ev;
+  TEST_ASSERT_TRUE(event_receive(slow, ev, 0));
+  TEST_ASSERT_EQUAL_UINT32(1, ev.arg);
+  TEST_ASSERT_TRUE(event_receive(slow, ev, 0));
+  TEST_ASSERT_EQUAL_UINT32(2, ev.arg);
+  TEST_ASSERT_FALSE(event_receive(slow, ev, 0));
+  TEST_ASSERT_EQUAL_UINT8(4, drain(fast));
+
+  // Drained again, it picks up where the publisher is now
+  event_publish(EventType::STATE, 6);
+  TEST_ASSERT_TRUE(event_receive(slow, ev, 0));
+  TEST_ASSERT_EQUAL_UINT32(6, ev.arg);
+}
+
+static void test_unsubscribed_type_goes_nowhere() {
+  const uint32_t dropped0 = event_dropped();
+  EventSub none = sub(0, 1);
+  TEST_ASSERT_NOT_NULL(none);
+  for (int i = 0; i < 4; ++i) event_publish(EventType::NET_OFFLINE);
+  TEST_ASSERT_EQUAL_UINT8(0, drain(none));
+  TEST_ASSERT_EQUAL_UINT32(0, event_dropped() - dropped0);
+}
+
+static void test_table_full_returns_null() {
+  Event ev;
+  TEST_ASSERT_FALSE(event_receive(nullptr, ev, 0));
+  while (s_n < EVENT_MAX_SUBS) TEST_ASSERT_NOT_NULL(sub(event_bit(EventType::STATE), 0));
+  TEST_ASSERT_NULL(event_subscribe(event_bit(EventType::STATE), 4));
+
+  // depth 0 means 1; a full table still delivers to everyone in it
+  event_publish(EventType::STATE, 7);
+  event_publish(EventType::STATE, 8);
+  TEST_ASSERT_TRUE(event_receive(s_all[EVENT_MAX_SUBS - 1], ev, 0));
+  TEST_ASSERT_EQUAL_UINT32(7, ev.arg);
+  TEST_ASSERT_FALSE(event_receive(s_all[EVENT_MAX_SUBS - 1], ev, 0));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_routes_by_mask_in_order);
+  RUN_TEST(test_full_queue_drops_and_counts);
+  RUN_TEST(test_unsubscribed_type_goes_nowhere);
+  RUN_TEST(test_table_full_returns_null);
+  return UNITY_END();
+}
@@ -0,0 +1,137 @@
+// features/filter_chain: exactness, rate detection from conversion stamps,
+// then a sweep of CIC order, decimation and post stage over the fake cell at
+// 80 SPS, reporting output noise and step latency per configuration
+// (pio test -e native -v shows the table)
+#include <unity.h>
+#include <stdio.h>
+#include "features/filter_chain.h"
+#include "hal/clock.h"
+#include "hal/fake.h"
+#include "hal/hx711_port.h"
+
+static constexpr uint16_t SPS      = 80;
+static constexpr int32_t  NOISE    = 600;      // ± counts, uniform: σ ≈ 346 mg at 1000 counts/g
+static constexpr int32_t  STEP_MG  = 100000;
+
+void setUp() {
+  fake_clock_set_us(0);
+  fake_hx711_config({ SPS, 0, 1000.0f, NOISE, 1 });   // 1 count = 1 mg
+  fake_hx711_load(0, 0);
+  hal_hx711_begin(1, 10, 128);
+}
+void tearDown() {}
+
+static void test_dc_passes_exactly() {
+  for (uint8_t n = 1; n <= FilterChain::MAX_ORDER; ++n) {
+    for (uint8_t post = 0; post <= (uint8_t)FilterPost::FIR5; ++post) {
+      FilterChain f({ SPS, n, 8, (FilterPost)post });
+      int32_t out = 0, outs = 0;
+      for (int i = 0; i < 400; ++i) {
+        if (f.push(-1234567, out)) { outs++; TEST_ASSERT_EQUAL_INT32(-1234567, out); }
+      }
+      TEST_ASSERT_GREATER_THAN(40, outs);
+    }
+  }
+}
+
+static void test_integrators_survive_wrap() {
+  FilterChain f({ SPS, 3, 16, FilterPost::NONE });
+  int32_t out = 0;
+  for (uint32_t i = 0; i < 2000000; ++i) {
+    if (f.push(INT32_MAX, out)) TEST_ASSERT_EQUAL_INT32(INT32_MAX, out);
+  }
+}
+
+static void test_median_kills_single_spike() {
+  FilterChain f({ SPS, 1, 1, FilterPost::MEDIAN3 });
+  int32_t out = 0;
+  for (int i = 0; i < 20; ++i) {
+    if (f.push(i == 10 ? 5000000 : 1000, out)) TEST_ASSERT_EQUAL_INT32(1000, out);
+  }
+}
+
+struct SweepResult {
+  int32_t  sigmaMg;      // output σ with no load
+  uint32_t halfMs;       // step → first output past 50 %
+  uint32_t settleMs;     // step → output within SETTLE_MG of the load for good
+};
+static constexpr int32_t SETTLE_MG = 1000;
+
+static SweepResult sweep_one(const FilterChainConfig& cfg) {
+  fake_hx711_load(0, 0);
+  FilterChain f(cfg);
+  NoiseMeter noise(200);
+  int32_t out = 0;
+  while (!(f.push(hal_hx711_read(), out) && noise.push(out))) {}
+
+  SweepResult r{ noise.stddevMg(), 0, 0 };
+  fake_hx711_load(STEP_MG, 0);
+  const uint32_t t0 = hal_millis();
+  while (hal_millis() - t0 < 4000) {
+    if (!f.push(hal_hx711_read(), out)) continue;
+    const uint32_t dt = hal_millis() - t0;
+    if (!r.halfMs && out >= STEP_MG / 2) r.halfMs = dt;
+    const int32_t err = out > STEP_MG ? out - STEP_MG : STEP_MG - out;
+    if (err > SETTLE_MG)  r.settleMs = 0;
+    else if (!r.settleMs) r.settleMs = dt;
+  }
+  return r;
+}
+
+static void test_sweep_noise_and_latency() {
+  static const uint8_t kDecim[] = { 4, 8, 16 };
+  printf("\n  config             out Hz   sigma mg   group ms   50%% ms   settle ms\n");
+  for (uint8_t post = 0; post <= (uint8_t)FilterPost::FIR5; ++post) {
+    for (uint8_t n = 1; n <= FilterChain::MAX_ORDER; ++n) {
+      int32_t sigmaFirst = 0;
+      for (uint8_t d : kDecim) {
+        const FilterChainConfig cfg{ SPS, n, d, (FilterPost)post };
+        FilterChain f(cfg);
+        const SweepResult r = sweep_one(cfg);
+        char label[32];
+        f.describe(label, sizeof(label));
+        printf("  %-18s %6.1f %10ld %10lu %8lu %11lu\n", label, (double)SPS / d, (long)r.sigmaMg,
+               (unsigned long)f.latencyMs(), (unsigned long)r.halfMs, (unsigned long)r.settleMs);
+
+        // The 50 % crossing is the group delay, give or take one output
+        TEST_ASSERT_UINT32_WITHIN(f.outPeriodMs(), f.latencyMs(), r.halfMs);
+        TEST_ASSERT_GREATER_THAN_UINT32(0, r.settleMs);
+        if (d == kDecim[0]) sigmaFirst = r.sigmaMg;
+        else                TEST_ASSERT_LESS_THAN(sigmaFirst, r.sigmaMg);   // more averaging, less noise
+      }
+    }
+  }
+}
+
+// A strapped board: the rate comes from the spacing of the conversions, and
+// the chain built from it reports the latency a step actually sees
+static void test_rate_from_stamps_sets_time_base() {
+  static const uint16_t kRates[] = { 10, 80 };
+  for (uint16_t sps : kRates) {
+    fake_clock_set_us(0xFFFFFFFFull - 250000);     // micros() wraps mid-measurement
+    fake_hx711_config({ sps, 0, 1000.0f, NOISE, 1 });
+    uint32_t us[9];
+    for (uint32_t& t : us) { (void)hal_hx711_read(); t = hal_micros(); }
+    us[4] += 40000;                                  // one late wakeup
+    TEST_ASSERT_EQUAL_UINT16(sps, filter_rate_from_stamps(us, 9));
+
+    const FilterChainConfig cfg{ sps, 2, (uint8_t)(sps / 10), FilterPost::MEDIAN3 };
+    FilterChain f(cfg);
+    TEST_ASSERT_EQUAL_UINT32(100, f.outPeriodMs());
+    const SweepResult r = sweep_one(cfg);
+    TEST_ASSERT_UINT32_WITHIN(f.outPeriodMs(), f.latencyMs(), r.halfMs);
+  }
+  const uint32_t few[2] = { 0, 100000 }, stalled[4] = { 0, 1000000, 2000000, 3000000 };
+  TEST_ASSERT_EQUAL_UINT16(0, filter_rate_from_stamps(few, 2));
+  TEST_ASSERT_EQUAL_UINT16(0, filter_rate_from_stamps(stalled, 4));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_dc_passes_exactly);
+  RUN_TEST(test_integrators_survive_wrap);
+  RUN_TEST(test_median_kills_single_spike);
+  RUN_TEST(test_rate_from_stamps_sets_time_base);
+  RUN_TEST(test_sweep_noise_and_latency);
+  return UNITY_END();
+}
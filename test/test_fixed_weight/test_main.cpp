@@ -0,0 +1,117 @@
+// util/fixed_weight.h: the Q16 integer path against the float math it
+// replaced, formatting (results and cost against printf) and isqrt
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "util/fixed_weight.h"
+#include "../test_support.h"
+
+static int32_t rnd_raw() { return (int32_t)(rnd() % 0x1000000) - 0x800000; }   // 24-bit ADC
+
+void setUp() { rnd_reset(); }
+void tearDown() {}
+
+// Old path: get_units() style float grams
+static float float_grams(int32_t raw, int32_t offset, float countsPerG) {
+  return (float)(raw - offset) / countsPerG;
+}
+
+// Rounding is exact for the Q16 scale; against the true counts/g the error
+// is the scale's quantisation (a few counts of 2^-16 per count), reported
+// beside the float path it replaced
+static void test_matches_float_path() {
+  static const float kScales[] = { 420.0f, -420.0f, 42.4f, 1234.5f, 2.1f };
+  for (float cpg : kScales) {
+    WeightScale s;
+    s.offset = -52000;
+    s.mgPerCountQ16 = weight_scale_from_counts_per_g(cpg);
+    TEST_ASSERT_FLOAT_WITHIN(fabsf(cpg) * 1e-5f, cpg, weight_scale_to_counts_per_g(s.mgPerCountQ16));
+
+    double worstInt = 0, worstFloat = 0;
+    for (int i = 0; i < 100000; ++i) {
+      const int32_t raw = rnd_raw();
+      const int64_t d = (int64_t)raw - s.offset;
+      const double exact = (double)d * 1000.0 / cpg;
+      if (fabs(exact) > 2e9) continue;                  // past ±2 t the result is not an int32 mg
+      const int32_t mg = weight_raw_to_mg(raw, s);
+      TEST_ASSERT_TRUE(fabs(mg - (double)d * s.mgPerCountQ16 / WEIGHT_Q_ONE) <= 0.5);
+
+      const double errInt   = fabs(mg - exact);
+      const double errFloat = fabs(float_grams(raw, s.offset, cpg) * 1000.0 - exact);
+      TEST_ASSERT_TRUE(errInt <= 1.0 + fabs((double)d) * 3.0 / WEIGHT_Q_ONE);
+      if (errInt > worstInt)     worstInt = errInt;
+      if (errFloat > worstFloat) worstFloat = errFloat;
+    }
+    printf("\n  %8.1f counts/g: worst error Q16 %.1f mg, float %.1f mg", cpg, worstInt, worstFloat);
+  }
+  printf("\n");
+}
+
+static void test_scale_from_delta() {
+  TEST_ASSERT_EQUAL_INT32(0, weight_scale_from_delta(0, 100000));
+  WeightScale s;
+  s.offset = 1000;
+  s.mgPerCountQ16 = weight_scale_from_delta(42000, 100000);
+  TEST_ASSERT_EQUAL_INT32(100000, weight_raw_to_mg(43000, s));
+  TEST_ASSERT_EQUAL_INT32(-100000, weight_raw_to_mg(-41000, s));
+  TEST_ASSERT_EQUAL_INT32(0, weight_raw_to_mg(1000, s));
+}
+
+static void test_format_matches_printf() {
+  char got[24], ref[24];
+  for (int i = 0; i < 200000; ++i) {
+    const int32_t mg = (i < 2000) ? i - 1000 : (int32_t)(rnd() % 20000001) - 10000000;
+    for (uint8_t d = 0; d <= 3; ++d) {
+      weight_format_g(got, sizeof(got), mg, d);
+      // reference in integers: printf of a double would round differently on .5
+      const int32_t step = d == 0 ? 1000 : d == 1 ? 100 : d == 2 ? 10 : 1;
+      const int64_t q = (llabs(mg) + step / 2) / step;
+      const int64_t unit = 1000 / step;
+      if (d == 0) snprintf(ref, sizeof(ref), "%s%lld", (mg < 0 && q) ? "-" : "", (long long)q);
+      else        snprintf(ref, sizeof(ref), "%s%lld.%0*lld", (mg < 0 && q) ? "-" : "",
+                           (long long)(q / unit), (int)d, (long long)(q % unit));
+      TEST_ASSERT_EQUAL_STRING(ref, got);
+    }
+  }
+  weight_format_g(got, sizeof(got), -4, 2);
+  TEST_ASSERT_EQUAL_STRING("0.00", got);                // no "-0.00"
+  weight_format_g(got, sizeof(got), 123456, 2);
+  TEST_ASSERT_EQUAL_STRING("123.46", got);
+}
+
+static void test_isqrt() {
+  for (uint64_t v = 0; v < 100000; ++v) {
+    const uint64_t r = weight_isqrt64(v);
+    TEST_ASSERT_TRUE(r * r <= v && (r + 1) * (r + 1) > v);
+  }
+  TEST_ASSERT_EQUAL_UINT32(0xFFFFFFFFu, weight_isqrt64(UINT64_MAX));
+  TEST_ASSERT_EQUAL_UINT32(3000000000u, weight_isqrt64(9000000000000000000ull));
+}
+
+// Q16 against float is a soft-float question for the C3, not for this
+// host; formatting is not: the integer formatter beats printf("%.2f")
+static void test_format_cheaper_than_printf() {
+  static int32_t raws[4096];
+  for (int32_t& r : raws) r = rnd_raw();
+  char g[16];
+  size_t sink = 0;
+  const double fixed = host_ns_per_call(200000, [&](uint32_t i) {
+    sink += (size_t)weight_format_g(g, sizeof(g), raws[i & 4095], 2);
+  });
+  const double pf = host_ns_per_call(200000, [&](uint32_t i) {
+    sink += (size_t)snprintf(g, sizeof(g), "%.2f", raws[i & 4095] / 1000.0f);
+  });
+  printf("\n  format: integer %.1f ns vs %%.2f %.1f ns (%u)\n", fixed, pf, (unsigned)(sink & 1));
+  TEST_ASSERT_TRUE(fixed < pf);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_matches_float_path);
+  RUN_TEST(test_scale_from_delta);
+  RUN_TEST(test_format_matches_printf);
+  RUN_TEST(test_isqrt);
+  RUN_TEST(test_format_cheaper_than_printf);
+  return UNITY_END();
+}
@@ -0,0 +1,133 @@
+// hal/fake.cpp: the host stand-ins the other suites and the simulator build on
+#include <unity.h>
+#include <stdio.h>
+#include "hal/clock.h"
+#include "hal/fake.h"
+#include "hal/gpio.h"
+#include "hal/hx711_port.h"
+#include "hal/http_port.h"
+#include "storage/nvs_store.h"
+
+void setUp() {
+  fake_clock_set_us(0);
+  fake_nvs_clear();
+  fake_nvs_fail_writes(false);
+  fake_http_reset();
+  fake_http_set_handler(nullptr);
+  fake_http_set_status(200);
+}
+void tearDown() {}
+
+static void test_clock_moves_only_when_told() {
+  TEST_ASSERT_EQUAL_UINT32(0, hal_millis());
+  hal_delay_ms(25);
+  TEST_ASSERT_EQUAL_UINT32(25, hal_millis());
+  fake_clock_advance_us(1500);
+  TEST_ASSERT_EQUAL_UINT32(26, hal_millis());
+  TEST_ASSERT_EQUAL_UINT32(26500, hal_micros());
+}
+
+static int s_falls = 0;
+static void on_fall() { s_falls++; }
+
+static void test_gpio_falling_edge_handler() {
+  s_falls = 0;
+  hal_gpio_input(4);
+  hal_gpio_on_falling(4, on_fall);
+  fake_gpio_set(4, true);
+  fake_gpio_set(4, false);
+  fake_gpio_set(4, false);          // no edge
+  TEST_ASSERT_EQUAL_INT(1, s_falls);
+  hal_gpio_detach(4);
+  fake_gpio_set(4, true);
+  fake_gpio_set(4, false);
+  TEST_ASSERT_EQUAL_INT(1, s_falls);
+
+  hal_gpio_output(5);
+  hal_gpio_write(5, false);
+  TEST_ASSERT_TRUE(fake_gpio_is_output(5));
+  TEST_ASSERT_FALSE(fake_gpio_get(5));
+}
+
+static void test_hx711_paces_the_clock_and_settles() {
+  fake_hx711_config({ 80, 1000, 100.0f, 0, 1 });
+  TEST_ASSERT_TRUE(hal_hx711_begin(1, 10, 128));
+  TEST_ASSERT_FALSE(hal_hx711_ready());
+  TEST_ASSERT_EQUAL_INT32(1000, hal_hx711_read());    // blocks one period
+  TEST_ASSERT_EQUAL_UINT32(12, hal_millis());         // 12.5 ms at 80 SPS
+
+  fake_hx711_load(100000, 100);                       // 100 g, τ = 100 ms
+  const int32_t first = hal_hx711_read() - 1000;
+  TEST_ASSERT_TRUE(first > 0 && first < 10000);       // still far from 100 g · 100 counts/g
+  hal_delay_ms(1000);                                 // 10 τ
+  TEST_ASSERT_INT32_WITHIN(2, 10000, hal_hx711_read() - 1000);
+  TEST_ASSERT_EQUAL_UINT32(3, fake_hx711_reads());
+}
+
+static void test_hx711_noise_is_bounded_and_seeded() {
+  int32_t a[32], b[32];
+  fake_hx711_config({ 80, 0, 100.0f, 50, 7 });
+  fake_hx711_load(0, 0);
+  for (int i = 0; i < 32; ++i) { a[i] = hal_hx711_read(); TEST_ASSERT_INT32_WITHIN(50, 0, a[i]); }
+  fake_hx711_config({ 80, 0, 100.0f, 50, 7 });
+  for (int i = 0; i < 32; ++i) b[i] = hal_hx711_read();
+  TEST_ASSERT_EQUAL_MEMORY(a, b, sizeof(a));
+}
+
+static void test_nvs_roundtrip_and_faults() {
+  TEST_ASSERT_TRUE(nvs_init());
+  float f = 0;
+  uint32_t u = 0;
+  TEST_ASSERT_FALSE(nvs_load_float("cal_scale", f));
+  TEST_ASSERT_TRUE(nvs_save_float("cal_scale", 42.5f));
+  TEST_ASSERT_TRUE(nvs_load_float("cal_scale", f));
+  TEST_ASSERT_FLOAT_WITHIN(0.0001f, 42.5f, f);
+
+  struct Blob { uint32_t a, b; } in{ 1, 2 }, out{};
+  TEST_ASSERT_TRUE(nvs_save_blob("blob", &in, sizeof(in)));
+  TEST_ASSERT_FALSE(nvs_load_blob("blob", &u, sizeof(u)));          // size must match
+  TEST_ASSERT_TRUE(nvs_load_blob("blob", &out, sizeof(out)));
+  TEST_ASSERT_EQUAL_UINT32(2, out.b);
+
+  fake_nvs_fail_writes(true);
+  TEST_ASSERT_FALSE(nvs_save_u32("seq", 5));
+  TEST_ASSERT_FALSE(nvs_load_u32("seq", u));
+  fake_nvs_fail_writes(false);
+  TEST_ASSERT_TRUE(nvs_remove_key("blob"));
+  TEST_ASSERT_EQUAL_size_t(1, fake_nvs_keys());
+}
+
+static int teapot(const char*, const char*, const uint8_t*, size_t, char* resp, size_t cap) {
+  snprintf(resp, cap, "short and stout");
+  return 418;
+}
+
+static void test_http_records_and_replies() {
+  const uint8_t body[] = { 1, 2, 3 };
+  char resp[32];
+  fake_http_set_status(503);
+  TEST_ASSERT_EQUAL_INT(503, hal_http_post("/b", "application/x", body, sizeof(body), resp, sizeof(resp)));
+  TEST_ASSERT_EQUAL_STRING("", resp);
+
+  fake_http_set_handler(teapot);
+  TEST_ASSERT_EQUAL_INT(418, hal_http_post("/t", "text/plain", body, 2, resp, sizeof(resp)));
+  TEST_ASSERT_EQUAL_STRING("", resp);               // body only on 2xx, like the device
+
+  const FakeHttpStats& st = fake_http_stats();
+  TEST_ASSERT_EQUAL_UINT32(2, st.posts);
+  TEST_ASSERT_EQUAL_UINT32(5, st.bytes);
+  TEST_ASSERT_EQUAL_STRING("/t", st.lastPath);
+  TEST_ASSERT_EQUAL_STRING("text/plain", st.lastType);
+  TEST_ASSERT_EQUAL_size_t(2, st.lastLen);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_clock_moves_only_when_told);
+  RUN_TEST(test_gpio_falling_edge_handler);
+  RUN_TEST(test_hx711_paces_the_clock_and_settles);
+  RUN_TEST(test_hx711_noise_is_bounded_and_seeded);
+  RUN_TEST(test_nvs_roundtrip_and_faults);
+  RUN_TEST(test_http_records_and_replies);
+  return UNITY_END();
+}
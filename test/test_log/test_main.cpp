@@ -0,0 +1,292 @@
+// util/log on the host (hal/serial.h captured by the fake): sync path before
+// log_start(), queue + flush, level filter, truncation, ring overflow and
+// its drop report, concurrent producers against the drain, binary frames
+// (sync and queued)
+#include <unity.h>
+#include <atomic>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include "app_config.h"
+#include "hal/fake.h"
+#include "hal/serial.h"
+#include "util/log.h"
+
+static LogStats s_base;
+
+static LogStats delta() {
+  LogStats s;
+  log_get_stats(s);
+  return { s.written - s_base.written, s.dropped - s_base.dropped,
+           s.truncated - s_base.truncated, s.highWater };
+}
+
+// Output lines without their "\r\n"
+static std::vector<std::string> lines() {
+  std::vector<std::string> out;
+  const std::string& s = fake_serial_output();
+  size_t at = 0;
+  for (size_t e; (e = s.find("\r\n", at)) != std::string::npos; at = e + 2) out.push_back(s.substr(at, e - at));
+  TEST_ASSERT_EQUAL_size_t(s.size(), at);   // nothing half-written
+  return out;
+}
+
+// "[LOG] dropped N lines (ring full)" → N, else -1
+static long dropped_report(const std::string& l) {
+  unsigned long n;
+  return sscanf(l.c_str(), "[LOG] dropped %lu lines", &n) == 1 ? (long)n : -1;
+}
+
+// Binary trace frames: 0xA5 | len | level | ms | id + args | xor(len..args)
+struct Frame {
+  uint8_t     level;
+  uint32_t    ms;
+  std::string payload;
+};
+
+static std::vector<Frame> frames() {
+  std::vector<Frame> out;
+  const std::string& s = fake_serial_output();
+  size_t at = 0;
+  while (at < s.size()) {
+    TEST_ASSERT_EQUAL_HEX8(0xA5, (uint8_t)s[at]);
+    TEST_ASSERT_TRUE(at + 2 <= s.size());
+    const size_t len = (uint8_t)s[at + 1];             // level + ms + payload
+    TEST_ASSERT_TRUE(len >= 5 && at + 3 + len <= s.size());
+    uint8_t x = 0;
+    for (size_t i = at + 1; i < at + 2 + len; ++i) x ^= (uint8_t)s[i];
+    TEST_ASSERT_EQUAL_HEX8(x, (uint8_t)s[at + 2 + len]);
+    Frame f;
+    f.level = (uint8_t)s[at + 2];
+    memcpy(&f.ms, s.data() + at + 3, 4);
+    f.payload = s.substr(at + 7, len - 5);
+    out.push_back(f);
+    at += 3 + len;
+  }
+  return out;
+}
+
+static uint32_t u32_at(const std::string& p, size_t off) {
+  uint32_t v = 0;
+  TEST_ASSERT_TRUE(off + 4 <= p.size());
+  memcpy(&v, p.data() + off, 4);
+  return v;
+}
+
+static constexpr uint32_t ID_BIN = LogId<log_fnv1a("T\x1f" "t=%d i=%d k=%d %s")>::value;
+
+void setUp() {
+  log_flush(0);
+  log_set_level(LOG_LVL_INFO);
+  fake_serial_clear();
+  log_get_stats(s_base);
+}
+
+void tearDown() {}
+
+// Runs first: nothing is queued before log_start()
+static void test_sync_before_start() {
+  LOGI("T", "x=%d", 5);
+  TEST_ASSERT_EQUAL_STRING("[T] x=5\r\n", fake_serial_output().c_str());
+  LOGD("T", "compiled out");
+  log_set_level(LOG_LVL_WARN);
+  LOGI("T", "filtered");
+  LOGW("T", "kept");
+  TEST_ASSERT_EQUAL_STRING("[T] x=5\r\n[T] kept\r\n", fake_serial_output().c_str());
+  TEST_ASSERT_EQUAL_UINT32(0, delta().written);      // the sync path does not queue
+}
+
+// Threads on the synchronous binary path (before log_start) each format in
+// their own buffer: every frame is whole and carries its own thread's args
+// (a shared buffer fails here most runs; -fsanitize=thread flags it always)
+static void test_bin_sync_threads_do_not_share_a_buffer() {
+  static constexpr int THREADS = 4;
+  static constexpr int PER     = 20000;
+  std::vector<std::thread> th;
+  for (int t = 0; t < THREADS; ++t) {
+    th.emplace_back([t] {
+      char name[LOG_BIN_STR_MAX + 1];
+      snprintf(name, sizeof(name), "%0*d", LOG_BIN_STR_MAX, t);     // longest string: widest window
+      for (int i = 0; i < PER; ++i) log_bin(LOG_LVL_INFO, ID_BIN, t, i, (int32_t)(t * 100000 + i), name);
+    });
+  }
+  for (std::thread& x : th) x.join();
+
+  int last[THREADS];
+  for (int& v : last) v = -1;
+  const std::vector<Frame> f = frames();
+  TEST_ASSERT_EQUAL_size_t(THREADS * PER, f.size());
+  for (const Frame& fr : f) {
+    TEST_ASSERT_EQUAL_UINT8(LOG_LVL_INFO, fr.level);
+    TEST_ASSERT_EQUAL_size_t(4 + 4 + 4 + 4 + 1 + LOG_BIN_STR_MAX, fr.payload.size());
+    TEST_ASSERT_EQUAL_HEX32(ID_BIN, u32_at(fr.payload, 0));
+    const int t = (int)u32_at(fr.payload, 4), i = (int)u32_at(fr.payload, 8);
+    TEST_ASSERT_TRUE(t >= 0 && t < THREADS);
+    TEST_ASSERT_EQUAL_INT32(t * 100000 + i, (int32_t)u32_at(fr.payload, 12));
+    char name[LOG_BIN_STR_MAX + 1];
+    snprintf(name, sizeof(name), "%0*d", LOG_BIN_STR_MAX, t);
+    TEST_ASSERT_EQUAL_UINT8(LOG_BIN_STR_MAX, (uint8_t)fr.payload[16]);
+    TEST_ASSERT_EQUAL_STRING(name, fr.payload.substr(17).c_str());
+    TEST_ASSERT_GREATER_THAN_INT(last[t], i);
+    last[t] = i;
+  }
+  TEST_ASSERT_EQUAL_UINT32(0, delta().written);
+}
+
+static void test_queued_until_flush() {
+  log_start();
+  LOGI("A", "one");
+  LOGW("B", "two %s", "x");
+  LOGE("C", "three %u", 3u);
+  TEST_ASSERT_EQUAL_size_t(0, fake_serial_output().size());
+  TEST_ASSERT_EQUAL_UINT32(3, delta().written);
+  TEST_ASSERT_TRUE(log_flush(100));
+  TEST_ASSERT_EQUAL_STRING("[A] one\r\n[B] two x\r\n[C] three 3\r\n", fake_serial_output().c_str());
+
+  log_set_level(LOG_LVL_ERROR);
+  LOGW("B", "filtered");
+  TEST_ASSERT_EQUAL_UINT32(3, delta().written);
+  log_set_level(LOG_LVL_DEBUG);                       // capped at LOG_COMPILE_LEVEL
+  TEST_ASSERT_EQUAL_UINT8(LOG_COMPILE_LEVEL, log_get_level());
+}
+
+static void test_long_line_truncated_and_counted() {
+  char big[LOG_LINE_MAX * 2];
+  memset(big, 'x', sizeof(big) - 1);
+  big[sizeof(big) - 1] = '\0';
+  LOGI("T", "%s", big);
+  LOGI("T", "%.*s", (int)(LOG_LINE_MAX - 1), big);    // fits exactly
+  log_flush(100);
+  const std::vector<std::string> l = lines();
+  TEST_ASSERT_EQUAL_size_t(2, l.size());
+  TEST_ASSERT_EQUAL_size_t(4 + LOG_LINE_MAX - 1, l[0].size());
+  TEST_ASSERT_TRUE(l[0] == l[1]);
+  TEST_ASSERT_EQUAL_UINT32(1, delta().truncated);
+}
+
+static void test_overflow_drops_counted_and_reported() {
+  const uint32_t extra = 10;
+  for (uint32_t i = 0; i < LOG_RING_SLOTS + extra; ++i) LOGI("T", "n=%lu", (unsigned long)i);
+  LogStats d = delta();
+  TEST_ASSERT_EQUAL_UINT32(LOG_RING_SLOTS, d.written);
+  TEST_ASSERT_EQUAL_UINT32(extra, d.dropped);
+  TEST_ASSERT_EQUAL_UINT32(LOG_RING_SLOTS, d.highWater);
+
+  TEST_ASSERT_TRUE(log_flush(100));
+  std::vector<std::string> l = lines();
+  TEST_ASSERT_EQUAL_size_t(LOG_RING_SLOTS + 1, l.size());
+  for (uint32_t i = 0; i < LOG_RING_SLOTS; ++i) {       // the oldest survive, in order
+    char want[24];
+    snprintf(want, sizeof(want), "[T] n=%lu", (unsigned long)i);
+    TEST_ASSERT_EQUAL_STRING(want, l[i].c_str());
+  }
+  TEST_ASSERT_EQUAL_INT32((long)extra, dropped_report(l.back()));
+
+  // Reported once; the ring is usable again on the next lap
+  fake_serial_clear();
+  log_flush(100);
+  TEST_ASSERT_EQUAL_size_t(0, fake_serial_output().size());
+  LOGI("T", "after");
+  log_flush(100);
+  TEST_ASSERT_EQUAL_STRING("[T] after\r\n", fake_serial_output().c_str());
+  TEST_ASSERT_EQUAL_UINT32(extra, delta().dropped);
+}
+
+// Binary frames through the ring: argument encoding by type, the clock
+// stamp, and an over-long argument list cut back to the ID (counted)
+static void test_bin_queued_frames() {
+  fake_clock_set_us(1234567);
+  const int64_t big = -5000000000LL;
+  const void* ptr = (const void*)(uintptr_t)0x3FC81234u;
+  log_bin(LOG_LVL_WARN, 0x11223344u, (uint8_t)7, big, 2.5, "ab", ptr);
+  log_bin(LOG_LVL_DEBUG, 0x55667788u, 1);                      // above the run-time level
+
+  char s48[LOG_BIN_STR_MAX + 8];
+  memset(s48, 's', sizeof(s48) - 1);
+  s48[sizeof(s48) - 1] = '\0';
+  log_bin(LOG_LVL_ERROR, 0x99AABBCCu, s48, s48, s48);          // 4 + 3 · 49 > LOG_LINE_MAX
+  TEST_ASSERT_EQUAL_size_t(0, fake_serial_output().size());
+  TEST_ASSERT_TRUE(log_flush(100));
+
+  const std::vector<Frame> f = frames();
+  TEST_ASSERT_EQUAL_size_t(2, f.size());
+  TEST_ASSERT_EQUAL_UINT8(LOG_LVL_WARN, f[0].level);
+  TEST_ASSERT_EQUAL_UINT32(1234, f[0].ms);
+  const std::string& p = f[0].payload;
+  TEST_ASSERT_EQUAL_size_t(4 + 4 + 8 + 4 + 3 + 4, p.size());
+  TEST_ASSERT_EQUAL_HEX32(0x11223344u, u32_at(p, 0));
+  TEST_ASSERT_EQUAL_UINT32(7, u32_at(p, 4));
+  int64_t gotBig;
+  memcpy(&gotBig, p.data() + 8, 8);
+  TEST_ASSERT_TRUE(gotBig == big);
+  float gotF;
+  memcpy(&gotF, p.data() + 16, 4);
+  TEST_ASSERT_FLOAT_WITHIN(0.0f, 2.5f, gotF);
+  TEST_ASSERT_EQUAL_UINT8(2, (uint8_t)p[20]);
+  TEST_ASSERT_EQUAL_STRING("ab", p.substr(21, 2).c_str());
+  TEST_ASSERT_EQUAL_HEX32(0x3FC81234u, u32_at(p, 23));
+
+  TEST_ASSERT_EQUAL_UINT8(LOG_LVL_ERROR, f[1].level);
+  TEST_ASSERT_EQUAL_size_t(4, f[1].payload.size());
+  TEST_ASSERT_EQUAL_HEX32(0x99AABBCCu, u32_at(f[1].payload, 0));
+  const LogStats d = delta();
+  TEST_ASSERT_EQUAL_UINT32(2, d.written);
+  TEST_ASSERT_EQUAL_UINT32(1, d.truncated);
+}
+
+// Producers on other threads while this one drains: every line is either
+// written whole, in its producer's order, or counted as dropped, and the
+// drop reports add up to the counter
+static void test_concurrent_producers() {
+  static constexpr int THREADS = 4;
+  static constexpr int PER     = 5000;
+  std::atomic<int> done{0};
+  std::vector<std::thread> th;
+  for (int t = 0; t < THREADS; ++t) {
+    th.emplace_back([t, &done] {
+      for (int i = 0; i < PER; ++i) {
+        LOGI("P", "t=%d i=%d", t, i);
+        if (i % 4 == 3) std::this_thread::yield();   // bursts: both lines and drops occur
+      }
+      done.fetch_add(1);
+    });
+  }
+  while (done.load() < THREADS) log_flush(0);
+  for (std::thread& x : th) x.join();
+  while (!log_flush(0)) {}
+
+  int last[THREADS];
+  for (int& v : last) v = -1;
+  uint32_t got = 0, reported = 0;
+  for (const std::string& l : lines()) {
+    const long d = dropped_report(l);
+    if (d >= 0) { reported += (uint32_t)d; continue; }
+    int t, i;
+    TEST_ASSERT_EQUAL_INT(2, sscanf(l.c_str(), "[P] t=%d i=%d", &t, &i));
+    TEST_ASSERT_TRUE(t >= 0 && t < THREADS);
+    TEST_ASSERT_GREATER_THAN_INT(last[t], i);
+    last[t] = i;
+    got++;
+  }
+  const LogStats d = delta();
+  TEST_ASSERT_EQUAL_UINT32(THREADS * PER, d.written + d.dropped);
+  TEST_ASSERT_EQUAL_UINT32(d.written, got);
+  TEST_ASSERT_EQUAL_UINT32(d.dropped, reported);
+  printf("\n  %d producers x %d lines: %lu written, %lu dropped (ring %lu slots)\n",
+         THREADS, PER, (unsigned long)d.written, (unsigned long)d.dropped, (unsigned long)LOG_RING_SLOTS);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_sync_before_start);
+  RUN_TEST(test_bin_sync_threads_do_not_share_a_buffer);
+  RUN_TEST(test_queued_until_flush);
+  RUN_TEST(test_long_line_truncated_and_counted);
+  RUN_TEST(test_overflow_drops_counted_and_reported);
+  RUN_TEST(test_bin_queued_frames);
+  RUN_TEST(test_concurrent_producers);
+  return UNITY_END();
+}
@@ -0,0 +1,167 @@
+// features/measurement_logic + stability_detector: trigger, settle, the
+// final value of a load that is still ringing down when the window goes
+// stable, and early-settle estimates: emitted, confirmed, or corrected
+#include <math.h>
+#include <unity.h>
+#include "features/measurement_logic.h"
+#include "features/stability_detector.h"
+#include "features/measurement.h"
+
+static constexpr int32_t  DELTA_MG = 20000;
+static constexpr int32_t  BAND_MG  = 6000;
+static constexpr uint32_t WIN_MS   = 800;
+static constexpr uint32_t STEP_MS  = 100;    // 10 Hz filter output
+
+static MeasurementLogic::Params params() {
+  return { DELTA_MG, WIN_MS, BAND_MG, false, 70, { 6, 1500, 50000, 62259 } };
+}
+
+void setUp() {}
+void tearDown() {}
+
+// Feeds 'toMg' approached from 'fromMg' with time constant tauMs; returns
+// the settled weight (valueMg = INT32_MIN if none within timeoutMs)
+static MeasurementLogic::Weight settle(MeasurementLogic& m, uint32_t& now, int32_t fromMg,
+                                       int32_t toMg, uint32_t tauMs, uint32_t timeoutMs = 10000) {
+  const uint32_t t0 = now;
+  for (; now - t0 < timeoutMs; now += STEP_MS) {
+    const double t = (double)(now - t0);
+    const int32_t mg = toMg + (int32_t)lround((fromMg - toMg) * (tauMs ? exp(-t / tauMs) : 0.0));
+    MeasurementLogic::Step st;
+    m.push(now, mg, mg, st);
+    if (st.settled) { now += STEP_MS; return st.finalW; }
+  }
+  return { INT32_MIN, 0, 0, 0, 0 };
+}
+
+static void test_recent_mean_covers_newest_samples() {
+  StabilityDetector d(WIN_MS, BAND_MG);
+  for (uint32_t i = 0; i < 9; ++i) d.push(i * STEP_MS, (int32_t)(i * 1000));
+  TEST_ASSERT_EQUAL_INT32(4000, d.meanMg());
+  TEST_ASSERT_EQUAL_INT32(8000, d.recentMeanMg(0));
+  TEST_ASSERT_EQUAL_INT32(7000, d.recentMeanMg(200));     // 6, 7, 8 g
+  TEST_ASSERT_EQUAL_INT32(4000, d.recentMeanMg(WIN_MS));
+}
+
+static void test_small_change_does_not_trigger() {
+  MeasurementLogic m(params());
+  uint32_t now = 0;
+  for (int i = 0; i < 50; ++i, now += STEP_MS) {
+    MeasurementLogic::Step st;
+    m.push(now, DELTA_MG - 1, DELTA_MG - 1, st);
+    TEST_ASSERT_FALSE(st.triggered);
+  }
+  TEST_ASSERT_TRUE(m.idle());
+}
+
+static void test_step_load_settles_exactly() {
+  MeasurementLogic m(params());
+  uint32_t now = 0;
+  const MeasurementLogic::Weight w = settle(m, now, 0, 250000, 0);
+  TEST_ASSERT_EQUAL_INT32(250000, w.valueMg);
+  TEST_ASSERT_EQUAL_INT32(0, w.prevMg);
+  TEST_ASSERT_EQUAL_UINT32(WIN_MS, w.stableMs - w.detectMs);
+  TEST_ASSERT_TRUE(m.idle());
+  TEST_ASSERT_EQUAL_INT32(250000, m.lastStableMg());
+}
+
+// A ringing load passes the spread test while still moving: the final
+// value must come from the settled end of the window, not its mean
+static void test_ring_down_final_value_within_band() {
+  static const struct { int32_t from, to; uint32_t tau; } kCases[] = {
+    { 0, 250000, 300 }, { 250000, 750000, 500 }, { 750000, 700000, 200 }, { 700000, 0, 300 },
+    { 0, 2000000, 400 },
+  };
+  for (const auto& c : kCases) {
+    MeasurementLogic m(params());
+    uint32_t now = 0;
+    settle(m, now, c.from, c.from, 0);                 // last stable = from
+    const MeasurementLogic::Weight w = settle(m, now, c.from, c.to, c.tau);
+    TEST_ASSERT_TRUE(w.valueMg != INT32_MIN);
+    TEST_ASSERT_INT32_WITHIN(BAND_MG, c.to, w.valueMg);
+    TEST_ASSERT_EQUAL_INT32(c.from, w.prevMg);
+  }
+}
+
+static MeasurementLogic::Params early_params() {
+  MeasurementLogic::Params p = params();
+  p.earlyEnabled = true;
+  return p;
+}
+
+// What one load change produced: the early estimate (if any), then the
+// settle step with its confirm/correct decision
+struct Change {
+  bool early = false;
+  MeasurementLogic::Weight earlyW{};
+  uint32_t earlyAtMs = 0;
+  MeasurementLogic::Step settled{};
+};
+
+// Ring-down from 0 towards 'toMg' (tau 400 ms); once the estimate is out,
+// the load jumps by 'shiftMg' (something moved on the pan) and stays
+static Change run_change(int32_t toMg, int32_t shiftMg) {
+  MeasurementLogic m(early_params());
+  Change c;
+  uint32_t now = 0;
+  for (int i = 0; i < 150; ++i, now += STEP_MS) {
+    const int32_t target = toMg + (c.early ? shiftMg : 0);
+    const int32_t mg = target + (int32_t)lround(-toMg * exp(-(double)now / 400.0));
+    MeasurementLogic::Step st;
+    m.push(now, mg, mg, st);
+    if (st.early) { c.early = true; c.earlyW = st.earlyW; c.earlyAtMs = now; }
+    if (st.settled) { c.settled = st; break; }
+  }
+  return c;
+}
+
+static void test_early_estimate_emitted_before_settle() {
+  const Change c = run_change(250000, 0);
+  TEST_ASSERT_TRUE(c.early);
+  TEST_ASSERT_LESS_THAN(100, c.earlyW.confPct);
+  TEST_ASSERT_GREATER_OR_EQUAL(70, c.earlyW.confPct);
+  TEST_ASSERT_INT32_WITHIN(BAND_MG, 250000, c.earlyW.valueMg);
+  TEST_ASSERT_TRUE(c.settled.settled);
+  TEST_ASSERT_LESS_THAN_UINT32(c.settled.finalW.stableMs, c.earlyW.stableMs);
+}
+
+// The final value lands within the band of the estimate: nothing is resent
+static void test_confirmed_value_replaces_nothing() {
+  const Change c = run_change(250000, 0);
+  TEST_ASSERT_TRUE(c.settled.confirmed);
+  TEST_ASSERT_FALSE(c.settled.corrects);
+  TEST_ASSERT_INT32_WITHIN(BAND_MG, 0, c.settled.earlyErrMg);
+  TEST_ASSERT_EQUAL_UINT8(100, c.settled.finalW.confPct);
+}
+
+// The load moved after the estimate went out: the final value is sent as
+// a correction that names the estimate's seq
+static void test_mispredicted_estimate_is_corrected() {
+  const Change c = run_change(250000, 3 * BAND_MG);
+  TEST_ASSERT_TRUE(c.early);
+  TEST_ASSERT_FALSE(c.settled.confirmed);
+  TEST_ASSERT_TRUE(c.settled.corrects);
+  TEST_ASSERT_INT32_WITHIN(BAND_MG, 250000 + 3 * BAND_MG, c.settled.finalW.valueMg);
+  TEST_ASSERT_EQUAL_INT32(0, c.settled.finalW.prevMg);
+
+  Measurement fix{};
+  fix.seq     = 41;
+  fix.confPct = meas_correction_conf(fix.seq, 40);
+  TEST_ASSERT_FALSE(fix.confPct < 100);                  // not an estimate itself
+  TEST_ASSERT_EQUAL_UINT32(40, meas_corrects_seq(fix));
+  fix.confPct = meas_correction_conf(fix.seq, fix.seq - 200);
+  TEST_ASSERT_EQUAL_UINT8(100, fix.confPct);             // too far back: unlinked
+  TEST_ASSERT_EQUAL_UINT32(0, meas_corrects_seq(fix));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_recent_mean_covers_newest_samples);
+  RUN_TEST(test_small_change_does_not_trigger);
+  RUN_TEST(test_step_load_settles_exactly);
+  RUN_TEST(test_ring_down_final_value_within_band);
+  RUN_TEST(test_early_estimate_emitted_before_settle);
+  RUN_TEST(test_confirmed_value_replaces_nothing);
+  RUN_TEST(test_mispredicted_estimate_is_corrected);
+  return UNITY_END();
+}
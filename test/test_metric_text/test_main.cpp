@@ -0,0 +1,105 @@
+// core/metric_text: the Prometheus lines behind GET /metrics and the serial
+// dump (line format and fit, histogram buckets cumulative with +Inf = count,
+// percentile estimates inside their bucket and capped at the max)
+#include <unity.h>
+#include <stdlib.h>
+#include <string>
+#include "core/metric_text.h"
+
+void setUp() {}
+void tearDown() {}
+
+// Renders every sample the way the HTTP handler does
+static void text_sink(void* ctx, const char* name, const char* label, int64_t value) {
+  char line[128];
+  const size_t n = metric_line(line, sizeof(line), name, label, value);
+  TEST_ASSERT_TRUE(n > 0);
+  ((std::string*)ctx)->append(line, n);
+}
+
+static HistSnapshot hist_of(const uint32_t* ms, size_t n) {
+  HistSnapshot s{};
+  for (size_t i = 0; i < n; ++i) {
+    uint8_t b = 0;
+    while (b < METRIC_BUCKETS && ms[i] > METRIC_BUCKET_LE[b]) ++b;
+    s.bucket[b]++;
+    s.count++;
+    s.sumMs += ms[i];
+    if (ms[i] > s.maxMs) s.maxMs = ms[i];
+  }
+  return s;
+}
+
+static void test_line_format_and_fit() {
+  char out[64];
+  TEST_ASSERT_EQUAL_size_t(13, metric_line(out, sizeof(out), "uptime", "", 12345));
+  TEST_ASSERT_EQUAL_STRING("uptime 12345\n", out);
+  metric_line(out, sizeof(out), "wifi_rssi_dbm", "", -67);
+  TEST_ASSERT_EQUAL_STRING("wifi_rssi_dbm -67\n", out);
+  metric_line(out, sizeof(out), "wakeups_total", "task=\"ui\"", 4000000000LL);
+  TEST_ASSERT_EQUAL_STRING("wakeups_total{task=\"ui\"} 4000000000\n", out);
+
+  // "a 1\n" needs 5 bytes with the NUL; one less is no line at all
+  TEST_ASSERT_EQUAL_size_t(4, metric_line(out, 5, "a", "", 1));
+  TEST_ASSERT_EQUAL_size_t(0, metric_line(out, 4, "a", "", 1));
+}
+
+static void test_percentile_interpolates_and_caps() {
+  HistSnapshot empty{};
+  TEST_ASSERT_EQUAL_UINT32(0, metric_percentile(empty, 50));
+
+  // 100 samples in the 100..200 bucket: estimates spread across it, capped at the max
+  uint32_t ms[100];
+  for (int i = 0; i < 100; ++i) ms[i] = 150;
+  HistSnapshot s = hist_of(ms, 100);
+  TEST_ASSERT_EQUAL_UINT32(150, metric_percentile(s, 50));   // 100 + 100*50/100 = 150, the max
+  TEST_ASSERT_EQUAL_UINT32(150, metric_percentile(s, 99));
+  ms[99] = 199;
+  s = hist_of(ms, 100);
+  TEST_ASSERT_EQUAL_UINT32(150, metric_percentile(s, 50));
+  TEST_ASSERT_EQUAL_UINT32(190, metric_percentile(s, 90));
+  TEST_ASSERT_EQUAL_UINT32(199, metric_percentile(s, 99));
+
+  // Past the last bound the max closes the +Inf bucket
+  const uint32_t slow[4] = { 3, 3, 3, 90000 };
+  s = hist_of(slow, 4);
+  TEST_ASSERT_EQUAL_UINT32(4, metric_percentile(s, 50));    // rank 2 of 3 in (2, 5]
+  TEST_ASSERT_EQUAL_UINT32(90000, metric_percentile(s, 99));
+}
+
+static void test_hist_lines() {
+  const uint32_t ms[6] = { 1, 4, 4, 180, 1500, 70000 };
+  const HistSnapshot s = hist_of(ms, 6);
+  std::string text;
+  metric_write_hist(text_sink, &text, "upload_post_ms", s);
+
+  TEST_ASSERT_TRUE(text.find("upload_post_ms_bucket{le=\"1\"} 1\n") != std::string::npos);
+  TEST_ASSERT_TRUE(text.find("upload_post_ms_bucket{le=\"2\"} 1\n") != std::string::npos);
+  TEST_ASSERT_TRUE(text.find("upload_post_ms_bucket{le=\"5\"} 3\n") != std::string::npos);
+  TEST_ASSERT_TRUE(text.find("upload_post_ms_bucket{le=\"200\"} 4\n") != std::string::npos);
+  TEST_ASSERT_TRUE(text.find("upload_post_ms_bucket{le=\"60000\"} 5\n") != std::string::npos);
+  TEST_ASSERT_TRUE(text.find("upload_post_ms_bucket{le=\"+Inf\"} 6\n") != std::string::npos);
+  TEST_ASSERT_TRUE(text.find("upload_post_ms_sum 71689\n") != std::string::npos);
+  TEST_ASSERT_TRUE(text.find("upload_post_ms_count 6\n") != std::string::npos);
+  TEST_ASSERT_TRUE(text.find("upload_post_ms_max 70000\n") != std::string::npos);
+  TEST_ASSERT_TRUE(text.find("upload_post_ms_p50 5\n") != std::string::npos);
+
+  // Buckets never go down, and +Inf comes last
+  size_t lines = 0, pos = 0;
+  long prev = -1;
+  for (size_t at; (at = text.find("_bucket{", pos)) != std::string::npos; pos = at + 1, ++lines) {
+    const long v = atol(text.c_str() + text.find("} ", at) + 2);
+    TEST_ASSERT_TRUE(v >= prev);
+    prev = v;
+  }
+  TEST_ASSERT_EQUAL_size_t(METRIC_BUCKETS + 1, lines);
+  TEST_ASSERT_TRUE(text.find("+Inf") > text.find("le=\"60000\""));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_line_format_and_fit);
+  RUN_TEST(test_percentile_interpolates_and_caps);
+  RUN_TEST(test_hist_lines);
+  return UNITY_END();
+}
@@ -0,0 +1,153 @@
+// util/retry_scheduler against a faulting server on the fake HTTP port and
+// clock: backoff bounds, breaker open/half-open/close, 4xx as an answer,
+// fleet spread after an outage, millis() wrap
+#include <unity.h>
+#include <stdio.h>
+#include "app_config.h"
+#include "hal/clock.h"
+#include "hal/fake.h"
+#include "hal/http_port.h"
+#include "util/retry_scheduler.h"
+
+static constexpr RetryScheduler::Config CFG = {
+  RETRY_BASE_MS, RETRY_MAX_MS, BREAKER_OPEN_AFTER, BREAKER_OPEN_MS, BREAKER_OPEN_MAX_MS
+};
+
+// Server script: down (transport error or 503, alternating) until s_upAtMs
+static uint32_t s_upAtMs   = 0;
+static int      s_upStatus = 200;
+
+static int server(const char*, const char*, const uint8_t*, size_t, char*, size_t) {
+  if (hal_millis() < s_upAtMs) return (fake_http_stats().posts & 1) ? 503 : -1;
+  return s_upStatus;
+}
+
+// What the uploader counts as "server unhealthy"
+static bool unhealthy(int code) { return code < 0 || code >= 500 || code == 408 || code == 429; }
+
+// One attempt if the scheduler allows it; returns true if one was made
+static bool try_once(RetryScheduler& r) {
+  const uint32_t now = hal_millis();
+  if (r.waitMs(now) != 0 || !r.begin(now)) return false;
+  char resp[16];
+  const int code = hal_http_post("/weights", "application/json", (const uint8_t*)"{}", 2, resp, sizeof(resp));
+  if (unhealthy(code)) r.onFailure(hal_millis());
+  else                 r.onSuccess(hal_millis());
+  return true;
+}
+
+void setUp() {
+  fake_clock_set_us(0);
+  fake_http_reset();
+  fake_http_set_handler(server);
+  s_upAtMs   = 0;
+  s_upStatus = 200;
+}
+void tearDown() { fake_http_set_handler(nullptr); }
+
+// Backoff delays stay in [cap/2, cap] with cap doubling from baseMs, then
+// the breaker opens after BREAKER_OPEN_AFTER failures in a row
+static void test_backoff_bounds_then_open() {
+  s_upAtMs = UINT32_MAX;
+  RetryScheduler r(CFG, 12345);
+  uint32_t fails = 0;
+  while (r.state() == RetryScheduler::State::CLOSED) {
+    if (try_once(r)) {
+      fails++;
+      if (r.state() != RetryScheduler::State::CLOSED) break;
+      const uint32_t cap = RETRY_BASE_MS << (fails - 1) < RETRY_MAX_MS ? RETRY_BASE_MS << (fails - 1) : RETRY_MAX_MS;
+      TEST_ASSERT_GREATER_OR_EQUAL_UINT32(cap / 2, r.stats().lastDelayMs);
+      TEST_ASSERT_LESS_OR_EQUAL_UINT32(cap, r.stats().lastDelayMs);
+      TEST_ASSERT_EQUAL_UINT32(r.stats().lastDelayMs, r.waitMs(hal_millis()));
+    }
+    hal_delay_ms(10);
+  }
+  TEST_ASSERT_EQUAL_UINT32(BREAKER_OPEN_AFTER, fails);
+  TEST_ASSERT_EQUAL_UINT32(1, r.stats().opens);
+  TEST_ASSERT_GREATER_OR_EQUAL_UINT32(BREAKER_OPEN_MS / 2, r.waitMs(hal_millis()));
+}
+
+// A 20 min outage: few attempts (backoff, then spaced probes), recovery
+// at the first probe after the server is back, breaker closed again
+static void test_outage_and_recovery() {
+  s_upAtMs = 20 * 60 * 1000;
+  RetryScheduler r(CFG, 777);
+  uint32_t recoveredAt = 0;
+  while (hal_millis() < 40 * 60 * 1000 && !recoveredAt) {
+    if (try_once(r) && r.state() == RetryScheduler::State::CLOSED && r.stats().successes) recoveredAt = hal_millis();
+    hal_delay_ms(10);
+  }
+  const RetryScheduler::Stats& s = r.stats();
+  printf("\n  20 min outage: %lu attempts (%lu posts), %lu opens, %lu probes, back %lu s after the server\n",
+         (unsigned long)s.attempts, (unsigned long)fake_http_stats().posts, (unsigned long)s.opens,
+         (unsigned long)s.probes, (unsigned long)((recoveredAt - s_upAtMs) / 1000));
+  TEST_ASSERT_GREATER_THAN_UINT32(0, recoveredAt);
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(BREAKER_OPEN_MAX_MS, recoveredAt - s_upAtMs);
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(BREAKER_OPEN_AFTER + 12, s.attempts);     // not a retry storm
+  TEST_ASSERT_EQUAL_UINT32(s.attempts, fake_http_stats().posts);
+  TEST_ASSERT_EQUAL_UINT32(0, s.consecutiveFails);
+  TEST_ASSERT_EQUAL_UINT32(0, r.waitMs(hal_millis()));
+}
+
+// Half-open lets exactly one probe out; a failed probe re-opens for longer
+static void test_half_open_single_probe() {
+  s_upAtMs = UINT32_MAX;
+  RetryScheduler r(CFG, 9);
+  while (r.state() != RetryScheduler::State::OPEN) { try_once(r); hal_delay_ms(10); }
+  hal_delay_ms(r.waitMs(hal_millis()));
+  TEST_ASSERT_EQUAL_UINT32(0, r.waitMs(hal_millis()));
+  TEST_ASSERT_TRUE(r.begin(hal_millis()));
+  TEST_ASSERT_EQUAL(RetryScheduler::State::HALF_OPEN, r.state());
+  TEST_ASSERT_FALSE(r.begin(hal_millis()));                  // probe still out
+  r.onFailure(hal_millis());
+  TEST_ASSERT_EQUAL(RetryScheduler::State::OPEN, r.state());
+  TEST_ASSERT_EQUAL_UINT32(2, r.stats().opens);
+  TEST_ASSERT_GREATER_OR_EQUAL_UINT32(BREAKER_OPEN_MS, r.waitMs(hal_millis()));   // doubled, jittered
+}
+
+// 4xx is an answer: the server is healthy, no backoff
+static void test_rejection_is_not_an_outage() {
+  s_upStatus = 400;
+  RetryScheduler r(CFG, 3);
+  for (int i = 0; i < 20; ++i) TEST_ASSERT_TRUE(try_once(r));
+  TEST_ASSERT_EQUAL_UINT32(0, r.stats().failures);
+  TEST_ASSERT_EQUAL(RetryScheduler::State::CLOSED, r.state());
+}
+
+// Devices that lost the server together do not come back in lock-step
+static void test_fleet_spreads_out() {
+  static constexpr int FLEET = 50;
+  s_upAtMs = UINT32_MAX;
+  uint32_t first = UINT32_MAX, last = 0;
+  for (int d = 0; d < FLEET; ++d) {
+    RetryScheduler r(CFG, 1000 + d * 7919);
+    fake_clock_set_us(0);
+    while (r.state() != RetryScheduler::State::OPEN) { try_once(r); hal_delay_ms(10); }
+    const uint32_t probeAt = hal_millis() + r.waitMs(hal_millis());
+    if (probeAt < first) first = probeAt;
+    if (probeAt > last)  last = probeAt;
+  }
+  printf("\n  %d devices: first half-open probes spread over %lu ms\n", FLEET, (unsigned long)(last - first));
+  TEST_ASSERT_GREATER_THAN_UINT32(BREAKER_OPEN_MS / 4, last - first);
+}
+
+static void test_wrap() {
+  RetryScheduler r(CFG, 7);
+  const uint32_t t0 = 0xFFFFFF00u;
+  TEST_ASSERT_TRUE(r.begin(t0));
+  r.onFailure(t0);
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(RETRY_BASE_MS, r.waitMs(t0));
+  TEST_ASSERT_GREATER_THAN_UINT32(0, r.waitMs(t0 + 100));
+  TEST_ASSERT_EQUAL_UINT32(0, r.waitMs(t0 + 2000));           // past the wrap
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_backoff_bounds_then_open);
+  RUN_TEST(test_outage_and_recovery);
+  RUN_TEST(test_half_open_single_probe);
+  RUN_TEST(test_rejection_is_not_an_outage);
+  RUN_TEST(test_fleet_spreads_out);
+  RUN_TEST(test_wrap);
+  return UNITY_END();
+}
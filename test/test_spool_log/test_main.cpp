@@ -0,0 +1,273 @@
+// storage/spool_log on RamFlash: FIFO against a model, power cut mid-append
+// and mid-commit, CRC recovery at remount, sector rotation and wear
+#include <unity.h>
+#include <deque>
+#include <memory>
+#include <stdio.h>
+#include <string.h>
+#include "storage/spool_log.h"
+#include "util/crc.h"
+#include "../test_support.h"
+
+struct Rec { uint32_t seq; uint32_t pad[3]; };
+
+static constexpr uint32_t SECTOR = 4096;
+static constexpr uint32_t SLOTS  = (SECTOR - SpoolLog::HDR_SIZE) / SpoolLog::SLOT_SIZE;   // per sector
+static uint8_t s_mem[16 * SECTOR];
+
+void setUp() { rnd_reset(); }
+void tearDown() {}
+
+static bool append_seq(SpoolLog& log, uint32_t seq) {
+  const Rec r{ seq, { 0, 0, 0 } };
+  return log.append(&r, sizeof(r));
+}
+
+// Everything pending, oldest first, must be exactly 'expect'
+static void assert_contents(SpoolLog& log, const std::deque<uint32_t>& expect) {
+  static Rec out[16 * SLOTS];
+  TEST_ASSERT_EQUAL_UINT32(expect.size(), log.pending());
+  TEST_ASSERT_EQUAL_size_t(expect.size(), log.peek(out, sizeof(Rec), 16 * SLOTS));
+  for (size_t i = 0; i < expect.size(); ++i) TEST_ASSERT_EQUAL_UINT32(expect[i], out[i].seq);
+}
+
+static void test_fifo_matches_model_across_remounts() {
+  RamFlash fl(s_mem, sizeof(s_mem), SECTOR);
+  std::unique_ptr<SpoolLog> log(new SpoolLog(fl));
+  TEST_ASSERT_TRUE(log->mount());
+
+  std::deque<uint32_t> model;
+  uint32_t seq = 0;
+  for (int it = 0; it < 60000; ++it) {
+    const uint32_t op = rnd() % 100;
+    if (op < 55) {
+      const uint32_t dropped0 = log->stats().dropped;
+      if (append_seq(*log, ++seq)) model.push_back(seq);
+      for (uint32_t d = log->stats().dropped - dropped0; d > 0; --d) model.pop_front();   // ring full
+    } else if (op < 97) {
+      Rec out[8];
+      const size_t want = 1 + rnd() % 8;
+      const size_t n = log->peek(out, sizeof(Rec), want);
+      TEST_ASSERT_EQUAL_size_t(model.size() < want ? model.size() : want, n);
+      for (size_t i = 0; i < n; ++i) TEST_ASSERT_EQUAL_UINT32(model[i], out[i].seq);
+      const size_t c = rnd() % (n + 1);
+      TEST_ASSERT_TRUE(log->commit(c));
+      model.erase(model.begin(), model.begin() + c);
+    } else {
+      log.reset(new SpoolLog(fl));
+      TEST_ASSERT_TRUE(log->mount());
+      assert_contents(*log, model);
+    }
+    TEST_ASSERT_EQUAL_UINT32(model.size(), log->pending());
+  }
+}
+
+// Every possible cut point inside one append: after remount the record is
+// either fully there or gone (and counted torn), the rest untouched, and
+// the next append lands normally
+static void test_power_cut_mid_append() {
+  RamFlash fl(s_mem, sizeof(s_mem), SECTOR);
+  std::deque<uint32_t> model;
+  uint32_t seq = 0;
+  {
+    SpoolLog log(fl);
+    TEST_ASSERT_TRUE(log.mount());
+    for (uint32_t i = 0; i < SLOTS - 3; ++i) { TEST_ASSERT_TRUE(append_seq(log, ++seq)); model.push_back(seq); }
+  }
+  // A record near the sector end also covers opening the next sector
+  for (int32_t budget = 0; budget <= (int32_t)(SpoolLog::SLOT_SIZE + SpoolLog::HDR_SIZE); ++budget) {
+    {
+      SpoolLog log(fl);
+      TEST_ASSERT_TRUE(log.mount());
+      fl.cutPowerAfter(budget);
+      const bool ok = append_seq(log, ++seq);
+      fl.restorePower();
+      if (ok) model.push_back(seq);
+    }
+    SpoolLog log(fl);
+    TEST_ASSERT_TRUE(log.mount());
+    if (log.pending() == model.size() + 1) model.push_back(seq);   // cut after the state byte
+    assert_contents(log, model);
+
+    TEST_ASSERT_TRUE(append_seq(log, ++seq));
+    model.push_back(seq);
+    assert_contents(log, model);
+  }
+}
+
+// Cut while commit() marks slots consumed across a sector boundary: the
+// remounted log holds exactly the records whose state byte was not written.
+// The 20th slot empties the first sector, whose erase is followed by its
+// 16-byte wear half before the next state byte.
+static void test_power_cut_mid_commit() {
+  static uint8_t image[sizeof(s_mem)];
+  const uint32_t total = SLOTS + 20;
+  {
+    RamFlash fl(s_mem, sizeof(s_mem), SECTOR);
+    SpoolLog log(fl);
+    TEST_ASSERT_TRUE(log.mount());
+    for (uint32_t i = 1; i <= SLOTS - 10; ++i) TEST_ASSERT_TRUE(append_seq(log, i));
+    TEST_ASSERT_TRUE(log.commit(SLOTS - 20));                     // reader 10 short of the sector end
+    for (uint32_t i = SLOTS - 9; i <= total; ++i) TEST_ASSERT_TRUE(append_seq(log, i));
+    memcpy(image, s_mem, sizeof(s_mem));
+  }
+  const uint32_t first = SLOTS - 19, pending = total - (SLOTS - 20);
+  const int32_t WEAR_HALF = 16;
+  for (int32_t cut = 0; cut <= 45; ++cut) {
+    RamFlash fl(s_mem, sizeof(s_mem), SECTOR);
+    memcpy(s_mem, image, sizeof(s_mem));            // after: RamFlash blanks its buffer
+    {
+      SpoolLog log(fl);
+      TEST_ASSERT_TRUE(log.mount());
+      TEST_ASSERT_EQUAL_UINT32(pending, log.pending());
+      fl.cutPowerAfter(cut);
+      TEST_ASSERT_EQUAL(cut >= 25 + WEAR_HALF, log.commit(25));
+      fl.restorePower();
+    }
+    SpoolLog log(fl);
+    TEST_ASSERT_TRUE(log.mount());
+    const int32_t marked = cut <= 20 ? cut : cut < 20 + WEAR_HALF ? 20 : cut - WEAR_HALF;
+    const uint32_t done = marked < 25 ? (uint32_t)marked : 25;
+    std::deque<uint32_t> expect;
+    for (uint32_t s = first + done; s <= total; ++s) expect.push_back(s);
+    assert_contents(log, expect);
+  }
+}
+
+// A flipped payload bit is caught by the slot CRC at mount/peek
+static void test_crc_mismatch_skipped_as_torn() {
+  RamFlash fl(s_mem, sizeof(s_mem), SECTOR);
+  {
+    SpoolLog log(fl);
+    TEST_ASSERT_TRUE(log.mount());
+    for (uint32_t i = 1; i <= 5; ++i) TEST_ASSERT_TRUE(append_seq(log, i));
+  }
+  s_mem[SpoolLog::HDR_SIZE + 2 * SpoolLog::SLOT_SIZE + 8] ^= 0x01;   // payload of seq 3 → 2
+  SpoolLog log(fl);
+  TEST_ASSERT_TRUE(log.mount());
+  assert_contents(log, { 1, 2, 4, 5 });
+  TEST_ASSERT_GREATER_THAN_UINT32(0, log.stats().torn);
+}
+
+// Sustained traffic rotates through every sector: erase counts stay within
+// one of each other, and the header wear survives a remount
+static void test_rotation_levels_wear() {
+  RamFlash fl(s_mem, sizeof(s_mem), SECTOR);
+  SpoolLog log(fl);
+  TEST_ASSERT_TRUE(log.mount());
+  uint32_t seq = 0;
+  for (int round = 0; round < 200; ++round) {
+    for (uint32_t i = 0; i < SLOTS / 2; ++i) TEST_ASSERT_TRUE(append_seq(log, ++seq));
+    TEST_ASSERT_TRUE(log.commit(log.pending()));
+  }
+  uint32_t lo = UINT32_MAX, hi = 0;
+  for (uint32_t s = 0; s < 16; ++s) {
+    if (fl.eraseCount(s) < lo) lo = fl.eraseCount(s);
+    if (fl.eraseCount(s) > hi) hi = fl.eraseCount(s);
+  }
+  printf("\n  %lu records through 16 sectors: erases %lu..%lu per sector\n",
+         (unsigned long)seq, (unsigned long)lo, (unsigned long)hi);
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(lo + 1, hi);
+  TEST_ASSERT_GREATER_THAN_UINT32(0, lo);
+
+  SpoolLog again(fl);
+  TEST_ASSERT_TRUE(again.mount());
+  TEST_ASSERT_EQUAL_UINT32(0, again.pending());
+  TEST_ASSERT_EQUAL_UINT32(hi, again.stats().maxSectorWear);
+}
+
+static uint32_t max_erases(const RamFlash& fl, uint32_t sectors) {
+  uint32_t hi = 0;
+  for (uint32_t s = 0; s < sectors; ++s) if (fl.eraseCount(s) > hi) hi = fl.eraseCount(s);
+  return hi;
+}
+
+// Erased (free) sectors keep their count across reboots: every boot the
+// header wear must match what the flash actually saw
+static void test_wear_survives_erase_and_remount() {
+  static uint8_t small[4 * SECTOR];
+  RamFlash fl(small, sizeof(small), SECTOR);
+  uint32_t seq = 0;
+  for (int boot = 0; boot < 12; ++boot) {
+    SpoolLog log(fl);
+    TEST_ASSERT_TRUE(log.mount());
+    TEST_ASSERT_EQUAL_UINT32(max_erases(fl, 4), log.stats().maxSectorWear);
+    for (uint32_t i = 0; i < SLOTS + SLOTS / 2; ++i) TEST_ASSERT_TRUE(append_seq(log, ++seq));
+    const size_t keep = (boot % 2) ? 3 : 0;          // odd boots leave a tail pending
+    TEST_ASSERT_TRUE(log.commit(log.pending() - keep));
+    TEST_ASSERT_EQUAL_UINT32(max_erases(fl, 4), log.stats().maxSectorWear);
+  }
+  TEST_ASSERT_GREATER_THAN_UINT32(4, max_erases(fl, 4));
+
+  // format() starts over on the data, not on the wear
+  SpoolLog log(fl);
+  TEST_ASSERT_TRUE(log.mount());
+  TEST_ASSERT_TRUE(log.format());
+  SpoolLog again(fl);
+  TEST_ASSERT_TRUE(again.mount());
+  TEST_ASSERT_EQUAL_UINT32(0, again.pending());
+  TEST_ASSERT_EQUAL_UINT32(max_erases(fl, 4), again.stats().maxSectorWear);
+}
+
+// A sector opened by the previous firmware ("SPL1": one header with seq and
+// wear) still mounts with its records and wear
+static void test_legacy_header_mounts() {
+  RamFlash fl(s_mem, sizeof(s_mem), SECTOR);
+  {
+    SpoolLog log(fl);
+    TEST_ASSERT_TRUE(log.mount());
+    for (uint32_t i = 1; i <= 3; ++i) TEST_ASSERT_TRUE(append_seq(log, i));
+  }
+  uint32_t legacy[4] = { 0x314C5053, 5, 3, 0 };
+  legacy[3] = crc32(legacy, 12);
+  memset(s_mem, 0xFF, SpoolLog::HDR_SIZE);
+  memcpy(s_mem, legacy, sizeof(legacy));
+  SpoolLog log(fl);
+  TEST_ASSERT_TRUE(log.mount());
+  assert_contents(log, { 1, 2, 3 });
+  TEST_ASSERT_EQUAL_UINT32(3, log.stats().maxSectorWear);
+}
+
+// Full ring: append drops the oldest sector, never the new record
+static void test_full_ring_drops_oldest_sector() {
+  static uint8_t small[4 * SECTOR];
+  RamFlash fl(small, sizeof(small), SECTOR);
+  SpoolLog log(fl);
+  TEST_ASSERT_TRUE(log.mount());
+  const uint32_t n = 4 * SLOTS + 10;
+  for (uint32_t i = 1; i <= n; ++i) TEST_ASSERT_TRUE(append_seq(log, i));
+  TEST_ASSERT_GREATER_THAN_UINT32(0, log.stats().dropped);
+  TEST_ASSERT_EQUAL_UINT32(n - log.stats().dropped, log.pending());
+  Rec out[1];
+  TEST_ASSERT_EQUAL_size_t(1, log.peek(out, sizeof(Rec), 1));
+  TEST_ASSERT_EQUAL_UINT32(log.stats().dropped + 1, out[0].seq);
+}
+
+// mount() is one pass over sector and slot headers, however full the ring
+static void test_mount_reads_bounded() {
+  static uint8_t big[64 * SECTOR];
+  RamFlash fl(big, sizeof(big), SECTOR);
+  SpoolLog log(fl);
+  TEST_ASSERT_TRUE(log.mount());
+  const uint32_t n = 60 * SLOTS;
+  for (uint32_t i = 1; i <= n; ++i) TEST_ASSERT_TRUE(append_seq(log, i));
+  SpoolLog again(fl);
+  TEST_ASSERT_TRUE(again.mount());
+  TEST_ASSERT_EQUAL_UINT32(n, again.pending());
+  printf("\n  mount of %lu records: %lu flash reads\n", (unsigned long)n, (unsigned long)again.stats().mountReads);
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(64 + 64 * SLOTS, again.stats().mountReads);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_fifo_matches_model_across_remounts);
+  RUN_TEST(test_power_cut_mid_append);
+  RUN_TEST(test_power_cut_mid_commit);
+  RUN_TEST(test_crc_mismatch_skipped_as_torn);
+  RUN_TEST(test_rotation_levels_wear);
+  RUN_TEST(test_wear_survives_erase_and_remount);
+  RUN_TEST(test_legacy_header_mounts);
+  RUN_TEST(test_full_ring_drops_oldest_sector);
+  RUN_TEST(test_mount_reads_bounded);
+  return UNITY_END();
+}
@@ -0,0 +1,123 @@
+// features/stability_detector: the O(1) window (monotonic min/max deques,
+// running sums) against a brute-force window, plus the stable rule,
+// capacity eviction, millis() wrap, and a push that stays cheaper than
+// rescanning the window
+#include <unity.h>
+#include <deque>
+#include <math.h>
+#include <stdio.h>
+#include "features/stability_detector.h"
+#include "../test_support.h"
+
+static constexpr uint32_t WIN_MS  = 800;
+static constexpr int32_t  BAND_MG = 6000;
+
+struct Sample { uint32_t ms; int32_t mg; };
+
+// Sums are kept relative to the first sample after a reset ('anchor');
+// the variance's integer mean is off by < 1 mg, so its error grows with
+// the distance from that anchor
+static int32_t s_anchor = 0;
+
+// Same window rule as the detector: capacity, then keep one sample at/behind the edge
+static void ref_push(std::deque<Sample>& w, uint32_t ms, int32_t mg) {
+  if (w.empty()) s_anchor = mg;
+  w.push_back({ ms, mg });
+  if (w.size() > StabilityDetector::CAPACITY) w.pop_front();
+  while (w.size() >= 2 && ms - w[1].ms >= WIN_MS) w.pop_front();
+}
+
+static void assert_matches(const StabilityDetector& d, const std::deque<Sample>& w) {
+  TEST_ASSERT_EQUAL_size_t(w.size(), d.count());
+  int32_t mn = INT32_MAX, mx = INT32_MIN;
+  int64_t sum = 0;
+  for (const Sample& s : w) { if (s.mg < mn) mn = s.mg; if (s.mg > mx) mx = s.mg; sum += s.mg; }
+  TEST_ASSERT_EQUAL_INT32(mn, d.minMg());
+  TEST_ASSERT_EQUAL_INT32(mx, d.maxMg());
+  const int64_t n = (int64_t)w.size();
+  TEST_ASSERT_INT32_WITHIN(1, (int32_t)(sum / n), d.meanMg());
+  double m = (double)sum / n, v = 0;
+  for (const Sample& s : w) v += ((double)s.mg - m) * ((double)s.mg - m);
+  v /= n;
+  TEST_ASSERT_TRUE(fabs((double)d.varianceMg2() - v) <= 2.0 + 2.0 * fabs(m - s_anchor));
+  const uint32_t span = w.size() >= 2 ? w.back().ms - w.front().ms : 0;
+  TEST_ASSERT_EQUAL_UINT32(span, d.spanMs());
+  TEST_ASSERT_EQUAL(w.size() >= 2 && span >= WIN_MS && mx - mn <= 2 * BAND_MG, d.isStable());
+}
+
+void setUp() { rnd_reset(); }
+void tearDown() {}
+
+static void test_matches_brute_force_window() {
+  StabilityDetector d(WIN_MS, BAND_MG);
+  std::deque<Sample> w;
+  uint32_t t = 0xFFFF0000u;                                 // wraps half way
+  for (int i = 0; i < 200000; ++i) {
+    t += (i % 50000 < 1000) ? 1 + rnd() % 5 : 5 + rnd() % 120;   // bursts fill the capacity
+    const int32_t mg = (int32_t)(rnd() % 20001) - 10000 + (i / 1000) * 100000 % 2000000;
+    if (rnd() % 5000 == 0) { d.reset(); w.clear(); }
+    d.push(t, mg);
+    ref_push(w, t, mg);
+    assert_matches(d, w);
+  }
+}
+
+// Monotonic deques: a falling then rising stream keeps min/max right as
+// the extremes slide out of the window
+static void test_extremes_slide_out() {
+  StabilityDetector d(WIN_MS, BAND_MG);
+  std::deque<Sample> w;
+  uint32_t t = 0;
+  for (int i = 0; i < 40; ++i, t += 100) { d.push(t, 100000 - i * 1000); ref_push(w, t, 100000 - i * 1000); assert_matches(d, w); }
+  for (int i = 0; i < 40; ++i, t += 100) { d.push(t, 60000 + i * 1000);  ref_push(w, t, 60000 + i * 1000);  assert_matches(d, w); }
+  for (int i = 0; i < 20; ++i, t += 100) { d.push(t, 5000);              ref_push(w, t, 5000);              assert_matches(d, w); }
+  TEST_ASSERT_EQUAL_INT32(5000, d.minMg());
+  TEST_ASSERT_EQUAL_INT32(5000, d.maxMg());
+}
+
+static void test_stable_rule() {
+  StabilityDetector d(WIN_MS, BAND_MG);
+  for (uint32_t t = 0; t < WIN_MS; t += 100) { d.push(t, 1000 + ((t / 100) % 2 ? BAND_MG : -BAND_MG)); TEST_ASSERT_FALSE(d.isStable()); }
+  d.push(WIN_MS, 1000);
+  TEST_ASSERT_TRUE(d.isStable());                           // span reached, spread exactly 2·band
+  d.push(WIN_MS + 100, 1000 + BAND_MG + 1);
+  TEST_ASSERT_FALSE(d.isStable());                          // one past the band
+
+  // A stream too fast for CAPACITY never spans the window
+  StabilityDetector fast(WIN_MS, BAND_MG);
+  for (uint32_t t = 0; t < 5000; t += 2) fast.push(t, 0);
+  TEST_ASSERT_EQUAL_size_t(StabilityDetector::CAPACITY, fast.count());
+  TEST_ASSERT_FALSE(fast.isStable());
+}
+
+static void test_push_cheaper_than_rescan() {
+  StabilityDetector d(WIN_MS, BAND_MG);
+  std::deque<Sample> w;
+  uint32_t t = 0;
+  int sink = 0;
+  const double push = host_ns_per_call(200000, [&](uint32_t) {
+    t += 10;
+    d.push(t, (int32_t)(rnd() % 12001));
+    sink += d.isStable();
+  });
+  const double rescan = host_ns_per_call(200000, [&](uint32_t) {
+    t += 10;
+    ref_push(w, t, (int32_t)(rnd() % 12001));
+    int32_t mn = INT32_MAX, mx = INT32_MIN;
+    for (const Sample& s : w) { if (s.mg < mn) mn = s.mg; if (s.mg > mx) mx = s.mg; }
+    sink += mx - mn <= 2 * BAND_MG;
+  });
+  printf("\n  push + isStable %.1f ns vs rescan %.1f ns (%u samples in window, %d)\n",
+         push, rescan, (unsigned)d.count(), sink & 1);
+  TEST_ASSERT_EQUAL_size_t(w.size(), d.count());                  // same window length
+  TEST_ASSERT_TRUE(push < rescan);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_matches_brute_force_window);
+  RUN_TEST(test_extremes_slide_out);
+  RUN_TEST(test_stable_rule);
+  RUN_TEST(test_push_cheaper_than_rescan);
+  return UNITY_END();
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <stdint.h>
+#include <chrono>
+#include "util/xorshift.h"
+
+// Shared by the native suites (#include "../test_support.h"): a seeded
+// random source that setUp() rewinds, so every test sees the same inputs,
+// and a host timer for cost comparisons that assert an ordering, never an
+// absolute figure.
+
+static XorShift32 s_rng;
+
+static inline uint32_t rnd() { return s_rng.next(); }
+static inline void rnd_reset() { s_rng = XorShift32(); }
+
+// Best of three runs of fn(i) for i in [0, n): ns per call on this host
+template <class F>
+static double host_ns_per_call(uint32_t n, F&& fn) {
+  using clk = std::chrono::steady_clock;
+  double best = 0;
+  for (int run = 0; run < 3; ++run) {
+    const auto t0 = clk::now();
+    for (uint32_t i = 0; i < n; ++i) fn(i);
+    const double ns = std::chrono::duration<double, std::nano>(clk::now() - t0).count() / n;
+    if (run == 0 || ns < best) best = ns;
+  }
+  return best;
+}
@@ -0,0 +1,95 @@
+// features/trace_stages: stage durations of full and partial traces, millis()
+// wrap, SLO window share, and the SAMPLE mark against a real step through
+// the filter chain on the fake cell
+#include <unity.h>
+#include "app_config.h"
+#include "hal/clock.h"
+#include "hal/fake.h"
+#include "hal/hx711_port.h"
+#include "features/filter_chain.h"
+#include "features/trace_stages.h"
+
+static constexpr uint8_t NS = (uint8_t)TraceStage::COUNT;
+
+void setUp() {}
+void tearDown() {}
+
+static TraceMarks marks(uint32_t base, const uint32_t (&at)[6], uint8_t have) {
+  TraceMarks t{};
+  for (uint8_t i = 0; i < 6; ++i) t.ms[i] = base + at[i];
+  t.have = have;
+  return t;
+}
+
+static uint32_t stage(const uint32_t (&d)[NS], TraceStage s) { return d[(uint8_t)s]; }
+
+static void test_full_trace_and_wrap() {
+  //                         SAMPLE DETECT STABLE FINAL ENQUEUE SEND
+  static const uint32_t at[6] = { 0, 100, 900, 902, 903, 1500 };
+  const uint32_t bases[] = { 1000, 0xFFFFFFFFu - 950 };      // second one wraps mid-trace
+  for (uint32_t base : bases) {
+    uint32_t d[NS];
+    trace_stages(marks(base, at, 0x3F), base + 1700, d);
+    TEST_ASSERT_EQUAL_UINT32(100, stage(d, TraceStage::FILTER));
+    TEST_ASSERT_EQUAL_UINT32(800, stage(d, TraceStage::STABLE));
+    TEST_ASSERT_EQUAL_UINT32(2,   stage(d, TraceStage::FINAL));
+    TEST_ASSERT_EQUAL_UINT32(1,   stage(d, TraceStage::ENQUEUE));
+    TEST_ASSERT_EQUAL_UINT32(597, stage(d, TraceStage::QUEUE));
+    TEST_ASSERT_EQUAL_UINT32(200, stage(d, TraceStage::SEND));
+    TEST_ASSERT_EQUAL_UINT32(1700, stage(d, TraceStage::TOTAL));
+    uint32_t sum = 0;
+    for (uint8_t i = 0; i < (uint8_t)TraceStage::TOTAL; ++i) sum += d[i];
+    TEST_ASSERT_EQUAL_UINT32(stage(d, TraceStage::TOTAL), sum);
+  }
+}
+
+// Without ENQUEUE the queue runs from FINAL; without SEND it runs to the ack
+static void test_missing_marks_fold_into_queue() {
+  static const uint32_t at[6] = { 0, 100, 900, 902, 0, 0 };
+  uint32_t d[NS];
+  trace_stages(marks(50, at, 0x0F), 50 + 3000, d);
+  TEST_ASSERT_EQUAL_UINT32(0,    stage(d, TraceStage::ENQUEUE));
+  TEST_ASSERT_EQUAL_UINT32(2098, stage(d, TraceStage::QUEUE));
+  TEST_ASSERT_EQUAL_UINT32(0,    stage(d, TraceStage::SEND));
+  TEST_ASSERT_EQUAL_UINT32(3000, stage(d, TraceStage::TOTAL));
+}
+
+static void test_window_pct() {
+  TEST_ASSERT_EQUAL_UINT8(100, trace_window_pct(0, 0));
+  TEST_ASSERT_EQUAL_UINT8(50,  trace_window_pct(0b0110, 4));
+  TEST_ASSERT_EQUAL_UINT8(75,  trace_window_pct(0xF0 | 0b0111, 4));   // bits past n ignored
+  TEST_ASSERT_EQUAL_UINT8(100, trace_window_pct(~0ull, 64));
+  TEST_ASSERT_EQUAL_UINT8(98,  trace_window_pct(~0ull >> 1, 64));
+}
+
+// The sensor task stamps SAMPLE = DETECT - chain.latencyMs(): on the fake
+// cell that lands on the conversion where the load actually changed
+static void test_sample_mark_matches_step() {
+  fake_clock_set_us(0);
+  fake_hx711_config({ HX_RATE_SPS, 0, 1000.0f, 0, 1 });     // 1 count = 1 mg, no noise
+  fake_hx711_load(0, 0);
+  hal_hx711_begin(1, 10, 128);
+  const uint16_t sps = HX_RATE_SPS;
+  FilterChain chain({ sps, FILT_CIC_ORDER, (uint8_t)(sps / FILT_OUT_SPS), (FilterPost)FILT_POST });
+  int32_t out;
+  for (int i = 0; i < 50; ++i) (void)chain.push(hal_hx711_read(), out);
+
+  fake_hx711_load(100000, 0);
+  uint32_t stepMs = 0, detectMs = 0;
+  for (int i = 0; i < 100 && !detectMs; ++i) {
+    const int32_t raw = hal_hx711_read();
+    if (!stepMs && raw > DELTA_SEND_MG) stepMs = hal_millis();
+    if (chain.push(raw, out) && out > DELTA_SEND_MG) detectMs = hal_millis();
+  }
+  TEST_ASSERT_TRUE(stepMs && detectMs);
+  TEST_ASSERT_UINT32_WITHIN(chain.outPeriodMs(), stepMs, detectMs - chain.latencyMs());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_full_trace_and_wrap);
+  RUN_TEST(test_missing_marks_fold_into_queue);
+  RUN_TEST(test_window_pct);
+  RUN_TEST(test_sample_mark_matches_step);
+  return UNITY_END();
+}
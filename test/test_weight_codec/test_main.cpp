@@ -0,0 +1,264 @@
+// net/weight_codec: batch/record round trips (FINISH epochs too), malformed
+// input, and size and speed against the JSON and form bodies it replaces
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include "net/weight_codec.h"
+#include "util/body_writer.h"
+#include "util/fixed_weight.h"
+#include "../test_support.h"
+
+static WireHeader header(uint32_t nowMs) {
+  WireHeader h{};
+  wire_parse_mac("AA:BB:CC:DD:EE:0F", h.mac);
+  h.id    = "dev-42";
+  h.name  = "Sample Scale1";
+  h.boot  = 7;
+  h.nowMs = nowMs;
+  h.epoch = 1700000000;
+  return h;
+}
+
+static void assert_same(const Measurement& a, const Measurement& b) {
+  if (a.kind == MeasKind::FINISH) TEST_ASSERT_EQUAL_UINT32(a.epoch, b.epoch);
+  else                            TEST_ASSERT_EQUAL_INT32(a.mg, b.mg);
+  TEST_ASSERT_EQUAL_UINT32(a.monoMs, b.monoMs);
+  TEST_ASSERT_EQUAL_UINT32(a.seq, b.seq);
+  TEST_ASSERT_EQUAL_UINT8((uint8_t)a.kind, (uint8_t)b.kind);
+  TEST_ASSERT_EQUAL_UINT8(a.confPct, b.confPct);
+  TEST_ASSERT_EQUAL_UINT16(a.boot, b.boot);
+}
+
+// Sixteen realistic weighings: 20-60 s apart, ±150..350 g
+static void realistic(Measurement* r, size_t n) {
+  uint32_t t = 3600000;
+  for (size_t i = 0; i < n; ++i) {
+    t += 20000 + rnd() % 40000;
+    const int32_t v = (rnd() & 1 ? 1 : -1) * (int32_t)(150000 + rnd() % 200000);
+    r[i] = { v, t, (uint32_t)(1000 + i), v > 0 ? MeasKind::ADD : MeasKind::REMOVE, 100, 7 };
+  }
+}
+
+void setUp() { rnd_reset(); }
+void tearDown() {}
+
+static void test_varint_edges() {
+  static const uint32_t kVals[] = { 0, 1, 127, 128, 16383, 16384, 0x0FFFFFFF, 0xFFFFFFFF };
+  for (uint32_t v : kVals) {
+    uint8_t b[5];
+    const size_t n = wire_put_varint(b, sizeof(b), v);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, n);
+    uint32_t back = 0;
+    TEST_ASSERT_EQUAL_size_t(n, wire_get_varint(b, n, back));
+    TEST_ASSERT_EQUAL_UINT32(v, back);
+    TEST_ASSERT_EQUAL_size_t(0, wire_get_varint(b, n - 1, back));   // cut short
+    TEST_ASSERT_EQUAL_size_t(0, wire_put_varint(b, n - 1, v));      // no room
+  }
+}
+
+static void test_batch_round_trip_random() {
+  static constexpr size_t N = 16;
+  Measurement r[N], o[N];
+  uint32_t t = 123456;
+  int32_t  mg = 0;
+  for (int it = 0; it < 5000; ++it) {
+    const size_t n = 1 + rnd() % N;
+    for (size_t i = 0; i < n; ++i) {
+      t  += (it % 3 == 0) ? rnd() : 1000 + rnd() % 60000;     // incl. clock wrap
+      mg += (int32_t)(rnd() % 200001) - 100000;
+      if (it % 7 == 0) mg = (int32_t)rnd();                   // full range
+      r[i] = { mg, t, (uint32_t)(it * 20 + i + 1), (MeasKind)(rnd() % 3),
+               (uint8_t)(rnd() % 3 ? 100 : rnd() % 100), (uint16_t)(rnd() % 4) };
+    }
+    uint8_t buf[255];
+    size_t packed = 0, count = 0;
+    const size_t len = wire_encode_batch(buf, sizeof(buf), header(t), r, n, packed);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, len);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, packed);               // full-range records may not all fit
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(n, packed);
+
+    WireDecoded d;
+    TEST_ASSERT_TRUE(wire_decode_batch(buf, len, d, o, N, count));
+    TEST_ASSERT_EQUAL_size_t(packed, count);
+    for (size_t i = 0; i < count; ++i) assert_same(r[i], o[i]);
+    TEST_ASSERT_EQUAL_UINT8(0x0F, d.mac[5]);
+    TEST_ASSERT_EQUAL_STRING("dev-42", d.id);
+    TEST_ASSERT_EQUAL_STRING("Sample Scale1", d.name);
+    TEST_ASSERT_EQUAL_UINT32(t, d.nowMs);
+
+    for (size_t cut = 0; cut < len; cut += 5) {
+      TEST_ASSERT_FALSE(wire_decode_batch(buf, cut, d, o, N, count));
+    }
+  }
+}
+
+static void test_batch_packs_what_fits() {
+  Measurement r[16], o[16];
+  realistic(r, 16);
+  uint8_t buf[64];
+  size_t packed = 0, count = 0;
+  const size_t len = wire_encode_batch(buf, sizeof(buf), header(0), r, 16, packed);
+  TEST_ASSERT_GREATER_THAN_UINT32(0, packed);
+  TEST_ASSERT_LESS_THAN_UINT32(16, packed);
+  WireDecoded d;
+  TEST_ASSERT_TRUE(wire_decode_batch(buf, len, d, o, 16, count));
+  TEST_ASSERT_EQUAL_size_t(packed, count);
+  for (size_t i = 0; i < count; ++i) assert_same(r[i], o[i]);
+
+  TEST_ASSERT_EQUAL_size_t(0, wire_encode_batch(buf, 20, header(0), r, 16, packed));   // header alone
+}
+
+static void test_record_round_trip() {
+  const Measurement kRecs[] = {
+    { 250000, 1234, 1, MeasKind::ADD, 100, 3 },
+    { -4560, 0xFFFFFFFF, 0xFFFFFFFF, MeasKind::REMOVE, 72, 0xFFFF },
+    { 256000, 1534, 2, MeasKind::ADD, MEAS_CORRECTS | 1, 3 },      // corrects seq 1
+    { 1700000000, 99, 5, MeasKind::FINISH, 100, 1 },
+  };
+  for (const Measurement& m : kRecs) {
+    uint8_t b[32];
+    const size_t n = wire_encode_record(b, sizeof(b), m);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, n);
+    Measurement back{};
+    TEST_ASSERT_EQUAL_size_t(n, wire_decode_record(b, n, back));
+    assert_same(m, back);
+    TEST_ASSERT_EQUAL_size_t(0, wire_decode_record(b, n - 1, back));
+  }
+}
+
+// FINISH carries an unsigned epoch in the value field, delta-coded against
+// weights on either side; past 2038 it no longer fits an int32
+static Measurement finish(uint32_t seq, uint32_t ms, uint32_t epoch) {
+  Measurement m{};
+  m.epoch   = epoch;
+  m.monoMs  = ms;
+  m.seq     = seq;
+  m.kind    = MeasKind::FINISH;
+  m.confPct = 100;
+  m.boot    = 3;
+  return m;
+}
+
+static void test_finish_epoch_between_weights() {
+  const Measurement r[4] = {
+    { 250000, 1000, 1, MeasKind::ADD, 100, 3 },
+    finish(2, 2000, 0xF0000000u),
+    { -4560, 3000, 3, MeasKind::REMOVE, 100, 3 },
+    finish(4, 4000, 0),
+  };
+
+  uint8_t buf[255];
+  size_t packed = 0, count = 0;
+  const size_t len = wire_encode_batch(buf, sizeof(buf), header(5000), r, 4, packed);
+  TEST_ASSERT_EQUAL_size_t(4, packed);
+  WireDecoded d;
+  Measurement o[4];
+  TEST_ASSERT_TRUE(wire_decode_batch(buf, len, d, o, 4, count));
+  TEST_ASSERT_EQUAL_size_t(4, count);
+  for (size_t i = 0; i < 4; ++i) assert_same(r[i], o[i]);
+  TEST_ASSERT_EQUAL_HEX32(0xF0000000u, o[1].epoch);
+  TEST_ASSERT_EQUAL_INT32(-4560, o[2].mg);
+}
+
+// A batch leaves the spool only on an explicit count; a legacy endpoint's
+// 2xx page or an unparseable count acknowledges nothing
+static void test_batch_ack_parsing() {
+  uint32_t n = 99;
+  TEST_ASSERT_TRUE(wire_parse_ack("{\"ok\":16}", n));
+  TEST_ASSERT_EQUAL_UINT32(16, n);
+  TEST_ASSERT_TRUE(wire_parse_ack("{ \"seen\": 3, \"ok\" :\n 0 }", n));
+  TEST_ASSERT_EQUAL_UINT32(0, n);
+  TEST_ASSERT_TRUE(wire_parse_ack("{\"ok\":4294967295}", n));
+  TEST_ASSERT_EQUAL_UINT32(0xFFFFFFFFu, n);
+
+  const char* const bad[] = {
+    nullptr, "", "OK", "<html>saved</html>", "{\"status\":\"ok\"}", "{\"ok\":true}",
+    "{\"ok\":-1}", "{\"ok\":\"3\"}", "{\"ok\" 3}", "{\"ok\":4294967296}",
+  };
+  for (const char* r : bad) TEST_ASSERT_FALSE(wire_parse_ack(r, n));
+}
+
+static void test_malformed_header_rejected() {
+  Measurement r[4], o[4];
+  realistic(r, 4);
+  uint8_t buf[255];
+  size_t packed = 0, count = 0;
+  const size_t len = wire_encode_batch(buf, sizeof(buf), header(0), r, 4, packed);
+  WireDecoded d;
+  buf[0] = 'X';
+  TEST_ASSERT_FALSE(wire_decode_batch(buf, len, d, o, 4, count));
+  buf[0] = 'S';
+  buf[2] = WIRE_VERSION + 1;
+  TEST_ASSERT_FALSE(wire_decode_batch(buf, len, d, o, 4, count));
+}
+
+// The same 16 weighings as bin2, as the JSON batch and as 16 form posts
+static size_t json_body(char* out, size_t cap, const Measurement* r, size_t n, uint32_t nowMs) {
+  BodyWriter w(out, cap);
+  w.raw("{\"mac\":").jsonStr("AA:BB:CC:DD:EE:0F").raw(",\"id\":").jsonStr("dev-42")
+   .raw(",\"name\":").jsonStr("Sample Scale1").raw(",\"boot\":").u32(7)
+   .raw(",\"now\":").u32(nowMs).raw(",\"epoch\":").u32(1700000000).raw(",\"items\":[");
+  for (size_t i = 0; i < n; ++i) {
+    char g[16];
+    weight_format_g(g, sizeof(g), r[i].mg, 2);
+    if (i) w.ch(',');
+    w.raw("{\"seq\":").u32(r[i].seq).raw(",\"b\":").u32(r[i].boot).raw(",\"t\":").u32(r[i].monoMs)
+     .raw(",\"k\":").jsonStr(r[i].kind == MeasKind::ADD ? "add" : "rm").raw(",\"w\":").jsonStr(g).ch('}');
+  }
+  w.raw("]}");
+  return w.overflow() ? 0 : w.length();
+}
+
+static void test_size_and_speed_vs_json() {
+  Measurement r[16];
+  realistic(r, 16);
+  const WireHeader h = header(r[15].monoMs);
+
+  uint8_t bin[255];
+  size_t packed = 0;
+  const size_t binLen = wire_encode_batch(bin, sizeof(bin), h, r, 16, packed);
+  TEST_ASSERT_EQUAL_size_t(16, packed);
+
+  char json[1536];
+  const size_t jsonLen = json_body(json, sizeof(json), r, 16, h.nowMs);
+  TEST_ASSERT_GREATER_THAN_UINT32(0, jsonLen);
+
+  size_t formLen = 0;
+  for (size_t i = 0; i < 16; ++i) {
+    char b[192], g[16];
+    weight_format_g(g, sizeof(g), r[i].mg, 2);
+    BodyWriter f(b, sizeof(b));
+    f.form("mac", "AA:BB:CC:DD:EE:0F").form("id", "dev-42").form("name", "Sample Scale1").form("w", g)
+     .form("seq", r[i].seq).form("boot", r[i].boot);
+    formLen += f.length();
+  }
+
+  size_t sink = 0;
+  const double enc = host_ns_per_call(20000, [&](uint32_t) {
+    sink += wire_encode_batch(bin, sizeof(bin), h, r, 16, packed);
+  });
+  const double js = host_ns_per_call(20000, [&](uint32_t) {
+    sink += json_body(json, sizeof(json), r, 16, h.nowMs);
+  });
+
+  printf("\n  16 records: bin2 %u B, JSON %u B, form %u B in 16 posts\n",
+         (unsigned)binLen, (unsigned)jsonLen, (unsigned)formLen);
+  printf("  per batch: bin2 encode %.0f ns vs JSON build %.0f ns (%u)\n", enc, js, (unsigned)(sink & 1));
+
+  TEST_ASSERT_TRUE(enc < js);
+  TEST_ASSERT_LESS_THAN_UINT32(jsonLen / 5, binLen);          // "6-9 B instead of ~70" per record
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(48 + 16 * 9, binLen);      // ~45 B header with these strings
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_varint_edges);
+  RUN_TEST(test_batch_round_trip_random);
+  RUN_TEST(test_batch_packs_what_fits);
+  RUN_TEST(test_record_round_trip);
+  RUN_TEST(test_finish_epoch_between_weights);
+  RUN_TEST(test_batch_ack_parsing);
+  RUN_TEST(test_malformed_header_rejected);
+  RUN_TEST(test_size_and_speed_vs_json);
+  return UNITY_END();
+}
@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+"""Fault-injecting stand-in for the upload server (HTTP transport).
+
+Answers every POST with 200 "ok", except while it is told to misbehave:
+
+    --down 30:150      server "down" from t=30 s to t=150 s (repeatable)
+    --fail-rate 0.3    otherwise fail 30 % of requests at random
+    --mode 503|drop|hang
+                       how a failure looks: HTTP 503, connection closed
+                       without a response, or no answer until the device
+                       times out
+
+Every request is printed with the time since start, so the device's
+backoff, breaker opening and half-open probes show up as gaps:
+
+    openssl req -x509 -newkey rsa:2048 -nodes -days 365 -subj /CN=stub \\
+        -keyout key.pem -out cert.pem
+    python3 tools/fault_http_server.py --cert cert.pem --key key.pem \\
+        --port 8443 --down 30:150 --mode drop
+
+Point SERVER_BASE_URL in app_config.h at https://<this machine>:8443/.
+"""
+import argparse
+import http.server
+import random
+import ssl
+import sys
+import time
+
+
+def parse_window(s):
+    a, b = s.split(":")
+    return float(a), float(b)
+
+
+class Handler(http.server.BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"            # keep-alive, like the real server
+
+    def log_message(self, fmt, *args):
+        pass
+
+    def do_POST(self):
+        srv = self.server
+        t = time.monotonic() - srv.t0
+        n = int(self.headers.get("Content-Length", 0))
+        body = self.rfile.read(n)
+        ct = self.headers.get("Content-Type", "")
+
+        down = any(a <= t < b for a, b in srv.windows)
+        fail = down or random.random() < srv.fail_rate
+        srv.count += 1
+        tag = f"#{srv.count:<4} t={t:8.1f}s {len(body):5} B {ct:<36}"
+
+        if not fail:
+            print(f"{tag} → 200")
+            self.reply(200, b"ok")
+            return
+
+        print(f"{tag} → {srv.mode.upper()}{' (down)' if down else ''}")
+        if srv.mode == "503":
+            self.reply(503, b"unavailable")
+        elif srv.mode == "hang":
+            time.sleep(srv.hang_s)
+            self.close_connection = True
+        else:
+            self.close_connection = True
+
+    def reply(self, code, data):
+        self.send_response(code)
+        self.send_header("Content-Type", "text/plain")
+        self.send_header("Content-Length", str(len(data)))
+        self.end_headers()
+        self.wfile.write(data)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--port", type=int, default=8443)
+    ap.add_argument("--cert")
+    ap.add_argument("--key")
+    ap.add_argument("--plain", action="store_true", help="no TLS")
+    ap.add_argument("--down", action="append", default=[], type=parse_window,
+                    metavar="FROM:TO", help="outage window in seconds since start")
+    ap.add_argument("--fail-rate", type=float, default=0.0)
+    ap.add_argument("--mode", choices=["503", "drop", "hang"], default="503")
+    ap.add_argument("--hang-s", type=float, default=15.0)
+    args = ap.parse_args()
+
+    srv = http.server.ThreadingHTTPServer(("0.0.0.0", args.port), Handler)
+    srv.t0 = time.monotonic()
+    srv.windows = args.down
+    srv.fail_rate = args.fail_rate
+    srv.mode = args.mode
+    srv.hang_s = args.hang_s
+    srv.count = 0
+
+    if not args.plain:
+        if not (args.cert and args.key):
+            sys.exit("--cert/--key required (or --plain)")
+        ctx = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+        ctx.load_cert_chain(args.cert, args.key)
+        srv.socket = ctx.wrap_socket(srv.socket, server_side=True)
+
+    print(f"listening on :{args.port}  down={args.down} fail-rate={args.fail_rate} mode={args.mode}")
+    try:
+        srv.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,257 @@
+#!/usr/bin/env python3
+"""Decoder for the binary trace mode of src/util/log (build with -DLOG_BINARY=1).
+
+Rebuilds the message table from the LOGE/LOGW/LOGI/LOGD call sites in the
+source tree (same FNV-1a hash of "TAG\\x1f" fmt as log.h), then turns the
+captured frames back into text. Bytes outside valid frames (boot ROM
+output, the banner) are passed through unchanged.
+
+    python3 tools/log_decode.py --port /dev/ttyACM0        # live, needs pyserial
+    python3 tools/log_decode.py capture.bin                 # from a file
+    cat capture.bin | python3 tools/log_decode.py
+
+The table must come from the same sources the firmware was built from.
+"""
+import argparse
+import codecs
+import os
+import re
+import struct
+import sys
+
+SYNC = 0xA5
+ID_DROP = 0
+LEVELS = {1: "E", 2: "W", 3: "I", 4: "D"}
+
+CALL = re.compile(rb'\bLOG[EWID]\s*\(\s*"')
+SPEC = re.compile(rb"%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d*))?(hh|h|ll|l|j|z|t|L|q)?([diouxXeEfFgGaAcspn%])")
+
+
+def fnv1a(data):
+    h = 2166136261
+    for c in data:
+        h = ((h ^ c) * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def c_literal(src, i):
+    """Parses the string literal whose opening quote is at src[i]."""
+    out = bytearray()
+    i += 1
+    while src[i] != 0x22:
+        c = src[i]
+        if c != 0x5C:
+            out.append(c)
+            i += 1
+            continue
+        e = src[i + 1]
+        i += 2
+        simple = {b"n": 10, b"r": 13, b"t": 9, b"0": 0, b"\\": 92, b'"': 34, b"'": 39, b"a": 7, b"b": 8, b"f": 12, b"v": 11}
+        if e == 0x78:                                   # \xHH...
+            j = i
+            while j < len(src) and chr(src[j]) in "0123456789abcdefABCDEF":
+                j += 1
+            out.append(int(src[i:j], 16) & 0xFF)
+            i = j
+        elif 0x30 <= e <= 0x37:                         # octal
+            j = i
+            while j < len(src) and j < i + 2 and 0x30 <= src[j] <= 0x37:
+                j += 1
+            out.append(int(src[i - 1:j], 8) & 0xFF)
+            i = j
+        else:
+            out.append(simple.get(bytes([e]), e))
+    return bytes(out), i + 1
+
+
+def literals(src, i):
+    """Adjacent string literals starting at src[i] (after whitespace/comments)."""
+    parts = []
+    while True:
+        while i < len(src) and src[i] in b" \t\r\n":
+            i += 1
+        if src.startswith(b"//", i):
+            i = src.index(b"\n", i)
+            continue
+        if i >= len(src) or src[i] != 0x22:
+            return b"".join(parts), i
+        s, i = c_literal(src, i)
+        parts.append(s)
+
+
+def build_table(root):
+    table = {}
+    for d, _, files in os.walk(root):
+        for name in files:
+            if not name.endswith((".cpp", ".h", ".ino")):
+                continue
+            path = os.path.join(d, name)
+            src = open(path, "rb").read()
+            for m in CALL.finditer(src):
+                tag, i = literals(src, m.end() - 1)
+                while i < len(src) and src[i] in b" \t\r\n":
+                    i += 1
+                if i >= len(src) or src[i] != 0x2C:
+                    continue
+                fmt, _ = literals(src, i + 1)
+                if not fmt:
+                    continue
+                key = fnv1a(tag + b"\x1f" + fmt)
+                line = src.count(b"\n", 0, m.start()) + 1
+                prev = table.get(key)
+                if prev and prev[:2] != (tag, fmt):
+                    print(f"warning: ID 0x{key:08x} collides: {prev[2]} and {path}:{line}", file=sys.stderr)
+                table.setdefault(key, (tag, fmt, f"{path}:{line}"))
+    return table
+
+
+class Args:
+    def __init__(self, data):
+        self.b, self.i, self.short = data, 0, False
+
+    def take(self, fmt):
+        n = struct.calcsize(fmt)
+        if self.i + n > len(self.b):
+            self.short = True
+            return 0
+        v = struct.unpack_from(fmt, self.b, self.i)[0]
+        self.i += n
+        return v
+
+    def string(self):
+        n = self.take("<B")
+        s = self.b[self.i:self.i + n]
+        self.i += len(s)
+        return s.decode(errors="replace")
+
+
+def render(fmt, args):
+    out, pos = [], 0
+    for m in SPEC.finditer(fmt):
+        out.append(fmt[pos:m.start()].decode(errors="replace"))
+        pos = m.end()
+        flags, width, prec, length, conv = m.groups()
+        conv = conv.decode()
+        if conv == "%":
+            out.append("%")
+            continue
+        if width == b"*":
+            width = str(args.take("<i")).encode()
+        if prec == b"*":
+            prec = str(args.take("<i")).encode()
+        spec = "%" + flags.decode() + (width or b"").decode()
+        if prec is not None:
+            spec += "." + prec.decode()
+        wide = length in (b"ll", b"j", b"q")
+        if conv in "di":
+            v = args.take("<q" if wide else "<i")
+        elif conv in "ouxXc":
+            v = args.take("<Q" if wide else "<I")
+        elif conv in "eEfFgGaA":
+            v, conv = args.take("<f"), conv.replace("a", "e").replace("A", "E")
+        elif conv == "s":
+            v = args.string()
+        elif conv == "p":
+            v, spec, conv = args.take("<I"), "0x%08", "x"
+        else:                                           # %n: nothing was captured
+            continue
+        if args.short:
+            break
+        out.append((spec + conv) % v)
+    if args.short:
+        return "".join(out) + "… (args truncated)"
+    out.append(fmt[pos:].decode(errors="replace"))
+    return "".join(out)
+
+
+def decode_frame(payload, table):
+    level, ms, msg_id = struct.unpack_from("<BII", payload)
+    args = Args(payload[9:])
+    lvl = LEVELS.get(level, "?")
+    if msg_id == ID_DROP:
+        return f"{ms:>9} {lvl} [LOG] dropped {args.take('<I')} lines (ring full)"
+    if msg_id not in table:
+        return f"{ms:>9} {lvl} [?] unknown id 0x{msg_id:08x} {payload[9:].hex()}"
+    tag, fmt, _ = table[msg_id]
+    try:
+        text = render(fmt, args)
+    except (ValueError, OverflowError):             # stale table or corrupt frame
+        text = f"{fmt.decode(errors='replace')} ?? {payload[9:].hex()}"
+    return f"{ms:>9} {lvl} [{tag.decode(errors='replace')}] {text}"
+
+
+class Decoder:
+    """Incremental: feed() bytes, get back printable text."""
+
+    def __init__(self, table):
+        self.table, self.buf = table, bytearray()
+        self.utf = codecs.getincrementaldecoder("utf-8")(errors="replace")   # text split across reads
+
+    def feed(self, data):
+        self.buf += data
+        out, text, b, i = [], bytearray(), self.buf, 0
+        while i < len(b):
+            if b[i] != SYNC:
+                j = b.find(bytes([SYNC]), i)
+                j = len(b) if j < 0 else j
+                text += b[i:j]
+                i = j
+                continue
+            if i + 2 > len(b):
+                break
+            n = b[i + 1]
+            if i + 3 + n > len(b):
+                break
+            x = 0
+            for c in b[i + 1:i + 2 + n]:
+                x ^= c
+            if n >= 9 and x == b[i + 2 + n]:
+                out.append(self.utf.decode(bytes(text)))
+                text.clear()
+                out.append(decode_frame(bytes(b[i + 2:i + 2 + n]), self.table) + "\n")
+                i += 3 + n
+            else:                                       # not a frame: resync
+                text.append(SYNC)
+                i += 1
+        out.append(self.utf.decode(bytes(text)))
+        del b[:i]
+        return "".join(out)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("input", nargs="?", help="capture file (default: stdin)")
+    ap.add_argument("--port", help="serial port to read live")
+    ap.add_argument("--baud", type=int, default=115200)
+    ap.add_argument("--src", default=os.path.join(os.path.dirname(__file__), "..", "src"),
+                    help="firmware sources the table is built from")
+    ap.add_argument("--list", action="store_true", help="print the message table and exit")
+    a = ap.parse_args()
+
+    table = build_table(a.src)
+    if a.list:
+        for k, (tag, fmt, where) in sorted(table.items(), key=lambda kv: kv[1][2]):
+            print(f"0x{k:08x}  [{tag.decode()}] {fmt.decode(errors='replace')}  ({where})")
+        return
+
+    dec = Decoder(table)
+    if a.port:
+        import serial                                   # pyserial
+        src = serial.Serial(a.port, a.baud, timeout=0.1)
+        read = lambda: src.read(256)
+    else:
+        src = open(a.input, "rb") if a.input else sys.stdin.buffer
+        read = lambda: src.read1(4096) if hasattr(src, "read1") else src.read(4096)
+    try:
+        while True:
+            chunk = read()
+            if not chunk and not a.port:
+                break
+            sys.stdout.write(dec.feed(chunk))
+            sys.stdout.flush()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,152 @@
+#!/usr/bin/env python3
+"""Local stand-in for the telemetry stream server (see src/net/stream_client.h).
+
+Accepts the device's HELLO, acks every MEAS frame, answers PING and prints
+what it receives. Records are de-duplicated by (mac, seq), so resends after
+a reconnect show up as "dup".
+
+    openssl req -x509 -newkey rsa:2048 -nodes -days 365 -subj /CN=stub \\
+        -keyout key.pem -out cert.pem
+    python3 tools/stream_stub_server.py --cert cert.pem --key key.pem --port 8443
+
+Point STREAM_HOST/STREAM_PORT in app_config.h at this machine and set
+UPLOAD_TRANSPORT = 1. Type a line on stdin to PUSH it to connected devices.
+"""
+import argparse
+import asyncio
+import ssl
+import struct
+import sys
+
+HELLO, WELCOME, DENY = 0x01, 0x02, 0x03
+MEAS = 0x10
+PING, PONG = 0x20, 0x21
+ACK, PUSH = 0x30, 0x40
+
+
+def varint(v):
+    out = bytearray()
+    while v >= 0x80:
+        out.append((v & 0x7F) | 0x80)
+        v >>= 7
+    out.append(v)
+    return bytes(out)
+
+
+def get_varint(b, i):
+    v = shift = 0
+    while True:
+        c = b[i]
+        i += 1
+        v |= (c & 0x7F) << shift
+        if not c & 0x80:
+            return v, i
+        shift += 7
+
+
+def get_str(b, i):
+    n, i = get_varint(b, i)
+    return b[i:i + n].decode(errors="replace"), i + n
+
+
+def unzigzag(u):
+    return (u >> 1) ^ -(u & 1)
+
+
+def frame(t, payload=b""):
+    return struct.pack("<BH", t, len(payload)) + payload
+
+
+class Server:
+    def __init__(self, token, heartbeat_ms):
+        self.token = token
+        self.heartbeat_ms = heartbeat_ms
+        self.seen = set()
+        self.writers = set()
+
+    async def handle(self, reader, writer):
+        peer = writer.get_extra_info("peername")
+        mac = None
+        self.writers.add(writer)
+        try:
+            while True:
+                t, n = struct.unpack("<BH", await reader.readexactly(3))
+                p = await reader.readexactly(n)
+                if t == HELLO:
+                    ver, mac = p[0], p[1:7]
+                    token, i = get_str(p, 7)
+                    dev_id, i = get_str(p, i)
+                    name, i = get_str(p, i)
+                    boot = struct.unpack_from("<I", p, i)[0]
+                    last, _ = get_varint(p, i + 4)
+                    print(f"{peer} HELLO v{ver} mac={mac.hex(':')} id={dev_id} "
+                          f"name={name!r} boot={boot:08x} lastAcked={last}")
+                    if self.token and token != self.token:
+                        writer.write(frame(DENY, b"bad token"))
+                        await writer.drain()
+                        return
+                    writer.write(frame(WELCOME, varint(self.heartbeat_ms)))
+                elif t == MEAS:
+                    seq, i = get_varint(p, 0)
+                    rboot, i = get_varint(p, i)
+                    tms, i = get_varint(p, i)
+                    mg, i = get_varint(p, i)
+                    flags = p[i]
+                    conf = p[i + 1] if flags & 2 else 100
+                    key = (mac, seq)
+                    tag = "dup" if key in self.seen else "new"
+                    self.seen.add(key)
+                    head = f"  seq={seq} boot={unzigzag(rboot)} t={unzigzag(tms)}"
+                    if flags & 4:
+                        print(f"{head} FINISH epoch={unzigzag(mg)} [{tag}]")
+                    else:
+                        kind = "REMOVE" if flags & 1 else "ADD"
+                        fix = f" fixes seq={seq - (conf & 0x7F)}" if conf & 0x80 else ""
+                        conf = 100 if conf & 0x80 else conf
+                        print(f"{head} {kind} {unzigzag(mg) / 1000:.2f} g conf={conf}{fix} [{tag}]")
+                    writer.write(frame(ACK, bytes([MEAS]) + varint(seq)))
+                elif t == PING:
+                    writer.write(frame(PONG))
+                else:
+                    print(f"  unknown frame 0x{t:02x} ({n} B)")
+                await writer.drain()
+        except (asyncio.IncompleteReadError, ConnectionError):
+            pass
+        finally:
+            self.writers.discard(writer)
+            print(f"{peer} closed")
+            writer.close()
+
+    async def stdin_push(self):
+        loop = asyncio.get_running_loop()
+        while True:
+            line = await loop.run_in_executor(None, sys.stdin.readline)
+            if not line:
+                return
+            for w in list(self.writers):
+                w.write(frame(PUSH, line.rstrip("\n").encode()[:192]))
+
+
+async def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--port", type=int, default=8443)
+    ap.add_argument("--cert", help="PEM certificate (omit for plain TCP)")
+    ap.add_argument("--key", help="PEM private key")
+    ap.add_argument("--token", default="", help="expected STREAM_TOKEN")
+    ap.add_argument("--heartbeat-ms", type=int, default=15000)
+    args = ap.parse_args()
+
+    ctx = None
+    if args.cert:
+        ctx = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+        ctx.load_cert_chain(args.cert, args.key)
+
+    srv = Server(args.token, args.heartbeat_ms)
+    server = await asyncio.start_server(srv.handle, "0.0.0.0", args.port, ssl=ctx)
+    print(f"listening on :{args.port} ({'TLS' if ctx else 'plain'})")
+    async with server:
+        await asyncio.gather(server.serve_forever(), srv.stdin_push())
+
+
+if __name__ == "__main__":
+    asyncio.run(main())